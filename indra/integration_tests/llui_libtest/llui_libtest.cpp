@@ -38,8 +38,10 @@
 #include "llfloater.h"
 #include "llfontfreetype.h"
 #include "llfontgl.h"
+#include "lltimer.h"
 #include "lltransutil.h"
 #include "llui.h"
+#include "lluibatch.h"
 #include "lluictrlfactory.h"
 
 #include <iostream>
@@ -203,11 +205,185 @@ void export_test_floaters()
 }
 |*==========================================================================*/
 
+//---------------------------------------------------------------------------
+// UI batching benchmark
+//
+// There is no GL context here, so this replays the quads LLRender is handed
+// while drawing a busy floater (the texture changes are what used to force
+// a draw each) through LLUIBatch, and reports how many draw calls remain.
+//---------------------------------------------------------------------------
+namespace
+{
+	// stand-in texture names
+	enum
+	{
+		TEX_WHITE = 1,
+		TEX_FONT,
+		TEX_FLOATER,
+		TEX_BUTTON,
+		TEX_CHECKBOX,
+		TEX_TEXT_FIELD,
+		TEX_SCROLLBAR,
+		TEX_ICON_FIRST
+	};
+
+	class QuadRecorder
+	{
+	public:
+		QuadRecorder(LLUIBatch& batch): mBatch(batch), mDrawCalls(0), mGroups(0) {}
+
+		void quad(U32 texture, F32 left, F32 bottom, F32 right, F32 top)
+		{
+			LLVector3 verts[4] = { LLVector3(left, top, 0.f), LLVector3(left, bottom, 0.f),
+								   LLVector3(right, bottom, 0.f), LLVector3(right, top, 0.f) };
+			LLVector2 uvs[4] = { LLVector2(0.f, 1.f), LLVector2(0.f, 0.f),
+								 LLVector2(1.f, 0.f), LLVector2(1.f, 1.f) };
+			LLColor4U colors[4];
+			LLStrider<LLVector3> vert_strider;
+			LLStrider<LLVector2> uv_strider;
+			LLStrider<LLColor4U> color_strider;
+			vert_strider = verts;
+			uv_strider = uvs;
+			color_strider = colors;
+
+			if (!mBatch.hasRoom(4))
+			{
+				flush();
+			}
+			if (mBatch.empty() || mBatch.getRun(mBatch.getRunCount() - 1).mTexture.mName != texture)
+			{ //without batching, every texture change is a draw
+				mDrawCalls++;
+			}
+			LLUIBatch::Texture tex = { texture, 0 };
+			mBatch.add(tex, vert_strider, uv_strider, color_strider, 4);
+		}
+
+		// a scalable image: corners, edges and center
+		void image(U32 texture, const LLRect& rect)
+		{
+			const F32 border = 4.f;
+			F32 x[4] = { (F32) rect.mLeft, rect.mLeft + border, rect.mRight - border, (F32) rect.mRight };
+			F32 y[4] = { (F32) rect.mBottom, rect.mBottom + border, rect.mTop - border, (F32) rect.mTop };
+			for (S32 row = 0; row < 3; ++row)
+			{
+				for (S32 col = 0; col < 3; ++col)
+				{
+					quad(texture, x[col], y[row], x[col + 1], y[row + 1]);
+				}
+			}
+		}
+
+		void text(S32 left, S32 bottom, S32 chars)
+		{
+			for (S32 i = 0; i < chars; ++i)
+			{
+				quad(TEX_FONT, left + i * 7.f, (F32) bottom, left + i * 7.f + 6.f, bottom + 12.f);
+			}
+		}
+
+		void flush()
+		{
+			mGroups += mBatch.sort().size();
+			mBatch.clear();
+		}
+
+		LLUIBatch& mBatch;
+		U32 mDrawCalls;
+		U32 mGroups;
+	};
+
+	// a floater with a title bar, a form of labelled controls and a scroll list
+	void draw_floater(QuadRecorder& out, const LLRect& rect)
+	{
+		out.image(TEX_FLOATER, rect);
+		out.text(rect.mLeft + 8, rect.mTop - 18, 24);
+		for (S32 i = 0; i < 3; ++i)
+		{ //title bar buttons
+			out.quad(TEX_ICON_FIRST + i, rect.mRight - 20.f * (i + 1), rect.mTop - 18.f, rect.mRight - 20.f * i - 4.f, rect.mTop - 4.f);
+		}
+
+		S32 top = rect.mTop - 32;
+		for (S32 row = 0; row < 16; ++row, top -= 26)
+		{
+			for (S32 col = 0; col < 2; ++col)
+			{
+				S32 left = rect.mLeft + 8 + col * 230;
+				out.text(left, top - 18, 10);
+				LLRect control(left + 80, top, left + 220, top - 22);
+				switch ((row + col) % 4)
+				{
+				case 0:
+					out.image(TEX_BUTTON, control);
+					out.text(control.mLeft + 8, control.mBottom + 5, 12);
+					break;
+				case 1:
+					out.quad(TEX_CHECKBOX, (F32) control.mLeft, control.mBottom + 3.f, control.mLeft + 16.f, control.mBottom + 19.f);
+					out.text(control.mLeft + 20, control.mBottom + 5, 14);
+					break;
+				case 2:
+					out.image(TEX_TEXT_FIELD, control);
+					out.text(control.mLeft + 4, control.mBottom + 5, 16);
+					break;
+				default:
+					out.quad(TEX_WHITE, (F32) control.mLeft, (F32) control.mBottom, (F32) control.mRight, (F32) control.mTop);
+					out.quad(TEX_ICON_FIRST + 3 + row % 8, (F32) control.mLeft + 2, control.mBottom + 3.f, control.mLeft + 18.f, control.mBottom + 19.f);
+					out.text(control.mLeft + 22, control.mBottom + 5, 12);
+					break;
+				}
+			}
+		}
+
+		// scroll list: alternating row highlight, icon and text per row, then scrollbar
+		LLRect list(rect.mLeft + 470, rect.mTop - 32, rect.mRight - 24, rect.mBottom + 8);
+		out.image(TEX_TEXT_FIELD, list);
+		for (S32 y = list.mTop - 20; y > list.mBottom; y -= 20)
+		{
+			if ((y / 20) % 2)
+			{
+				out.quad(TEX_WHITE, list.mLeft + 1.f, (F32) y, list.mRight - 1.f, y + 20.f);
+			}
+			out.quad(TEX_ICON_FIRST + 11 + (y / 20) % 6, list.mLeft + 2.f, y + 2.f, list.mLeft + 18.f, y + 18.f);
+			out.text(list.mLeft + 22, y + 4, 20);
+		}
+		out.image(TEX_SCROLLBAR, LLRect(rect.mRight - 22, list.mTop, rect.mRight - 8, list.mBottom));
+		out.image(TEX_SCROLLBAR, LLRect(rect.mRight - 21, list.mTop - 40, rect.mRight - 9, list.mTop - 120));
+	}
+
+	void benchmark_ui_batching()
+	{
+		const S32 frames = 200;
+		LLUIBatch batch(16384);
+		QuadRecorder recorder(batch);
+
+		LLTimer timer;
+		for (S32 frame = 0; frame < frames; ++frame)
+		{
+			// a few overlapping floaters, as on a busy screen
+			for (S32 i = 0; i < 4; ++i)
+			{
+				draw_floater(recorder, LLRect(40 + i * 90, 700 - i * 60, 760 + i * 90, 220 - i * 60));
+			}
+			recorder.flush();
+		}
+		F64 seconds = timer.getElapsedTimeF64();
+
+		std::cout << "UI batching: " << recorder.mDrawCalls / frames << " draw calls per frame unbatched, "
+				  << recorder.mGroups / frames << " batched, "
+				  << seconds * 1000.0 / frames << " ms per frame to record and sort" << std::endl;
+	}
+}
+
 int main(int argc, char** argv)
 {
 	// Must init LLError for llerrs to actually cause errors.
 	LLError::initForApplication(".");
 
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-ui-batching")
+	{ //needs no skin or fonts
+		benchmark_ui_batching();
+		return 0;
+	}
+
 	init_llui();
 	
 //	export_test_floaters();
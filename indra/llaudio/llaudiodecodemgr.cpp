@@ -28,6 +28,8 @@
 #include "llaudiodecodemgr.h"
 
 #include "llaudioengine.h"
+#include "lldiriterator.h"
+#include "llfile.h"
 #include "lllfsthread.h"
 #include "llfilesystem.h"
 #include "llstring.h"
@@ -42,6 +44,7 @@
 
 #include "vorbis/codec.h"
 #include "vorbis/vorbisfile.h"
+#include <algorithm>
 #include <iterator>
 #include <deque>
 
@@ -80,16 +83,23 @@ public:
 	BOOL isValid() const				{ return mValid; }
 	BOOL isDone() const					{ return mDone; }
 	const LLUUID &getUUID() const		{ return mUUID; }
+	// The finished WAV image, set once it's being written to disk
+	LLAudioPCMCache::wav_ptr_t getWAV() const	{ return mWAV; }
+	// Whether the image has been pinned in the PCM cache for the write
+	BOOL isPinned() const				{ return mPinned; }
+	void setPinned()					{ mPinned = TRUE; }
 
 protected:
 	virtual ~LLVorbisDecodeState();
 
 	BOOL mValid;
 	BOOL mDone;
+	BOOL mPinned;
 	LLAtomicS32 mBytesRead;
 	LLUUID mUUID;
 
 	std::vector<U8> mWAVBuffer;
+	std::shared_ptr<std::vector<U8> > mWAV;
 	std::string mOutFilename;
 	LLLFSThread::handle_t mFileHandle;
 	
@@ -166,6 +176,7 @@ LLVorbisDecodeState::LLVorbisDecodeState(const LLUUID &uuid, const std::string &
 {
 	mDone = FALSE;
 	mValid = FALSE;
+	mPinned = FALSE;
 	mBytesRead = -1;
 	mUUID = uuid;
 	mInFilep = NULL;
@@ -490,8 +501,11 @@ BOOL LLVorbisDecodeState::finishDecode()
 			mValid = FALSE;
 			return TRUE; // we've finished
 		}
+		// Moving the image keeps its storage, so nothing is copied for
+		// LLAudioPCMCache to share it
+		mWAV = std::make_shared<std::vector<U8> >(std::move(mWAVBuffer));
 		mBytesRead = -1;
-		mFileHandle = LLLFSThread::sLocal->write(mOutFilename, &mWAVBuffer[0], 0, mWAVBuffer.size(),
+		mFileHandle = LLLFSThread::sLocal->write(mOutFilename, &(*mWAV)[0], 0, mWAV->size(),
 							 new WriteResponder(this));
 	}
 
@@ -542,12 +556,28 @@ class LLAudioDecodeMgr::Impl
     void enqueueFinishAudio(const LLUUID &decode_id, LLPointer<LLVorbisDecodeState>& decode_state);
     void checkDecodesFinished();
 
+    // Return true if finished
+    bool tryFinishAudio(const LLUUID &decode_id, LLPointer<LLVorbisDecodeState> decode_state);
+    // Mark the sound playable, or its decode failed if wav is empty
+    void finishAudio(const LLUUID &decode_id, const LLAudioPCMCache::wav_ptr_t& wav, bool cached = false);
+
+    void startBenchmark(const std::string& dir);
+    void benchmarkDecodeFinished(const LLUUID &decode_id, bool valid);
+
   protected:
     std::deque<LLUUID> mDecodeQueue;
     std::map<LLUUID, LLPointer<LLVorbisDecodeState>> mDecodes;
+
+    // Benchmark sounds still decoding, and when they were requested
+    std::map<LLUUID, F64> mBenchmarkStarts;
+    std::vector<F64> mBenchmarkLatencies;
+    S32 mBenchmarkFailures;
+    F64 mBenchmarkStartTime;
 };
 
 LLAudioDecodeMgr::Impl::Impl()
+:   mBenchmarkFailures(0),
+    mBenchmarkStartTime(0.0)
 {
 }
 
@@ -555,9 +585,6 @@ LLAudioDecodeMgr::Impl::Impl()
 // there was an error and there is no more work to be done.
 LLPointer<LLVorbisDecodeState> beginDecodingAndWritingAudio(const LLUUID &decode_id);
 
-// Return true if finished
-bool tryFinishAudio(const LLUUID &decode_id, LLPointer<LLVorbisDecodeState> decode_state);
-
 void LLAudioDecodeMgr::Impl::processQueue()
 {
     // First, check if any audio from in-progress decodes are ready to play. If
@@ -698,6 +725,15 @@ LLPointer<LLVorbisDecodeState> beginDecodingAndWritingAudio(const LLUUID &decode
 
 void LLAudioDecodeMgr::Impl::enqueueFinishAudio(const LLUUID &decode_id, LLPointer<LLVorbisDecodeState>& decode_state)
 {
+    if (!decode_state)
+    {
+        // The decode failed.  Mark it so, rather than leaving it in mDecodes
+        // where it would hold one of the decode slots forever.
+        finishAudio(decode_id, LLAudioPCMCache::wav_ptr_t());
+        mDecodes.erase(decode_id);
+        return;
+    }
+
     // Assumed fast
     if (tryFinishAudio(decode_id, decode_state))
     {
@@ -730,38 +766,178 @@ void LLAudioDecodeMgr::Impl::checkDecodesFinished()
     }
 }
 
-bool tryFinishAudio(const LLUUID &decode_id, LLPointer<LLVorbisDecodeState> decode_state)
+bool LLAudioDecodeMgr::Impl::tryFinishAudio(const LLUUID &decode_id, LLPointer<LLVorbisDecodeState> decode_state)
 {
-    // decode_state is a file write in progress unless finished is true
-    bool finished = decode_state && decode_state->finishDecode();
-    if (!finished)
+    if (!decode_state)
     {
         return false;
     }
 
     llassert_always(gAudiop);
+    LLAudioPCMCache& pcm_cache = gAudiop->getPCMCache();
+    if (decode_state->finishDecode())
+    {
+        if (!decode_state->isPinned())
+        {
+            finishAudio(decode_id, decode_state->isValid() ? decode_state->getWAV() : LLAudioPCMCache::wav_ptr_t());
+        }
+        else if (decode_state->isValid())
+        {
+            // the .dsf is complete, LLAudioData::load() can fall back to it
+            pcm_cache.unpin(decode_id);
+        }
+        else
+        {
+            // the write failed, fail the decode like it would have if the
+            // sound hadn't been made playable early
+            pcm_cache.remove(decode_id);
+            finishAudio(decode_id, LLAudioPCMCache::wav_ptr_t());
+        }
+        return true;
+    }
+
+    // decode_state is a file write in progress.  Pin the image in the PCM
+    // cache until it's done, so the sound can be played without waiting for
+    // the write, and LLAudioData::load() never reads the unfinished .dsf.
+    // decode_state stays in mDecodes meanwhile, which also bounds how many
+    // pinned images there are.
+    if (!decode_state->isPinned())
+    {
+        LLAudioPCMCache::wav_ptr_t wav = decode_state->getWAV();
+        pcm_cache.put(decode_id, wav, true);
+        decode_state->setPinned();
+        finishAudio(decode_id, wav, true);
+    }
+    return false;
+}
+
+void LLAudioDecodeMgr::Impl::finishAudio(const LLUUID &decode_id, const LLAudioPCMCache::wav_ptr_t& wav, bool cached)
+{
+    llassert_always(gAudiop);
+
+    bool valid = (bool)wav;
+    if (valid && !cached)
+    {
+        gAudiop->getPCMCache().put(decode_id, wav);
+    }
+    benchmarkDecodeFinished(decode_id, valid);
 
     LLAudioData *adp = gAudiop->getAudioData(decode_id);
     if (!adp)
     {
         LL_WARNS("AudioEngine") << "Missing LLAudioData for decode of " << decode_id << LL_ENDL;
-        return true;
+        return;
     }
 
-    bool valid = decode_state && decode_state->isValid();
     // Mark current decode finished regardless of success or failure
     adp->setHasCompletedDecode(true);
     // Flip flags for decoded data
     adp->setHasDecodeFailed(!valid);
     adp->setHasDecodedData(valid);
-    // When finished decoding, there will also be a decoded wav file cached on
-    // disk with the .dsf extension
+    // When finished decoding, the decoded wav is in the PCM cache if it fit
+    // the budget, and is also cached on disk with the .dsf extension
     if (valid)
     {
         adp->setHasWAVLoadFailed(false);
     }
+}
 
-    return true;
+void LLAudioDecodeMgr::Impl::startBenchmark(const std::string& dir)
+{
+    if (!mBenchmarkStarts.empty())
+    {
+        LL_WARNS("Benchmark") << "Audio decode benchmark is already running" << LL_ENDL;
+        return;
+    }
+
+    // Put the sounds in the asset cache first, as if they had just been
+    // downloaded, so only the decodes are timed
+    std::vector<LLUUID> ids;
+    LLDirIterator dir_iter(dir, "*.ogg");
+    std::string name;
+    while (dir_iter.next(name))
+    {
+        llifstream in_file(gDirUtilp->add(dir, name).c_str(), std::ios::in | std::ios::binary);
+        std::vector<U8> data((std::istreambuf_iterator<char>(in_file)), std::istreambuf_iterator<char>());
+        if (data.empty())
+        {
+            continue;
+        }
+
+        LLUUID id;
+        id.generate();
+        LLFileSystem out_file(id, LLAssetType::AT_SOUND, LLFileSystem::WRITE);
+        if (out_file.write(&data[0], (S32)data.size()))
+        {
+            ids.push_back(id);
+        }
+    }
+    if (ids.empty())
+    {
+        LL_WARNS("Benchmark") << "No .ogg files to decode in '" << dir << "'" << LL_ENDL;
+        return;
+    }
+
+    LL_INFOS("Benchmark") << "Decoding " << ids.size() << " sounds from " << dir << LL_ENDL;
+    mBenchmarkLatencies.clear();
+    mBenchmarkFailures = 0;
+    mBenchmarkStartTime = LLTimer::getTotalSeconds();
+    for (const LLUUID& id : ids)
+    {
+        // Creates the LLAudioData that finishAudio() marks playable
+        gAudiop->getAudioData(id);
+        mBenchmarkStarts[id] = LLTimer::getTotalSeconds();
+        mDecodeQueue.push_back(id);
+    }
+}
+
+void LLAudioDecodeMgr::Impl::benchmarkDecodeFinished(const LLUUID &decode_id, bool valid)
+{
+    auto iter = mBenchmarkStarts.find(decode_id);
+    if (iter == mBenchmarkStarts.end())
+    {
+        return;
+    }
+
+    F64 now = LLTimer::getTotalSeconds();
+    if (valid)
+    {
+        mBenchmarkLatencies.push_back(now - iter->second);
+    }
+    else
+    {
+        mBenchmarkFailures++;
+    }
+    mBenchmarkStarts.erase(iter);
+    // The source was only copied in for the benchmark
+    LLFileSystem::removeFile(decode_id, LLAssetType::AT_SOUND);
+
+    if (!mBenchmarkStarts.empty())
+    {
+        return;
+    }
+
+    std::vector<F64>& latencies = mBenchmarkLatencies;
+    std::sort(latencies.begin(), latencies.end());
+    F64 total = 0.0;
+    for (F64 latency : latencies)
+    {
+        total += latency;
+    }
+    size_t count = latencies.size();
+    LL_INFOS("Benchmark") << "Audio decode: " << count << " sounds playable, " << mBenchmarkFailures << " failed, in "
+                          << llformat("%.1f", (now - mBenchmarkStartTime) * 1000.0) << "ms" << LL_ENDL;
+    if (count)
+    {
+        LL_INFOS("Benchmark") << "Request to playable: mean " << llformat("%.1f", total * 1000.0 / count)
+                              << "ms, median " << llformat("%.1f", latencies[count / 2] * 1000.0)
+                              << "ms, 95th percentile " << llformat("%.1f", latencies[count * 95 / 100] * 1000.0)
+                              << "ms, max " << llformat("%.1f", latencies.back() * 1000.0) << "ms" << LL_ENDL;
+    }
+    LLAudioPCMCache& pcm_cache = gAudiop->getPCMCache();
+    LL_INFOS("Benchmark") << "PCM cache holds " << pcm_cache.getCount() << " sounds, "
+                          << pcm_cache.getBytes() / 1024 << "KB of " << pcm_cache.getMaxBytes() / 1024 << "KB" << LL_ENDL;
+    latencies.clear();
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -782,6 +958,16 @@ void LLAudioDecodeMgr::processQueue()
     mImpl->processQueue();
 }
 
+void LLAudioDecodeMgr::startBenchmark(const std::string& dir)
+{
+    if (!gAudiop)
+    {
+        LL_WARNS("Benchmark") << "No audio engine, can't run the audio decode benchmark" << LL_ENDL;
+        return;
+    }
+    mImpl->startBenchmark(dir);
+}
+
 BOOL LLAudioDecodeMgr::addDecodeRequest(const LLUUID &uuid)
 {
 	if (gAudiop && gAudiop->hasDecodedFile(uuid))
@@ -45,6 +45,11 @@ public:
 	void processQueue();
 	BOOL addDecodeRequest(const LLUUID &uuid);
 	void addAudioRequest(const LLUUID &uuid);
+
+	// Decode every .ogg file in dir as if it had just been downloaded and
+	// log how long the sounds took from request to playable.  Results are
+	// logged from processQueue() once the last one is done.
+	void startBenchmark(const std::string& dir);
 	
 protected:
 	class Impl;
@@ -974,6 +974,11 @@ void LLAudioEngine::cleanupAudioSource(LLAudioSource *asp)
 
 bool LLAudioEngine::hasDecodedFile(const LLUUID &uuid)
 {
+	if (mPCMCache.contains(uuid))
+	{
+		return true;
+	}
+
 	std::string uuid_str;
 	uuid.toString(uuid_str);
 
@@ -1827,12 +1832,20 @@ bool LLAudioData::load()
 		return true;
 	}
 
-	std::string uuid_str;
-	std::string wav_path;
-	mID.toString(uuid_str);
-	wav_path= gDirUtilp->getExpandedFilename(LL_PATH_CACHE,uuid_str) + ".dsf";
+	LLAudioPCMCache::wav_ptr_t wav = gAudiop->getPCMCache().get(mID);
+	if (wav)
+	{
+		mHasWAVLoadFailed = !mBufferp->loadWAVFromMemory(&(*wav)[0], (U32)wav->size());
+	}
+	else
+	{
+		std::string uuid_str;
+		std::string wav_path;
+		mID.toString(uuid_str);
+		wav_path= gDirUtilp->getExpandedFilename(LL_PATH_CACHE,uuid_str) + ".dsf";
 
-    mHasWAVLoadFailed = !mBufferp->loadWAV(wav_path);
+		mHasWAVLoadFailed = !mBufferp->loadWAV(wav_path);
+	}
     if (mHasWAVLoadFailed)
 	{
 		// Hrm.  Right now, let's unset the buffer, since it's empty.
@@ -38,6 +38,7 @@
 #include "llframetimer.h"
 #include "llassettype.h"
 #include "llextendedstatus.h"
+#include "llaudiopcmcache.h"
 
 #include "lllistener.h"
 
@@ -163,9 +164,11 @@ public:
 	LLAudioChannel *getFreeChannel(const F32 priority); // Get a free channel or flush an existing one if your priority is higher
 	void cleanupBuffer(LLAudioBuffer *bufferp);
 
-	bool hasDecodedFile(const LLUUID &uuid);
+	bool hasDecodedFile(const LLUUID &uuid);	// in mPCMCache or on disk
 	bool hasLocalFile(const LLUUID &uuid);
 
+	LLAudioPCMCache& getPCMCache()				{ return mPCMCache; }
+
 	bool updateBufferForData(LLAudioData *adp, const LLUUID &audio_uuid = LLUUID::null);
 
 
@@ -223,6 +226,8 @@ protected:
 	source_map mAllSources;
 	data_map mAllData;
 
+	LLAudioPCMCache mPCMCache;
+
     std::array<LLAudioChannel*, LL_MAX_AUDIO_CHANNELS> mChannels;
 
 	// Buffers needs to change into a different data structure, as the number of buffers
@@ -445,6 +450,8 @@ class LLAudioBuffer
 public:
 	virtual ~LLAudioBuffer() {};
 	virtual bool loadWAV(const std::string& filename) = 0;
+	// Load a complete WAV image, copying it
+	virtual bool loadWAVFromMemory(const U8* data, U32 size) = 0;
 	virtual U32 getLength() = 0;
 
 	friend class LLAudioEngine;
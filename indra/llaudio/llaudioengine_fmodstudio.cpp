@@ -701,6 +701,40 @@ bool LLAudioBufferFMODSTUDIO::loadWAV(const std::string& filename)
 }
 
 
+bool LLAudioBufferFMODSTUDIO::loadWAVFromMemory(const U8* data, U32 size)
+{
+    if (!data || !size)
+    {
+        return false;
+    }
+
+    if (mSoundp)
+    {
+        // If there's already something loaded in this buffer, clean it up.
+        mSoundp->release();
+        mSoundp = NULL;
+    }
+
+    // FMOD_OPENMEMORY copies the data, so the image can go away after this
+    FMOD_MODE base_mode = FMOD_LOOP_NORMAL | FMOD_OPENMEMORY;
+    FMOD_CREATESOUNDEXINFO exinfo;
+    memset(&exinfo, 0, sizeof(exinfo));
+    exinfo.cbsize = sizeof(exinfo);
+    exinfo.length = size;
+    exinfo.suggestedsoundtype = FMOD_SOUND_TYPE_WAV;	//Hint to speed up loading.
+    FMOD_RESULT result = getSystem()->createSound((const char*)data, base_mode, &exinfo, &mSoundp);
+
+    if (result != FMOD_OK)
+    {
+        LL_WARNS() << "Could not load decoded data from memory: " << FMOD_ErrorString(result) << LL_ENDL;
+        mSoundp = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+
 U32 LLAudioBufferFMODSTUDIO::getLength()
 {
     if (!mSoundp)
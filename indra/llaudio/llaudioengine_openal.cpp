@@ -360,6 +360,21 @@ bool LLAudioBufferOpenAL::loadWAV(const std::string& filename)
 	return true;
 }
 
+bool LLAudioBufferOpenAL::loadWAVFromMemory(const U8* data, U32 size)
+{
+	cleanup();
+	mALBuffer = alutCreateBufferFromFileImage(data, (ALsizei)size);
+	if(mALBuffer == AL_NONE)
+	{
+		ALenum error = alutGetError(); 
+		LL_WARNS() << "LLAudioBufferOpenAL::loadWAVFromMemory() Error loading decoded data "
+				   << alutGetErrorString(error) << LL_ENDL;
+		return false;
+	}
+
+	return true;
+}
+
 U32 LLAudioBufferOpenAL::getLength()
 {
 	if(mALBuffer == AL_NONE)
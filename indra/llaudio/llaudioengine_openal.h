@@ -95,6 +95,7 @@ class LLAudioBufferOpenAL : public LLAudioBuffer{
 		virtual ~LLAudioBufferOpenAL();
 
 		bool loadWAV(const std::string& filename);
+		bool loadWAVFromMemory(const U8* data, U32 size);
 		U32 getLength();
 
 		friend class LLAudioChannelOpenAL;
@@ -0,0 +1,182 @@
+/**
+ * @file llaudiopcmcache.cpp
+ * @brief Recently decoded sounds kept in memory
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llaudiopcmcache.h"
+
+LLAudioPCMCache::LLAudioPCMCache(U64 max_bytes)
+    : mBytes(0),
+      mMaxBytes(max_bytes)
+{
+}
+
+void LLAudioPCMCache::setMaxBytes(U64 max_bytes)
+{
+    LLMutexLock lock(&mMutex);
+    mMaxBytes = max_bytes;
+    trim();
+}
+
+bool LLAudioPCMCache::put(const LLUUID& id, const wav_ptr_t& wav, bool pinned)
+{
+    if (!wav)
+    {
+        return false;
+    }
+
+    LLMutexLock lock(&mMutex);
+    auto iter = mEntryMap.find(id);
+    if (iter != mEntryMap.end())
+    {
+        // replacing the image doesn't end a pin
+        pinned = pinned || iter->second->mPinned;
+        erase(iter->second);
+    }
+
+    if (!pinned && wav->size() > mMaxBytes)
+    {
+        return false;
+    }
+
+    mEntries.push_front(Entry{ id, wav, pinned });
+    mEntryMap[id] = mEntries.begin();
+    if (!pinned)
+    {
+        mBytes += wav->size();
+        trim();
+    }
+    return mEntryMap.find(id) != mEntryMap.end();
+}
+
+void LLAudioPCMCache::unpin(const LLUUID& id)
+{
+    LLMutexLock lock(&mMutex);
+    auto iter = mEntryMap.find(id);
+    if (iter == mEntryMap.end() || !iter->second->mPinned)
+    {
+        return;
+    }
+
+    if (iter->second->mWAV->size() > mMaxBytes)
+    {
+        // rather than trim() everything else before it
+        erase(iter->second);
+        return;
+    }
+
+    iter->second->mPinned = false;
+    mBytes += iter->second->mWAV->size();
+    trim();
+}
+
+LLAudioPCMCache::wav_ptr_t LLAudioPCMCache::get(const LLUUID& id)
+{
+    LLMutexLock lock(&mMutex);
+    auto iter = mEntryMap.find(id);
+    if (iter == mEntryMap.end())
+    {
+        return wav_ptr_t();
+    }
+
+    mEntries.splice(mEntries.begin(), mEntries, iter->second);
+    return iter->second->mWAV;
+}
+
+bool LLAudioPCMCache::contains(const LLUUID& id) const
+{
+    LLMutexLock lock(&mMutex);
+    return mEntryMap.find(id) != mEntryMap.end();
+}
+
+void LLAudioPCMCache::remove(const LLUUID& id)
+{
+    LLMutexLock lock(&mMutex);
+    auto iter = mEntryMap.find(id);
+    if (iter != mEntryMap.end())
+    {
+        erase(iter->second);
+    }
+}
+
+void LLAudioPCMCache::clear()
+{
+    LLMutexLock lock(&mMutex);
+    for (auto iter = mEntries.begin(); iter != mEntries.end(); )
+    {
+        auto next = std::next(iter);
+        if (!iter->mPinned)
+        {
+            erase(iter);
+        }
+        iter = next;
+    }
+}
+
+U64 LLAudioPCMCache::getBytes() const
+{
+    LLMutexLock lock(&mMutex);
+    return mBytes;
+}
+
+U64 LLAudioPCMCache::getMaxBytes() const
+{
+    LLMutexLock lock(&mMutex);
+    return mMaxBytes;
+}
+
+size_t LLAudioPCMCache::getCount() const
+{
+    LLMutexLock lock(&mMutex);
+    return mEntries.size();
+}
+
+void LLAudioPCMCache::trim()
+{
+    auto iter = mEntries.end();
+    while (mBytes > mMaxBytes && iter != mEntries.begin())
+    {
+        --iter;
+        if (!iter->mPinned)
+        {
+            // --iter from the entry after it goes on to the next more
+            // recently used one
+            auto next = std::next(iter);
+            erase(iter);
+            iter = next;
+        }
+    }
+}
+
+void LLAudioPCMCache::erase(entry_list_t::iterator iter)
+{
+    if (!iter->mPinned)
+    {
+        mBytes -= iter->mWAV->size();
+    }
+    mEntryMap.erase(iter->mID);
+    mEntries.erase(iter);
+}
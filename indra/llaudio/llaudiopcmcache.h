@@ -0,0 +1,99 @@
+/**
+ * @file llaudiopcmcache.h
+ * @brief Recently decoded sounds kept in memory
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLAUDIOPCMCACHE_H
+#define LL_LLAUDIOPCMCACHE_H
+
+#include "llmutex.h"
+#include "lluuid.h"
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The decoded WAV images of recently decoded or played sounds, least
+ * recently used dropped first once the total goes over a byte budget.
+ * LLAudioDecodeMgr adds sounds as soon as they're decoded, so they can be
+ * played before the .dsf copy reaches the disk, and LLAudioData::load()
+ * loads buffers from here when it can instead of reading the file back.
+ *
+ * Images are shared, not copied: an image handed out by get() stays valid
+ * after it's dropped from the cache.  A pinned image is never dropped, and
+ * doesn't count against the budget, until it's unpinned; LLAudioDecodeMgr
+ * pins each image until its .dsf write is done.  All methods are thread
+ * safe.
+ */
+class LLAudioPCMCache
+{
+public:
+    typedef std::shared_ptr<const std::vector<U8> > wav_ptr_t;
+
+    LLAudioPCMCache(U64 max_bytes = 64 * 1024 * 1024);
+
+    void setMaxBytes(U64 max_bytes);
+
+    // Returns whether the image was kept.  Unpinned images bigger than the
+    // whole budget aren't.
+    bool put(const LLUUID& id, const wav_ptr_t& wav, bool pinned = false);
+    // Let the image be dropped like any other
+    void unpin(const LLUUID& id);
+    // The image and mark it most recently used, or an empty pointer
+    wav_ptr_t get(const LLUUID& id);
+    bool contains(const LLUUID& id) const;
+    void remove(const LLUUID& id);
+    // Drop everything but pinned images
+    void clear();
+
+    // Bytes held against the budget, not counting pinned images
+    U64 getBytes() const;
+    U64 getMaxBytes() const;
+    size_t getCount() const;
+
+private:
+    struct Entry
+    {
+        LLUUID mID;
+        wav_ptr_t mWAV;
+        bool mPinned;
+    };
+    typedef std::list<Entry> entry_list_t;
+
+    // Drop least recently used unpinned images until within budget.  mMutex
+    // must be held.
+    void trim();
+    // mMutex must be held
+    void erase(entry_list_t::iterator iter);
+
+    mutable LLMutex mMutex;
+    entry_list_t mEntries;  // most recently used first
+    std::unordered_map<LLUUID, entry_list_t::iterator> mEntryMap;
+    U64 mBytes;
+    U64 mMaxBytes;
+};
+
+#endif // LL_LLAUDIOPCMCACHE_H
@@ -428,6 +428,9 @@ void LLApp::setErrorHandler(LLAppErrorHandler handler)
 // static
 void LLApp::runErrorHandler()
 {
+	// get any queued log messages into the log before we report the crash
+	LLError::flushLog();
+
 	if (LLApp::sErrorHandler)
 	{
 		LLApp::sErrorHandler();
@@ -35,7 +35,9 @@
 // STL headers
 // std headers
 #include <atomic>
+#include <mutex>
 #include <stdexcept>
+#include <vector>
 // external library headers
 #include <boost/bind.hpp>
 #include <boost/fiber/fiber.hpp>
@@ -61,6 +63,150 @@
 #include <excpt.h>
 #endif
 
+/*****************************************************************************
+*   LLCoros::StackPool
+*****************************************************************************/
+// Mapping a fresh guarded stack costs a couple of system calls plus page
+// faults as the new stack is touched, and unmapping it costs a TLB
+// shootdown. Viewer coroutines are mostly short-lived (one per capability
+// request), so we keep a bounded number of stacks from terminated coroutines
+// and hand them to the next launch(). Fibers run on whichever thread
+// launched them, so the pool is shared and locked.
+class LLCoros::StackPool
+{
+public:
+    StackPool(size_t stacksize, size_t maxidle):
+        mStackSize(stacksize)
+    {
+        setMaxIdle(maxidle);
+    }
+
+    ~StackPool()
+    {
+        // Nobody else can be holding a reference now.
+        for (auto& sctx : mIdle)
+        {
+            release(mStackSize, sctx);
+        }
+    }
+
+    /// StackAllocator passed to boost::fibers::fiber: stacks come from (and
+    /// go back to) the pool, while protected_fixedsize_stack still supplies
+    /// the guard page for each one.
+    class Allocator
+    {
+    public:
+        Allocator(const std::shared_ptr<StackPool>& pool, size_t stacksize):
+            mPool(pool),
+            mStackSize(stacksize)
+        {}
+
+        boost::context::stack_context allocate()
+        {
+            return mPool->allocate(mStackSize);
+        }
+
+        void deallocate(boost::context::stack_context& sctx) noexcept
+        {
+            mPool->deallocate(mStackSize, sctx);
+        }
+
+    private:
+        std::shared_ptr<StackPool> mPool;
+        size_t mStackSize;
+    };
+
+    boost::context::stack_context allocate(size_t stacksize)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (stacksize == mStackSize && ! mIdle.empty())
+            {
+                boost::context::stack_context sctx(mIdle.back());
+                mIdle.pop_back();
+                ++mStats.mReused;
+                return sctx;
+            }
+            ++mStats.mAllocated;
+        }
+        return boost::fibers::protected_fixedsize_stack(stacksize).allocate();
+    }
+
+    void deallocate(size_t stacksize, boost::context::stack_context& sctx) noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            // mIdle's capacity is reserved in setMaxIdle(), so push_back()
+            // cannot throw here
+            if (stacksize == mStackSize && mIdle.size() < mMaxIdle)
+            {
+                mIdle.push_back(sctx);
+                return;
+            }
+        }
+        release(stacksize, sctx);
+    }
+
+    void setStackSize(size_t stacksize)
+    {
+        std::vector<boost::context::stack_context> stale;
+        size_t oldsize;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            oldsize = mStackSize;
+            mStackSize = stacksize;
+            // copy rather than swap so mIdle keeps its reserved capacity
+            stale.assign(mIdle.begin(), mIdle.end());
+            mIdle.clear();
+        }
+        for (auto& sctx : stale)
+        {
+            release(oldsize, sctx);
+        }
+    }
+
+    void setMaxIdle(size_t maxidle)
+    {
+        std::vector<boost::context::stack_context> excess;
+        size_t stacksize;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mMaxIdle = maxidle;
+            mIdle.reserve(maxidle);
+            while (mIdle.size() > maxidle)
+            {
+                excess.push_back(mIdle.back());
+                mIdle.pop_back();
+            }
+            stacksize = mStackSize;
+        }
+        for (auto& sctx : excess)
+        {
+            release(stacksize, sctx);
+        }
+    }
+
+    StackPoolStats getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        StackPoolStats stats(mStats);
+        stats.mIdle = mIdle.size();
+        return stats;
+    }
+
+private:
+    static void release(size_t stacksize, boost::context::stack_context& sctx) noexcept
+    {
+        boost::fibers::protected_fixedsize_stack(stacksize).deallocate(sctx);
+    }
+
+    mutable std::mutex mMutex;
+    std::vector<boost::context::stack_context> mIdle;
+    size_t mStackSize;
+    size_t mMaxIdle{ 0 };
+    StackPoolStats mStats;
+};
+
 // static
 LLCoros::CoroData& LLCoros::get_CoroData(const std::string& caller)
 {
@@ -128,6 +274,9 @@ LLCoros::LLCoros():
 #else
     mStackSize(256*1024),
 #endif
+    // A few dozen idle stacks covers the bursts of capability requests we
+    // see at login and region crossing without holding much memory.
+    mStackPool(std::make_shared<StackPool>(mStackSize, 32)),
     // mCurrent does NOT own the current CoroData instance -- it simply
     // points to it. So initialize it with a no-op deleter.
     mCurrent{ [](CoroData*){} }
@@ -181,7 +330,7 @@ std::string LLCoros::generateDistinctName(const std::string& prefix) const
     // Until we find an unused name, append a numeric suffix for uniqueness.
     while (CoroData::getInstance(name))
     {
-        name = STRINGIZE(prefix << unique++);
+        name = prefix + std::to_string(unique++);
     }
     return name;
 }
@@ -235,6 +384,18 @@ void LLCoros::setStackSize(S32 stacksize)
 {
     LL_DEBUGS("LLCoros") << "Setting coroutine stack size to " << stacksize << LL_ENDL;
     mStackSize = stacksize;
+    mStackPool->setStackSize(stacksize);
+}
+
+void LLCoros::setStackPoolSize(size_t count)
+{
+    LL_DEBUGS("LLCoros") << "Setting coroutine stack pool size to " << count << LL_ENDL;
+    mStackPool->setMaxIdle(count);
+}
+
+LLCoros::StackPoolStats LLCoros::getStackPoolStats() const
+{
+    return mStackPool->getStats();
 }
 
 void LLCoros::printActiveCoroutines(const std::string& when)
@@ -263,15 +424,17 @@ std::string LLCoros::launch(const std::string& prefix, const callable_t& callabl
     // when the fiber yields for whatever reason.
     // std::allocator_arg is a flag to indicate that the following argument is
     // a StackAllocator.
-    // protected_fixedsize_stack sets a guard page past the end of the new
-    // stack so that stack underflow will result in an access violation
-    // instead of weird, subtle, possibly undiagnosed memory stomps.
+    // StackPool::Allocator recycles stacks of terminated coroutines; fresh
+    // ones come from protected_fixedsize_stack, which sets a guard page past
+    // the end of the new stack so that stack underflow will result in an
+    // access violation instead of weird, subtle, possibly undiagnosed memory
+    // stomps.
 
     try
     {
         boost::fibers::fiber newCoro(boost::fibers::launch::dispatch,
             std::allocator_arg,
-            boost::fibers::protected_fixedsize_stack(mStackSize),
+            StackPool::Allocator(mStackPool, mStackSize),
             [this, &name, &callable]() { toplevel(name, callable); });
 
         // You have two choices with a fiber instance: you can join() it or you
@@ -39,6 +39,7 @@
 #include <boost/function.hpp>
 #include <string>
 #include <exception>
+#include <memory>
 #include <queue>
 
 // e.g. #include LLCOROS_MUTEX_HEADER
@@ -186,6 +187,23 @@ public:
      */
     void setStackSize(S32 stacksize);
 
+    /**
+     * Stacks of terminated coroutines are kept for reuse by the next
+     * launch() rather than being unmapped and mapped again. This sets how
+     * many idle stacks may be retained; 0 disables pooling. Like
+     * setStackSize(), this is for delayed initialization.
+     */
+    void setStackPoolSize(size_t count);
+
+    /// diagnostic counters for the coroutine stack pool
+    struct StackPoolStats
+    {
+        U64 mAllocated{ 0 };        // stacks freshly mapped
+        U64 mReused{ 0 };           // launches served from the pool
+        size_t mIdle{ 0 };          // stacks currently waiting for reuse
+    };
+    StackPoolStats getStackPoolStats() const;
+
     /// diagnostic
     void printActiveCoroutines(const std::string& when=std::string());
 
@@ -331,6 +349,11 @@ private:
 
     S32 mStackSize;
 
+    // Idle coroutine stacks. Each launched fiber's allocator holds a
+    // reference, so a fiber that outlives LLCoros can still return its stack.
+    class StackPool;
+    std::shared_ptr<StackPool> mStackPool;
+
     // coroutine-local storage, as it were: one per coro we track
     struct CoroData: public LLInstanceTracker<CoroData, std::string>
     {
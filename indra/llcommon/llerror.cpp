@@ -31,7 +31,14 @@
 #include "llerrorcontrol.h"
 #include "llsdutil.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 #ifdef __GNUC__
 # include <cxxabi.h>
 #endif // __GNUC__
@@ -688,6 +695,8 @@ namespace LLError
 
 	CallSite::~CallSite()
 	{
+		// async log entries may still refer to this CallSite
+		flushLog();
 		delete []mTags;
 	}
 
@@ -935,6 +944,10 @@ namespace LLError
         {
             setEnabledLogTypesMask(config["enabled-log-types-mask"].asInteger());
         }
+        if (config.has("async-logging"))
+        {
+            setAsyncLogging(config["async-logging"].asBoolean());
+        }
         
         if (config.has("settings") && config["settings"].isArray())
         {
@@ -1056,6 +1069,8 @@ namespace LLError
 		{
 			return;
 		}
+		// let the recorder see anything already queued for it
+		flushLog();
 		SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
 		LLMutexLock lock(&s->mRecorderMutex);
 		s->mRecorders.erase(std::remove(s->mRecorders.begin(), s->mRecorders.end(), recorder),
@@ -1116,6 +1131,7 @@ namespace LLError
     template <typename RECORDER>
     bool removeRecorder()
     {
+        flushLog();
         SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
         LLMutexLock lock(&s->mRecorderMutex);
         auto found = findRecorderPos<RECORDER>(s);
@@ -1215,7 +1231,15 @@ namespace
         return out.str();
     }
 
-	void writeToRecorders(const LLError::CallSite& site, const std::string& message)
+    std::string currentTime(const SettingsConfigPtr& s)
+    {
+        return s->mTimeFunction ? s->mTimeFunction() : std::string();
+    }
+
+	// 'time' is captured when the message is logged, which for async logging
+	// may be a little before it is written.
+	void writeToRecorders(const LLError::CallSite& site, const std::string& message,
+						  const std::string& time)
 	{
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LOGGING
 		LLError::ELevel level = site.mLevel;
@@ -1237,9 +1261,9 @@ namespace
             
 			std::ostringstream message_stream;
 
-			if (r->wantsTime() && s->mTimeFunction != NULL)
+			if (r->wantsTime())
 			{
-				message_stream << s->mTimeFunction();
+				message_stream << time;
 			}
             message_stream << " ";
             
@@ -1285,6 +1309,363 @@ namespace
 	}
 }
 
+namespace
+{
+    // One message waiting for the async writer thread. The CallSite is a
+    // function-static in the logging macro; ~CallSite() flushes the queue,
+    // so mSite cannot dangle even during static destruction.
+    struct LogEntry
+    {
+        U64                      mSequence;
+        const LLError::CallSite* mSite;
+        std::string              mTime;
+        std::string              mMessage;
+    };
+
+    // Bounded single-producer/single-consumer ring: the owning thread pushes,
+    // the writer thread pops. Neither side takes a lock.
+    class ThreadLogBuffer
+    {
+    public:
+        static const size_t CAPACITY = 1024;
+
+        ThreadLogBuffer(): mHead(0), mTail(0), mOrphaned(false) {}
+
+        // returns false (and leaves entry alone) if the ring is full
+        bool push(LogEntry& entry)
+        {
+            size_t tail = mTail.load(std::memory_order_relaxed);
+            if (tail - mHead.load(std::memory_order_acquire) >= CAPACITY)
+            {
+                return false;
+            }
+            std::swap(mEntries[tail % CAPACITY], entry);
+            mTail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        size_t size() const
+        {
+            return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_acquire);
+        }
+
+        // move everything currently queued to the end of 'out'
+        void popAll(std::vector<LogEntry>& out)
+        {
+            size_t head = mHead.load(std::memory_order_relaxed);
+            size_t tail = mTail.load(std::memory_order_acquire);
+            for ( ; head != tail; ++head)
+            {
+                out.push_back(LogEntry());
+                std::swap(out.back(), mEntries[head % CAPACITY]);
+            }
+            mHead.store(head, std::memory_order_release);
+        }
+
+        // set when the owning thread exits
+        std::atomic<bool> mOrphaned;
+
+    private:
+        LogEntry mEntries[CAPACITY];
+        std::atomic<size_t> mHead;
+        std::atomic<size_t> mTail;
+    };
+    typedef std::shared_ptr<ThreadLogBuffer> ThreadLogBufferPtr;
+
+    class AsyncLogger
+    {
+    public:
+        // Never destroyed: the writer thread is stopped by an atexit()
+        // handler, and late logging during static destruction must still
+        // find a valid (if stopped) object.
+        static AsyncLogger& instance()
+        {
+            static AsyncLogger* sInstance = new AsyncLogger;
+            return *sInstance;
+        }
+
+        bool running() const { return mRunning.load(std::memory_order_acquire); }
+
+        void start()
+        {
+            std::lock_guard<std::mutex> lock(mControlMutex);
+            if (running())
+            {
+                return;
+            }
+            static bool sRegisteredAtExit = false;
+            if (!sRegisteredAtExit)
+            {
+                sRegisteredAtExit = true;
+                std::atexit([](){ AsyncLogger::instance().stop(); });
+            }
+            mRunning.store(true, std::memory_order_release);
+            mThread = std::thread([this](){ run(); });
+        }
+
+        void stop()
+        {
+            std::lock_guard<std::mutex> lock(mControlMutex);
+            if (!running())
+            {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> wake(mWakeMutex);
+                // seq_cst, pairs with mPosting in post()
+                mRunning.store(false);
+            }
+            mWake.notify_one();
+            if (onWriterThread())
+            {
+                // stopped from within a recorder: can't join ourselves
+                mThread.detach();
+            }
+            else
+            {
+                mThread.join();
+            }
+            // a post() that saw us still running may not have pushed yet
+            while (mPosting.load())
+            {
+                std::this_thread::yield();
+            }
+            // anything posted while we were shutting down
+            drain();
+        }
+
+        // Queue a message for the writer thread. Returns false if async
+        // logging is off, in which case the caller should write it directly.
+        bool post(const LLError::CallSite& site, std::string& message, std::string& time)
+        {
+            // seq_cst with the mRunning store in stop(): either we see the
+            // writer stopping and write directly, or stop() waits for this
+            // entry before its last drain()
+            PostingCount posting(mPosting);
+            if (!mRunning.load())
+            {
+                return false;
+            }
+            ThreadLogBuffer& buffer(getThreadBuffer());
+            LogEntry entry;
+            entry.mSequence = mNextSequence.fetch_add(1, std::memory_order_relaxed);
+            entry.mSite = &site;
+            entry.mTime.swap(time);
+            entry.mMessage.swap(message);
+            if (!buffer.push(entry))
+            {
+                mDropped.fetch_add(1, std::memory_order_relaxed);
+                // still "handled": the caller must not block on I/O instead
+                return true;
+            }
+            mPosted.fetch_add(1, std::memory_order_release);
+            if (buffer.size() == ThreadLogBuffer::CAPACITY / 2)
+            {
+                // getting full -- don't wait for the writer's next poll
+                wakeWriter();
+            }
+            return true;
+        }
+
+        // Wait until everything posted before this call has been written.
+        void flush()
+        {
+            if (!running() || onWriterThread())
+            {
+                return;
+            }
+            U64 target = mPosted.load(std::memory_order_acquire);
+            if (mWritten.load(std::memory_order_acquire) >= target)
+            {
+                return;
+            }
+            // no mutex here: this runs on the crash path, where the crashed
+            // thread may be holding one
+            wakeWriter();
+            // bounded, so a wedged recorder can't hang a crashing viewer
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+            while (mWritten.load(std::memory_order_acquire) < target && running()
+                   && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        U64 getDropped() const { return mDropped.load(std::memory_order_relaxed); }
+
+    private:
+        AsyncLogger():
+            mRunning(false),
+            mPosting(0),
+            mNextSequence(0),
+            mPosted(0),
+            mDropped(0),
+            mReportedDropped(0),
+            mWritten(0),
+            mWakeRequested(false)
+        {}
+
+        // counts the post() calls in progress for stop()
+        struct PostingCount
+        {
+            std::atomic<U32>& mCount;
+            PostingCount(std::atomic<U32>& count): mCount(count) { mCount.fetch_add(1); }
+            ~PostingCount() { mCount.fetch_sub(1); }
+        };
+
+        // Lock free, so it's safe from post() and the crash path. A wakeup
+        // that races the writer going back to sleep is caught by its poll.
+        void wakeWriter()
+        {
+            mWakeRequested.store(true, std::memory_order_release);
+            mWake.notify_one();
+        }
+
+        // Each thread's buffer is shared between a thread_local holder and
+        // mBuffers, so entries queued just before the thread exits are still
+        // written; the writer discards the buffer once it's orphaned and empty.
+        struct BufferHolder
+        {
+            ThreadLogBufferPtr mBuffer;
+            ~BufferHolder()
+            {
+                if (mBuffer)
+                {
+                    mBuffer->mOrphaned.store(true, std::memory_order_release);
+                }
+            }
+        };
+
+        ThreadLogBuffer& getThreadBuffer()
+        {
+            static thread_local BufferHolder tHolder;
+            if (!tHolder.mBuffer)
+            {
+                tHolder.mBuffer = std::make_shared<ThreadLogBuffer>();
+                std::lock_guard<std::mutex> lock(mBuffersMutex);
+                mBuffers.push_back(tHolder.mBuffer);
+            }
+            return *tHolder.mBuffer;
+        }
+
+        bool onWriterThread() const
+        {
+            return mWriterId.load(std::memory_order_acquire) == std::this_thread::get_id();
+        }
+
+        void run()
+        {
+            LL_PROFILER_SET_THREAD_NAME("LogWriter");
+            mWriterId.store(std::this_thread::get_id(), std::memory_order_release);
+            while (running())
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mWakeMutex);
+                    mWake.wait_for(lock, std::chrono::milliseconds(10),
+                                   [this](){ return mWakeRequested.load(std::memory_order_acquire) || !running(); });
+                    mWakeRequested.store(false, std::memory_order_relaxed);
+                }
+                drain();
+            }
+        }
+
+        void drain()
+        {
+            LL_PROFILE_ZONE_SCOPED_CATEGORY_LOGGING
+            std::vector<ThreadLogBufferPtr> buffers;
+            {
+                std::lock_guard<std::mutex> lock(mBuffersMutex);
+                // drop buffers whose threads have gone and which we emptied
+                mBuffers.erase(std::remove_if(mBuffers.begin(), mBuffers.end(),
+                                              [](const ThreadLogBufferPtr& buffer)
+                                              {
+                                                  return buffer->mOrphaned.load(std::memory_order_acquire)
+                                                      && !buffer->size();
+                                              }),
+                               mBuffers.end());
+                buffers = mBuffers;
+            }
+
+            mBatch.clear();
+            for (const ThreadLogBufferPtr& buffer : buffers)
+            {
+                buffer->popAll(mBatch);
+            }
+            // interleave the per-thread queues back into logging order
+            std::sort(mBatch.begin(), mBatch.end(),
+                      [](const LogEntry& a, const LogEntry& b){ return a.mSequence < b.mSequence; });
+            for (const LogEntry& entry : mBatch)
+            {
+                writeToRecorders(*entry.mSite, entry.mMessage, entry.mTime);
+            }
+
+            mWritten.fetch_add(mBatch.size(), std::memory_order_release);
+
+            U64 dropped = mDropped.load(std::memory_order_relaxed);
+            if (dropped != mReportedDropped)
+            {
+                // goes through our own queue like any other message
+                LL_WARNS("LLError") << (dropped - mReportedDropped)
+                                    << " log messages dropped: queue full" << LL_ENDL;
+                mReportedDropped = dropped;
+            }
+        }
+
+        std::atomic<bool>               mRunning;
+        std::atomic<U32>                mPosting;
+        std::mutex                      mControlMutex;
+        std::thread                     mThread;
+        std::atomic<std::thread::id>    mWriterId;
+
+        std::mutex                      mBuffersMutex;
+        std::vector<ThreadLogBufferPtr> mBuffers;
+        // only touched by the writer thread (or by stop() after join)
+        std::vector<LogEntry>           mBatch;
+
+        std::atomic<U64>                mNextSequence;
+        std::atomic<U64>                mPosted;
+        std::atomic<U64>                mDropped;
+        U64                             mReportedDropped;
+
+        // the writer sleeps on mWake under mWakeMutex; nothing else holds it
+        // except stop()
+        std::mutex                      mWakeMutex;
+        std::condition_variable         mWake;
+        std::atomic<U64>                mWritten;
+        std::atomic<bool>               mWakeRequested;
+    };
+} // anonymous namespace
+
+namespace LLError
+{
+    void setAsyncLogging(bool async)
+    {
+        if (async)
+        {
+            AsyncLogger::instance().start();
+        }
+        else
+        {
+            AsyncLogger::instance().stop();
+        }
+    }
+
+    bool getAsyncLogging()
+    {
+        return AsyncLogger::instance().running();
+    }
+
+    void flushLog()
+    {
+        AsyncLogger::instance().flush();
+    }
+
+    U64 getDroppedLogCount()
+    {
+        return AsyncLogger::instance().getDropped();
+    }
+}
+
 namespace {
 	// We need a couple different mutexes, but we want to use the same mechanism
 	// for both. Make getMutex() a template function with different instances
@@ -1398,12 +1779,6 @@ namespace LLError
 	void Log::flush(const std::ostringstream& out, const CallSite& site)
 	{
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LOGGING
-		LLMutexTrylock lock(getMutex<LOG_MUTEX>(),5);
-		if (!lock.isLocked())
-		{
-			return;
-		}
-
 		Globals* g = Globals::getInstance();
 		SettingsConfigPtr s = g->getSettingsConfig();
 
@@ -1411,6 +1786,12 @@ namespace LLError
 
 		if (site.mPrintOnce)
 		{
+			LLMutexTrylock lock(getMutex<LOG_MUTEX>(),5);
+			if (!lock.isLocked())
+			{
+				return;
+			}
+
 			std::ostringstream message_stream;
 
 			std::map<std::string, unsigned int>::iterator messageIter = s->mUniqueLogMessages.find(message);
@@ -1435,8 +1816,29 @@ namespace LLError
 			message_stream << message;
 			message = message_stream.str();
 		}
-		
-		writeToRecorders(site, message);
+
+		std::string time = currentTime(s);
+		AsyncLogger& async(AsyncLogger::instance());
+		if (site.mLevel != LEVEL_ERROR)
+		{
+			if (async.post(site, message, time))
+			{
+				return;
+			}
+		}
+		else
+		{
+			// make sure everything leading up to the error is written first
+			async.flush();
+		}
+
+		LLMutexTrylock lock(getMutex<LOG_MUTEX>(),5);
+		if (!lock.isLocked())
+		{
+			return;
+		}
+
+		writeToRecorders(site, message, time);
 
 		if (site.mLevel == LEVEL_ERROR)
 		{
@@ -228,6 +228,20 @@ namespace LLError
 	LL_COMMON_API std::string logFileName();
 		// returns name of current logging file, empty string if none
 
+	LL_COMMON_API void setAsyncLogging(bool async);
+	LL_COMMON_API bool getAsyncLogging();
+		// When enabled, messages below LEVEL_ERROR are queued in bounded
+		// per-thread buffers and passed to the recorders by a dedicated
+		// writer thread, so the logging thread never waits on file or
+		// console I/O. A LEVEL_ERROR message first flushes the queue and is
+		// then written synchronously, before the fatal function runs.
+		// Disabling async logging writes out anything still queued.
+	LL_COMMON_API void flushLog();
+		// Wait (briefly) until every queued message has been written.
+		// No-op unless async logging is enabled.
+	LL_COMMON_API U64 getDroppedLogCount();
+		// Messages discarded because a thread's queue was full.
+
 
 	/*
 		Utilities for use by the unit tests of LLError itself.
@@ -0,0 +1,254 @@
+/**
+ * @file   lleventchannel.h
+ * @date   2023-03-13
+ * @brief  LLEventChannel is a typed, allocation-free alternative to
+ *         LLEventPump for hot paths with a fixed event type.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_LLEVENTCHANNEL_H)
+#define LL_LLEVENTCHANNEL_H
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * LLEventPump is the right tool when events cross module boundaries by name,
+ * when listeners need ordering constraints, or when the event is naturally
+ * an LLSD blob. But each LLEventPump::post() goes through boost::signals2,
+ * and a locally-instantiated LLEventPump must register a unique name with
+ * LLEventPumps.
+ *
+ * LLEventChannel<EVENT> covers the simpler case: one C++ event type, known at
+ * compile time, with listeners called in connection order. It is not named,
+ * not registered anywhere, and post() neither allocates nor copies the event.
+ * Connecting a listener allocates only when the listener vector must grow.
+ *
+ * Listeners may connect() and disconnect() from within post() -- on the
+ * same channel, from the same thread. A listener connected during post()
+ * does not see the event being posted. A listener disconnected during post()
+ * is not called after that point.
+ *
+ * The channel is locked while listeners run, so connect(), disconnect() and
+ * post() are safe from any thread, but listeners must not block waiting on
+ * another thread that might itself touch this channel.
+ *
+ * See llcoro::suspendUntilEventOn(LLEventChannel<EVENT>&) in lleventcoro.h to
+ * suspend a coroutine until the next event on a channel.
+ */
+template <typename EVENT>
+class LLEventChannel
+{
+public:
+    typedef EVENT event_type;
+    typedef std::function<void(const EVENT&)> listener_t;
+    /// identifies one connection; 0 is never a valid id
+    typedef unsigned int id_t;
+
+    LLEventChannel() {}
+    LLEventChannel(const LLEventChannel&) = delete;
+    LLEventChannel& operator=(const LLEventChannel&) = delete;
+
+    /**
+     * Disconnects the referenced listener when destroyed, like
+     * LLTempBoundListener. The channel must outlive the TempConnection.
+     */
+    class TempConnection
+    {
+    public:
+        TempConnection(): mChannel(nullptr), mId(0) {}
+        TempConnection(LLEventChannel& channel, id_t id):
+            mChannel(&channel),
+            mId(id)
+        {}
+        TempConnection(TempConnection&& other):
+            mChannel(other.mChannel),
+            mId(other.mId)
+        {
+            other.release();
+        }
+        TempConnection& operator=(TempConnection&& other)
+        {
+            if (this != &other)
+            {
+                disconnect();
+                mChannel = other.mChannel;
+                mId = other.mId;
+                other.release();
+            }
+            return *this;
+        }
+        TempConnection(const TempConnection&) = delete;
+        TempConnection& operator=(const TempConnection&) = delete;
+
+        ~TempConnection()
+        {
+            disconnect();
+        }
+
+        void disconnect()
+        {
+            if (mChannel)
+            {
+                mChannel->disconnect(mId);
+            }
+            release();
+        }
+
+        /// forget the connection without disconnecting it
+        void release()
+        {
+            mChannel = nullptr;
+            mId = 0;
+        }
+
+        bool connected() const { return mChannel && mChannel->connected(mId); }
+
+    private:
+        LLEventChannel* mChannel;
+        id_t mId;
+    };
+
+    /// Register a listener. Returns its id for disconnect().
+    id_t connect(const listener_t& listener)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mMutex);
+        id_t id = mNextId++;
+        if (! mNextId)
+        {
+            // skip 0 on wraparound
+            mNextId = 1;
+        }
+        // While post() is walking mSlots, don't disturb it.
+        (mDispatching? mPending : mSlots).push_back(Slot{ id, listener });
+        return id;
+    }
+
+    /// Like connect(), but disconnects when the returned object is destroyed.
+    TempConnection connectTemp(const listener_t& listener)
+    {
+        return TempConnection(*this, connect(listener));
+    }
+
+    /// Disconnecting an id that isn't connected is a no-op.
+    void disconnect(id_t id)
+    {
+        if (! id)
+        {
+            return;
+        }
+        std::lock_guard<std::recursive_mutex> lock(mMutex);
+        auto pred = [id](const Slot& slot){ return slot.mId == id; };
+        auto pending = std::find_if(mPending.begin(), mPending.end(), pred);
+        if (pending != mPending.end())
+        {
+            mPending.erase(pending);
+            return;
+        }
+        auto found = std::find_if(mSlots.begin(), mSlots.end(), pred);
+        if (found == mSlots.end())
+        {
+            return;
+        }
+        if (mDispatching)
+        {
+            // The listener may be the one currently running: leave its
+            // std::function alone and sweep it up when post() finishes.
+            found->mId = 0;
+            mSwept = true;
+        }
+        else
+        {
+            mSlots.erase(found);
+        }
+    }
+
+    bool connected(id_t id) const
+    {
+        std::lock_guard<std::recursive_mutex> lock(mMutex);
+        auto pred = [id](const Slot& slot){ return id && slot.mId == id; };
+        return (std::any_of(mSlots.begin(), mSlots.end(), pred) ||
+                std::any_of(mPending.begin(), mPending.end(), pred));
+    }
+
+    /// number of connected listeners
+    size_t size() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(mMutex);
+        return mPending.size() +
+            std::count_if(mSlots.begin(), mSlots.end(),
+                          [](const Slot& slot){ return slot.mId != 0; });
+    }
+
+    bool empty() const { return ! size(); }
+
+    /// Call every listener connected before this call with @a event.
+    void post(const EVENT& event)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mMutex);
+        DispatchGuard guard(*this);
+        for (size_t i = 0, size = mSlots.size(); i < size; ++i)
+        {
+            if (mSlots[i].mId)
+            {
+                mSlots[i].mListener(event);
+            }
+        }
+    }
+
+private:
+    struct Slot
+    {
+        id_t mId;
+        listener_t mListener;
+    };
+
+    // Tracks post() nesting, even if a listener throws. Leaving the
+    // outermost post() removes swept slots and admits pending connections.
+    struct DispatchGuard
+    {
+        DispatchGuard(LLEventChannel& channel): mChannel(channel)
+        {
+            ++mChannel.mDispatching;
+        }
+        ~DispatchGuard()
+        {
+            if (--mChannel.mDispatching)
+            {
+                return;
+            }
+            if (mChannel.mSwept)
+            {
+                mChannel.mSlots.erase(
+                    std::remove_if(mChannel.mSlots.begin(), mChannel.mSlots.end(),
+                                   [](const Slot& slot){ return slot.mId == 0; }),
+                    mChannel.mSlots.end());
+                mChannel.mSwept = false;
+            }
+            if (! mChannel.mPending.empty())
+            {
+                std::move(mChannel.mPending.begin(), mChannel.mPending.end(),
+                          std::back_inserter(mChannel.mSlots));
+                mChannel.mPending.clear();
+            }
+        }
+        LLEventChannel& mChannel;
+    };
+
+    mutable std::recursive_mutex mMutex;
+    std::vector<Slot> mSlots;
+    // connections made during post()
+    std::vector<Slot> mPending;
+    unsigned int mDispatching{ 0 };
+    bool mSwept{ false };
+    id_t mNextId{ 1 };
+};
+
+#endif /* ! defined(LL_LLEVENTCHANNEL_H) */
@@ -242,6 +242,29 @@ postAndSuspendSetup(const std::string& callerName,
 
 } // anonymous
 
+LLEventChannel<std::string>& llcoro::detail::stopChannel()
+{
+    static LLEventChannel<std::string> sChannel;
+    // One listener on "LLApp" forwards to every typed wait. Declared after
+    // sChannel so it's disconnected before sChannel is destroyed.
+    static LLTempBoundListener sForwarder(
+        LLEventPumps::instance().obtain("LLApp").listen(
+            "llcoro::stopChannel",
+            [](const LLSD& status)
+            {
+                auto& statsd = status["status"];
+                if (statsd.asString() != "running")
+                {
+                    LL_DEBUGS("lleventcoro") << "stopChannel() spotted status " << statsd
+                                             << ", stopping typed waits" << LL_ENDL;
+                    sChannel.post(statsd.asString());
+                }
+                // do not consume -- every listener must see status
+                return false;
+            }));
+    return sChannel;
+}
+
 LLSD llcoro::postAndSuspend(const LLSD& event, const LLEventPumpOrPumpName& requestPump,
                  const LLEventPumpOrPumpName& replyPump, const LLSD& replyPumpNamePath)
 {
@@ -31,6 +31,8 @@
 
 #include <string>
 #include "llevents.h"
+#include "lleventchannel.h"
+#include "llcoros.h"
 
 /**
  * Like LLListenerOrPumpName, this is a class intended for parameter lists:
@@ -143,6 +145,61 @@ LLSD suspendUntilEventOn(const LLEventPumpOrPumpName& pump)
     return postAndSuspend(LLSD(), LLEventPumpOrPumpName(), pump);
 }
 
+namespace detail
+{
+/// Posts the new LLApp status whenever it changes to anything but "running",
+/// so typed waits can throw LLCoros::Stopping without each of them having
+/// to listen on the "LLApp" LLEventPump.
+LL_COMMON_API LLEventChannel<std::string>& stopChannel();
+} // namespace detail
+
+/**
+ * Wait for the next event on the specified LLEventChannel. Unlike the
+ * LLEventPump overload, neither the wait nor the wakeup involves LLSD or
+ * boost::signals2: the poster's post() fulfills this coroutine's promise
+ * directly. Like the LLEventPump overload, this throws LLCoros::Stopping if
+ * the application starts shutting down while we wait.
+ */
+template <typename EVENT>
+EVENT suspendUntilEventOn(LLEventChannel<EVENT>& channel)
+{
+    // Before we get any farther -- should we be stopping instead of
+    // suspending?
+    LLCoros::checkStop();
+    LLCoros::Promise<EVENT> promise;
+    // Only the first event (or stop notification) counts; later ones find
+    // the promise already satisfied.
+    typename LLEventChannel<EVENT>::TempConnection connection(
+        channel.connectTemp(
+            [&promise](const EVENT& event)
+            {
+                try
+                {
+                    promise.set_value(event);
+                }
+                catch (const boost::fibers::promise_already_satisfied&)
+                {
+                }
+            }));
+    LLEventChannel<std::string>::TempConnection stopper(
+        detail::stopChannel().connectTemp(
+            [&promise](const std::string& status)
+            {
+                try
+                {
+                    promise.set_exception(
+                        std::make_exception_ptr(LLCoros::Stopping("status " + status)));
+                }
+                catch (const boost::fibers::promise_already_satisfied&)
+                {
+                }
+            }));
+    LLCoros::Future<EVENT> future = LLCoros::getFuture(promise);
+    LLCoros::TempStatus st("waiting for event channel");
+    // returning disconnects both connections
+    return future.get();
+}
+
 /// Like postAndSuspend(), but if we wait longer than @a timeout seconds,
 /// stop waiting and return @a timeoutResult instead.
 LLSD postAndSuspendWithTimeout(const LLSD& event,
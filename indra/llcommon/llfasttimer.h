@@ -29,6 +29,7 @@
 
 #include "llinstancetracker.h"
 #include "lltrace.h"
+#include "lltracetimeline.h"
 #include "lltreeiterators.h"
 
 #if LL_WINDOWS
@@ -306,6 +307,10 @@ LL_FORCE_INLINE BlockTimer::BlockTimer(BlockTimerStatHandle& timer)
 	cur_timer_data->mChildTime = 0;
 
 	mStartTime = getCPUClockCount64();
+	if (Timeline::isEnabled())
+	{
+		Timeline::record(timer.getName().c_str(), mStartTime, Timeline::BEGIN);
+	}
 #endif
 }
 
@@ -316,6 +321,11 @@ LL_FORCE_INLINE BlockTimer::~BlockTimer()
 	BlockTimerStackRecord* cur_timer_data = LLThreadLocalSingletonPointer<BlockTimerStackRecord>::getInstance();
 	if (!cur_timer_data) return;
 
+	if (Timeline::isEnabled())
+	{
+		Timeline::record(cur_timer_data->mTimeBlock->getName().c_str(), mStartTime + total_time, Timeline::END);
+	}
+
 	TimeBlockAccumulator& accumulator = cur_timer_data->mTimeBlock->getCurrentAccumulator();
 
 	accumulator.mCalls++;
@@ -28,6 +28,7 @@
 #ifndef LL_LLINSTANCETRACKER_H
 #define LL_LLINSTANCETRACKER_H
 
+#include <atomic>
 #include <map>
 #include <set>
 #include <vector>
@@ -55,6 +56,73 @@ namespace LLInstanceTrackerPrivate
         std::mutex mMutex;
     };
 
+    /**
+     * Lookups and snapshots never lock the registry. Constructors and
+     * destructors change it under mMutex, then publish() an immutable TABLE
+     * built from it, which all readers share until the next change. Each
+     * thread also keeps its own reference to the current TABLE, so while the
+     * registry stays unchanged a lookup costs one atomic load, with no shared
+     * writes; after a change it costs one more, for the new TABLE.
+     */
+    template <typename TABLE>
+    struct PublishingStatic: public StaticBase
+    {
+        typedef TABLE table_t;
+        typedef std::shared_ptr<const TABLE> table_ptr;
+
+        // caller must hold mMutex
+        void publish(const table_ptr& table)
+        {
+            std::atomic_store_explicit(&mTable, table, std::memory_order_release);
+            // after the store, so a reader who sees the new version gets a
+            // table at least that new
+            mVersion.fetch_add(1, std::memory_order_release);
+        }
+
+        table_ptr getTable() const
+        {
+            return std::atomic_load_explicit(&mTable, std::memory_order_acquire);
+        }
+
+        // bumped by every change to the registry
+        std::atomic<U64> mVersion{ 1 };
+
+    private:
+        // only accessed with std::atomic_load/atomic_store
+        table_ptr mTable{ std::make_shared<const TABLE>() };
+    };
+
+    // Call func(const table_ptr&) with the current table of STATIC's
+    // registry. Never locks.
+    template <typename STATIC, typename FUNC>
+    auto with_table(FUNC&& func)
+    {
+        typedef typename STATIC::table_ptr table_ptr;
+        struct Cache
+        {
+            ~Cache() { *mGone = true; }
+            bool* mGone;
+            table_ptr mTable;
+            U64 mVersion;
+        };
+        STATIC* data = llthread::LockStatic<STATIC>::getStatic();
+        // trivially destructible, so still valid once tCache is destroyed
+        static thread_local bool tGone = false;
+        if (tGone)
+        {
+            // a thread_local destructor on an exiting thread: don't cache
+            return func(data->getTable());
+        }
+        static thread_local Cache tCache{ &tGone, {}, 0 };
+        U64 version = data->mVersion.load(std::memory_order_acquire);
+        if (version != tCache.mVersion)
+        {
+            tCache.mTable = data->getTable();
+            tCache.mVersion = version;
+        }
+        return func(tCache.mTable);
+    }
+
     void logerrs(const char* cls, const std::string&, const std::string&, const std::string&);
 } // namespace LLInstanceTrackerPrivate
 
@@ -75,16 +143,29 @@ template<typename T, typename KEY = void,
          EInstanceTrackerAllowKeyCollisions KEY_COLLISION_BEHAVIOR = LLInstanceTrackerErrorOnCollision>
 class LLInstanceTracker
 {
-    typedef std::map<KEY, std::shared_ptr<T>> InstanceMap;
-    struct StaticData: public LLInstanceTrackerPrivate::StaticBase
+public:
+    using ptr_t  = std::shared_ptr<T>;
+    using weak_t = std::weak_ptr<T>;
+
+private:
+    typedef std::map<KEY, ptr_t> InstanceMap;
+    // What readers see: weak_ptrs, so they can tell when an instance has
+    // been destroyed since the table was built.
+    typedef std::map<KEY, weak_t> InstanceTable;
+    struct StaticData: public LLInstanceTrackerPrivate::PublishingStatic<InstanceTable>
     {
         InstanceMap mMap;
+
+        // note, this assigns pair<KEY, shared_ptr> to pair<KEY, weak_ptr>
+        typename StaticData::table_ptr buildTable() const
+        {
+            return std::make_shared<InstanceTable>(mMap.begin(), mMap.end());
+        }
     };
     typedef llthread::LockStatic<StaticData> LockStatic;
+    typedef typename StaticData::table_ptr table_ptr;
 
 public:
-    using ptr_t  = std::shared_ptr<T>;
-    using weak_t = std::weak_ptr<T>;
 
     /**
      * Storing a dumb T* somewhere external is a bad idea, since
@@ -101,7 +182,8 @@ public:
 
     static S32 instanceCount() 
     { 
-        return LockStatic()->mMap.size(); 
+        return LLInstanceTrackerPrivate::with_table<StaticData>(
+            [](const table_ptr& table){ return S32(table->size()); });
     }
     
     // snapshot of std::pair<const KEY, std::shared_ptr<T>> pairs
@@ -110,7 +192,9 @@ public:
         // It's very important that what we store in this snapshot are
         // weak_ptrs, NOT shared_ptrs. That's how we discover whether any
         // instance has been deleted during the lifespan of a snapshot.
-        typedef std::vector<std::pair<const KEY, weak_t>> VectorType;
+        // The published InstanceTable is immutable, so we can share it
+        // rather than copy it.
+        typedef const InstanceTable VectorType;
         // Dereferencing our iterator produces a std::shared_ptr for each
         // instance that still exists. Since we store weak_ptrs, that involves
         // two chained transformations:
@@ -125,7 +209,7 @@ public:
         // coded functor, only with actual functions. In my experience, an
         // internal boost::result_of() operation fails, even with an explicit
         // result_type typedef. But this works.
-        static strong_pair strengthen(typename VectorType::value_type& pair)
+        static strong_pair strengthen(const typename VectorType::value_type& pair)
         {
             return { pair.first, pair.second.lock() };
         }
@@ -136,53 +220,31 @@ public:
 
     public:
         snapshot():
-            // populate our vector with a snapshot of (locked!) InstanceMap
-            // note, this assigns pair<KEY, shared_ptr> to pair<KEY, weak_ptr>
-            mData(mLock->mMap.begin(), mLock->mMap.end())
-        {
-            // release the lock once we've populated mData
-            mLock.unlock();
-        }
+            mData(LLInstanceTrackerPrivate::with_table<StaticData>(
+                      [](const table_ptr& table){ return table; }))
+        {}
 
         // You can't make a transform_iterator (or anything else) that
         // literally stores a C++ function (decltype(strengthen)) -- but you
         // can make a transform_iterator based on a _function pointer._
         typedef boost::transform_iterator<decltype(strengthen)*,
-                                          typename VectorType::iterator> strong_iterator;
+                                          typename VectorType::const_iterator> strong_iterator;
         typedef boost::filter_iterator<decltype(dead_skipper)*, strong_iterator> iterator;
 
-        iterator begin() { return make_iterator(mData.begin()); }
-        iterator end()   { return make_iterator(mData.end()); }
+        iterator begin() { return make_iterator(mData->begin()); }
+        iterator end()   { return make_iterator(mData->end()); }
 
     private:
-        iterator make_iterator(typename VectorType::iterator iter)
+        iterator make_iterator(typename VectorType::const_iterator iter)
         {
             // transform_iterator only needs the base iterator and the transform.
             // filter_iterator wants the predicate and both ends of the range.
             return iterator(dead_skipper,
                             strong_iterator(iter, strengthen),
-                            strong_iterator(mData.end(), strengthen));
+                            strong_iterator(mData->end(), strengthen));
         }
 
-        // lock static data during construction
-#if ! LL_WINDOWS
-        LockStatic mLock;
-#else  // LL_WINDOWS
-        // We want to be able to use (e.g.) our instance_snapshot subclass as:
-        // for (auto& inst : T::instance_snapshot()) ...
-        // But when this snapshot base class directly contains LockStatic, as
-        // above, Visual Studio 2017 requires us to code instead:
-        // for (auto& inst : std::move(T::instance_snapshot())) ...
-        // nat thinks this should be unnecessary, as an anonymous class
-        // instance is already a temporary. It shouldn't need to be cast to
-        // rvalue reference (the role of std::move()). clang evidently agrees,
-        // as the short form works fine with Xcode on Mac.
-        // To support the succinct usage, instead of directly storing
-        // LockStatic, store std::shared_ptr<LockStatic>, which is copyable.
-        std::shared_ptr<LockStatic> mLockp{std::make_shared<LockStatic>()};
-        LockStatic& mLock{*mLockp};
-#endif // LL_WINDOWS
-        VectorType mData;
+        table_ptr mData;
     };
 
     // iterate over this for references to each instance
@@ -225,10 +287,13 @@ public:
 
     static ptr_t getInstance(const KEY& k)
     {
-        LockStatic lock;
-        const InstanceMap& map(lock->mMap);
-        typename InstanceMap::const_iterator found = map.find(k);
-        return (found == map.end()) ? NULL : found->second;
+        return LLInstanceTrackerPrivate::with_table<StaticData>(
+            [&k](const table_ptr& table)
+            {
+                typename InstanceTable::const_iterator found = table->find(k);
+                // lock() fails if the instance has since been destroyed
+                return (found == table->end()) ? ptr_t() : found->second.lock();
+            });
     }
 
 protected:
@@ -243,12 +308,14 @@ protected:
         mSelf = ptr;
         LockStatic lock;
         add_(lock, key, ptr);
+        lock->publish(lock->buildTable());
     }
 public:
     virtual ~LLInstanceTracker()
     {
         LockStatic lock;
         remove_(lock);
+        lock->publish(lock->buildTable());
     }
 protected:
     virtual void setKey(KEY key)
@@ -260,6 +327,7 @@ protected:
         // and re-add it to the map with the new key.
         auto ptr = remove_(lock);
         add_(lock, key, ptr);
+        lock->publish(lock->buildTable());
     }
 public:
     virtual const KEY& getKey() const { return mInstanceKey; }
@@ -339,16 +407,29 @@ private:
 template<typename T, EInstanceTrackerAllowKeyCollisions KEY_COLLISION_BEHAVIOR>
 class LLInstanceTracker<T, void, KEY_COLLISION_BEHAVIOR>
 {
-    typedef std::set<std::shared_ptr<T>> InstanceSet;
-    struct StaticData: public LLInstanceTrackerPrivate::StaticBase
+public:
+    using ptr_t  = std::shared_ptr<T>;
+    using weak_t = std::weak_ptr<T>;
+
+private:
+    typedef std::set<ptr_t> InstanceSet;
+    // What readers see: weak_ptrs, so they can tell when an instance has
+    // been destroyed since the table was built.
+    typedef std::vector<weak_t> InstanceTable;
+    struct StaticData: public LLInstanceTrackerPrivate::PublishingStatic<InstanceTable>
     {
         InstanceSet mSet;
+
+        // note, this assigns stored shared_ptrs to weak_ptrs
+        typename StaticData::table_ptr buildTable() const
+        {
+            return std::make_shared<InstanceTable>(mSet.begin(), mSet.end());
+        }
     };
     typedef llthread::LockStatic<StaticData> LockStatic;
+    typedef typename StaticData::table_ptr table_ptr;
 
 public:
-    using ptr_t  = std::shared_ptr<T>;
-    using weak_t = std::weak_ptr<T>;
 
     /**
      * Storing a dumb T* somewhere external is a bad idea, since
@@ -365,7 +446,8 @@ public:
     
     static S32 instanceCount()
     {
-        return LockStatic()->mSet.size();
+        return LLInstanceTrackerPrivate::with_table<StaticData>(
+            [](const table_ptr& table){ return S32(table->size()); });
     }
 
     // snapshot of std::shared_ptr<T> pointers
@@ -374,14 +456,16 @@ public:
         // It's very important that what we store in this snapshot are
         // weak_ptrs, NOT shared_ptrs. That's how we discover whether any
         // instance has been deleted during the lifespan of a snapshot.
-        typedef std::vector<weak_t> VectorType;
+        // The published InstanceTable is immutable, so we can share it
+        // rather than copy it.
+        typedef const InstanceTable VectorType;
         // Dereferencing our iterator produces a std::shared_ptr for each
         // instance that still exists. Since we store weak_ptrs, that involves
         // two chained transformations:
         // - a transform_iterator to lock the weak_ptr and return a shared_ptr
         // - a filter_iterator to skip any shared_ptr that has become invalid.
         typedef std::shared_ptr<T> strong_ptr;
-        static strong_ptr strengthen(typename VectorType::value_type& ptr)
+        static strong_ptr strengthen(const typename VectorType::value_type& ptr)
         {
             return ptr.lock();
         }
@@ -392,50 +476,28 @@ public:
 
     public:
         snapshot():
-            // populate our vector with a snapshot of (locked!) InstanceSet
-            // note, this assigns stored shared_ptrs to weak_ptrs for snapshot
-            mData(mLock->mSet.begin(), mLock->mSet.end())
-        {
-            // release the lock once we've populated mData
-            mLock.unlock();
-        }
+            mData(LLInstanceTrackerPrivate::with_table<StaticData>(
+                      [](const table_ptr& table){ return table; }))
+        {}
 
         typedef boost::transform_iterator<decltype(strengthen)*,
-                                          typename VectorType::iterator> strong_iterator;
+                                          typename VectorType::const_iterator> strong_iterator;
         typedef boost::filter_iterator<decltype(dead_skipper)*, strong_iterator> iterator;
 
-        iterator begin() { return make_iterator(mData.begin()); }
-        iterator end()   { return make_iterator(mData.end()); }
+        iterator begin() { return make_iterator(mData->begin()); }
+        iterator end()   { return make_iterator(mData->end()); }
 
     private:
-        iterator make_iterator(typename VectorType::iterator iter)
+        iterator make_iterator(typename VectorType::const_iterator iter)
         {
             // transform_iterator only needs the base iterator and the transform.
             // filter_iterator wants the predicate and both ends of the range.
             return iterator(dead_skipper,
                             strong_iterator(iter, strengthen),
-                            strong_iterator(mData.end(), strengthen));
+                            strong_iterator(mData->end(), strengthen));
         }
 
-        // lock static data during construction
-#if ! LL_WINDOWS
-        LockStatic mLock;
-#else  // LL_WINDOWS
-        // We want to be able to use our instance_snapshot subclass as:
-        // for (auto& inst : T::instance_snapshot()) ...
-        // But when this snapshot base class directly contains LockStatic, as
-        // above, Visual Studio 2017 requires us to code instead:
-        // for (auto& inst : std::move(T::instance_snapshot())) ...
-        // nat thinks this should be unnecessary, as an anonymous class
-        // instance is already a temporary. It shouldn't need to be cast to
-        // rvalue reference (the role of std::move()). clang evidently agrees,
-        // as the short form works fine with Xcode on Mac.
-        // To support the succinct usage, instead of directly storing
-        // LockStatic, store std::shared_ptr<LockStatic>, which is copyable.
-        std::shared_ptr<LockStatic> mLockp{std::make_shared<LockStatic>()};
-        LockStatic& mLock{*mLockp};
-#endif // LL_WINDOWS
-        VectorType mData;
+        table_ptr mData;
     };
 
     // iterate over this for references to each instance
@@ -463,14 +525,18 @@ protected:
         // save corresponding weak_ptr for future reference
         mSelf = ptr;
         // Also store it in our class-static set to track this instance.
-        LockStatic()->mSet.emplace(ptr);
+        LockStatic lock;
+        lock->mSet.emplace(ptr);
+        lock->publish(lock->buildTable());
     }
 public:
     virtual ~LLInstanceTracker()
     {
         // convert weak_ptr to shared_ptr because that's what we store in our
         // InstanceSet
-        LockStatic()->mSet.erase(mSelf.lock());
+        LockStatic lock;
+        lock->mSet.erase(mSelf.lock());
+        lock->publish(lock->buildTable());
     }
 protected:
     LLInstanceTracker(const LLInstanceTracker& other):
@@ -403,6 +403,7 @@ S32 LLQueuedThread::processNextRequest()
 {
 	QueuedRequest *req;
 	// Get next request from pool
+	std::vector<QueuedRequest*> not_ready;
 	lockData();
 	
 	while(1)
@@ -416,6 +417,12 @@ S32 LLQueuedThread::processNextRequest()
 		mRequestQueue.erase(mRequestQueue.begin());
 		if ((req->getFlags() & FLAG_ABORT) || (mStatus == QUITTING))
 		{
+			if (mStatus != QUITTING && !req->readyToAbort())
+			{
+				// requeued below, so the rest of the queue gets a turn
+				not_ready.push_back(req);
+				continue;
+			}
 			req->setStatus(STATUS_ABORTED);
 			req->finishRequest(false);
 			if (req->getFlags() & FLAG_AUTO_COMPLETE)
@@ -429,6 +436,7 @@ S32 LLQueuedThread::processNextRequest()
 		llassert_always(req->getStatus() == STATUS_QUEUED);
 		break;
 	}
+	mRequestQueue.insert(not_ready.begin(), not_ready.end());
 	U32 start_priority = 0 ;
 	if (req)
 	{
@@ -558,6 +566,12 @@ void LLQueuedThread::QueuedRequest::finishRequest(bool completed)
 {
 }
 
+//virtual
+bool LLQueuedThread::QueuedRequest::readyToAbort()
+{
+	return true;
+}
+
 //virtual
 void LLQueuedThread::QueuedRequest::deleteRequest()
 {
@@ -119,6 +119,7 @@ public:
 		
 		virtual bool processRequest() = 0; // Return true when request has completed
 		virtual void finishRequest(bool completed); // Always called from thread after request has completed or aborted
+		virtual bool readyToAbort(); // Return false to stay queued until an aborted request can be finished
 		virtual void deleteRequest(); // Only method to delete a request
 
 		void setPriority(U32 pri)
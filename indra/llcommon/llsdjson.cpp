@@ -34,6 +34,20 @@
 #include "llerror.h"
 #include "../llmath/llmath.h"
 
+#include <cmath>
+#include <locale>
+#include <sstream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LL_JSON_SSE2 1
+#include <emmintrin.h>
+#if LL_WINDOWS
+#include <intrin.h>
+#endif
+#else
+#define LL_JSON_SSE2 0
+#endif
+
 //=========================================================================
 LLSD LlsdFromJson(const Json::Value &val)
 {
@@ -124,3 +138,758 @@ Json::Value LlsdToJson(const LLSD &val)
 
     return result;
 }
+
+//=========================================================================
+// Direct JSON text <-> LLSD conversion
+//=========================================================================
+namespace
+{
+
+// Strings dominate typical JSON payloads, so scan them 16 bytes at a time
+// for the only characters that need attention.
+#if LL_JSON_SSE2
+inline U32 lowest_set_bit(U32 mask)
+{
+#if LL_WINDOWS
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return U32(index);
+#else
+    return U32(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+// first '"' or '\\' in [pos, end), else end
+const char* find_quote_or_escape(const char* pos, const char* end)
+{
+#if LL_JSON_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    for (; end - pos >= 16; pos += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        U32 mask = U32(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                                      _mm_cmpeq_epi8(chunk, backslash))));
+        if (mask)
+        {
+            return pos + lowest_set_bit(mask);
+        }
+    }
+#endif
+    while (pos < end && *pos != '"' && *pos != '\\')
+    {
+        ++pos;
+    }
+    return pos;
+}
+
+// first character in [pos, end) that must be escaped in a JSON string
+const char* find_unsafe_char(const char* pos, const char* end)
+{
+#if LL_JSON_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    for (; end - pos >= 16; pos += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        // unsigned chunk <= 0x1f, without a signed compare that would also
+        // catch bytes >= 0x80
+        __m128i is_control = _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control);
+        U32 mask = U32(_mm_movemask_epi8(_mm_or_si128(is_control,
+                                                      _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                                                   _mm_cmpeq_epi8(chunk, backslash)))));
+        if (mask)
+        {
+            return pos + lowest_set_bit(mask);
+        }
+    }
+#endif
+    while (pos < end && U8(*pos) >= 0x20 && *pos != '"' && *pos != '\\')
+    {
+        ++pos;
+    }
+    return pos;
+}
+
+// first character in [pos, end) that isn't JSON whitespace
+const char* skip_whitespace(const char* pos, const char* end)
+{
+#if LL_JSON_SSE2
+    // Pretty-printed documents have long runs of indentation; compact ones
+    // rarely have more than one space, so check that first.
+    if (end - pos >= 16 && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t'))
+    {
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i cr = _mm_set1_epi8('\r');
+        const __m128i tab = _mm_set1_epi8('\t');
+        for (; end - pos >= 16; pos += 16)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+            __m128i is_space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space),
+                                                         _mm_cmpeq_epi8(chunk, newline)),
+                                            _mm_or_si128(_mm_cmpeq_epi8(chunk, cr),
+                                                         _mm_cmpeq_epi8(chunk, tab)));
+            U32 mask = U32(_mm_movemask_epi8(is_space)) ^ 0xffff;
+            if (mask)
+            {
+                return pos + lowest_set_bit(mask);
+            }
+        }
+    }
+#endif
+    while (pos < end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t'))
+    {
+        ++pos;
+    }
+    return pos;
+}
+
+// Exactly representable powers of ten, for the fast path in parseNumber().
+const F64 POWERS_OF_TEN[] =
+{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Same limit as jsoncpp's default reader.
+const S32 MAX_JSON_DEPTH = 1000;
+
+class LLJsonParser
+{
+public:
+    LLJsonParser(const char* text, size_t length):
+        mBegin(text),
+        mPos(text),
+        mEnd(text + length)
+    {}
+
+    bool parse(LLSD& result, std::string* error)
+    {
+        result.clear();
+        bool ok = skipSpace() && parseValue(result, 0) && skipSpace();
+        if (ok && mPos != mEnd)
+        {
+            ok = fail("unexpected text after JSON value");
+        }
+        if (! ok)
+        {
+            result.clear();
+            if (error)
+            {
+                *error = mError;
+            }
+        }
+        return ok;
+    }
+
+private:
+    bool fail(const char* what)
+    {
+        // report only the first problem
+        if (mError.empty())
+        {
+            std::ostringstream out;
+            out << what << " at offset " << (mPos - mBegin);
+            mError = out.str();
+        }
+        return false;
+    }
+
+    // whitespace and comments; false only for an unterminated comment
+    bool skipSpace()
+    {
+        for (;;)
+        {
+            mPos = skip_whitespace(mPos, mEnd);
+            if (mEnd - mPos < 2 || mPos[0] != '/')
+            {
+                return true;
+            }
+            if (mPos[1] == '/')
+            {
+                while (mPos < mEnd && *mPos != '\n')
+                {
+                    ++mPos;
+                }
+            }
+            else if (mPos[1] == '*')
+            {
+                const char* start = mPos;
+                for (mPos += 2; mEnd - mPos >= 2 && ! (mPos[0] == '*' && mPos[1] == '/'); ++mPos)
+                    ;
+                if (mEnd - mPos < 2)
+                {
+                    mPos = start;
+                    return fail("unterminated comment");
+                }
+                mPos += 2;
+            }
+            else
+            {
+                return true;
+            }
+        }
+    }
+
+    bool parseValue(LLSD& result, S32 depth)
+    {
+        if (mPos == mEnd)
+        {
+            return fail("unexpected end of JSON text");
+        }
+        switch (*mPos)
+        {
+        case '{':
+            return parseObject(result, depth + 1);
+        case '[':
+            return parseArray(result, depth + 1);
+        case '"':
+        {
+            std::string value;
+            if (! parseString(value))
+            {
+                return false;
+            }
+            result = value;
+            return true;
+        }
+        case 't':
+            result = true;
+            return parseLiteral("true", 4);
+        case 'f':
+            result = false;
+            return parseLiteral("false", 5);
+        case 'n':
+            // undefined, as result already is
+            return parseLiteral("null", 4);
+        default:
+            return parseNumber(result);
+        }
+    }
+
+    bool parseLiteral(const char* literal, size_t length)
+    {
+        if (size_t(mEnd - mPos) < length || strncmp(mPos, literal, length) != 0)
+        {
+            return fail("invalid JSON value");
+        }
+        mPos += length;
+        return true;
+    }
+
+    bool parseObject(LLSD& result, S32 depth)
+    {
+        if (depth > MAX_JSON_DEPTH)
+        {
+            return fail("JSON nested too deeply");
+        }
+        result = LLSD::emptyMap();
+        ++mPos;                     // '{'
+        if (! skipSpace())
+        {
+            return false;
+        }
+        if (mPos < mEnd && *mPos == '}')
+        {
+            ++mPos;
+            return true;
+        }
+        std::string key;
+        for (;;)
+        {
+            if (mPos == mEnd || *mPos != '"')
+            {
+                return fail("expected object member name");
+            }
+            if (! parseString(key) || ! skipSpace())
+            {
+                return false;
+            }
+            if (mPos == mEnd || *mPos != ':')
+            {
+                return fail("expected ':' after object member name");
+            }
+            ++mPos;
+            // parse straight into the map entry: no intermediate copy
+            // (a repeated name replaces the earlier value, as with jsoncpp)
+            if (! skipSpace() || ! parseValue(result[key] = LLSD(), depth) || ! skipSpace())
+            {
+                return false;
+            }
+            if (mPos == mEnd)
+            {
+                return fail("unterminated object");
+            }
+            if (*mPos == '}')
+            {
+                ++mPos;
+                return true;
+            }
+            if (*mPos != ',')
+            {
+                return fail("expected ',' or '}' in object");
+            }
+            ++mPos;
+            if (! skipSpace())
+            {
+                return false;
+            }
+        }
+    }
+
+    bool parseArray(LLSD& result, S32 depth)
+    {
+        if (depth > MAX_JSON_DEPTH)
+        {
+            return fail("JSON nested too deeply");
+        }
+        result = LLSD::emptyArray();
+        ++mPos;                     // '['
+        if (! skipSpace())
+        {
+            return false;
+        }
+        if (mPos < mEnd && *mPos == ']')
+        {
+            ++mPos;
+            return true;
+        }
+        for (;;)
+        {
+            if (! parseValue(result.append(LLSD()), depth) || ! skipSpace())
+            {
+                return false;
+            }
+            if (mPos == mEnd)
+            {
+                return fail("unterminated array");
+            }
+            if (*mPos == ']')
+            {
+                ++mPos;
+                return true;
+            }
+            if (*mPos != ',')
+            {
+                return fail("expected ',' or ']' in array");
+            }
+            ++mPos;
+            if (! skipSpace())
+            {
+                return false;
+            }
+        }
+    }
+
+    bool parseString(std::string& result)
+    {
+        ++mPos;                     // opening '"'
+        const char* run = mPos;
+        const char* stop = find_quote_or_escape(run, mEnd);
+        if (stop < mEnd && *stop == '"')
+        {
+            // the usual case: nothing to unescape
+            result.assign(run, stop);
+            mPos = stop + 1;
+            return true;
+        }
+
+        result.clear();
+        for (;;)
+        {
+            result.append(run, stop);
+            mPos = stop;
+            if (mPos == mEnd)
+            {
+                return fail("unterminated string");
+            }
+            if (*mPos == '"')
+            {
+                ++mPos;
+                return true;
+            }
+            // backslash
+            if (++mPos == mEnd)
+            {
+                return fail("unterminated string");
+            }
+            switch (*mPos++)
+            {
+            case '"':  result.push_back('"');  break;
+            case '\\': result.push_back('\\'); break;
+            case '/':  result.push_back('/');  break;
+            case 'b':  result.push_back('\b'); break;
+            case 'f':  result.push_back('\f'); break;
+            case 'n':  result.push_back('\n'); break;
+            case 'r':  result.push_back('\r'); break;
+            case 't':  result.push_back('\t'); break;
+            case 'u':
+                if (! parseUnicodeEscape(result))
+                {
+                    return false;
+                }
+                break;
+            default:
+                --mPos;
+                return fail("invalid escape in string");
+            }
+            run = mPos;
+            stop = find_quote_or_escape(run, mEnd);
+        }
+    }
+
+    bool parseHex4(U32& value)
+    {
+        if (mEnd - mPos < 4)
+        {
+            return fail("invalid \\u escape in string");
+        }
+        value = 0;
+        for (const char* end = mPos + 4; mPos < end; ++mPos)
+        {
+            char c = *mPos;
+            U32 digit;
+            if (c >= '0' && c <= '9')       digit = c - '0';
+            else if (c >= 'a' && c <= 'f')  digit = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')  digit = c - 'A' + 10;
+            else return fail("invalid \\u escape in string");
+            value = (value << 4) | digit;
+        }
+        return true;
+    }
+
+    // after "\u": append the code point, combining a surrogate pair, as UTF-8
+    bool parseUnicodeEscape(std::string& result)
+    {
+        U32 code;
+        if (! parseHex4(code))
+        {
+            return false;
+        }
+        if (code >= 0xd800 && code <= 0xdbff)
+        {
+            U32 low;
+            if (mEnd - mPos < 2 || mPos[0] != '\\' || mPos[1] != 'u')
+            {
+                return fail("expected low surrogate after high surrogate");
+            }
+            mPos += 2;
+            if (! parseHex4(low))
+            {
+                return false;
+            }
+            if (low < 0xdc00 || low > 0xdfff)
+            {
+                return fail("invalid low surrogate");
+            }
+            code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+        }
+
+        if (code < 0x80)
+        {
+            result.push_back(char(code));
+        }
+        else if (code < 0x800)
+        {
+            result.push_back(char(0xc0 | (code >> 6)));
+            result.push_back(char(0x80 | (code & 0x3f)));
+        }
+        else if (code < 0x10000)
+        {
+            result.push_back(char(0xe0 | (code >> 12)));
+            result.push_back(char(0x80 | ((code >> 6) & 0x3f)));
+            result.push_back(char(0x80 | (code & 0x3f)));
+        }
+        else
+        {
+            result.push_back(char(0xf0 | (code >> 18)));
+            result.push_back(char(0x80 | ((code >> 12) & 0x3f)));
+            result.push_back(char(0x80 | ((code >> 6) & 0x3f)));
+            result.push_back(char(0x80 | (code & 0x3f)));
+        }
+        return true;
+    }
+
+    bool parseNumber(LLSD& result)
+    {
+        const char* start = mPos;
+        bool negative = false;
+        if (mPos < mEnd && *mPos == '-')
+        {
+            negative = true;
+            ++mPos;
+        }
+        if (mPos == mEnd || *mPos < '0' || *mPos > '9')
+        {
+            mPos = start;
+            return fail("invalid JSON value");
+        }
+
+        // Accumulate up to 19 significant digits; beyond that, or for
+        // anything else the fast path can't do exactly, use the stream.
+        U64 mantissa = 0;
+        S32 digits = 0;
+        S32 exponent = 0;
+        if (*mPos == '0')
+        {
+            ++mPos;
+        }
+        else
+        {
+            for (; mPos < mEnd && *mPos >= '0' && *mPos <= '9'; ++mPos)
+            {
+                mantissa = mantissa * 10 + (*mPos - '0');
+                ++digits;
+            }
+        }
+        if (mPos < mEnd && *mPos >= '0' && *mPos <= '9')
+        {
+            return fail("leading zero in number");
+        }
+
+        bool integral = true;
+        if (mPos < mEnd && *mPos == '.')
+        {
+            integral = false;
+            const char* fraction = ++mPos;
+            for (; mPos < mEnd && *mPos >= '0' && *mPos <= '9'; ++mPos)
+            {
+                if (mantissa || *mPos != '0')
+                {
+                    ++digits;
+                }
+                mantissa = mantissa * 10 + (*mPos - '0');
+                --exponent;
+            }
+            if (mPos == fraction)
+            {
+                return fail("expected digits after decimal point");
+            }
+        }
+        if (mPos < mEnd && (*mPos == 'e' || *mPos == 'E'))
+        {
+            integral = false;
+            ++mPos;
+            bool negative_exp = false;
+            if (mPos < mEnd && (*mPos == '+' || *mPos == '-'))
+            {
+                negative_exp = (*mPos == '-');
+                ++mPos;
+            }
+            const char* exp_digits = mPos;
+            S32 explicit_exp = 0;
+            for (; mPos < mEnd && *mPos >= '0' && *mPos <= '9'; ++mPos)
+            {
+                // clamp: anything this large is out of range anyway
+                explicit_exp = llmin(explicit_exp * 10 + (*mPos - '0'), 100000);
+            }
+            if (mPos == exp_digits)
+            {
+                return fail("expected digits in exponent");
+            }
+            exponent += negative_exp ? -explicit_exp : explicit_exp;
+        }
+
+        if (integral && digits <= 10)
+        {
+            S64 value = negative ? -S64(mantissa) : S64(mantissa);
+            if (value >= S32_MIN && value <= S32_MAX)
+            {
+                result = LLSD::Integer(value);
+                return true;
+            }
+        }
+
+        if (digits <= 15 && exponent >= -22 && exponent <= 22)
+        {
+            // Both operands are exact, so one IEEE operation rounds correctly.
+            F64 value = F64(mantissa);
+            value = (exponent < 0) ? value / POWERS_OF_TEN[-exponent]
+                                   : value * POWERS_OF_TEN[exponent];
+            result = LLSD::Real(negative ? -value : value);
+            return true;
+        }
+
+        // The classic locale, because the viewer may set one whose decimal
+        // separator isn't '.'.
+        std::istringstream in(std::string(start, mPos));
+        in.imbue(std::locale::classic());
+        F64 value = 0.0;
+        // on overflow, the stream stores +/-max with failbit: keep that
+        in >> value;
+        result = LLSD::Real(value);
+        return true;
+    }
+
+    const char* mBegin;
+    const char* mPos;
+    const char* mEnd;
+    std::string mError;
+};
+
+void append_json_string(std::string& out, const std::string& value)
+{
+    static const char HEX[] = "0123456789abcdef";
+    out.push_back('"');
+    const char* pos = value.data();
+    const char* end = pos + value.size();
+    for (;;)
+    {
+        const char* stop = find_unsafe_char(pos, end);
+        out.append(pos, stop);
+        if (stop == end)
+        {
+            break;
+        }
+        char c = *stop;
+        switch (c)
+        {
+        case '"':  out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        case '\b': out.append("\\b");  break;
+        case '\f': out.append("\\f");  break;
+        case '\n': out.append("\\n");  break;
+        case '\r': out.append("\\r");  break;
+        case '\t': out.append("\\t");  break;
+        default:
+            out.append("\\u00");
+            out.push_back(HEX[(c >> 4) & 0xf]);
+            out.push_back(HEX[c & 0xf]);
+            break;
+        }
+        pos = stop + 1;
+    }
+    out.push_back('"');
+}
+
+void append_json_real(std::string& out, F64 value)
+{
+    // same choices as jsoncpp's writer
+    if (std::isnan(value))
+    {
+        out.append("null");
+        return;
+    }
+    if (std::isinf(value))
+    {
+        out.append(value < 0 ? "-1e+9999" : "1e+9999");
+        return;
+    }
+    char buffer[32];
+    S32 length = snprintf(buffer, sizeof(buffer), "%.17g", value);
+    bool integral = true;
+    for (S32 i = 0; i < length; ++i)
+    {
+        char c = buffer[i];
+        if ((c < '0' || c > '9') && c != '-' && c != '+' && c != 'e')
+        {
+            // whatever decimal separator the current locale uses
+            buffer[i] = '.';
+            integral = false;
+        }
+        else if (c == 'e')
+        {
+            integral = false;
+        }
+    }
+    out.append(buffer, length);
+    if (integral)
+    {
+        // keep it a real when read back
+        out.append(".0");
+    }
+}
+
+void append_json(std::string& out, const LLSD& val)
+{
+    switch (val.type())
+    {
+    case LLSD::TypeUndefined:
+        out.append("null");
+        break;
+    case LLSD::TypeBoolean:
+        out.append(val.asBoolean() ? "true" : "false");
+        break;
+    case LLSD::TypeInteger:
+    {
+        char buffer[16];
+        out.append(buffer, snprintf(buffer, sizeof(buffer), "%d", val.asInteger()));
+        break;
+    }
+    case LLSD::TypeReal:
+        append_json_real(out, val.asReal());
+        break;
+    case LLSD::TypeString:
+        append_json_string(out, val.asStringRef());
+        break;
+    case LLSD::TypeURI:
+    case LLSD::TypeDate:
+    case LLSD::TypeUUID:
+        append_json_string(out, val.asString());
+        break;
+    case LLSD::TypeMap:
+    {
+        out.push_back('{');
+        bool first = true;
+        for (LLSD::map_const_iterator it = val.beginMap(); it != val.endMap(); ++it)
+        {
+            if (! first)
+            {
+                out.push_back(',');
+            }
+            first = false;
+            append_json_string(out, it->first);
+            out.push_back(':');
+            append_json(out, it->second);
+        }
+        out.push_back('}');
+        break;
+    }
+    case LLSD::TypeArray:
+    {
+        out.push_back('[');
+        bool first = true;
+        for (LLSD::array_const_iterator it = val.beginArray(); it != val.endArray(); ++it)
+        {
+            if (! first)
+            {
+                out.push_back(',');
+            }
+            first = false;
+            append_json(out, *it);
+        }
+        out.push_back(']');
+        break;
+    }
+    case LLSD::TypeBinary:
+    default:
+        LL_ERRS("LlsdToJson") << "Unsupported conversion to JSON from LLSD type (" << val.type() << ")." << LL_ENDL;
+        break;
+    }
+}
+
+} // anonymous namespace
+
+//=========================================================================
+bool LlsdFromJsonString(const char* text, size_t length, LLSD& result, std::string* error)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
+    return LLJsonParser(text, length).parse(result, error);
+}
+
+bool LlsdFromJsonString(const std::string& text, LLSD& result, std::string* error)
+{
+    return LlsdFromJsonString(text.data(), text.size(), result, error);
+}
+
+//=========================================================================
+std::string LlsdToJsonString(const LLSD& val)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
+    std::string result;
+    append_json(result, val);
+    return result;
+}
@@ -74,4 +74,22 @@ LLSD LlsdFromJson(const Json::Value &val);
 /// TypeBinary    | unsupported 
 Json::Value LlsdToJson(const LLSD &val);
 
+/// Parse JSON text directly into LLSD, without building a Json::Value first.
+/// Types are converted as for LlsdFromJson(), except that an integer outside
+/// the 32-bit range of LLSD::Integer becomes LLSD::Real rather than being
+/// truncated.
+///
+/// Like jsoncpp's default reader, this accepts // and /* */ comments and
+/// unescaped control characters within strings. Anything else outside
+/// RFC 8259, including text after the root value, is an error: the parse
+/// returns false and, if @a error is non-NULL, describes the problem and its
+/// offset.
+bool LlsdFromJsonString(const char* text, size_t length, LLSD& result, std::string* error = NULL);
+bool LlsdFromJsonString(const std::string& text, LLSD& result, std::string* error = NULL);
+
+/// Serialize LLSD as compact JSON text, equivalent to writing LlsdToJson(val)
+/// with Json::FastWriter (minus its trailing newline) but without building a
+/// Json::Value first. Non-ASCII UTF-8 is written as is rather than escaped.
+std::string LlsdToJsonString(const LLSD& val);
+
 #endif // LL_LLSDJSON_H
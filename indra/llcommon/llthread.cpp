@@ -34,6 +34,7 @@
 #include "lltimer.h"
 #include "lltrace.h"
 #include "lltracethreadrecorder.h"
+#include "lltracetimeline.h"
 #include "llexception.h"
 
 #if LL_LINUX
@@ -136,6 +137,7 @@ void LLThread::threadRun()
 #endif
 
     LL_PROFILER_SET_THREAD_NAME( mName.c_str() );
+    LLTrace::Timeline::setThreadName(mName);
 
     // this is the first point at which we're actually running in the new thread
     mID = currentID();
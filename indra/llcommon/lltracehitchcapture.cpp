@@ -0,0 +1,214 @@
+/**
+ * @file   lltracehitchcapture.cpp
+ * @date   2023-03-27
+ * @brief  Implementation for lltracehitchcapture.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "lltracehitchcapture.h"
+// STL headers
+#include <ostream>
+#include <unordered_map>
+// std headers
+// external library headers
+// other Linden headers
+#include "llfasttimer.h"
+#include "llfile.h"
+#include "lltracerecording.h"
+
+namespace LLTrace
+{
+
+namespace
+{
+
+const U32 HITCH_CAPTURE_VERSION = 1;
+
+// Write fixed-size fields little-endian regardless of host byte order, so
+// the summary script needn't care where the file came from.
+void write_u16(std::ostream& out, U16 value)
+{
+    char bytes[2] = { char(value & 0xff), char(value >> 8) };
+    out.write(bytes, sizeof(bytes));
+}
+
+void write_u32(std::ostream& out, U32 value)
+{
+    char bytes[4];
+    for (size_t i = 0; i < sizeof(bytes); ++i)
+    {
+        bytes[i] = char((value >> (8 * i)) & 0xff);
+    }
+    out.write(bytes, sizeof(bytes));
+}
+
+void write_f32(std::ostream& out, F32 value)
+{
+    U32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    write_u32(out, bits);
+}
+
+void write_name(std::ostream& out, const std::string& name)
+{
+    U16 length = U16(llmin(name.length(), size_t(U16_MAX)));
+    write_u16(out, length);
+    out.write(name.data(), length);
+}
+
+U32 to_usec(F64Seconds seconds)
+{
+    return U32(llclamp(seconds.value() * 1000000.0, 0.0, F64(U32_MAX)));
+}
+
+} // anonymous namespace
+
+HitchCapture::HitchCapture(size_t frames):
+    mFrames(llmax(frames, size_t(1))),
+    mNext(0),
+    mCaptured(0)
+{}
+
+void HitchCapture::setFrameCount(size_t frames)
+{
+    mFrames.clear();
+    mFrames.resize(llmax(frames, size_t(1)));
+    clear();
+}
+
+void HitchCapture::addCounter(const std::string& name, const counter_t& total)
+{
+    mCounters.push_back(Counter{ name, total, total() });
+    clear();
+}
+
+void HitchCapture::clear()
+{
+    mNext = 0;
+    mCaptured = 0;
+}
+
+void HitchCapture::captureFrame(U32 frame_number, Recording& frame)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_STATS;
+    // Reuse the slot's vectors: once the ring has filled, capturing a frame
+    // allocates nothing unless the tree grows.
+    Frame& slot(mFrames[mNext]);
+    slot.mFrameNumber = frame_number;
+    slot.mFrameMs = F32(frame.getDuration().value() * 1000.0);
+
+    slot.mCounters.resize(mCounters.size());
+    for (size_t i = 0; i < mCounters.size(); ++i)
+    {
+        U64 total = mCounters[i].mTotal();
+        slot.mCounters[i] = U32(total - mCounters[i].mLast);
+        mCounters[i].mLast = total;
+    }
+
+    slot.mEntries.clear();
+    for (block_timer_tree_df_iterator_t it = begin_block_timer_tree_df(BlockTimer::getRootTimeBlock());
+         it != end_block_timer_tree_df();
+         ++it)
+    {
+        BlockTimerStatHandle* timer = *it;
+        S32 calls = frame.getSum(timer->callCount());
+        if (calls <= 0)
+        {
+            continue;
+        }
+        // the root is its own parent
+        BlockTimerStatHandle* parent = timer->getParent();
+        slot.mEntries.push_back(Entry{ timer, parent? parent : timer, U32(calls),
+                                       to_usec(frame.getSum(*timer)),
+                                       to_usec(frame.getSum(timer->selfTime())) });
+    }
+
+    mNext = (mNext + 1) % mFrames.size();
+    mCaptured = llmin(mCaptured + 1, mFrames.size());
+}
+
+bool HitchCapture::write(std::ostream& out) const
+{
+    const size_t first = (mNext + mFrames.size() - mCaptured) % mFrames.size();
+
+    // Number the timers that actually appear, in order of appearance.
+    std::unordered_map<const BlockTimerStatHandle*, U16> ids;
+    std::vector<const BlockTimerStatHandle*> timers;
+    auto id_of = [&ids, &timers](const BlockTimerStatHandle* timer)
+    {
+        auto inserted = ids.emplace(timer, U16(timers.size()));
+        if (inserted.second)
+        {
+            timers.push_back(timer);
+        }
+        return inserted.first->second;
+    };
+    for (size_t i = 0; i < mCaptured; ++i)
+    {
+        for (const Entry& entry : mFrames[(first + i) % mFrames.size()].mEntries)
+        {
+            id_of(entry.mTimer);
+            id_of(entry.mParent);
+        }
+    }
+
+    out.write("LLHC", 4);
+    write_u32(out, HITCH_CAPTURE_VERSION);
+    write_u32(out, U32(timers.size()));
+    for (const BlockTimerStatHandle* timer : timers)
+    {
+        write_name(out, timer->getName());
+    }
+    write_u32(out, U32(mCounters.size()));
+    for (const Counter& counter : mCounters)
+    {
+        write_name(out, counter.mName);
+    }
+
+    write_u32(out, U32(mCaptured));
+    for (size_t i = 0; i < mCaptured; ++i)
+    {
+        const Frame& frame(mFrames[(first + i) % mFrames.size()]);
+        write_u32(out, frame.mFrameNumber);
+        write_f32(out, frame.mFrameMs);
+        for (U32 count : frame.mCounters)
+        {
+            write_u32(out, count);
+        }
+        write_u32(out, U32(frame.mEntries.size()));
+        for (const Entry& entry : frame.mEntries)
+        {
+            write_u16(out, id_of(entry.mTimer));
+            write_u16(out, id_of(entry.mParent));
+            write_u32(out, entry.mCalls);
+            write_u32(out, entry.mTotalUsec);
+            write_u32(out, entry.mSelfUsec);
+        }
+    }
+    return out.good();
+}
+
+bool HitchCapture::write(const std::string& filename) const
+{
+    llofstream out(filename.c_str(), std::ios::out | std::ios::binary);
+    if (! out.is_open())
+    {
+        LL_WARNS("HitchCapture") << "Unable to open " << filename << LL_ENDL;
+        return false;
+    }
+    if (! write(out))
+    {
+        LL_WARNS("HitchCapture") << "Error writing " << filename << LL_ENDL;
+        return false;
+    }
+    LL_INFOS("HitchCapture") << "Wrote " << mCaptured << " frames to " << filename << LL_ENDL;
+    return true;
+}
+
+} // namespace LLTrace
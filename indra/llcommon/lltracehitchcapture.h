@@ -0,0 +1,125 @@
+/**
+ * @file   lltracehitchcapture.h
+ * @date   2023-03-27
+ * @brief  Rolling buffer of per-frame timer trees and counters, saved to a
+ *         compact binary file when a frame spikes.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_LLTRACEHITCHCAPTURE_H)
+#define LL_LLTRACEHITCHCAPTURE_H
+
+#include "stdtypes.h"
+#include "llpreprocessor.h"
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace LLTrace
+{
+
+class BlockTimerStatHandle;
+class Recording;
+
+/**
+ * The Fast Timers floater and the performance log only ever show averages
+ * or the most recent frame, so by the time anyone looks, the frame that
+ * hitched is long gone. HitchCapture keeps the full timer tree of each of
+ * the last N frames, along with a handful of counters, and writes them all
+ * out when asked -- typically right after a frame that took too long.
+ *
+ * Counters are cumulative totals read once per frame; HitchCapture stores
+ * the per-frame delta. That lets a counter be bumped from any thread with a
+ * plain atomic increment, without relying on LLTrace's thread recorders to
+ * deliver the count in the same frame.
+ *
+ * captureFrame() walks the timer tree as the Fast Timers floater does, so
+ * BlockTimer::processTimes() must have run for the tree to be meaningful.
+ * Not thread safe: call everything from the main thread.
+ *
+ * File format (version 1), all integers little-endian:
+ * @code
+ * "LLHC" U32 version
+ * U32 ntimers   { U16 length, name bytes } * ntimers
+ * U32 ncounters { U16 length, name bytes } * ncounters
+ * U32 nframes   { U32 frame number, F32 frame ms, U32 counter[ncounters],
+ *                 U32 nentries { U16 timer, U16 parent,
+ *                                U32 calls, U32 total usec, U32 self usec } * nentries
+ *               } * nframes
+ * @endcode
+ * Entries are in depth-first order; the root timer is its own parent.
+ * scripts/perf/hitch_summary.py summarizes these files.
+ */
+class LL_COMMON_API HitchCapture
+{
+public:
+    typedef std::function<U64()> counter_t;
+
+    HitchCapture(size_t frames = 120);
+
+    /// Number of frames retained. Discards anything already captured.
+    void setFrameCount(size_t frames);
+    size_t getFrameCount() const { return mFrames.size(); }
+
+    /**
+     * Track a counter. @a total must return a running total; each captured
+     * frame records how much it advanced since the previous frame. Adding a
+     * counter discards anything already captured.
+     */
+    void addCounter(const std::string& name, const counter_t& total);
+
+    /**
+     * Capture the frame described by @a frame, normally
+     * get_frame_recording().getLastRecording() right after nextPeriod().
+     */
+    void captureFrame(U32 frame_number, Recording& frame);
+
+    /// number of frames currently held, up to getFrameCount()
+    size_t size() const { return mCaptured; }
+
+    void clear();
+
+    /// Write held frames, oldest first. Returns false on stream error.
+    bool write(std::ostream& out) const;
+    /// Same, to the named file.
+    bool write(const std::string& filename) const;
+
+private:
+    struct Entry
+    {
+        BlockTimerStatHandle* mTimer;
+        BlockTimerStatHandle* mParent;
+        U32 mCalls;
+        U32 mTotalUsec;
+        U32 mSelfUsec;
+    };
+
+    struct Frame
+    {
+        U32 mFrameNumber;
+        F32 mFrameMs;
+        std::vector<U32> mCounters;
+        std::vector<Entry> mEntries;
+    };
+
+    struct Counter
+    {
+        std::string mName;
+        counter_t mTotal;
+        U64 mLast;
+    };
+
+    std::vector<Frame> mFrames;
+    // next slot to overwrite
+    size_t mNext;
+    size_t mCaptured;
+    std::vector<Counter> mCounters;
+};
+
+} // namespace LLTrace
+
+#endif /* ! defined(LL_LLTRACEHITCHCAPTURE_H) */
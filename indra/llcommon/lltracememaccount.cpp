@@ -0,0 +1,99 @@
+/**
+ * @file   lltracememaccount.cpp
+ * @date   2023-04-03
+ * @brief  Implementation for lltracememaccount.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "lltracememaccount.h"
+// STL headers
+#include <iomanip>
+#include <sstream>
+// std headers
+// external library headers
+// other Linden headers
+#include "llerror.h"
+
+namespace LLTrace
+{
+
+MemAccount::MemAccount(const char* name, const char* description):
+    LLInstanceTracker<MemAccount, std::string>(name),
+    mStat(name, description)
+{}
+
+S64 MemAccount::getBytes() const
+{
+    // Read the freed total first: an object's bytes are always claimed
+    // before they are disclaimed, so this order can't go negative.
+    U64 freed = mFreed.load(std::memory_order_acquire);
+    U64 allocated = mAllocated.load(std::memory_order_acquire);
+    return S64(allocated - freed);
+}
+
+// static
+void MemAccount::updateStats()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_STATS;
+    for (auto& account : instance_snapshot())
+    {
+        U64 freed = account.mFreed.load(std::memory_order_acquire);
+        U64 allocated = account.mAllocated.load(std::memory_order_acquire);
+        S64 bytes = S64(allocated - freed);
+        account.mPeak = llmax(account.mPeak, bytes);
+
+#if LL_TRACE_ENABLED
+        MemAccumulator& accumulator = account.mStat.getCurrentAccumulator();
+        if (allocated != account.mReportedAllocated)
+        {
+            accumulator.mAllocations.record(F64(allocated - account.mReportedAllocated));
+        }
+        if (freed != account.mReportedFreed)
+        {
+            accumulator.mDeallocations.add(F64(freed - account.mReportedFreed));
+        }
+        accumulator.mSize.sample(F64(bytes));
+#endif
+        account.mReportedAllocated = allocated;
+        account.mReportedFreed = freed;
+    }
+}
+
+// static
+LLSD MemAccount::snapshot()
+{
+    LLSD result(LLSD::emptyMap());
+    for (auto& account : instance_snapshot())
+    {
+        LLSD entry;
+        // LLSD::Integer is only 32 bits; byte counts can exceed that
+        entry["bytes"] = LLSD::Real(account.getBytes());
+        entry["objects"] = LLSD::Real(account.getObjects());
+        entry["peak"] = LLSD::Real(account.getPeakBytes());
+        result[account.getName()] = entry;
+    }
+    return result;
+}
+
+// static
+void MemAccount::logSnapshot()
+{
+    std::ostringstream out;
+    out << "Memory by subsystem (KB current / KB peak / objects):";
+    for (auto& account : instance_snapshot())
+    {
+        out << "\n  " << std::left << std::setw(20) << account.getName() << std::right
+            << std::setw(12) << account.getBytes() / 1024
+            << std::setw(12) << account.getPeakBytes() / 1024
+            << std::setw(10) << account.getObjects();
+    }
+    LL_INFOS("MemAccount") << out.str() << LL_ENDL;
+}
+
+} // namespace LLTrace
@@ -0,0 +1,108 @@
+/**
+ * @file   lltracememaccount.h
+ * @date   2023-04-03
+ * @brief  Thread-safe per-subsystem memory counters, reported through LLTrace.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_LLTRACEMEMACCOUNT_H)
+#define LL_LLTRACEMEMACCOUNT_H
+
+#include "llinstancetracker.h"
+#include "llsd.h"
+#include "lltrace.h"
+#include <atomic>
+#include <string>
+
+namespace LLTrace
+{
+
+/**
+ * A MemAccount tallies the bytes and objects currently held by one
+ * subsystem: decoded images, volume faces, vertex buffer client copies and
+ * so forth. claim_alloc() and disclaim_alloc() record into the calling
+ * thread's LLTrace recorder, which for most worker threads is never merged
+ * back into the frame recording; the owners of these allocations are freely
+ * created and destroyed on the texture, mesh and HTTP threads. So a
+ * MemAccount keeps plain atomic totals that any thread may bump, and the
+ * main thread publishes them each frame with updateStats(), which feeds the
+ * account's MemStatHandle of the same name. That handle is what the
+ * Statistics floater and the scene monitor display.
+ *
+ * Like any LLTrace stat, an account must be constructed before the thread
+ * recorders size their accumulator buffers, so make each one a static:
+ * @code
+ * static LLTrace::MemAccount sMemAccount("LLVOCacheEntry");
+ * ...
+ * sMemAccount.claim(sizeof(*this) + buffer_size);
+ * @endcode
+ */
+class LL_COMMON_API MemAccount : public LLInstanceTracker<MemAccount, std::string>
+{
+public:
+    MemAccount(const char* name, const char* description = "");
+
+    /// One more object, holding @a bytes.
+    void claim(size_t bytes)
+    {
+        mAllocated.fetch_add(bytes, std::memory_order_relaxed);
+        mObjects.fetch_add(1, std::memory_order_relaxed);
+    }
+    /// One object fewer, releasing @a bytes.
+    void disclaim(size_t bytes)
+    {
+        mFreed.fetch_add(bytes, std::memory_order_relaxed);
+        mObjects.fetch_sub(1, std::memory_order_relaxed);
+    }
+    /// An existing object grew (@a bytes > 0) or shrank (@a bytes < 0).
+    void adjust(S64 bytes)
+    {
+        if (bytes > 0)
+        {
+            mAllocated.fetch_add(U64(bytes), std::memory_order_relaxed);
+        }
+        else if (bytes < 0)
+        {
+            mFreed.fetch_add(U64(-bytes), std::memory_order_relaxed);
+        }
+    }
+
+    const std::string& getName() const { return mStat.getName(); }
+    MemStatHandle& getStat() { return mStat; }
+
+    /// bytes currently held
+    S64 getBytes() const;
+    /// objects currently held
+    S64 getObjects() const { return mObjects.load(std::memory_order_relaxed); }
+    /// largest getBytes() seen by updateStats()
+    S64 getPeakBytes() const { return mPeak; }
+
+    /// Publish every account to its MemStatHandle. Call once per frame from
+    /// the main thread.
+    static void updateStats();
+
+    /// { name: { bytes, objects, peak } } for every account
+    static LLSD snapshot();
+    /// Write a table of every account to the log.
+    static void logSnapshot();
+
+private:
+    MemStatHandle mStat;
+    // Monotonic totals: their difference is the current size, and their
+    // growth since the last updateStats() is what LLTrace records as
+    // allocations and deallocations.
+    std::atomic<U64> mAllocated{ 0 };
+    std::atomic<U64> mFreed{ 0 };
+    std::atomic<S64> mObjects{ 0 };
+    // main thread only
+    U64 mReportedAllocated{ 0 };
+    U64 mReportedFreed{ 0 };
+    S64 mPeak{ 0 };
+};
+
+} // namespace LLTrace
+
+#endif /* ! defined(LL_LLTRACEMEMACCOUNT_H) */
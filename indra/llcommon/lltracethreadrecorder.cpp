@@ -29,6 +29,7 @@
 #include "llfasttimer.h"
 #include "lltrace.h"
 #include "llstl.h"
+#include "lltimer.h"
 
 namespace LLTrace
 {
@@ -36,12 +37,19 @@ extern MemStatHandle gTraceMemStat;
 
 static ThreadRecorder* sMasterThreadRecorder = NULL;
 
+// how often pushToParentPeriodically() actually pushes: a few times a frame
+static const U64 PERIODIC_PUSH_INTERVAL_USEC = 5000;
+
 ///////////////////////////////////////////////////////////////////////
 // ThreadRecorder
 ///////////////////////////////////////////////////////////////////////
 
 ThreadRecorder::ThreadRecorder()
-:	mParentRecorder(NULL)
+:	mHasOrphanedRecordings(false),
+	mParentRecorder(NULL),
+	mPendingRecording(NULL),
+	mSpareRecording(NULL),
+	mLastPushTime(0)
 {
 	init();
 }
@@ -89,7 +97,11 @@ void ThreadRecorder::init()
 
 
 ThreadRecorder::ThreadRecorder( ThreadRecorder& parent )
-:	mParentRecorder(&parent)
+:	mHasOrphanedRecordings(false),
+	mParentRecorder(&parent),
+	mPendingRecording(NULL),
+	mSpareRecording(NULL),
+	mLastPushTime(0)
 {
 	init();
 	mParentRecorder->addChildRecorder(this);
@@ -106,6 +118,12 @@ ThreadRecorder::~ThreadRecorder()
 	disclaim_alloc(gTraceMemStat, sizeof(TimeBlockTreeNode) * mNumTimeBlockTreeNodes);
 
 	deactivate(&mThreadRecordingBuffers);
+	if (mParentRecorder)
+	{
+		// hand over whatever was recorded since the last push; the parent
+		// collects it when we remove ourselves below
+		publishToParent();
+	}
 
 	delete mRootTimer;
 
@@ -122,6 +140,8 @@ ThreadRecorder::~ThreadRecorder()
 	{
 		mParentRecorder->removeChildRecorder(this);
 	}
+	delete mPendingRecording.exchange(NULL);
+	delete mSpareRecording.exchange(NULL);
 #endif
 }
 
@@ -258,18 +278,63 @@ void ThreadRecorder::removeChildRecorder( class ThreadRecorder* child )
 #if LL_TRACE_ENABLED
 	{ LLMutexLock lock(&mChildListMutex);
 		mChildThreadRecorders.remove(child);
+
+		// keep anything the child published that we haven't pulled yet
+		AccumulatorBufferGroup* pending = child->mPendingRecording.exchange(NULL, std::memory_order_acquire);
+		if (pending)
+		{
+			mOrphanedRecordings.merge(*pending);
+			mHasOrphanedRecordings = true;
+			delete pending;
+		}
+		delete child->mSpareRecording.exchange(NULL, std::memory_order_acquire);
 	}
 #endif
 }
 
+// called by child thread
 void ThreadRecorder::pushToParent()
 {
 #if LL_TRACE_ENABLED
-	{ LLMutexLock lock(&mSharedRecordingMutex);	
-		LLTrace::get_thread_recorder()->bringUpToDate(&mThreadRecordingBuffers);
-		mSharedRecordingBuffers.append(mThreadRecordingBuffers);
-		mThreadRecordingBuffers.reset();
+	if (!mParentRecorder) return;
+
+	LLTrace::get_thread_recorder()->bringUpToDate(&mThreadRecordingBuffers);
+	publishToParent();
+	mLastPushTime = totalTime();
+#endif
+}
+
+// called by child thread
+void ThreadRecorder::pushToParentPeriodically()
+{
+#if LL_TRACE_ENABLED
+	if (!mParentRecorder) return;
+
+	if (totalTime() - mLastPushTime >= PERIODIC_PUSH_INTERVAL_USEC)
+	{
+		pushToParent();
+	}
+#endif
+}
+
+// called by child thread, with mThreadRecordingBuffers up to date
+void ThreadRecorder::publishToParent()
+{
+#if LL_TRACE_ENABLED
+	// If the parent hasn't taken our last push yet, take it back and add to
+	// it; otherwise reuse the group the parent handed back, if any.
+	AccumulatorBufferGroup* outgoing = mPendingRecording.exchange(NULL, std::memory_order_acquire);
+	if (!outgoing)
+	{
+		outgoing = mSpareRecording.exchange(NULL, std::memory_order_acquire);
+	}
+	if (!outgoing)
+	{
+		outgoing = new AccumulatorBufferGroup();
 	}
+	outgoing->append(mThreadRecordingBuffers);
+	mThreadRecordingBuffers.reset();
+	mPendingRecording.store(outgoing, std::memory_order_release);
 #endif
 }
 
@@ -280,6 +345,8 @@ void ThreadRecorder::pullFromChildren()
     LL_PROFILE_ZONE_SCOPED_CATEGORY_STATS;
 	if (mActiveRecordings.empty()) return;
 
+	// The list lock only keeps children from coming and going meanwhile;
+	// children never take it to push their data.
 	{ LLMutexLock lock(&mChildListMutex);
 
 		AccumulatorBufferGroup& target_recording_buffers = mActiveRecordings.back()->mPartialRecording;
@@ -287,10 +354,23 @@ void ThreadRecorder::pullFromChildren()
 		for (child_thread_recorder_list_t::iterator it = mChildThreadRecorders.begin(), end_it = mChildThreadRecorders.end();
 			it != end_it;
 			++it)
-		{ LLMutexLock lock(&(*it)->mSharedRecordingMutex);
+		{
+			ThreadRecorder* child = *it;
+			AccumulatorBufferGroup* pending = child->mPendingRecording.exchange(NULL, std::memory_order_acquire);
+			if (pending)
+			{
+				target_recording_buffers.merge(*pending);
+				pending->reset();
+				// hand it back for reuse, freeing any spare the child didn't need
+				delete child->mSpareRecording.exchange(pending, std::memory_order_acq_rel);
+			}
+		}
 
-			target_recording_buffers.merge((*it)->mSharedRecordingBuffers);
-			(*it)->mSharedRecordingBuffers.reset();
+		if (mHasOrphanedRecordings)
+		{
+			target_recording_buffers.merge(mOrphanedRecordings);
+			mOrphanedRecordings.reset();
+			mHasOrphanedRecordings = false;
 		}
 	}
 #endif
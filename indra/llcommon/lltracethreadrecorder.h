@@ -33,6 +33,7 @@
 #include "llmutex.h"
 #include "lltraceaccumulators.h"
 #include "llthreadlocalstorage.h"
+#include <atomic>
 
 namespace LLTrace
 {
@@ -57,11 +58,15 @@ namespace LLTrace
 		// call this periodically to gather stats data from child threads
 		void pullFromChildren();
 		void pushToParent();
+		// pushToParent(), at most every few milliseconds: cheap enough to
+		// call after each work item on a pool thread
+		void pushToParentPeriodically();
 
 		TimeBlockTreeNode* getTimeBlockTreeNode(S32 index);
 
 	protected:
 		void init();
+		void publishToParent();
 
 	protected:
 		struct ActiveRecording
@@ -85,11 +90,19 @@ namespace LLTrace
 		typedef std::list<class ThreadRecorder*> child_thread_recorder_list_t;
 
 		child_thread_recorder_list_t	mChildThreadRecorders;	// list of child thread recorders associated with this master
-		LLMutex							mChildListMutex;		// protects access to child list
-		LLMutex							mSharedRecordingMutex;
-		AccumulatorBufferGroup			mSharedRecordingBuffers;
+		LLMutex							mChildListMutex;		// protects access to child list and mOrphanedRecordings
+		AccumulatorBufferGroup			mOrphanedRecordings;	// last data from children that have exited, merged on next pull
+		bool							mHasOrphanedRecordings;
 		ThreadRecorder*					mParentRecorder;
 
+		// Hand-off of this thread's data to the parent, without locks.
+		// pushToParent() fills a group and publishes it in mPendingRecording;
+		// pullFromChildren() takes it, merges it and returns it emptied via
+		// mSpareRecording. Whoever holds a group's pointer owns the group.
+		std::atomic<AccumulatorBufferGroup*>	mPendingRecording;
+		std::atomic<AccumulatorBufferGroup*>	mSpareRecording;
+		U64								mLastPushTime;
+
 	};
 
 	const LLThreadLocalPointer<ThreadRecorder>& get_thread_recorder();
@@ -0,0 +1,389 @@
+/**
+ * @file   lltracetimeline.cpp
+ * @date   2023-03-20
+ * @brief  Implementation for lltracetimeline.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "lltracetimeline.h"
+// STL headers
+#include <algorithm>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_set>
+#include <vector>
+// std headers
+// external library headers
+// other Linden headers
+#include "llfasttimer.h"
+#include "llfile.h"
+
+namespace LLTrace
+{
+
+std::atomic<bool> Timeline::sEnabled{ false };
+
+namespace
+{
+
+// Set in Event::mStamp for END events. Clock counts won't reach it.
+const U64 END_BIT = U64(1) << 63;
+
+struct Event
+{
+    std::atomic<U64> mStamp;
+    std::atomic<const char*> mName;
+};
+
+/*****************************************************************************
+*   ThreadBuffer
+*****************************************************************************/
+// Single-writer ring: only the owning thread writes events. Writing an
+// event first advances mClaimed, then fills the slot, then advances
+// mCommitted. A reader copies slots below mCommitted, then rereads mClaimed
+// to find out which of the slots it copied might have been overwritten in
+// the meantime, and discards those.
+struct ThreadBuffer
+{
+    ThreadBuffer(size_t capacity, U32 tid):
+        mEvents(new Event[capacity]()),
+        mCapacity(capacity),
+        mTid(tid)
+    {}
+
+    void write(const char* name, U64 stamp)
+    {
+        U64 index = mClaimed.load(std::memory_order_relaxed);
+        mClaimed.store(index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        Event& event(mEvents[index & (mCapacity - 1)]);
+        event.mName.store(name, std::memory_order_relaxed);
+        event.mStamp.store(stamp, std::memory_order_relaxed);
+        mCommitted.store(index + 1, std::memory_order_release);
+    }
+
+    // Reader side; caller holds Registry::mMutex.
+    void snapshot(std::vector<std::pair<U64, const char*> >& out) const
+    {
+        U64 committed = mCommitted.load(std::memory_order_acquire);
+        U64 first = std::max<U64>(mClearedAt, (committed > mCapacity)? committed - mCapacity : 0);
+        out.clear();
+        out.reserve(size_t(committed - first));
+        for (U64 i = first; i < committed; ++i)
+        {
+            const Event& event(mEvents[i & (mCapacity - 1)]);
+            out.emplace_back(event.mStamp.load(std::memory_order_relaxed),
+                             event.mName.load(std::memory_order_relaxed));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        U64 claimed = mClaimed.load(std::memory_order_relaxed);
+        if (claimed > first + mCapacity)
+        {
+            size_t stale = std::min<size_t>(out.size(), size_t(claimed - mCapacity - first));
+            out.erase(out.begin(), out.begin() + stale);
+        }
+    }
+
+    std::unique_ptr<Event[]> mEvents;
+    const size_t mCapacity;
+    std::atomic<U64> mClaimed{ 0 };
+    std::atomic<U64> mCommitted{ 0 };
+
+    // The rest is guarded by Registry::mMutex.
+    U32 mTid;
+    std::string mThreadName;
+    // events before this index were discarded by clear()
+    U64 mClearedAt{ 0 };
+    // the owning thread has exited
+    bool mOrphaned{ false };
+};
+
+/*****************************************************************************
+*   Registry
+*****************************************************************************/
+struct Registry
+{
+    // Never destroyed: threads may still record during static destruction.
+    static Registry& instance()
+    {
+        static Registry* sInstance = new Registry;
+        return *sInstance;
+    }
+
+    ThreadBuffer* acquire(const std::string& thread_name)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        U32 tid = mNextTid++;
+        ThreadBuffer* result = nullptr;
+        // Recycle the buffer of a finished thread if we can.
+        for (auto& buffer : mBuffers)
+        {
+            if (buffer->mOrphaned && buffer->mCapacity == mCapacity)
+            {
+                result = buffer.get();
+                result->mOrphaned = false;
+                result->mTid = tid;
+                result->mClearedAt = result->mCommitted.load(std::memory_order_relaxed);
+                break;
+            }
+        }
+        if (! result)
+        {
+            mBuffers.emplace_back(new ThreadBuffer(mCapacity, tid));
+            result = mBuffers.back().get();
+        }
+        result->mThreadName = thread_name;
+        return result;
+    }
+
+    void release(ThreadBuffer* buffer)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        buffer->mOrphaned = true;
+    }
+
+    std::mutex mMutex;
+    std::vector<std::unique_ptr<ThreadBuffer> > mBuffers;
+    std::unordered_set<std::string> mNames;
+    size_t mCapacity{ 64 * 1024 };
+    U32 mNextTid{ 1 };
+};
+
+// Each thread's buffer is created on its first event and handed back to the
+// Registry for reuse when the thread exits. Threads that never record an
+// event never pay for a buffer, even if they're named.
+struct BufferHolder
+{
+    ~BufferHolder()
+    {
+        if (mBuffer)
+        {
+            Registry::instance().release(mBuffer);
+            mBuffer = nullptr;
+        }
+    }
+
+    ThreadBuffer& get()
+    {
+        if (! mBuffer)
+        {
+            mBuffer = Registry::instance().acquire(mThreadName);
+        }
+        return *mBuffer;
+    }
+
+    void setThreadName(const std::string& name)
+    {
+        mThreadName = name;
+        if (mBuffer)
+        {
+            std::lock_guard<std::mutex> lock(Registry::instance().mMutex);
+            mBuffer->mThreadName = name;
+        }
+    }
+
+    ThreadBuffer* mBuffer{ nullptr };
+    std::string mThreadName;
+};
+thread_local BufferHolder sThreadBuffer;
+
+void write_json_string(std::ostream& out, const char* str)
+{
+    out << '"';
+    for (const char* p = str; *p; ++p)
+    {
+        unsigned char c = *p;
+        if (c == '"' || c == '\\')
+        {
+            out << '\\' << c;
+        }
+        else if (c < 0x20)
+        {
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c)
+                << std::dec << std::setfill(' ');
+        }
+        else
+        {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // anonymous namespace
+
+/*****************************************************************************
+*   Timeline
+*****************************************************************************/
+//static
+void Timeline::setEnabled(bool enabled)
+{
+    sEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+//static
+void Timeline::setBufferSize(size_t events)
+{
+    size_t capacity = 1024;
+    while (capacity < events)
+    {
+        capacity <<= 1;
+    }
+    Registry& registry(Registry::instance());
+    std::lock_guard<std::mutex> lock(registry.mMutex);
+    registry.mCapacity = capacity;
+}
+
+//static
+void Timeline::record(const char* name, U64 time, Phase phase)
+{
+    sThreadBuffer.get().write(name, (phase == END)? (time | END_BIT) : (time & ~END_BIT));
+}
+
+//static
+void Timeline::begin(const char* name)
+{
+    record(name, BlockTimer::getCPUClockCount64(), BEGIN);
+}
+
+//static
+void Timeline::end(const char* name)
+{
+    record(name, BlockTimer::getCPUClockCount64(), END);
+}
+
+//static
+const char* Timeline::intern(const std::string& name)
+{
+    Registry& registry(Registry::instance());
+    std::lock_guard<std::mutex> lock(registry.mMutex);
+    return registry.mNames.insert(name).first->c_str();
+}
+
+//static
+void Timeline::setThreadName(const std::string& name)
+{
+    sThreadBuffer.setThreadName(name);
+}
+
+//static
+void Timeline::clear()
+{
+    Registry& registry(Registry::instance());
+    std::lock_guard<std::mutex> lock(registry.mMutex);
+    registry.mBuffers.erase(
+        std::remove_if(registry.mBuffers.begin(), registry.mBuffers.end(),
+                       [](const std::unique_ptr<ThreadBuffer>& buffer)
+                       { return buffer->mOrphaned; }),
+        registry.mBuffers.end());
+    for (auto& buffer : registry.mBuffers)
+    {
+        buffer->mClearedAt = buffer->mCommitted.load(std::memory_order_acquire);
+    }
+}
+
+//static
+size_t Timeline::writeChromeTrace(std::ostream& out)
+{
+    struct Track
+    {
+        U32 mTid;
+        std::string mName;
+        std::vector<std::pair<U64, const char*> > mEvents;
+    };
+    std::vector<Track> tracks;
+    {
+        Registry& registry(Registry::instance());
+        std::lock_guard<std::mutex> lock(registry.mMutex);
+        tracks.resize(registry.mBuffers.size());
+        for (size_t i = 0; i < tracks.size(); ++i)
+        {
+            const ThreadBuffer& buffer(*registry.mBuffers[i]);
+            tracks[i].mTid = buffer.mTid;
+            tracks[i].mName = buffer.mThreadName;
+            buffer.snapshot(tracks[i].mEvents);
+        }
+    }
+
+    // Report times relative to the earliest event, in microseconds as
+    // Chrome trace requires, keeping nanosecond precision.
+    U64 base = ~U64(0);
+    for (const Track& track : tracks)
+    {
+        if (! track.mEvents.empty())
+        {
+            base = std::min(base, track.mEvents.front().first & ~END_BIT);
+        }
+    }
+    const F64 usec_per_count = 1000000.0 / F64(BlockTimer::countsPerSecond());
+
+    size_t written = 0;
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    const char* sep = "\n";
+    for (const Track& track : tracks)
+    {
+        if (track.mEvents.empty())
+        {
+            continue;
+        }
+        out << sep << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track.mTid
+            << ",\"args\":{\"name\":";
+        write_json_string(out, track.mName.empty()? ("thread " + std::to_string(track.mTid)).c_str()
+                                                   : track.mName.c_str());
+        out << "}}";
+        sep = ",\n";
+
+        // The oldest events in the ring may be ENDs whose BEGINs were
+        // overwritten; Chrome can't pair those, so drop them.
+        size_t depth = 0;
+        for (const auto& event : track.mEvents)
+        {
+            bool is_end = (event.first & END_BIT) != 0;
+            if (is_end)
+            {
+                if (! depth)
+                {
+                    continue;
+                }
+                --depth;
+            }
+            else
+            {
+                ++depth;
+            }
+            S64 counts = S64((event.first & ~END_BIT) - base);
+            out << sep << "{\"name\":";
+            write_json_string(out, event.second);
+            out << ",\"ph\":\"" << (is_end? 'E' : 'B') << "\",\"pid\":1,\"tid\":" << track.mTid
+                << ",\"ts\":" << std::fixed << std::setprecision(3) << (F64(counts) * usec_per_count)
+                << '}';
+            ++written;
+        }
+    }
+    out << "\n]}\n";
+    return written;
+}
+
+//static
+bool Timeline::writeChromeTrace(const std::string& filename)
+{
+    llofstream out(filename.c_str());
+    if (! out.is_open())
+    {
+        LL_WARNS("Timeline") << "Unable to open " << filename << LL_ENDL;
+        return false;
+    }
+    size_t events = writeChromeTrace(out);
+    LL_INFOS("Timeline") << "Wrote " << events << " timeline events to " << filename << LL_ENDL;
+    return true;
+}
+
+} // namespace LLTrace
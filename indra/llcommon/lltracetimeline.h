@@ -0,0 +1,112 @@
+/**
+ * @file   lltracetimeline.h
+ * @date   2023-03-20
+ * @brief  Ring-buffered begin/end event recorder for BlockTimer scopes and
+ *         thread pool tasks, exported as Chrome trace JSON.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_LLTRACETIMELINE_H)
+#define LL_LLTRACETIMELINE_H
+
+#include "stdtypes.h"
+#include "llpreprocessor.h"
+#include <atomic>
+#include <iosfwd>
+#include <string>
+
+namespace LLTrace
+{
+
+/**
+ * The fast timers aggregate per frame, which is fine for the Fast Timers
+ * floater but says nothing about the order of events within one bad frame.
+ * Timeline keeps the most recent begin/end events from every thread in a
+ * per-thread ring buffer, so that when a frame spikes we can write out what
+ * actually happened in a form chrome://tracing and ui.perfetto.dev can load.
+ *
+ * Recording is off by default. While it's off, each BlockTimer pays for one
+ * relaxed atomic load. While it's on, each event costs two relaxed stores
+ * into the calling thread's buffer: no locks, no allocation, and no extra
+ * clock reads, since we reuse BlockTimer's own timestamps.
+ */
+class LL_COMMON_API Timeline
+{
+public:
+    enum Phase { BEGIN, END };
+
+    static bool isEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+
+    /**
+     * Events retained per thread (rounded up to a power of 2). Only affects
+     * threads that record their first event after the call, so set it
+     * before enabling.
+     */
+    static void setBufferSize(size_t events);
+
+    /**
+     * Record an event on the calling thread. @a time is in
+     * BlockTimer::getCPUClockCount64() units. @a name must remain valid
+     * until the trace is written: pass a string literal, a
+     * BlockTimerStatHandle name or the result of intern().
+     */
+    static void record(const char* name, U64 time, Phase phase);
+    /// record() with the current time
+    static void begin(const char* name);
+    static void end(const char* name);
+
+    /// Return a copy of @a name that lives until program exit.
+    static const char* intern(const std::string& name);
+
+    /// Label the calling thread's track in the trace.
+    static void setThreadName(const std::string& name);
+
+    /// Discard recorded events and release buffers of finished threads.
+    static void clear();
+
+    /// Write the recorded events as Chrome trace JSON. Returns the number of
+    /// events written.
+    static size_t writeChromeTrace(std::ostream& out);
+    /// Same, to the named file. Returns false if the file can't be opened.
+    static bool writeChromeTrace(const std::string& filename);
+
+private:
+    static std::atomic<bool> sEnabled;
+};
+
+/// Timeline begin/end pair for a scope that isn't a BlockTimerStatHandle,
+/// such as a WorkQueue task.
+class TimelineScope
+{
+public:
+    TimelineScope(const char* name):
+        mName(Timeline::isEnabled()? name : nullptr)
+    {
+        if (mName)
+        {
+            Timeline::begin(mName);
+        }
+    }
+
+    ~TimelineScope()
+    {
+        if (mName)
+        {
+            Timeline::end(mName);
+        }
+    }
+
+    TimelineScope(const TimelineScope&) = delete;
+    TimelineScope& operator=(const TimelineScope&) = delete;
+
+private:
+    const char* mName;
+};
+
+} // namespace LLTrace
+
+#endif /* ! defined(LL_LLTRACETIMELINE_H) */
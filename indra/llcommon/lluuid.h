@@ -26,6 +26,7 @@
 #ifndef LL_LLUUID_H
 #define LL_LLUUID_H
 
+#include <cstring>
 #include <iostream>
 #include <set>
 #include <vector>
@@ -119,6 +120,16 @@ public:
 	U16 getCRC16() const;
 	U32 getCRC32() const;
 
+	// The bytes of a UUID are already uniformly distributed, so folding the
+	// two halves together is as good a hash as combining every byte.
+	size_t hash() const
+	{
+		U64 lo, hi;
+		memcpy(&lo, mData, sizeof(lo));
+		memcpy(&hi, mData + sizeof(lo), sizeof(hi));
+		return (size_t)(lo ^ hi);
+	}
+
 	static BOOL validate(const std::string& in_string); // Validate that the UUID string is legal.
 
 	static const LLUUID null;
@@ -173,14 +184,7 @@ struct boost::hash<LLUUID>
     typedef std::size_t result_type;
     result_type operator()(argument_type const& s) const
     {
-        result_type seed(0);
-
-        for (S32 i = 0; i < UUID_BYTES; ++i)
-        {
-            boost::hash_combine(seed, s.mData[i]);
-        }
-
-        return seed;
+        return s.hash();
     }
 };
 
@@ -0,0 +1,473 @@
+/**
+ * @file lluuidhashmap.h
+ * @brief Open-addressing hash map keyed by LLUUID.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLUUIDHASHMAP_H
+#define LL_LLUUIDHASHMAP_H
+
+#include "lldefs.h"
+#include "lluuid.h"
+
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+// LLUUIDHashMap is a drop-in replacement for std::map<LLUUID, DATA> in hot
+// lookup tables (object list, inventory model, mesh headers, ...). It stores
+// entries in one flat array using Robin Hood linear probing, so a lookup
+// usually touches a single cache line instead of walking a red-black tree.
+//
+// The probe sequence never wraps around: the slot array carries a tail of
+// mMaxProbe extra slots, and the table grows if an entry would have to be
+// placed further than that from its home slot. Combined with backward-shift
+// deletion (no tombstones) this means erase() only ever moves entries towards
+// the front of the array, so the usual
+//
+//     for (iter = map.begin(); iter != map.end(); )
+//         if (cond) iter = map.erase(iter); else ++iter;
+//
+// loop visits every entry exactly once.
+//
+// Differences from std::map worth knowing about:
+//  - iteration order is unspecified (not sorted by UUID);
+//  - insertion may invalidate all iterators, pointers and references;
+//  - erase invalidates iterators, pointers and references to the erased
+//    entry and to entries after it in iteration order.
+template <typename DATA>
+class LLUUIDHashMap
+{
+public:
+	typedef LLUUID key_type;
+	typedef DATA mapped_type;
+	typedef std::pair<const LLUUID, DATA> value_type;
+	typedef size_t size_type;
+
+private:
+	// mProbe[i] == 0 means slot i is empty, otherwise it is the 1-based
+	// distance of the entry in slot i from its home slot.
+	static const U8 EMPTY = 0;
+	// mProbe[mSlotCount] holds SENTINEL so iterators stop at end().
+	static const U8 SENTINEL = 0xff;
+	static const size_type MIN_CAPACITY = 16;
+
+	template <typename VALUE>
+	class iterator_base
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef VALUE value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef VALUE* pointer;
+		typedef VALUE& reference;
+
+		iterator_base() : mSlot(NULL), mProbe(NULL) {}
+		iterator_base(VALUE* slot, const U8* probe) : mSlot(slot), mProbe(probe) {}
+		// allow iterator -> const_iterator conversion
+		template <typename OTHER>
+		iterator_base(const iterator_base<OTHER>& other) : mSlot(other.mSlot), mProbe(other.mProbe) {}
+
+		reference operator*() const { return *mSlot; }
+		pointer operator->() const { return mSlot; }
+
+		iterator_base& operator++()
+		{
+			do
+			{
+				++mSlot;
+				++mProbe;
+			}
+			while (*mProbe == EMPTY);
+			return *this;
+		}
+
+		iterator_base operator++(int)
+		{
+			iterator_base prev(*this);
+			++(*this);
+			return prev;
+		}
+
+		template <typename OTHER>
+		bool operator==(const iterator_base<OTHER>& rhs) const { return mProbe == rhs.mProbe; }
+		template <typename OTHER>
+		bool operator!=(const iterator_base<OTHER>& rhs) const { return mProbe != rhs.mProbe; }
+
+	private:
+		template <typename OTHER> friend class iterator_base;
+		friend class LLUUIDHashMap;
+
+		VALUE* mSlot;
+		const U8* mProbe;
+	};
+
+public:
+	typedef iterator_base<value_type> iterator;
+	typedef iterator_base<const value_type> const_iterator;
+
+	LLUUIDHashMap()
+	:	mSlots(NULL),
+		mProbe(const_cast<U8*>(&sEmptyProbe[0])),
+		mMask(0),
+		mSlotCount(0),
+		mShift(64),
+		mMaxProbe(0),
+		mSize(0)
+	{
+	}
+
+	LLUUIDHashMap(const LLUUIDHashMap& other)
+	:	LLUUIDHashMap()
+	{
+		reserve(other.size());
+		for (const_iterator it = other.begin(), end = other.end(); it != end; ++it)
+		{
+			insertUnique(value_type(*it));
+		}
+	}
+
+	LLUUIDHashMap(LLUUIDHashMap&& other)
+	:	LLUUIDHashMap()
+	{
+		swap(other);
+	}
+
+	LLUUIDHashMap& operator=(LLUUIDHashMap other)
+	{
+		swap(other);
+		return *this;
+	}
+
+	~LLUUIDHashMap()
+	{
+		clear();
+		deallocate();
+	}
+
+	void swap(LLUUIDHashMap& other)
+	{
+		std::swap(mSlots, other.mSlots);
+		std::swap(mProbe, other.mProbe);
+		std::swap(mMask, other.mMask);
+		std::swap(mSlotCount, other.mSlotCount);
+		std::swap(mShift, other.mShift);
+		std::swap(mMaxProbe, other.mMaxProbe);
+		std::swap(mSize, other.mSize);
+	}
+
+	//
+	// ITERATORS
+	//
+	iterator begin()
+	{
+		iterator it(mSlots, mProbe);
+		if (*mProbe == EMPTY)
+		{
+			++it;
+		}
+		return it;
+	}
+	const_iterator begin() const { return const_cast<LLUUIDHashMap*>(this)->begin(); }
+	const_iterator cbegin() const { return begin(); }
+
+	iterator end() { return iterator(mSlots + mSlotCount, mProbe + mSlotCount); }
+	const_iterator end() const { return const_cast<LLUUIDHashMap*>(this)->end(); }
+	const_iterator cend() const { return end(); }
+
+	//
+	// ACCESSORS
+	//
+	bool empty() const { return mSize == 0; }
+	size_type size() const { return mSize; }
+	// Number of home slots; the probe tail is not included.
+	size_type bucket_count() const { return mSlotCount ? mMask + 1 : 0; }
+	F32 load_factor() const { return mSlotCount ? (F32)mSize / (F32)(mMask + 1) : 0.f; }
+	// Heap bytes held by the table, for memory budgeting and benchmarks.
+	size_type getMemoryUsage() const
+	{
+		return mSlotCount ? mSlotCount * sizeof(value_type) + mSlotCount + 1 : 0;
+	}
+
+	iterator find(const LLUUID& key)
+	{
+		if (mSlotCount)
+		{
+			size_type idx = homeSlot(key);
+			for (U8 dist = 1; mProbe[idx] >= dist; ++idx, ++dist)
+			{
+				if (mSlots[idx].first == key)
+				{
+					return iterator(mSlots + idx, mProbe + idx);
+				}
+			}
+		}
+		return end();
+	}
+	const_iterator find(const LLUUID& key) const { return const_cast<LLUUIDHashMap*>(this)->find(key); }
+
+	size_type count(const LLUUID& key) const { return find(key) != end() ? 1 : 0; }
+
+	DATA& at(const LLUUID& key)
+	{
+		iterator it = find(key);
+		if (it == end())
+		{
+			throw std::out_of_range("LLUUIDHashMap::at");
+		}
+		return it->second;
+	}
+	const DATA& at(const LLUUID& key) const { return const_cast<LLUUIDHashMap*>(this)->at(key); }
+
+	//
+	// MANIPULATORS
+	//
+	DATA& operator[](const LLUUID& key)
+	{
+		iterator it = find(key);
+		if (it != end())
+		{
+			return it->second;
+		}
+		return insertUnique(value_type(std::piecewise_construct,
+									   std::forward_as_tuple(key),
+									   std::forward_as_tuple()))->second;
+	}
+
+	std::pair<iterator, bool> insert(const value_type& value)
+	{
+		return emplace(value.first, value.second);
+	}
+
+	template <typename... ARGS>
+	std::pair<iterator, bool> emplace(const LLUUID& key, ARGS&&... args)
+	{
+		iterator it = find(key);
+		if (it != end())
+		{
+			return std::make_pair(it, false);
+		}
+		return std::make_pair(insertUnique(value_type(std::piecewise_construct,
+													  std::forward_as_tuple(key),
+													  std::forward_as_tuple(std::forward<ARGS>(args)...))),
+							  true);
+	}
+
+	size_type erase(const LLUUID& key)
+	{
+		iterator it = find(key);
+		if (it == end())
+		{
+			return 0;
+		}
+		erase(it);
+		return 1;
+	}
+
+	// Returns an iterator to the entry following the erased one.
+	iterator erase(const_iterator pos)
+	{
+		size_type idx = pos.mProbe - mProbe;
+		mSlots[idx].~value_type();
+		// backward-shift deletion: pull the following displaced entries one
+		// slot closer to home until we reach an empty or home-slotted entry
+		size_type next = idx + 1;
+		for (; next < mSlotCount && mProbe[next] > 1; ++next)
+		{
+			new (mSlots + next - 1) value_type(std::move(mSlots[next]));
+			mSlots[next].~value_type();
+			mProbe[next - 1] = mProbe[next] - 1;
+		}
+		mProbe[next - 1] = EMPTY;
+		--mSize;
+
+		iterator it(mSlots + idx, mProbe + idx);
+		if (mProbe[idx] == EMPTY)
+		{
+			++it;
+		}
+		return it;
+	}
+
+	void clear()
+	{
+		for (size_type i = 0; i < mSlotCount; ++i)
+		{
+			if (mProbe[i] != EMPTY)
+			{
+				mSlots[i].~value_type();
+				mProbe[i] = EMPTY;
+			}
+		}
+		mSize = 0;
+	}
+
+	// Make room for at least count entries without further rehashing.
+	void reserve(size_type count)
+	{
+		size_type capacity = MIN_CAPACITY;
+		while (count >= maxLoad(capacity))
+		{
+			capacity <<= 1;
+		}
+		if (capacity > bucket_count())
+		{
+			rehash(capacity);
+		}
+	}
+
+private:
+	// A UUID's bytes are already uniformly distributed, so LLUUID::hash()
+	// just folds the two halves. Multiplying by the golden ratio and taking
+	// the high bits protects us from the few hand-made UUIDs (library
+	// folders, default textures) that differ only in their low bytes.
+	size_type homeSlot(const LLUUID& key) const
+	{
+		return (size_type)(((U64)key.hash() * 0x9E3779B97F4A7C15ULL) >> mShift) & mMask;
+	}
+
+	// keep the load factor at or below 7/8
+	static size_type maxLoad(size_type capacity) { return capacity - (capacity >> 3); }
+
+	// Insert an entry whose key is known not to be present.
+	iterator insertUnique(value_type&& value)
+	{
+		if (mSize + 1 > maxLoad(bucket_count()))
+		{
+			rehash(mSlotCount ? (mMask + 1) << 1 : MIN_CAPACITY);
+		}
+
+		const LLUUID key(value.first);
+		size_type idx = homeSlot(key);
+		U8 dist = 1;
+		// index where the new entry came to rest, once it has been placed
+		size_type placed = mSlotCount;
+		for (;; ++idx, ++dist)
+		{
+			if (dist > mMaxProbe)
+			{
+				// Probe sequence too long: grow and re-place whatever
+				// entry we are currently carrying.
+				rehash((mMask + 1) << 1);
+				insertUnique(std::move(value));
+				return find(key);
+			}
+			if (mProbe[idx] == EMPTY)
+			{
+				new (mSlots + idx) value_type(std::move(value));
+				mProbe[idx] = dist;
+				++mSize;
+				if (placed == mSlotCount)
+				{
+					placed = idx;
+				}
+				return iterator(mSlots + placed, mProbe + placed);
+			}
+			if (mProbe[idx] < dist)
+			{
+				// Robin Hood: the resident is closer to home than we are,
+				// so take its slot and carry it further along instead.
+				value_type resident(std::move(mSlots[idx]));
+				mSlots[idx].~value_type();
+				new (mSlots + idx) value_type(std::move(value));
+				value.~value_type();
+				new (&value) value_type(std::move(resident));
+				std::swap(dist, mProbe[idx]);
+				if (placed == mSlotCount)
+				{
+					placed = idx;
+				}
+			}
+		}
+	}
+
+	void rehash(size_type capacity)
+	{
+		value_type* old_slots = mSlots;
+		U8* old_probe = mProbe;
+		size_type old_count = mSlotCount;
+
+		mMask = capacity - 1;
+		mShift = 64;
+		mMaxProbe = 0;
+		for (size_type c = capacity; c > 1; c >>= 1)
+		{
+			--mShift;
+			++mMaxProbe;
+		}
+		// log2(capacity) is a generous bound on Robin Hood probe length
+		mMaxProbe = llmax<U8>(mMaxProbe, 4);
+		mSlotCount = capacity + mMaxProbe;
+		mSlots = std::allocator<value_type>().allocate(mSlotCount);
+		mProbe = new U8[mSlotCount + 1];
+		memset(mProbe, EMPTY, mSlotCount);
+		mProbe[mSlotCount] = SENTINEL;
+		mSize = 0;
+
+		for (size_type i = 0; i < old_count; ++i)
+		{
+			if (old_probe[i] != EMPTY)
+			{
+				insertUnique(std::move(old_slots[i]));
+				old_slots[i].~value_type();
+			}
+		}
+		if (old_count)
+		{
+			std::allocator<value_type>().deallocate(old_slots, old_count);
+			delete[] old_probe;
+		}
+	}
+
+	void deallocate()
+	{
+		if (mSlotCount)
+		{
+			std::allocator<value_type>().deallocate(mSlots, mSlotCount);
+			delete[] mProbe;
+			mSlots = NULL;
+			mProbe = const_cast<U8*>(&sEmptyProbe[0]);
+			mSlotCount = 0;
+		}
+	}
+
+	// shared by every empty map so begin() == end() without allocating
+	static const U8 sEmptyProbe[1];
+
+	value_type* mSlots;
+	U8* mProbe;
+	size_type mMask;
+	size_type mSlotCount;
+	U32 mShift;
+	U8 mMaxProbe;
+	size_type mSize;
+};
+
+template <typename DATA>
+const U8 LLUUIDHashMap<DATA>::sEmptyProbe[1] = { LLUUIDHashMap<DATA>::SENTINEL };
+
+#endif // LL_LLUUIDHASHMAP_H
@@ -40,11 +40,9 @@ public:
         mData = nullptr;
         mLock.unlock();
     }
-protected:
-    Static* mData;
-    lock_t mLock;
-private:
-    Static* getStatic()
+    // Access the canonical instance WITHOUT locking it: only for members
+    // that are safe to touch concurrently, such as std::atomics.
+    static Static* getStatic()
     {
         // Static::mMutex must be function-local static rather than class-
         // static. Some of our consumers must function properly (therefore
@@ -66,6 +64,9 @@ private:
         static Static sData;
         return &sData;
     }
+protected:
+    Static* mData;
+    lock_t mLock;
 };
 
 } // llthread namespace
@@ -0,0 +1,130 @@
+/**
+ * @file   llcoros_test.cpp
+ * @date   2023-03-09
+ * @brief  Test for llcoros.h stack pooling, plus a launch benchmark.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "llcoros.h"
+// STL headers
+#include <algorithm>
+#include <string>
+// std headers
+// external library headers
+#include <boost/fiber/operations.hpp>
+// other Linden headers
+#include "llmemory.h"
+#include "stringize.h"
+#include "../test/benchmark.h"
+#include "../test/lltestapp.h"
+#include "../test/lltut.h"
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct llcoros_data
+    {
+        LLTestApp testApp;
+
+        ~llcoros_data()
+        {
+            // restore the default for subsequent tests
+            LLCoros::instance().setStackPoolSize(32);
+        }
+
+        // Launch count coroutines that each suspend once, the way a typical
+        // request coroutine waits for its response, and run them all to
+        // completion. Return peak resident set size seen along the way.
+        U64 launch_and_finish(size_t count, size_t yield_every=16)
+        {
+            size_t finished = 0;
+            U64 peak_rss = LLMemory::getCurrentRSS();
+            for (size_t i = 0; i < count; ++i)
+            {
+                LLCoros::instance().launch("launch_and_finish",
+                                           [&finished]()
+                                           {
+                                               boost::this_fiber::yield();
+                                               ++finished;
+                                           });
+                // let the main fiber's scheduler reap terminated coroutines,
+                // as the viewer's main loop does once per frame
+                if (i % yield_every == 0)
+                {
+                    boost::this_fiber::yield();
+                }
+                if (i % 1000 == 0)
+                {
+                    peak_rss = std::max(peak_rss, LLMemory::getCurrentRSS());
+                }
+            }
+            while (finished < count)
+            {
+                boost::this_fiber::yield();
+            }
+            // one more pass so the last coroutines release their stacks
+            boost::this_fiber::yield();
+            return std::max(peak_rss, LLMemory::getCurrentRSS());
+        }
+    };
+    typedef test_group<llcoros_data> llcoros_group;
+    typedef llcoros_group::object object;
+    llcoros_group llcorosgrp("llcoros");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("stacks are reused");
+        LLCoros::instance().setStackPoolSize(4);
+        LLCoros::StackPoolStats before(LLCoros::instance().getStackPoolStats());
+        launch_and_finish(100, 1);
+        LLCoros::StackPoolStats after(LLCoros::instance().getStackPoolStats());
+        ensure_equals("every launch got a stack",
+                      (after.mAllocated + after.mReused) - (before.mAllocated + before.mReused),
+                      U64(100));
+        ensure("stacks were recycled", after.mReused - before.mReused >= 90);
+        ensure("idle stacks capped", after.mIdle <= 4);
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("pooling disabled");
+        LLCoros::instance().setStackPoolSize(0);
+        ensure_equals("idle stacks released", LLCoros::instance().getStackPoolStats().mIdle, size_t(0));
+        LLCoros::StackPoolStats before(LLCoros::instance().getStackPoolStats());
+        launch_and_finish(20, 1);
+        LLCoros::StackPoolStats after(LLCoros::instance().getStackPoolStats());
+        ensure_equals("no stacks reused", after.mReused, before.mReused);
+        ensure_equals("no stacks retained", after.mIdle, size_t(0));
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("benchmark launching 100k coroutines");
+        skip_unless_benchmarking();
+
+        const size_t count = 100000;
+        for (size_t poolsize : { 0, 32 })
+        {
+            LLCoros::instance().setStackPoolSize(poolsize);
+            LLCoros::StackPoolStats before(LLCoros::instance().getStackPoolStats());
+            U64 peak_rss = 0;
+            double seconds = time_seconds([&]{ peak_rss = launch_and_finish(count); });
+            LLCoros::StackPoolStats after(LLCoros::instance().getStackPoolStats());
+            report_benchmark(STRINGIZE("LLCoros::launch() pool " << poolsize), count, seconds,
+                             STRINGIZE("peak RSS " << peak_rss / 1024 << " KB, "
+                                       << (after.mAllocated - before.mAllocated) << " stacks mapped, "
+                                       << (after.mReused - before.mReused) << " reused"));
+        }
+    }
+} // namespace tut
@@ -27,6 +27,10 @@
 
 #include <vector>
 #include <stdexcept>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <thread>
 
 #include "linden_common.h"
 
@@ -34,8 +38,10 @@
 
 #include "../llerrorcontrol.h"
 #include "../llsd.h"
+#include "../stringize.h"
 
 #include "../test/lltut.h"
+#include "../test/benchmark.h"
 
 enum LogFieldIndex
 {
@@ -918,6 +924,120 @@ namespace tut
     }
 }
 
+namespace tut
+{
+    template<> template<>
+    void ErrorTestObject::test<19>()
+        // async logging preserves order and flushes ahead of an error
+    {
+        LLError::setDefaultLevel(LLError::LEVEL_DEBUG);
+        LLError::setAsyncLogging(true);
+        ensure("async logging on", LLError::getAsyncLogging());
+        for (int i = 0; i < 100; ++i)
+        {
+            LL_INFOS() << "async " << i << LL_ENDL;
+        }
+        fatalWasCalled = false;
+        CATCH(LL_ERRS(), "fatal after async");
+        ensure("fatal callback called", fatalWasCalled);
+        // the error was written synchronously, after everything queued
+        ensure_message_count(101);
+        for (int i = 0; i < 100; ++i)
+        {
+            ensure_message_field_equals(i, MSG_FIELD, STRINGIZE("async " << i));
+        }
+        ensure_message_field_equals(100, LEVEL_FIELD, "ERROR");
+
+        LL_INFOS() << "last async" << LL_ENDL;
+        LLError::setAsyncLogging(false);
+        ensure("async logging off", ! LLError::getAsyncLogging());
+        // stopping writes whatever is still queued
+        ensure_message_count(102);
+        ensure_message_field_equals(101, MSG_FIELD, "last async");
+    }
+
+    template<> template<>
+    void ErrorTestObject::test<20>()
+        // a full queue drops messages rather than blocking the caller
+    {
+        LLError::setDefaultLevel(LLError::LEVEL_DEBUG);
+        std::mutex gate;
+        std::unique_lock<std::mutex> closed(gate);
+        // this recorder wedges the writer thread until we open the gate
+        LLError::RecorderPtr blocker(
+            LLError::addGenericRecorder([&gate](LLError::ELevel, const std::string&)
+                                        { std::lock_guard<std::mutex> pass(gate); }));
+        U64 dropped = LLError::getDroppedLogCount();
+
+        LLError::setAsyncLogging(true);
+        for (int i = 0; i < 3000; ++i)
+        {
+            LL_DEBUGS("Flood") << "flood " << i << LL_ENDL;
+        }
+        ensure("messages dropped", LLError::getDroppedLogCount() > dropped);
+
+        closed.unlock();
+        LLError::setAsyncLogging(false);
+        LLError::removeRecorder(blocker);
+        U64 lost = LLError::getDroppedLogCount() - dropped;
+        // everything not dropped was recorded, plus the dropped-count warning
+        ensure_equals("recorded + dropped", U64(countMessages()), 3000 - lost + 1);
+        ensure_contains("drop warning", message(countMessages() - 1), "log messages dropped");
+    }
+
+    template<> template<>
+    void ErrorTestObject::test<21>()
+        // benchmark: 1M messages from 8 threads, synchronous vs. async
+    {
+        skip_unless_benchmarking();
+        LLError::setDefaultLevel(LLError::LEVEL_INFO);
+        LLError::removeRecorder(mRecorder);
+        // a file recorder like the viewer's, minus the LLFile plumbing
+        FILE* file = tmpfile();
+        LLError::RecorderPtr recorder(
+            LLError::addGenericRecorder([file](LLError::ELevel, const std::string& message)
+                                        { fprintf(file, "%s\n", message.c_str()); }));
+
+        const int THREADS = 8, PER_THREAD = 1000000 / THREADS;
+        auto flood = [&]()
+        {
+            std::vector<std::thread> threads;
+            for (int t = 0; t < THREADS; ++t)
+            {
+                threads.emplace_back([t, PER_THREAD]()
+                {
+                    for (int i = 0; i < PER_THREAD; ++i)
+                    {
+                        LL_INFOS("Bench") << "thread " << t << " message " << i << LL_ENDL;
+                    }
+                });
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+        };
+
+        report_benchmark("llerror sync", THREADS * PER_THREAD, time_seconds(flood));
+
+        LLError::setAsyncLogging(true);
+        U64 dropped = LLError::getDroppedLogCount();
+        double posting = 0;
+        double total = time_seconds([&]()
+        {
+            posting = time_seconds(flood);
+            LLError::flushLog();
+        });
+        LLError::setAsyncLogging(false);
+        report_benchmark("llerror async (callers)", THREADS * PER_THREAD, posting);
+        report_benchmark("llerror async (until written)", THREADS * PER_THREAD, total,
+                         STRINGIZE((LLError::getDroppedLogCount() - dropped) << " dropped"));
+
+        LLError::removeRecorder(recorder);
+        fclose(file);
+    }
+}
+
 /* Tests left:
 	handling of classes without LOG_CLASS
 
@@ -0,0 +1,209 @@
+/**
+ * @file   lleventchannel_test.cpp
+ * @date   2023-03-13
+ * @brief  Test for lleventchannel.h, plus post/dispatch and coroutine wakeup
+ *         benchmarks against LLEventPump.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "lleventchannel.h"
+// STL headers
+#include <string>
+// std headers
+// external library headers
+// other Linden headers
+#include "llcoros.h"
+#include "lleventcoro.h"
+#include "llevents.h"
+#include "llsd.h"
+#include "llsdutil.h"
+#include "../test/benchmark.h"
+#include "../test/lltestapp.h"
+#include "../test/lltut.h"
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct lleventchannel_data
+    {
+        LLTestApp testApp;
+    };
+    typedef test_group<lleventchannel_data> lleventchannel_group;
+    typedef lleventchannel_group::object object;
+    lleventchannel_group lleventchannelgrp("lleventchannel");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("post and disconnect");
+        LLEventChannel<int> channel;
+        std::string calls;
+        auto first = channel.connect([&calls](int v){ calls += "a" + std::to_string(v) + " "; });
+        channel.connect([&calls](int v){ calls += "b" + std::to_string(v) + " "; });
+        ensure_equals("size", channel.size(), size_t(2));
+        channel.post(1);
+        channel.disconnect(first);
+        channel.disconnect(first);      // no-op
+        channel.disconnect(0);          // no-op
+        channel.post(2);
+        ensure_equals("calls", calls, "a1 b1 b2 ");
+        ensure_equals("size after disconnect", channel.size(), size_t(1));
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("connect and disconnect during post");
+        LLEventChannel<int> channel;
+        std::string calls;
+        LLEventChannel<int>::id_t self = 0, victim = 0;
+        self = channel.connect(
+            [&](int v)
+            {
+                calls += "self" + std::to_string(v) + " ";
+                // disconnect ourselves and a later listener, add a new one
+                channel.disconnect(self);
+                channel.disconnect(victim);
+                channel.connect([&calls](int w){ calls += "late" + std::to_string(w) + " "; });
+            });
+        victim = channel.connect([&calls](int v){ calls += "victim" + std::to_string(v) + " "; });
+        channel.post(1);
+        ensure_equals("first post", calls, "self1 ");
+        channel.post(2);
+        ensure_equals("second post", calls, "self1 late2 ");
+        ensure_equals("size", channel.size(), size_t(1));
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("TempConnection");
+        LLEventChannel<std::string> channel;
+        std::string last;
+        {
+            auto connection = channel.connectTemp([&last](const std::string& s){ last = s; });
+            ensure("connected", connection.connected());
+            channel.post("in scope");
+            LLEventChannel<std::string>::TempConnection moved(std::move(connection));
+            ensure("moved-from", ! connection.connected());
+            ensure("moved-to", moved.connected());
+        }
+        channel.post("out of scope");
+        ensure_equals("last", last, "in scope");
+        ensure("empty", channel.empty());
+    }
+
+    template<> template<>
+    void object::test<4>()
+    {
+        set_test_name("suspendUntilEventOn(LLEventChannel)");
+        LLEventChannel<LLSD> channel;
+        LLSD result;
+        LLCoros::instance().launch("channelWaiter",
+                                   [&channel, &result]()
+                                   {
+                                       result = llcoro::suspendUntilEventOn(channel);
+                                   });
+        ensure_equals("waiting", channel.size(), size_t(1));
+        ensure("not yet", result.isUndefined());
+        channel.post(LLSDMap("value", 17));
+        // let the coroutine run
+        llcoro::suspend();
+        ensure_equals("result", result["value"].asInteger(), 17);
+        ensure("disconnected", channel.empty());
+    }
+
+    template<> template<>
+    void object::test<5>()
+    {
+        set_test_name("benchmark vs. LLEventPump");
+        skip_unless_benchmarking();
+
+        const size_t posts = 1000000;
+        S64 sum = 0;
+        {
+            LLEventStream pump("benchmark", true);
+            LLTempBoundListener connection(
+                pump.listen("sum", [&sum](const LLSD& event){ sum += event.asInteger(); return false; }));
+            report_benchmark("LLEventStream::post(LLSD)", posts, time_seconds([&]{
+                for (size_t i = 0; i < posts; ++i)
+                {
+                    pump.post(LLSD::Integer(i));
+                }
+            }));
+        }
+        {
+            LLEventChannel<LLSD> channel;
+            auto connection = channel.connectTemp([&sum](const LLSD& event){ sum += event.asInteger(); });
+            report_benchmark("LLEventChannel<LLSD>::post()", posts, time_seconds([&]{
+                for (size_t i = 0; i < posts; ++i)
+                {
+                    channel.post(LLSD::Integer(i));
+                }
+            }));
+        }
+        {
+            LLEventChannel<S32> channel;
+            auto connection = channel.connectTemp([&sum](S32 event){ sum += event; });
+            report_benchmark("LLEventChannel<S32>::post()", posts, time_seconds([&]{
+                for (size_t i = 0; i < posts; ++i)
+                {
+                    channel.post(S32(i));
+                }
+            }));
+        }
+        ensure("sum", sum != 0);
+
+        // Coroutine wakeup round trip: post, then let the waiting coroutine
+        // resume and suspend again.
+        const size_t wakeups = 100000;
+        {
+            LLEventStream pump("wakeup", true);
+            size_t received = 0;
+            LLCoros::instance().launch("pumpWaiter",
+                                       [&pump, &received, wakeups]()
+                                       {
+                                           while (received < wakeups)
+                                           {
+                                               llcoro::suspendUntilEventOn(pump);
+                                               ++received;
+                                           }
+                                       });
+            report_benchmark("suspendUntilEventOn(LLEventPump)", wakeups, time_seconds([&]{
+                while (received < wakeups)
+                {
+                    pump.post(LLSD::Integer(received));
+                    llcoro::suspend();
+                }
+            }));
+        }
+        {
+            LLEventChannel<S32> channel;
+            size_t received = 0;
+            LLCoros::instance().launch("channelWaiter",
+                                       [&channel, &received, wakeups]()
+                                       {
+                                           while (received < wakeups)
+                                           {
+                                               llcoro::suspendUntilEventOn(channel);
+                                               ++received;
+                                           }
+                                       });
+            report_benchmark("suspendUntilEventOn(LLEventChannel)", wakeups, time_seconds([&]{
+                while (received < wakeups)
+                {
+                    channel.post(S32(received));
+                    llcoro::suspend();
+                }
+            }));
+        }
+    }
+} // namespace tut
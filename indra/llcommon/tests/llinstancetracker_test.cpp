@@ -36,11 +36,17 @@
 #include <set>
 #include <algorithm>                // std::sort()
 #include <stdexcept>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
 // std headers
 // external library headers
 #include <boost/scoped_ptr.hpp>
 // other Linden headers
+#include "stringize.h"
 #include "../test/lltut.h"
+#include "../test/benchmark.h"
 
 struct Badness: public std::runtime_error
 {
@@ -271,4 +277,139 @@ namespace tut
             ensure("failed to remove instance", existing.find(&ref) != existing.end());
         }
     }
+
+    template<> template<>
+    void object::test<9>()
+    {
+        set_test_name("concurrent construction, lookup and iteration");
+        // These must be visible to every reader throughout.
+        std::vector<std::unique_ptr<Keyed>> permanent;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            permanent.emplace_back(new Keyed(stringize("permanent ", i)));
+        }
+        std::atomic<bool> done(false);
+        std::atomic<size_t> failures(0);
+
+        std::vector<std::thread> threads;
+        // churners: construct and destroy instances as fast as they can
+        for (size_t t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([t, &done]()
+            {
+                for (size_t i = 0; ! done; ++i)
+                {
+                    Keyed churn(stringize("churn ", t, " ", i % 16));
+                    Unkeyed unkeyed;
+                }
+            });
+        }
+        // readers: every permanent instance must always be found, and found
+        // correctly. Don't dereference churned instances: they may be
+        // destroyed at any moment.
+        for (size_t t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&permanent, &failures]()
+            {
+                for (size_t i = 0; i < 20000; ++i)
+                {
+                    size_t which = i % permanent.size();
+                    if (Keyed::getInstance(stringize("permanent ", which)).get() != permanent[which].get())
+                    {
+                        ++failures;
+                    }
+                    Keyed::getInstance(stringize("churn ", i % 4, " ", i % 16));
+                    if (i % 100 == 0)
+                    {
+                        size_t found = 0;
+                        for (const auto& key : Keyed::key_snapshot())
+                        {
+                            found += (key.compare(0, 10, "permanent ") == 0);
+                        }
+                        if (found != permanent.size() ||
+                            Keyed::instanceCount() < S32(permanent.size()))
+                        {
+                            ++failures;
+                        }
+                    }
+                }
+            });
+        }
+        // wait for the readers, then stop the churners
+        for (size_t t = 4; t < threads.size(); ++t)
+        {
+            threads[t].join();
+        }
+        done = true;
+        for (size_t t = 0; t < 4; ++t)
+        {
+            threads[t].join();
+        }
+        ensure_equals("lookup failures", failures.load(), size_t(0));
+        ensure_equals("churned instances gone", Keyed::instanceCount(), S32(permanent.size()));
+        ensure_equals("no Unkeyed left", Unkeyed::instanceCount(), 0);
+        ensure("churned key gone", ! Keyed::getInstance("churn 0 0"));
+        permanent.clear();
+        ensure_equals("all gone", Keyed::instanceCount(), 0);
+    }
+
+    template<> template<>
+    void object::test<10>()
+    {
+        set_test_name("benchmark getInstance() from many threads");
+        skip_unless_benchmarking();
+        std::vector<std::unique_ptr<Keyed>> instances;
+        std::vector<std::string> keys;
+        for (size_t i = 0; i < 32; ++i)
+        {
+            keys.push_back(stringize("bench ", i));
+            instances.emplace_back(new Keyed(keys.back()));
+        }
+        // what getInstance() used to do: lock a shared map for every lookup
+        std::mutex mutex;
+        std::map<std::string, Keyed*> locked(
+            [&instances]{
+                std::map<std::string, Keyed*> map;
+                for (auto& inst : instances)
+                    map[inst->mName] = inst.get();
+                return map; }());
+
+        const size_t per_thread = 1000000;
+        for (size_t num_threads : { 1, 4, 16 })
+        {
+            auto run = [&](auto lookup)
+            {
+                return time_seconds([&]()
+                {
+                    std::vector<std::thread> threads;
+                    for (size_t t = 0; t < num_threads; ++t)
+                    {
+                        threads.emplace_back([&keys, &lookup, per_thread]()
+                        {
+                            size_t hits = 0;
+                            for (size_t i = 0; i < per_thread; ++i)
+                            {
+                                hits += lookup(keys[i % keys.size()]);
+                            }
+                            ensure_equals("hits", hits, per_thread);
+                        });
+                    }
+                    for (auto& thread : threads)
+                    {
+                        thread.join();
+                    }
+                });
+            };
+            size_t ops = num_threads * per_thread;
+            report_benchmark(stringize("getInstance ", num_threads, " threads"), ops,
+                             run([](const std::string& key)
+                                 { return bool(Keyed::getInstance(key)); }));
+            report_benchmark(stringize("mutex-guarded map ", num_threads, " threads"), ops,
+                             run([&mutex, &locked](const std::string& key)
+                                 {
+                                     std::unique_lock<std::mutex> lock(mutex);
+                                     return locked.find(key) != locked.end();
+                                 }));
+        }
+    }
 } // namespace tut
@@ -0,0 +1,259 @@
+/**
+ * @file   llsdjson_test.cpp
+ * @date   2023-04-10
+ * @brief  Test for llsdjson.h, plus a benchmark of direct JSON parsing and
+ *         serialization against the Json::Value round trip.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "llsdjson.h"
+// STL headers
+#include <sstream>
+#include <string>
+// std headers
+// external library headers
+#include "reader.h"
+#include "writer.h"
+// other Linden headers
+#include "llsdutil.h"
+#include "stringize.h"
+#include "../test/benchmark.h"
+#include "../test/lltut.h"
+
+namespace
+{
+    // the old two-step path
+    LLSD parse_via_value(const std::string& text)
+    {
+        std::istringstream in(text);
+        Json::Value root;
+        in >> root;
+        return LlsdFromJson(root);
+    }
+
+    std::string write_via_value(const LLSD& value)
+    {
+        Json::FastWriter writer;
+        std::string text(writer.write(LlsdToJson(value)));
+        // FastWriter appends a newline
+        if (! text.empty() && text.back() == '\n')
+        {
+            text.pop_back();
+        }
+        return text;
+    }
+
+    // a document shaped like a large capability response: many records of
+    // strings, numbers, nested objects and arrays
+    std::string make_document(size_t records, bool pretty)
+    {
+        const char* nl = pretty? "\n" : "";
+        const char* indent = pretty? "        " : "";
+        std::ostringstream out;
+        out << "[" << nl;
+        for (size_t i = 0; i < records; ++i)
+        {
+            out << (i? "," : "") << indent << "{" << nl
+                << indent << indent << "\"id\": " << i << "," << nl
+                << indent << indent << "\"name\": \"Listing number " << i
+                << " with a longer description of the item for sale\"," << nl
+                << indent << indent << "\"price\": " << (i * 7) % 1000 << "." << i % 100 << "," << nl
+                << indent << indent << "\"uuid\": \"8f5a2b4e-" << (1000 + i % 9000)
+                << "-4c6e-9a1b-0123456789ab\"," << nl
+                << indent << indent << "\"escaped\": \"line\\nbreak \\\"quoted\\\" \\u00e9\"," << nl
+                << indent << indent << "\"active\": " << ((i % 3)? "true" : "false") << "," << nl
+                << indent << indent << "\"tags\": [\"a\", \"b\", null, " << i % 17 << "]," << nl
+                << indent << indent << "\"location\": {\"x\": " << i % 256 << ".5, \"y\": 12.25, \"z\": -3e2}" << nl
+                << indent << "}";
+        }
+        out << nl << "]";
+        return out.str();
+    }
+
+    LLSD parse(const std::string& text)
+    {
+        LLSD result;
+        std::string error;
+        tut::ensure(stringize("parse '", text, "': ", error),
+                    LlsdFromJsonString(text, result, &error));
+        return result;
+    }
+} // anonymous namespace
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct llsdjson_data
+    {
+    };
+    typedef test_group<llsdjson_data> llsdjson_group;
+    typedef llsdjson_group::object object;
+    llsdjson_group llsdjsongrp("llsdjson");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("scalars");
+        ensure("null", parse("null").isUndefined());
+        ensure_equals("true", parse("true").asBoolean(), true);
+        ensure_equals("false type", parse(" false ").type(), LLSD::TypeBoolean);
+        ensure_equals("integer type", parse("42").type(), LLSD::TypeInteger);
+        ensure_equals("integer", parse("-17").asInteger(), -17);
+        ensure_equals("int max", parse("2147483647").asInteger(), 2147483647);
+        ensure_equals("int min", parse("-2147483648").asInteger(), S32_MIN);
+        ensure_equals("beyond int is real", parse("2147483648").type(), LLSD::TypeReal);
+        ensure_equals("beyond int value", parse("2147483648").asReal(), 2147483648.0);
+        ensure_equals("real type", parse("1.0").type(), LLSD::TypeReal);
+        ensure_equals("real", parse("0.1").asReal(), 0.1);
+        ensure_equals("exponent", parse("-1.5e3").asReal(), -1500.0);
+        ensure_equals("negative exponent", parse("25E-2").asReal(), 0.25);
+        ensure_equals("long mantissa", parse("3.14159265358979323846264").asReal(), 3.14159265358979323846264);
+        ensure_equals("tiny", parse("1e-300").asReal(), 1e-300);
+        ensure_equals("string", parse("\"hello\"").asString(), "hello");
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("string escapes");
+        ensure_equals("simple escapes", parse("\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"").asString(),
+                      "\"\\/\b\f\n\r\t");
+        ensure_equals("\\u ASCII", parse("\"\\u0041\"").asString(), "A");
+        ensure_equals("\\u two bytes", parse("\"\\u00e9\"").asString(), "\xc3\xa9");
+        ensure_equals("\\u three bytes", parse("\"\\u20AC\"").asString(), "\xe2\x82\xac");
+        ensure_equals("surrogate pair", parse("\"\\ud83d\\ude00\"").asString(), "\xf0\x9f\x98\x80");
+        ensure_equals("raw UTF-8", parse("\"\xe2\x82\xac\"").asString(), "\xe2\x82\xac");
+        // longer than one SIMD block on either side of the escape
+        std::string longer(40, 'x');
+        ensure_equals("long with escape", parse("\"" + longer + "\\n" + longer + "\"").asString(),
+                      longer + "\n" + longer);
+        ensure_equals("embedded NUL", parse("\"a\\u0000b\"").asString(), std::string("a\0b", 3));
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("structures");
+        LLSD value(parse(" { \"a\" : [ 1 , 2.5 , \"three\" , [ ] , { } ] ,\n\t\"b\":{\"c\":null}, \"a2\": true } "));
+        ensure_equals("map", value.type(), LLSD::TypeMap);
+        ensure_equals("members", value.size(), 3);
+        ensure_equals("array size", value["a"].size(), 5);
+        ensure_equals("a[0]", value["a"][0].asInteger(), 1);
+        ensure_equals("a[1]", value["a"][1].asReal(), 2.5);
+        ensure_equals("a[2]", value["a"][2].asString(), "three");
+        ensure_equals("empty array", value["a"][3].type(), LLSD::TypeArray);
+        ensure_equals("empty map", value["a"][4].type(), LLSD::TypeMap);
+        ensure("null member", value["b"].has("c") && value["b"]["c"].isUndefined());
+        ensure_equals("repeated name: last wins", parse("{\"k\":1,\"k\":2}")["k"].asInteger(), 2);
+        ensure_equals("comments", parse("// lead\n[1, /* two */ 2] // trail").size(), 2);
+    }
+
+    template<> template<>
+    void object::test<4>()
+    {
+        set_test_name("invalid JSON");
+        static const char* bad[] =
+        {
+            "", "   ", "nul", "tru", "[1,]", "[1 2]", "{\"a\" 1}", "{\"a\":1,}", "{a:1}",
+            "[", "{", "\"unterminated", "\"bad \\x escape\"", "\"\\u12\"", "\"\\ud800\"",
+            "\"\\ud800\\u0041\"", "01", "-", "1.", ".5", "1e", "+1", "[1] 2", "/* open",
+            "[NaN]", "'single'"
+        };
+        for (const char* text : bad)
+        {
+            LLSD result("unchanged");
+            std::string error;
+            ensure(stringize("rejects '", text, "'"), ! LlsdFromJsonString(text, result, &error));
+            ensure(stringize("describes '", text, "'"), ! error.empty());
+            ensure(stringize("clears result for '", text, "'"), result.isUndefined());
+        }
+        // nesting limit
+        std::string deep(2000, '['), close(2000, ']');
+        LLSD result;
+        ensure("too deep", ! LlsdFromJsonString(deep + close, result));
+    }
+
+    template<> template<>
+    void object::test<5>()
+    {
+        set_test_name("serialization");
+        LLSD value(LLSD::emptyMap());
+        value["int"] = -5;
+        value["real"] = 0.1;
+        value["whole"] = 2.0;
+        value["string"] = "tab\there \"quoted\" back\\slash \x01";
+        value["bool"] = true;
+        value["undef"] = LLSD();
+        value["uuid"] = LLUUID("8f5a2b4e-1234-4c6e-9a1b-0123456789ab");
+        value["array"] = llsd::array(1, "two", LLSD::emptyMap(), LLSD::emptyArray());
+        std::string text(LlsdToJsonString(value));
+        ensure_equals("matches FastWriter", text, write_via_value(value));
+        ensure_equals("whole real stays real", parse(text)["whole"].type(), LLSD::TypeReal);
+        ensure_equals("uuid as string", parse(text)["uuid"].asString(), "8f5a2b4e-1234-4c6e-9a1b-0123456789ab");
+        // round trip, apart from the UUID becoming a string
+        LLSD expected(value);
+        expected["uuid"] = value["uuid"].asString();
+        ensure("round trip", llsd_equals(parse(text), expected));
+    }
+
+    template<> template<>
+    void object::test<6>()
+    {
+        set_test_name("agrees with the Json::Value path");
+        for (bool pretty : { false, true })
+        {
+            std::string text(make_document(200, pretty));
+            LLSD direct(parse(text));
+            ensure_equals("records", direct.size(), 200);
+            ensure("same LLSD", llsd_equals(direct, parse_via_value(text)));
+            // not a textual comparison: some jsoncpp versions escape non-ASCII
+            ensure("round trip", llsd_equals(parse(LlsdToJsonString(direct)), direct));
+        }
+    }
+
+    template<> template<>
+    void object::test<7>()
+    {
+        set_test_name("benchmark large documents");
+        skip_unless_benchmarking();
+        for (bool pretty : { false, true })
+        {
+            std::string text(make_document(20000, pretty));
+            std::string label(stringize(pretty? "pretty " : "compact ", text.size() / 1024, " KB"));
+            const size_t reps = 5;
+            LLSD result;
+            double seconds = time_seconds([&]{
+                    for (size_t i = 0; i < reps; ++i)
+                        result = parse_via_value(text);
+                });
+            report_benchmark("parse Json::Value + LlsdFromJson " + label, reps, seconds,
+                             stringize(text.size() * reps / seconds / (1024 * 1024), " MB/s"));
+            seconds = time_seconds([&]{
+                    for (size_t i = 0; i < reps; ++i)
+                        LlsdFromJsonString(text, result);
+                });
+            report_benchmark("parse LlsdFromJsonString " + label, reps, seconds,
+                             stringize(text.size() * reps / seconds / (1024 * 1024), " MB/s"));
+
+            std::string out;
+            seconds = time_seconds([&]{
+                    for (size_t i = 0; i < reps; ++i)
+                        out = write_via_value(result);
+                });
+            report_benchmark("write LlsdToJson + FastWriter " + label, reps, seconds);
+            seconds = time_seconds([&]{
+                    for (size_t i = 0; i < reps; ++i)
+                        out = LlsdToJsonString(result);
+                });
+            report_benchmark("write LlsdToJsonString " + label, reps, seconds);
+        }
+    }
+} // namespace tut
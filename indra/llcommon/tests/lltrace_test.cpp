@@ -30,7 +30,12 @@
 #include "lltrace.h"
 #include "lltracethreadrecorder.h"
 #include "lltracerecording.h"
+#include "stringize.h"
+#include "../test/benchmark.h"
 #include "../test/lltut.h"
+#include <atomic>
+#include <thread>
+#include <vector>
 
 namespace LLUnits
 {
@@ -139,4 +144,82 @@ namespace tut
 				&& after_3pm.getMax(sCaffeineLevelStat) == sCaffeinePerOz * ((S32Ounces)S32TallCup(1) + (S32Ounces)S32GrandeCup(3) + (S32Ounces)S32VentiCup(1)).value());
 	}
 
+	static CountStatHandle<S32> sWorkerCount("workercount", "Counted on worker threads");
+	static EventStatHandle<F64> sWorkerEvent("workerevent", "Recorded on worker threads");
+
+	// Run num_threads workers, each with its own child recorder, each adding
+	// per_thread counts and events, pushing periodically, while this thread
+	// keeps pulling. Returns seconds spent.
+	F64 record_on_workers(ThreadRecorder& parent, size_t num_threads, size_t per_thread)
+	{
+		std::atomic<size_t> running(num_threads);
+		std::vector<std::thread> workers;
+		F64 seconds = time_seconds([&]()
+		{
+			for (size_t t = 0; t < num_threads; ++t)
+			{
+				workers.emplace_back([&parent, &running, per_thread]()
+				{
+					ThreadRecorder recorder(parent);
+					for (size_t i = 0; i < per_thread; ++i)
+					{
+						add(sWorkerCount, 1);
+						record(sWorkerEvent, 2.0);
+						if (i % 1000 == 0)
+						{
+							recorder.pushToParentPeriodically();
+						}
+					}
+					--running;
+					// the recorder's destructor hands over the remainder
+				});
+			}
+			while (running)
+			{
+				parent.pullFromChildren();
+				std::this_thread::yield();
+			}
+			for (auto& worker : workers)
+			{
+				worker.join();
+			}
+		});
+		parent.pullFromChildren();
+		return seconds;
+	}
+
+	template<> template<>
+	void trace_object_t::test<2>()
+	{
+		set_test_name("child thread stats reach the parent");
+		const size_t threads = 16, per_thread = 20000;
+		Recording recording;
+		recording.start();
+		record_on_workers(mRecorder, threads, per_thread);
+		recording.stop();
+
+		ensure_equals("counts", recording.getSum(sWorkerCount), S32(threads * per_thread));
+		ensure_equals("events", recording.getSampleCount(sWorkerEvent), S32(threads * per_thread));
+		ensure_equals("event sum", recording.getSum(sWorkerEvent), F64(2 * threads * per_thread));
+	}
+
+	template<> template<>
+	void trace_object_t::test<3>()
+	{
+		set_test_name("benchmark sampling from 16 threads");
+		skip_unless_benchmarking();
+
+		const size_t per_thread = 1000000;
+		for (size_t threads : { 1, 4, 16 })
+		{
+			Recording recording;
+			recording.start();
+			F64 seconds = record_on_workers(mRecorder, threads, per_thread);
+			recording.stop();
+			// two stats per iteration, on each thread
+			report_benchmark(STRINGIZE("count + event, " << threads << " threads"),
+							 2 * threads * per_thread, seconds,
+							 STRINGIZE(recording.getSum(sWorkerCount) << " counted"));
+		}
+	}
 }
@@ -0,0 +1,177 @@
+/**
+ * @file   lltracehitchcapture_test.cpp
+ * @date   2023-03-27
+ * @brief  Test for lltracehitchcapture.h.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "lltracehitchcapture.h"
+// STL headers
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+// std headers
+// external library headers
+// other Linden headers
+#include "llfasttimer.h"
+#include "lltracerecording.h"
+#include "lltracethreadrecorder.h"
+#include "../test/lltut.h"
+
+namespace
+{
+    LLTrace::BlockTimerStatHandle FTM_HITCH_OUTER("hitch outer");
+    LLTrace::BlockTimerStatHandle FTM_HITCH_INNER("hitch inner");
+
+    void timed_work(size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            LL_RECORD_BLOCK_TIME(FTM_HITCH_OUTER);
+            LL_RECORD_BLOCK_TIME(FTM_HITCH_INNER);
+        }
+    }
+
+    // Minimal reader for the fields the tests look at.
+    struct Reader
+    {
+        Reader(const std::string& data): mData(data), mPos(0) {}
+
+        U32 u32()
+        {
+            U32 value = 0;
+            for (size_t i = 0; i < 4; ++i)
+            {
+                value |= U32(U8(mData.at(mPos++))) << (8 * i);
+            }
+            return value;
+        }
+        U16 u16()
+        {
+            U16 value = U16(U8(mData.at(mPos)) | (U8(mData.at(mPos + 1)) << 8));
+            mPos += 2;
+            return value;
+        }
+        std::string bytes(size_t length)
+        {
+            std::string result(mData.substr(mPos, length));
+            mPos += length;
+            return result;
+        }
+        std::string name() { return bytes(u16()); }
+
+        const std::string& mData;
+        size_t mPos;
+    };
+} // anonymous namespace
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct lltracehitchcapture_data
+    {
+        LLTrace::ThreadRecorder mRecorder;
+        U64 mTexturesCreated{ 0 };
+
+        // one frame of timed work, captured into @a capture
+        void frame(LLTrace::HitchCapture& capture, U32 frame_number, size_t work = 10)
+        {
+            LLTrace::Recording recording;
+            recording.start();
+            timed_work(work);
+            LLTrace::BlockTimer::processTimes();
+            recording.stop();
+            mTexturesCreated += frame_number;
+            capture.captureFrame(frame_number, recording);
+        }
+    };
+    typedef test_group<lltracehitchcapture_data> lltracehitchcapture_group;
+    typedef lltracehitchcapture_group::object object;
+    lltracehitchcapture_group lltracehitchcapturegrp("lltracehitchcapture");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("ring of frames");
+        LLTrace::HitchCapture capture(4);
+        ensure_equals("frame count", capture.getFrameCount(), size_t(4));
+        ensure_equals("empty", capture.size(), size_t(0));
+        for (U32 i = 1; i <= 6; ++i)
+        {
+            frame(capture, i);
+        }
+        ensure_equals("full", capture.size(), size_t(4));
+        capture.clear();
+        ensure_equals("cleared", capture.size(), size_t(0));
+        capture.setFrameCount(0);
+        ensure_equals("at least one frame", capture.getFrameCount(), size_t(1));
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("file contents");
+        LLTrace::HitchCapture capture(3);
+        capture.addCounter("textures created", [this]{ return mTexturesCreated; });
+        for (U32 i = 1; i <= 5; ++i)
+        {
+            frame(capture, i);
+        }
+
+        std::ostringstream out;
+        ensure("write", capture.write(out));
+        std::string data(out.str());
+        Reader reader(data);
+        ensure_equals("magic", reader.bytes(4), "LLHC");
+        ensure_equals("version", reader.u32(), U32(1));
+
+        U32 ntimers = reader.u32();
+        std::vector<std::string> timers;
+        for (U32 i = 0; i < ntimers; ++i)
+        {
+            timers.push_back(reader.name());
+        }
+        ensure("outer timer named", std::find(timers.begin(), timers.end(), "hitch outer") != timers.end());
+        ensure("inner timer named", std::find(timers.begin(), timers.end(), "hitch inner") != timers.end());
+
+        ensure_equals("counters", reader.u32(), U32(1));
+        ensure_equals("counter name", reader.name(), "textures created");
+
+        ensure_equals("frames", reader.u32(), U32(3));
+        for (U32 expected = 3; expected <= 5; ++expected)
+        {
+            ensure_equals("oldest first", reader.u32(), expected);
+            reader.u32();   // frame ms
+            // the counter advanced by the frame number each frame
+            ensure_equals("counter delta", reader.u32(), expected);
+            U32 entries = reader.u32();
+            bool found_inner = false;
+            for (U32 e = 0; e < entries; ++e)
+            {
+                U16 timer = reader.u16();
+                U16 parent = reader.u16();
+                U32 calls = reader.u32();
+                reader.u32();   // total usec
+                reader.u32();   // self usec
+                ensure("timer id", timer < ntimers);
+                ensure("parent id", parent < ntimers);
+                if (timers[timer] == "hitch inner")
+                {
+                    found_inner = true;
+                    ensure_equals("inner calls", calls, U32(10));
+                }
+            }
+            ensure("inner timer captured", found_inner);
+        }
+        ensure_equals("consumed", reader.mPos, data.length());
+    }
+} // namespace tut
@@ -0,0 +1,158 @@
+/**
+ * @file   lltracememaccount_test.cpp
+ * @date   2023-04-03
+ * @brief  Test for lltracememaccount.h.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "lltracememaccount.h"
+// STL headers
+#include <memory>
+#include <thread>
+#include <vector>
+// std headers
+// external library headers
+// other Linden headers
+#include "lltracerecording.h"
+#include "lltracethreadrecorder.h"
+#include "../test/lltut.h"
+
+namespace
+{
+    // Like every LLTrace stat, accounts must exist before any ThreadRecorder
+    // sizes its accumulator buffers, so declare them statically: one per test.
+    LLTrace::MemAccount sAccount1("memaccount test 1");
+    LLTrace::MemAccount sAccount2("memaccount test 2");
+    LLTrace::MemAccount sAccount3("memaccount test 3");
+
+    // Stand-in for a subsystem object that accounts for its own buffer.
+    struct Tracked
+    {
+        Tracked(LLTrace::MemAccount& account, size_t size):
+            mAccount(account),
+            mData(new U8[size]),
+            mSize(size)
+        {
+            mAccount.claim(sizeof(*this) + mSize);
+        }
+        ~Tracked()
+        {
+            mAccount.disclaim(sizeof(*this) + mSize);
+        }
+        void resize(size_t size)
+        {
+            mData.reset(new U8[size]);
+            mAccount.adjust(S64(size) - S64(mSize));
+            mSize = size;
+        }
+
+        LLTrace::MemAccount& mAccount;
+        std::unique_ptr<U8[]> mData;
+        size_t mSize;
+    };
+} // anonymous namespace
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct lltracememaccount_data
+    {
+        LLTrace::ThreadRecorder mRecorder;
+    };
+    typedef test_group<lltracememaccount_data> lltracememaccount_group;
+    typedef lltracememaccount_group::object object;
+    lltracememaccount_group lltracememaccountgrp("lltracememaccount");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("counts known allocations");
+        LLTrace::MemAccount& account(sAccount1);
+        ensure_equals("found by name", LLTrace::MemAccount::getInstance("memaccount test 1").get(), &account);
+        {
+            Tracked a(account, 1000), b(account, 3000);
+            ensure_equals("bytes", account.getBytes(), S64(2 * sizeof(Tracked) + 4000));
+            ensure_equals("objects", account.getObjects(), S64(2));
+            a.resize(5000);
+            ensure_equals("grown", account.getBytes(), S64(2 * sizeof(Tracked) + 8000));
+            b.resize(100);
+            ensure_equals("shrunk", account.getBytes(), S64(2 * sizeof(Tracked) + 5100));
+            ensure_equals("still two", account.getObjects(), S64(2));
+        }
+        ensure_equals("all released", account.getBytes(), S64(0));
+        ensure_equals("no objects", account.getObjects(), S64(0));
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("claims from many threads");
+        LLTrace::MemAccount& account(sAccount2);
+        const size_t threads = 8, per_thread = 1000;
+        std::vector<std::unique_ptr<Tracked>> kept;
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&account, per_thread]()
+                                 {
+                                     // churn: every object is freed on its own thread
+                                     for (size_t i = 0; i < per_thread; ++i)
+                                     {
+                                         Tracked temp(account, i + 1);
+                                     }
+                                 });
+        }
+        // meanwhile, keep some on this thread
+        for (size_t i = 0; i < per_thread; ++i)
+        {
+            kept.emplace_back(new Tracked(account, 16));
+        }
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+        ensure_equals("kept bytes", account.getBytes(), S64(per_thread * (sizeof(Tracked) + 16)));
+        ensure_equals("kept objects", account.getObjects(), S64(per_thread));
+        // free on another thread than the one that allocated
+        std::thread([&kept]{ kept.clear(); }).join();
+        ensure_equals("released", account.getBytes(), S64(0));
+        ensure_equals("no objects", account.getObjects(), S64(0));
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("reported through LLTrace");
+        LLTrace::MemAccount& account(sAccount3);
+        LLTrace::Recording recording;
+        recording.start();
+        std::unique_ptr<Tracked> big;
+        // allocate on a worker, as the texture and mesh threads do
+        std::thread([&]{ big.reset(new Tracked(account, 1024 * 1024)); }).join();
+        LLTrace::MemAccount::updateStats();
+        const F64 expected = F64(sizeof(Tracked) + 1024 * 1024);
+        ensure_equals("size", recording.getLastValue(account.getStat()).valueInUnits<LLUnits::Bytes>(), expected);
+        ensure_equals("allocated", recording.getSum(account.getStat().allocations()).valueInUnits<LLUnits::Bytes>(), expected);
+        ensure_equals("peak", account.getPeakBytes(), S64(expected));
+
+        big.reset();
+        LLTrace::MemAccount::updateStats();
+        recording.stop();
+        ensure_equals("size after free", recording.getLastValue(account.getStat()).valueInUnits<LLUnits::Bytes>(), 0.0);
+        ensure_equals("freed", recording.getSum(account.getStat().deallocations()).valueInUnits<LLUnits::Bytes>(), expected);
+        ensure_equals("peak kept", account.getPeakBytes(), S64(expected));
+
+        LLSD snapshot(LLTrace::MemAccount::snapshot());
+        ensure("in snapshot", snapshot.has("memaccount test 3"));
+        ensure_equals("snapshot peak", snapshot["memaccount test 3"]["peak"].asReal(), expected);
+        ensure_equals("snapshot bytes", snapshot["memaccount test 3"]["bytes"].asReal(), 0.0);
+    }
+} // namespace tut
@@ -0,0 +1,176 @@
+/**
+ * @file   lltracetimeline_test.cpp
+ * @date   2023-03-20
+ * @brief  Test for lltracetimeline.h, plus a BlockTimer overhead benchmark.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "lltracetimeline.h"
+// STL headers
+#include <sstream>
+#include <string>
+#include <thread>
+// std headers
+// external library headers
+// other Linden headers
+#include "llfasttimer.h"
+#include "stringize.h"
+#include "../test/benchmark.h"
+#include "../test/lltut.h"
+
+namespace
+{
+    LLTrace::BlockTimerStatHandle FTM_TIMELINE_OUTER("timeline outer");
+    LLTrace::BlockTimerStatHandle FTM_TIMELINE_INNER("timeline inner");
+
+    // nested BlockTimer scopes, as LL_RECORD_BLOCK_TIME would produce
+    void timed_work(size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const LLTrace::BlockTimer& outer(LLTrace::timeThisBlock(FTM_TIMELINE_OUTER));
+            const LLTrace::BlockTimer& inner(LLTrace::timeThisBlock(FTM_TIMELINE_INNER));
+            (void)outer;
+            (void)inner;
+        }
+    }
+
+    std::string trace()
+    {
+        std::ostringstream out;
+        LLTrace::Timeline::writeChromeTrace(out);
+        return out.str();
+    }
+
+    size_t occurrences(const std::string& haystack, const std::string& needle)
+    {
+        size_t count = 0;
+        for (size_t pos = haystack.find(needle); pos != std::string::npos;
+             pos = haystack.find(needle, pos + needle.length()))
+        {
+            ++count;
+        }
+        return count;
+    }
+} // anonymous namespace
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct lltracetimeline_data
+    {
+        lltracetimeline_data()
+        {
+            LLTrace::Timeline::clear();
+        }
+        ~lltracetimeline_data()
+        {
+            LLTrace::Timeline::setEnabled(false);
+            LLTrace::Timeline::clear();
+        }
+    };
+    typedef test_group<lltracetimeline_data> lltracetimeline_group;
+    typedef lltracetimeline_group::object object;
+    lltracetimeline_group lltracetimelinegrp("lltracetimeline");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("disabled records nothing");
+        timed_work(10);
+        std::ostringstream out;
+        ensure_equals("events", LLTrace::Timeline::writeChromeTrace(out), size_t(0));
+        ensure("valid empty trace", out.str().find("\"traceEvents\":[") != std::string::npos);
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("block timers and task scopes");
+        LLTrace::Timeline::setEnabled(true);
+        timed_work(3);
+        std::thread worker([]()
+                           {
+                               LLTrace::Timeline::setThreadName("timeline \"worker\"");
+                               LLTrace::TimelineScope task(LLTrace::Timeline::intern("some task"));
+                           });
+        worker.join();
+        LLTrace::Timeline::setEnabled(false);
+        timed_work(3);
+
+        std::string json(trace());
+        ensure_equals("outer begins", occurrences(json, "\"timeline outer\",\"ph\":\"B\""), size_t(3));
+        ensure_equals("outer ends", occurrences(json, "\"timeline outer\",\"ph\":\"E\""), size_t(3));
+        ensure_equals("inner begins", occurrences(json, "\"timeline inner\",\"ph\":\"B\""), size_t(3));
+        ensure_equals("task", occurrences(json, "\"some task\""), size_t(2));
+        ensure("escaped thread name", json.find("timeline \\\"worker\\\"") != std::string::npos);
+        // nesting: the first inner begin follows the first outer begin
+        ensure("nested", json.find("\"timeline outer\",\"ph\":\"B\"") <
+                         json.find("\"timeline inner\",\"ph\":\"B\""));
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("ring wraparound");
+        LLTrace::Timeline::setBufferSize(1000);
+        LLTrace::Timeline::setEnabled(true);
+        // a new thread gets a buffer of the new size
+        std::thread worker([]()
+                           {
+                               for (size_t i = 0; i < 5000; ++i)
+                               {
+                                   LLTrace::TimelineScope outer("wrap outer");
+                                   LLTrace::TimelineScope inner("wrap inner");
+                               }
+                           });
+        worker.join();
+        LLTrace::Timeline::setEnabled(false);
+        LLTrace::Timeline::setBufferSize(64 * 1024);
+
+        std::ostringstream out;
+        size_t events = LLTrace::Timeline::writeChromeTrace(out);
+        ensure("kept at most one buffer's worth", events <= 1024);
+        ensure("kept something", events > 1000);
+        std::string json(out.str());
+        // no END without a BEGIN at the start of the track
+        size_t first_begin = json.find("\"ph\":\"B\"");
+        size_t first_end = json.find("\"ph\":\"E\"");
+        ensure("begins before ends", first_begin < first_end);
+    }
+
+    template<> template<>
+    void object::test<4>()
+    {
+        set_test_name("benchmark BlockTimer overhead");
+        skip_unless_benchmarking();
+
+        const size_t count = 1000000;
+        // each iteration is two nested timers: four events when enabled
+        report_benchmark("BlockTimer pair, timeline disabled", count,
+                         time_seconds([count]{ timed_work(count); }));
+        LLTrace::Timeline::setEnabled(true);
+        report_benchmark("BlockTimer pair, timeline enabled", count,
+                         time_seconds([count]{ timed_work(count); }));
+        report_benchmark("TimelineScope", count, time_seconds([count]{
+            for (size_t i = 0; i < count; ++i)
+            {
+                LLTrace::TimelineScope scope("benchmark");
+            }
+        }));
+        LLTrace::Timeline::setEnabled(false);
+        std::ostringstream out;
+        size_t events = 0;
+        double seconds = time_seconds([&]{ events = LLTrace::Timeline::writeChromeTrace(out); });
+        report_benchmark("writeChromeTrace()", 1, seconds,
+                         STRINGIZE(events << " events, " << out.str().length() / 1024 << " KB"));
+    }
+} // namespace tut
@@ -0,0 +1,292 @@
+/**
+ * @file   lluuidhashmap_test.cpp
+ * @date   2023-03-02
+ * @brief  Test for lluuidhashmap.h, plus a lookup/insert/erase benchmark
+ *         against std::map and std::unordered_map.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "lluuidhashmap.h"
+// STL headers
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+// std headers
+// external library headers
+// other Linden headers
+#include "llpointer.h"
+#include "llrefcount.h"
+#include "stringize.h"
+#include "../test/benchmark.h"
+#include "../test/lltut.h"
+
+namespace
+{
+    // Counts live instances so we can check that the map constructs and
+    // destroys exactly what it should while moving entries around.
+    struct Counted: public LLRefCount
+    {
+        Counted(int value=0): mValue(value) { ++sLive; }
+        ~Counted() { --sLive; }
+        int mValue;
+        static int sLive;
+    };
+    int Counted::sLive = 0;
+
+    std::vector<LLUUID> make_ids(size_t count)
+    {
+        std::vector<LLUUID> ids(count);
+        for (LLUUID& id : ids)
+        {
+            id.generate();
+        }
+        return ids;
+    }
+
+    // std::allocator wrapper that tallies bytes currently allocated, so the
+    // benchmark can compare the footprint of the node-based containers.
+    size_t sAllocatedBytes = 0;
+    template <typename T>
+    struct CountingAllocator: public std::allocator<T>
+    {
+        typedef T value_type;
+        template <typename U> struct rebind { typedef CountingAllocator<U> other; };
+        CountingAllocator() {}
+        template <typename U> CountingAllocator(const CountingAllocator<U>&) {}
+        T* allocate(size_t n)
+        {
+            sAllocatedBytes += n * sizeof(T);
+            return std::allocator<T>::allocate(n);
+        }
+        void deallocate(T* p, size_t n)
+        {
+            sAllocatedBytes -= n * sizeof(T);
+            std::allocator<T>::deallocate(p, n);
+        }
+    };
+
+    // time insert, find (hit and miss) and erase of ids in MAP
+    template <typename MAP>
+    void bench_map(const std::string& name, MAP& map,
+                   const std::vector<LLUUID>& ids, const std::vector<LLUUID>& misses,
+                   std::function<size_t(const MAP&)> footprint)
+    {
+        const size_t lookups = 10 * ids.size();
+        report_benchmark(name + " insert", ids.size(), time_seconds([&]{
+            for (size_t i = 0; i < ids.size(); ++i)
+            {
+                map[ids[i]] = S32(i);
+            }
+        }), STRINGIZE(footprint(map) / 1024 << " KB"));
+
+        S64 sum = 0;
+        report_benchmark(name + " find hit", lookups, time_seconds([&]{
+            for (size_t i = 0; i < lookups; ++i)
+            {
+                sum += map.find(ids[(i * 7919) % ids.size()])->second;
+            }
+        }));
+        report_benchmark(name + " find miss", lookups, time_seconds([&]{
+            for (size_t i = 0; i < lookups; ++i)
+            {
+                sum += (map.find(misses[i % misses.size()]) == map.end());
+            }
+        }));
+        report_benchmark(name + " erase", ids.size(), time_seconds([&]{
+            for (const LLUUID& id : ids)
+            {
+                map.erase(id);
+            }
+        }));
+        // keep the optimizer from discarding the lookups
+        tut::ensure("bench_map sum", sum != 0);
+    }
+} // anonymous namespace
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct lluuidhashmap_data
+    {
+    };
+    typedef test_group<lluuidhashmap_data> lluuidhashmap_group;
+    typedef lluuidhashmap_group::object object;
+    lluuidhashmap_group lluuidhashmapgrp("lluuidhashmap");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("empty map");
+        LLUUIDHashMap<S32> map;
+        ensure("empty", map.empty());
+        ensure("begin == end", map.begin() == map.end());
+        ensure("find", map.find(LLUUID::null) == map.end());
+        ensure_equals("count", map.count(LLUUID::null), size_t(0));
+        ensure_equals("erase", map.erase(LLUUID::null), size_t(0));
+        map.clear();
+        ensure_equals("size", map.size(), size_t(0));
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("matches std::map");
+        std::vector<LLUUID> ids(make_ids(5000));
+        // null and hand-made ids that differ only in their low bytes
+        ids.push_back(LLUUID::null);
+        for (U8 i = 1; i < 200; ++i)
+        {
+            LLUUID id;
+            id.mData[UUID_BYTES - 1] = i;
+            ids.push_back(id);
+        }
+
+        LLUUIDHashMap<S32> map;
+        std::map<LLUUID, S32> reference;
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            map[ids[i]] = S32(i);
+            reference[ids[i]] = S32(i);
+        }
+        ensure_equals("size after insert", map.size(), reference.size());
+        ensure("duplicate emplace", ! map.emplace(ids[7], -1).second);
+        ensure_equals("duplicate emplace value", map[ids[7]], 7);
+
+        // remove every third entry by key
+        for (size_t i = 0; i < ids.size(); i += 3)
+        {
+            ensure_equals("erase existing", map.erase(ids[i]), size_t(1));
+            reference.erase(ids[i]);
+        }
+        ensure_equals("size after erase", map.size(), reference.size());
+
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            auto found = map.find(ids[i]);
+            auto expected = reference.find(ids[i]);
+            ensure_equals(STRINGIZE("presence of " << ids[i]),
+                          found == map.end(), expected == reference.end());
+            if (found != map.end())
+            {
+                ensure_equals(STRINGIZE("value of " << ids[i]), found->second, expected->second);
+            }
+        }
+
+        size_t visited = 0;
+        for (const auto& pair : map)
+        {
+            ensure_equals("iterated value", pair.second, reference[pair.first]);
+            ++visited;
+        }
+        ensure_equals("iterated count", visited, reference.size());
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("erase while iterating");
+        std::vector<LLUUID> ids(make_ids(3000));
+        LLUUIDHashMap<S32> map;
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            map[ids[i]] = S32(i);
+        }
+
+        size_t visited = 0;
+        for (auto it = map.begin(); it != map.end(); )
+        {
+            ++visited;
+            if (it->second % 2)
+            {
+                it = map.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        ensure_equals("each entry visited once", visited, ids.size());
+        ensure_equals("odd entries erased", map.size(), (ids.size() + 1) / 2);
+        for (const auto& pair : map)
+        {
+            ensure("only even entries remain", pair.second % 2 == 0);
+        }
+    }
+
+    template<> template<>
+    void object::test<4>()
+    {
+        set_test_name("object lifetimes");
+        std::vector<LLUUID> ids(make_ids(1000));
+        {
+            LLUUIDHashMap<LLPointer<Counted> > map;
+            for (size_t i = 0; i < ids.size(); ++i)
+            {
+                map[ids[i]] = new Counted(S32(i));
+            }
+            ensure_equals("live after insert", Counted::sLive, S32(ids.size()));
+
+            LLUUIDHashMap<LLPointer<Counted> > copy(map);
+            ensure_equals("copy shares pointees", Counted::sLive, S32(ids.size()));
+            ensure_equals("copy size", copy.size(), map.size());
+
+            for (size_t i = 0; i < ids.size() / 2; ++i)
+            {
+                map.erase(ids[i]);
+            }
+            ensure_equals("copy keeps erased alive", Counted::sLive, S32(ids.size()));
+            copy.clear();
+            ensure_equals("live after clear", Counted::sLive, S32(ids.size() - ids.size() / 2));
+
+            LLUUIDHashMap<LLPointer<Counted> > moved(std::move(map));
+            ensure("moved-from empty", map.empty());
+            ensure_equals("moved-to value", moved[ids.back()]->mValue, S32(ids.size() - 1));
+        }
+        ensure_equals("live after destruction", Counted::sLive, 0);
+    }
+
+    template<> template<>
+    void object::test<5>()
+    {
+        set_test_name("benchmark vs. std::map and std::unordered_map");
+        skip_unless_benchmarking();
+
+        for (size_t count : { 1000, 100000, 1000000 })
+        {
+            std::vector<LLUUID> ids(make_ids(count));
+            std::vector<LLUUID> misses(make_ids(std::min<size_t>(count, 10000)));
+            std::cout << "--- " << count << " entries" << std::endl;
+
+            {
+                sAllocatedBytes = 0;
+                std::map<LLUUID, S32, std::less<LLUUID>,
+                         CountingAllocator<std::pair<const LLUUID, S32> > > map;
+                bench_map<decltype(map)>("std::map", map, ids, misses,
+                                         [](const decltype(map)&){ return sAllocatedBytes; });
+            }
+            {
+                sAllocatedBytes = 0;
+                std::unordered_map<LLUUID, S32, std::hash<LLUUID>, std::equal_to<LLUUID>,
+                                   CountingAllocator<std::pair<const LLUUID, S32> > > map;
+                bench_map<decltype(map)>("std::unordered_map", map, ids, misses,
+                                         [](const decltype(map)&){ return sAllocatedBytes; });
+            }
+            {
+                LLUUIDHashMap<S32> map;
+                bench_map<decltype(map)>("LLUUIDHashMap", map, ids, misses,
+                                         [](const decltype(map)& hashmap){ return hashmap.getMemoryUsage(); });
+            }
+        }
+    }
+} // namespace tut
@@ -14,11 +14,14 @@
 // associated header
 #include "threadpool.h"
 // STL headers
+#include <memory>
 // std headers
 // external library headers
 // other Linden headers
 #include "llerror.h"
 #include "llevents.h"
+#include "lltracethreadrecorder.h"
+#include "lltracetimeline.h"
 #include "stringize.h"
 
 LL::ThreadPool::ThreadPool(const std::string& name, size_t threads, size_t capacity):
@@ -36,6 +39,16 @@ void LL::ThreadPool::start()
         mThreads.emplace_back(tname, [this, tname]()
             {
                 LL_PROFILER_SET_THREAD_NAME(tname.c_str());
+                LLTrace::Timeline::setThreadName(tname);
+                // Give each worker its own LLTrace recorder, as LLThread
+                // does, so stats recorded here land in thread-local buffers
+                // that reach the main thread's frame recording -- instead
+                // of in the shared default buffers, which nobody reads.
+                std::unique_ptr<LLTrace::ThreadRecorder> recorder;
+                if (LLTrace::get_master_thread_recorder())
+                {
+                    recorder.reset(new LLTrace::ThreadRecorder(*LLTrace::get_master_thread_recorder()));
+                }
                 run(tname);
             });
     }
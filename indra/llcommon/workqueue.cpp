@@ -21,6 +21,8 @@
 #include LLCOROS_MUTEX_HEADER
 #include "llerror.h"
 #include "llexception.h"
+#include "lltracethreadrecorder.h"
+#include "lltracetimeline.h"
 #include "stringize.h"
 
 using Mutex = LLCoros::Mutex;
@@ -28,7 +30,8 @@ using Lock  = LLCoros::LockType;
 
 LL::WorkQueue::WorkQueue(const std::string& name, size_t capacity):
     super(makeName(name)),
-    mQueue(capacity)
+    mQueue(capacity),
+    mTimelineName(LLTrace::Timeline::intern(getKey()))
 {
     // TODO: register for "LLApp" events so we can implicitly close() on
     // viewer shutdown.
@@ -62,6 +65,12 @@ void LL::WorkQueue::runUntilClose()
         {
             LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
             callWork(mQueue.pop());
+            // let the main thread see this worker's stats now and then
+            LLTrace::ThreadRecorder* recorder = LLTrace::get_thread_recorder().get();
+            if (recorder)
+            {
+                recorder->pushToParentPeriodically();
+            }
         }
     }
     catch (const Queue::Closed&)
@@ -130,6 +139,7 @@ void LL::WorkQueue::callWork(const Queue::DataTuple& work)
 void LL::WorkQueue::callWork(const Work& work)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    LLTrace::TimelineScope timeline(mTimelineName);
     try
     {
         work();
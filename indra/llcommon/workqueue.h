@@ -293,6 +293,8 @@ namespace LL
         void callWork(const Queue::DataTuple& work);
         void callWork(const Work& work);
         Queue mQueue;
+        // our name, as recorded in LLTrace::Timeline for each task we run
+        const char* mTimelineName;
     };
 
     /**
@@ -27,6 +27,7 @@
 #include "bufferarray.h"
 #include "llexception.h"
 #include "llmemory.h"
+#include "lltracememaccount.h"
 
 
 // BufferArray is a list of chunks, each a BufferArray::Block, of contiguous
@@ -44,6 +45,9 @@
 namespace LLCore
 {
 
+// Request and response bodies, counted by the block
+static LLTrace::MemAccount sBufferArrayMemAccount("BufferArray");
+
 
 // ==================================
 // BufferArray::Block Declaration
@@ -328,11 +332,13 @@ BufferArray::Block::Block(size_t len)
 	  mAlloced(len)
 {
 	memset(mData, 0, len);
+	sBufferArrayMemAccount.claim(sizeof(Block) + mAlloced);
 }
 			
 
 BufferArray::Block::~Block()
 {
+	sBufferArrayMemAccount.disclaim(sizeof(Block) + mAlloced);
 	mUsed = 0;
 	mAlloced = 0;
 }
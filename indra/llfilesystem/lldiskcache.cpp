@@ -39,6 +39,7 @@
 #include <chrono>
 
 #include "lldiskcache.h"
+#include "llfilehandlecache.h"
 
 LLDiskCache::LLDiskCache(const std::string cache_dir,
                          const uintmax_t max_size_bytes,
@@ -87,6 +88,9 @@ void LLDiskCache::purge()
         LL_INFOS() << "Total dir size before purge is " << dirFileSize(mCacheDir) << LL_ENDL;
     }
 
+    // access times LLFileSystem hasn't written out yet decide what goes
+    LLFileHandleCache::instance().flushAccessTimes();
+
     boost::system::error_code ec;
     auto start_time = std::chrono::high_resolution_clock::now();
 
@@ -98,6 +102,7 @@ void LLDiskCache::purge()
 #else
     std::string cache_path(mCacheDir);
 #endif
+    LLFileHandleCache::instance().invalidateAll();
     if (boost::filesystem::is_directory(cache_path, ec) && !ec.failed())
     {
         for (auto& entry : boost::make_iterator_range(boost::filesystem::directory_iterator(cache_path, ec), {}))
@@ -148,6 +153,7 @@ void LLDiskCache::purge()
         }
         if (should_remove)
         {
+            LLFileHandleCache::instance().invalidatePath(entry.second.second);
             boost::filesystem::remove(entry.second.second, ec);
             if (ec.failed())
             {
@@ -346,6 +352,9 @@ void LLDiskCache::clearCache()
 #else
     std::string cache_path(mCacheDir);
 #endif
+    // cached handles would keep the removed files alive (or fail to remove
+    // them on Windows) and serve their stale contents
+    LLFileHandleCache::instance().invalidateAll();
     if (boost::filesystem::is_directory(cache_path, ec) && !ec.failed())
     {
         for (auto& entry : boost::make_iterator_range(boost::filesystem::directory_iterator(cache_path, ec), {}))
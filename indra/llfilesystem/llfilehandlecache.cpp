@@ -0,0 +1,482 @@
+/**
+ * @file llfilehandlecache.cpp
+ * @brief Open file handles and metadata for disk cache files
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llfilehandlecache.h"
+
+#include "llfile.h"
+#include <boost/filesystem.hpp>
+#include <ctime>
+
+#if LL_WINDOWS
+#include "llwin32headerslean.h"
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Same threshold as LLDiskCache::updateFileAccessTime(), see SL-14582
+static const time_t ACCESS_TIME_THRESHOLD = 1 * 60 * 60;
+
+// Queued access times are written once there are this many of them, or
+// this many seconds after the last batch
+static const size_t TOUCH_BATCH_SIZE = 64;
+static const time_t TOUCH_BATCH_INTERVAL = 30;
+
+//============================================================================
+// An open file, closed when the last user lets go of it.  Reads and writes
+// take an explicit offset, so threads can share one handle.
+
+class LLFileHandleCache::Handle
+{
+public:
+#if LL_WINDOWS
+    typedef HANDLE native_t;
+#else
+    typedef int native_t;
+#endif
+
+    Handle(native_t file, std::atomic<U64>& closes)
+    :   mFile(file),
+        mCloses(closes)
+    {
+    }
+
+    ~Handle()
+    {
+#if LL_WINDOWS
+        CloseHandle(mFile);
+#else
+        ::close(mFile);
+#endif
+        ++mCloses;
+    }
+
+    static bool open(const std::string& path, bool create, native_t& file)
+    {
+#if LL_WINDOWS
+        // share delete so LLDiskCache::purge() can remove files we have open
+        file = CreateFileW(utf8str_to_utf16str(path).c_str(),
+                           GENERIC_READ | GENERIC_WRITE,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           NULL,
+                           create ? OPEN_ALWAYS : OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL,
+                           NULL);
+        return file != INVALID_HANDLE_VALUE;
+#else
+        file = ::open(path.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0), 0644);
+        if (file < 0 && errno == EACCES && !create)
+        {
+            file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        }
+        return file >= 0;
+#endif
+    }
+
+    // Returns the number of bytes read, -1 on error
+    S32 readAt(S32 offset, U8* buffer, S32 bytes)
+    {
+        S32 total = 0;
+        while (total < bytes)
+        {
+#if LL_WINDOWS
+            OVERLAPPED overlapped = {};
+            overlapped.Offset = (DWORD) (offset + total);
+            DWORD count = 0;
+            if (!ReadFile(mFile, buffer + total, bytes - total, &count, &overlapped))
+            {
+                if (GetLastError() == ERROR_HANDLE_EOF)
+                {
+                    break;
+                }
+                return total ? total : -1;
+            }
+#else
+            ssize_t count = ::pread(mFile, buffer + total, bytes - total, offset + total);
+            if (count < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return total ? total : -1;
+            }
+#endif
+            if (count == 0)
+            {
+                break;
+            }
+            total += (S32) count;
+        }
+        return total;
+    }
+
+    bool writeAt(S32 offset, const U8* buffer, S32 bytes)
+    {
+        S32 total = 0;
+        while (total < bytes)
+        {
+#if LL_WINDOWS
+            OVERLAPPED overlapped = {};
+            overlapped.Offset = (DWORD) (offset + total);
+            DWORD count = 0;
+            if (!WriteFile(mFile, buffer + total, bytes - total, &count, &overlapped))
+            {
+                return false;
+            }
+#else
+            ssize_t count = ::pwrite(mFile, buffer + total, bytes - total, offset + total);
+            if (count < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+#endif
+            total += (S32) count;
+        }
+        return true;
+    }
+
+    bool truncate()
+    {
+#if LL_WINDOWS
+        FILE_END_OF_FILE_INFO info = {};
+        return SetFileInformationByHandle(mFile, FileEndOfFileInfo, &info, sizeof(info)) != 0;
+#else
+        return ::ftruncate(mFile, 0) == 0;
+#endif
+    }
+
+private:
+    native_t mFile;
+    std::atomic<U64>& mCloses;
+};
+
+//============================================================================
+
+LLFileHandleCache::LLFileHandleCache(path_func_t path_func, U32 max_handles, U32 max_entries)
+:   mPathFunc(path_func),
+    mMaxHandles(llmax(max_handles, (U32) 1)),
+    mMaxEntries(llmax(max_entries, max_handles)),
+    mLastTouchFlush(0),
+    mOpens(0),
+    mCloses(0),
+    mStats(0),
+    mReads(0),
+    mWrites(0),
+    mTouches(0)
+{
+}
+
+LLFileHandleCache::~LLFileHandleCache()
+{
+    flushAccessTimes();
+}
+
+const std::string LLFileHandleCache::getFilepath(const LLUUID& id)
+{
+    LLMutexLock lock(&mMutex);
+    return getEntry(id).mPath;
+}
+
+S32 LLFileHandleCache::getSize(const LLUUID& id)
+{
+    LLMutexLock lock(&mMutex);
+    return getEntry(id).mSize;
+}
+
+S32 LLFileHandleCache::read(const LLUUID& id, S32 offset, U8* buffer, S32 bytes)
+{
+    handle_ptr_t handle;
+    {
+        LLMutexLock lock(&mMutex);
+        Entry& entry = getEntry(id);
+        if (entry.mSize < 0)
+        {
+            return -1;
+        }
+        handle = getHandle(entry, false);
+        if (!handle)
+        {
+            return -1;
+        }
+    }
+
+    // the read itself doesn't need the lock, the handle stays open while we hold it
+    ++mReads;
+    return llmax(handle->readAt(offset, buffer, bytes), 0);
+}
+
+S32 LLFileHandleCache::write(const LLUUID& id, EWriteMode mode, S32 offset, const U8* buffer, S32 bytes)
+{
+    handle_ptr_t handle;
+    S32 write_offset = 0;
+    {
+        LLMutexLock lock(&mMutex);
+        Entry& entry = getEntry(id);
+        handle = getHandle(entry, true);
+        if (!handle)
+        {
+            return -1;
+        }
+
+        // reserve the range now so concurrent appends don't overlap
+        switch (mode)
+        {
+        case WRITE_TRUNCATE:
+            ++mWrites;
+            if (!handle->truncate())
+            {
+                eraseEntry(mEntryMap[id]);
+                return -1;
+            }
+            write_offset = 0;
+            entry.mSize = bytes;
+            break;
+        case WRITE_APPEND:
+            write_offset = llmax(entry.mSize, 0);
+            entry.mSize = write_offset + bytes;
+            break;
+        case WRITE_AT_OFFSET:
+            write_offset = offset;
+            entry.mSize = llmax(entry.mSize, offset + bytes);
+            break;
+        }
+        entry.mAccessTime = time(NULL);
+    }
+
+    ++mWrites;
+    if (!handle->writeAt(write_offset, buffer, bytes))
+    {
+        // don't trust the size we reserved
+        invalidate(id);
+        return -1;
+    }
+
+    return write_offset + bytes;
+}
+
+void LLFileHandleCache::touch(const LLUUID& id)
+{
+    bool flush = false;
+    {
+        LLMutexLock lock(&mMutex);
+        Entry& entry = getEntry(id);
+        if (entry.mSize < 0)
+        {
+            return;
+        }
+
+        time_t now = time(NULL);
+        if (now - entry.mAccessTime <= ACCESS_TIME_THRESHOLD)
+        {
+            return;
+        }
+        entry.mAccessTime = now;
+        mPendingTouches.push_back(entry.mPath);
+
+        flush = mPendingTouches.size() >= TOUCH_BATCH_SIZE ||
+                now - mLastTouchFlush > TOUCH_BATCH_INTERVAL;
+    }
+
+    if (flush)
+    {
+        flushAccessTimes();
+    }
+}
+
+void LLFileHandleCache::flushAccessTimes()
+{
+    std::vector<std::string> paths;
+    {
+        LLMutexLock lock(&mMutex);
+        paths.swap(mPendingTouches);
+        mLastTouchFlush = time(NULL);
+    }
+
+    const std::time_t cur_time = std::time(nullptr);
+    for (const std::string& path : paths)
+    {
+        boost::system::error_code ec;
+#if LL_WINDOWS
+        boost::filesystem::last_write_time(utf8str_to_utf16str(path), cur_time, ec);
+#else
+        boost::filesystem::last_write_time(path, cur_time, ec);
+#endif
+        ++mTouches;
+    }
+}
+
+void LLFileHandleCache::invalidate(const LLUUID& id)
+{
+    LLMutexLock lock(&mMutex);
+    auto iter = mEntryMap.find(id);
+    if (iter != mEntryMap.end())
+    {
+        eraseEntry(iter->second);
+    }
+}
+
+void LLFileHandleCache::invalidatePath(const std::string& path)
+{
+    LLMutexLock lock(&mMutex);
+    auto path_iter = mPathMap.find(path);
+    if (path_iter != mPathMap.end())
+    {
+        eraseEntry(mEntryMap[path_iter->second]);
+    }
+}
+
+void LLFileHandleCache::invalidateAll()
+{
+    LLMutexLock lock(&mMutex);
+    mHandleLRU.clear();
+    mEntryMap.clear();
+    mPathMap.clear();
+    mEntries.clear();
+}
+
+LLFileHandleCache::Stats LLFileHandleCache::getStats() const
+{
+    Stats stats;
+    stats.mOpens = mOpens;
+    stats.mCloses = mCloses;
+    stats.mStats = mStats;
+    stats.mReads = mReads;
+    stats.mWrites = mWrites;
+    stats.mTouches = mTouches;
+    return stats;
+}
+
+void LLFileHandleCache::resetStats()
+{
+    mOpens = 0;
+    mCloses = 0;
+    mStats = 0;
+    mReads = 0;
+    mWrites = 0;
+    mTouches = 0;
+}
+
+LLFileHandleCache::Entry& LLFileHandleCache::getEntry(const LLUUID& id)
+{
+    auto iter = mEntryMap.find(id);
+    if (iter != mEntryMap.end())
+    {
+        mEntries.splice(mEntries.begin(), mEntries, iter->second);
+        return mEntries.front();
+    }
+
+    mEntries.push_front(Entry());
+    Entry& entry = mEntries.front();
+    entry.mID = id;
+    entry.mPath = mPathFunc(id);
+    statEntry(entry);
+
+    mEntryMap[id] = mEntries.begin();
+    mPathMap[entry.mPath] = id;
+
+    while (mEntries.size() > mMaxEntries)
+    {
+        eraseEntry(std::prev(mEntries.end()));
+    }
+
+    return entry;
+}
+
+void LLFileHandleCache::statEntry(Entry& entry)
+{
+    llstat file_status;
+    ++mStats;
+    if (LLFile::stat(entry.mPath, &file_status) == 0)
+    {
+        entry.mSize = (S32) file_status.st_size;
+        entry.mAccessTime = file_status.st_mtime;
+    }
+    else
+    {
+        entry.mSize = -1;
+        entry.mAccessTime = 0;
+    }
+}
+
+LLFileHandleCache::handle_ptr_t LLFileHandleCache::getHandle(Entry& entry, bool create)
+{
+    if (entry.mHandle)
+    {
+        mHandleLRU.splice(mHandleLRU.begin(), mHandleLRU, entry.mHandleIter);
+        return entry.mHandle;
+    }
+
+    Handle::native_t file;
+    ++mOpens;
+    if (!Handle::open(entry.mPath, create, file))
+    {
+        // gone since we last looked
+        entry.mSize = -1;
+        return handle_ptr_t();
+    }
+
+    if (entry.mSize < 0)
+    {
+        entry.mSize = 0;
+        entry.mAccessTime = time(NULL);
+    }
+
+    entry.mHandle = std::make_shared<Handle>(file, mCloses);
+    mHandleLRU.push_front(&entry);
+    entry.mHandleIter = mHandleLRU.begin();
+
+    if (mHandleLRU.size() > mMaxHandles)
+    {
+        // anyone still using it keeps it open until they're done
+        releaseHandle(*mHandleLRU.back());
+    }
+
+    return entry.mHandle;
+}
+
+void LLFileHandleCache::releaseHandle(Entry& entry)
+{
+    if (entry.mHandle)
+    {
+        mHandleLRU.erase(entry.mHandleIter);
+        entry.mHandle.reset();
+    }
+}
+
+void LLFileHandleCache::eraseEntry(entry_list_t::iterator iter)
+{
+    releaseHandle(*iter);
+    mPathMap.erase(iter->mPath);
+    mEntryMap.erase(iter->mID);
+    mEntries.erase(iter);
+}
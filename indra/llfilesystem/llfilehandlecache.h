@@ -0,0 +1,160 @@
+/**
+ * @file llfilehandlecache.h
+ * @brief Open file handles and metadata for disk cache files
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFILEHANDLECACHE_H
+#define LL_LLFILEHANDLECACHE_H
+
+#include "llmutex.h"
+#include "lluuid.h"
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Keeps what LLFileSystem learns about each cache file between calls:
+ * the path, whether it exists and its size, when its access time was last
+ * brought up to date, and (for the most recently used files) an open handle
+ * that reads and writes go through at explicit offsets, so many small reads
+ * of one asset cost one open and one syscall each.
+ *
+ * Access time updates for LLDiskCache::purge() are queued and written in
+ * batches, and skipped for files already touched within the hour, the same
+ * threshold LLDiskCache::updateFileAccessTime() uses.
+ *
+ * All methods are thread safe.  Anything that removes or renames a cache
+ * file outside of this class must call invalidate() or invalidatePath()
+ * first, otherwise stale metadata and handles will be used.
+ */
+class LLFileHandleCache
+{
+public:
+    typedef std::function<std::string(const LLUUID&)> path_func_t;
+
+    // path_func maps an asset id to its cache file.  At most max_handles
+    // files are kept open and metadata is kept for at most max_entries.
+    LLFileHandleCache(path_func_t path_func, U32 max_handles = 64, U32 max_entries = 4096);
+    ~LLFileHandleCache();
+
+    // The cache LLFileSystem uses, backed by LLDiskCache
+    static LLFileHandleCache& instance();
+
+    const std::string getFilepath(const LLUUID& id);
+
+    // Size of the file in bytes, or -1 if it doesn't exist
+    S32 getSize(const LLUUID& id);
+
+    // Read up to bytes at offset.  Returns the number of bytes read, or -1
+    // if the file doesn't exist.
+    S32 read(const LLUUID& id, S32 offset, U8* buffer, S32 bytes);
+
+    enum EWriteMode
+    {
+        WRITE_TRUNCATE,     // replace the file's contents
+        WRITE_APPEND,       // write at the end of the file
+        WRITE_AT_OFFSET     // write at offset, keeping the rest of the file
+    };
+
+    // Write bytes, creating the file if needed.  Returns the offset just
+    // past the written data, or -1 on failure.
+    S32 write(const LLUUID& id, EWriteMode mode, S32 offset, const U8* buffer, S32 bytes);
+
+    // Mark the file as used for LLDiskCache::purge()
+    void touch(const LLUUID& id);
+
+    // Forget everything about a file (before it's removed or renamed)
+    void invalidate(const LLUUID& id);
+    void invalidatePath(const std::string& path);
+    void invalidateAll();
+
+    // Write out queued access time updates
+    void flushAccessTimes();
+
+    // Operating system calls made, for benchmarking
+    struct Stats
+    {
+        U64 mOpens;
+        U64 mCloses;
+        U64 mStats;
+        U64 mReads;
+        U64 mWrites;
+        U64 mTouches;
+
+        U64 getTotal() const { return mOpens + mCloses + mStats + mReads + mWrites + mTouches; }
+    };
+    Stats getStats() const;
+    void resetStats();
+
+private:
+    class Handle;
+    typedef std::shared_ptr<Handle> handle_ptr_t;
+
+    struct Entry
+    {
+        LLUUID      mID;
+        std::string mPath;
+        S32         mSize;          // -1 if the file doesn't exist
+        time_t      mAccessTime;    // last known modification time, 0 if unknown
+        handle_ptr_t mHandle;
+        std::list<Entry*>::iterator mHandleIter;    // position in mHandleLRU if mHandle is set
+    };
+
+    typedef std::list<Entry> entry_list_t;
+
+    // Find or create the entry for id and mark it most recently used,
+    // filling in its metadata if needed.  mMutex must be held.
+    Entry& getEntry(const LLUUID& id);
+    void statEntry(Entry& entry);
+    // Open entry's file, or return its open handle.  mMutex must be held.
+    handle_ptr_t getHandle(Entry& entry, bool create);
+    void releaseHandle(Entry& entry);
+    void eraseEntry(entry_list_t::iterator iter);
+
+    path_func_t mPathFunc;
+    U32 mMaxHandles;
+    U32 mMaxEntries;
+
+    LLMutex mMutex;
+    entry_list_t mEntries;  // most recently used first
+    std::unordered_map<LLUUID, entry_list_t::iterator> mEntryMap;
+    std::unordered_map<std::string, LLUUID> mPathMap;
+    std::list<Entry*> mHandleLRU;   // entries with open handles, most recently used first
+
+    std::vector<std::string> mPendingTouches;
+    time_t mLastTouchFlush;
+
+    std::atomic<U64> mOpens;
+    std::atomic<U64> mCloses;
+    std::atomic<U64> mStats;
+    std::atomic<U64> mReads;
+    std::atomic<U64> mWrites;
+    std::atomic<U64> mTouches;
+};
+
+#endif // LL_LLFILEHANDLECACHE_H
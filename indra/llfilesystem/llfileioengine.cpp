@@ -0,0 +1,455 @@
+/**
+ * @file llfileioengine.cpp
+ * @brief Asynchronous positional file reads and writes
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llfileioengine.h"
+
+#include "llfile.h"
+#include "llthreadsafequeue.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if LL_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#include <linux/io_uring.h>
+#define LL_IO_URING 1
+#endif
+#endif
+
+// More than this many requests in flight doesn't help any disk we've seen
+static const U32 MAX_QUEUE_DEPTH = 256;
+// Blocking I/O needs a thread per request in flight, but not too many
+static const U32 MAX_IO_THREADS = 8;
+
+//============================================================================
+
+LLFileIOEngine::LLFileIOEngine(U32 queue_depth)
+:   mQueueDepth(queue_depth),
+    mInFlight(0)
+{
+}
+
+LLFileIOEngine::~LLFileIOEngine()
+{
+}
+
+void LLFileIOEngine::waitFor(Op* op)
+{
+    while (!op->isDone())
+    {
+        poll(true);
+    }
+}
+
+void LLFileIOEngine::complete(Op* op, S32 result)
+{
+    op->mResult = llmax(result, 0);
+    op->mDone = true;
+    mInFlight--;
+}
+
+// static
+void LLFileIOEngine::perform(Op* op)
+{
+    op->mResult = 0;
+    if (op->mType == Op::READ)
+    {
+        LLUniqueFile infile = LLFile::fopen(op->mFilename, "rb");
+        if (!infile)
+        {
+            LL_WARNS() << "LLLFS: Unable to read file: " << op->mFilename << LL_ENDL;
+            return;
+        }
+        if (op->mOffset >= 0 && fseek(infile, op->mOffset, SEEK_SET) == 0)
+        {
+            op->mResult = (S32) fread(op->mBuffer, 1, op->mBytes, infile);
+        }
+    }
+    else
+    {
+        LLUniqueFile outfile;
+        if (op->mOffset < 0)
+        {
+            outfile = LLFile::fopen(op->mFilename, "ab");
+        }
+        else
+        {
+            // create the file if needed, but don't truncate it
+            outfile = LLFile::fopen(op->mFilename, "r+b");
+            if (!outfile)
+            {
+                outfile = LLFile::fopen(op->mFilename, "w+b");
+            }
+        }
+        if (!outfile)
+        {
+            LL_WARNS() << "LLLFS: Unable to write file: " << op->mFilename << LL_ENDL;
+            return;
+        }
+        if (op->mOffset >= 0 && fseek(outfile, op->mOffset, SEEK_SET) != 0)
+        {
+            LL_WARNS() << "LLLFS: Unable to write file (seek failed): " << op->mFilename << LL_ENDL;
+            return;
+        }
+        op->mResult = (S32) fwrite(op->mBuffer, 1, op->mBytes, outfile);
+    }
+}
+
+//============================================================================
+// Worker threads doing blocking I/O, for when there's no io_uring
+
+class LLFileIOThreadEngine : public LLFileIOEngine
+{
+public:
+    LLFileIOThreadEngine(U32 queue_depth)
+    :   LLFileIOEngine(queue_depth),
+        mRequests(queue_depth),
+        mCompleted(queue_depth)
+    {
+        U32 thread_count = llmin(queue_depth, MAX_IO_THREADS);
+        for (U32 i = 0; i < thread_count; ++i)
+        {
+            mThreads.emplace_back([this]()
+                {
+                    try
+                    {
+                        while (true)
+                        {
+                            Op* op = mRequests.pop();
+                            perform(op);
+                            mCompleted.push(op);
+                        }
+                    }
+                    catch (const LLThreadSafeQueueInterrupt&)
+                    {
+                        // closed and drained
+                    }
+                });
+        }
+    }
+
+    ~LLFileIOThreadEngine()
+    {
+        mRequests.close();
+        for (std::thread& thread : mThreads)
+        {
+            thread.join();
+        }
+    }
+
+    /*virtual*/ const char* getName() const { return "threads"; }
+
+    /*virtual*/ bool submit(Op* op)
+    {
+        if (isFull())
+        {
+            return false;
+        }
+        mInFlight++;
+        mRequests.push(op);
+        return true;
+    }
+
+    /*virtual*/ void poll(bool wait)
+    {
+        Op* op = NULL;
+        if (wait && mInFlight > 0)
+        {
+            op = mCompleted.pop();
+            complete(op, op->mResult);
+        }
+        while (mCompleted.tryPop(op))
+        {
+            complete(op, op->mResult);
+        }
+    }
+
+private:
+    LLThreadSafeQueue<Op*> mRequests;
+    LLThreadSafeQueue<Op*> mCompleted;
+    std::vector<std::thread> mThreads;
+};
+
+//============================================================================
+// Linux io_uring, set up with the raw system calls so there's no liburing
+// dependency.  Uses readv/writev (kernel 5.1+) rather than read/write (5.6+).
+
+#if LL_IO_URING
+
+class LLFileIOUringEngine : public LLFileIOEngine
+{
+public:
+    LLFileIOUringEngine(U32 queue_depth)
+    :   LLFileIOEngine(queue_depth),
+        mRing(-1),
+        mUnsubmitted(0),
+        mSQRing(MAP_FAILED),
+        mCQRing(MAP_FAILED),
+        mSQEs(MAP_FAILED),
+        mSQRingSize(0),
+        mCQRingSize(0),
+        mSQEsSize(0)
+    {
+    }
+
+    ~LLFileIOUringEngine()
+    {
+        // the kernel may still be writing to buffers of ops in flight
+        while (mInFlight > 0 && mRing >= 0)
+        {
+            poll(true);
+        }
+
+        if (mSQEs != MAP_FAILED)
+        {
+            munmap(mSQEs, mSQEsSize);
+        }
+        if (mCQRing != MAP_FAILED && mCQRing != mSQRing)
+        {
+            munmap(mCQRing, mCQRingSize);
+        }
+        if (mSQRing != MAP_FAILED)
+        {
+            munmap(mSQRing, mSQRingSize);
+        }
+        if (mRing >= 0)
+        {
+            close(mRing);
+        }
+    }
+
+    // False if the kernel doesn't have io_uring or won't let us use it
+    bool init()
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        mRing = (int) syscall(__NR_io_uring_setup, mQueueDepth, &params);
+        if (mRing < 0)
+        {
+            LL_INFOS() << "io_uring unavailable: " << strerror(errno) << LL_ENDL;
+            return false;
+        }
+
+        mSQRingSize = params.sq_off.array + params.sq_entries * sizeof(U32);
+        mCQRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap)
+        {
+            mSQRingSize = mCQRingSize = llmax(mSQRingSize, mCQRingSize);
+        }
+
+        mSQRing = mmap(NULL, mSQRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQ_RING);
+        if (mSQRing == MAP_FAILED)
+        {
+            return false;
+        }
+        mCQRing = single_mmap ? mSQRing : mmap(NULL, mCQRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_CQ_RING);
+        if (mCQRing == MAP_FAILED)
+        {
+            return false;
+        }
+        mSQEsSize = params.sq_entries * sizeof(io_uring_sqe);
+        mSQEs = mmap(NULL, mSQEsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQES);
+        if (mSQEs == MAP_FAILED)
+        {
+            return false;
+        }
+
+        U8* sq = (U8*) mSQRing;
+        mSQHead = (U32*) (sq + params.sq_off.head);
+        mSQTail = (U32*) (sq + params.sq_off.tail);
+        mSQMask = *(U32*) (sq + params.sq_off.ring_mask);
+        mSQArray = (U32*) (sq + params.sq_off.array);
+        U8* cq = (U8*) mCQRing;
+        mCQHead = (U32*) (cq + params.cq_off.head);
+        mCQTail = (U32*) (cq + params.cq_off.tail);
+        mCQMask = *(U32*) (cq + params.cq_off.ring_mask);
+        mCQEs = (io_uring_cqe*) (cq + params.cq_off.cqes);
+
+        return true;
+    }
+
+    /*virtual*/ const char* getName() const { return "io_uring"; }
+
+    /*virtual*/ bool submit(Op* op)
+    {
+        if (isFull())
+        {
+            return false;
+        }
+        mInFlight++;
+
+        if (op->mType == Op::READ && op->mOffset < 0)
+        {
+            // nothing to read at the end of the file
+            complete(op, 0);
+            return true;
+        }
+
+        int flags = O_CLOEXEC;
+        if (op->mType == Op::READ)
+        {
+            flags |= O_RDONLY;
+        }
+        else
+        {
+            flags |= O_WRONLY | O_CREAT | (op->mOffset < 0 ? O_APPEND : 0);
+        }
+        op->mFile = open(op->mFilename.c_str(), flags, 0644);
+        if (op->mFile < 0)
+        {
+            LL_WARNS() << "LLLFS: Unable to " << (op->mType == Op::READ ? "read" : "write") << " file: " << op->mFilename << LL_ENDL;
+            complete(op, 0);
+            return true;
+        }
+
+        iovec* iov = new iovec;
+        iov->iov_base = op->mBuffer;
+        iov->iov_len = op->mBytes;
+        op->mIOVec = iov;
+
+        U32 tail = *mSQTail;
+        U32 index = tail & mSQMask;
+        io_uring_sqe* sqe = (io_uring_sqe*) mSQEs + index;
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = op->mType == Op::READ ? IORING_OP_READV : IORING_OP_WRITEV;
+        sqe->fd = op->mFile;
+        sqe->addr = (U64) iov;
+        sqe->len = 1;
+        sqe->off = op->mOffset < 0 ? 0 : op->mOffset; // O_APPEND writes ignore the offset
+        sqe->user_data = (U64) op;
+        mSQArray[index] = index;
+        __atomic_store_n(mSQTail, tail + 1, __ATOMIC_RELEASE);
+        mUnsubmitted++;
+
+        enter(0);
+        return true;
+    }
+
+    /*virtual*/ void poll(bool wait)
+    {
+        reap();
+        if (wait && mInFlight > 0)
+        {
+            enter(1);
+            reap();
+        }
+        else if (mUnsubmitted)
+        {
+            enter(0);
+        }
+    }
+
+private:
+    // Hand queued entries to the kernel, waiting for min_complete completions.
+    // Entries the kernel doesn't take stay in the ring for next time.
+    void enter(U32 min_complete)
+    {
+        while (true)
+        {
+            int submitted = (int) syscall(__NR_io_uring_enter, mRing, mUnsubmitted, min_complete,
+                                          min_complete ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+            if (submitted >= 0)
+            {
+                mUnsubmitted -= llmin((U32) submitted, mUnsubmitted);
+                return;
+            }
+            if (errno != EINTR)
+            {
+                // EAGAIN or EBUSY, try again on the next poll
+                return;
+            }
+        }
+    }
+
+    void reap()
+    {
+        U32 head = *mCQHead;
+        U32 tail = __atomic_load_n(mCQTail, __ATOMIC_ACQUIRE);
+        while (head != tail)
+        {
+            io_uring_cqe* cqe = mCQEs + (head & mCQMask);
+            Op* op = (Op*) cqe->user_data;
+            close(op->mFile);
+            op->mFile = -1;
+            delete (iovec*) op->mIOVec;
+            op->mIOVec = NULL;
+            complete(op, cqe->res);
+            head++;
+        }
+        __atomic_store_n(mCQHead, head, __ATOMIC_RELEASE);
+    }
+
+    int mRing;
+    U32 mUnsubmitted;
+
+    void* mSQRing;
+    void* mCQRing;
+    void* mSQEs;
+    size_t mSQRingSize;
+    size_t mCQRingSize;
+    size_t mSQEsSize;
+
+    U32* mSQHead;
+    U32* mSQTail;
+    U32 mSQMask;
+    U32* mSQArray;
+    U32* mCQHead;
+    U32* mCQTail;
+    U32 mCQMask;
+    io_uring_cqe* mCQEs;
+};
+
+#endif // LL_IO_URING
+
+//============================================================================
+
+// static
+std::unique_ptr<LLFileIOEngine> LLFileIOEngine::create(U32 queue_depth, bool allow_io_uring)
+{
+    queue_depth = llclamp(queue_depth, (U32) 1, MAX_QUEUE_DEPTH);
+
+#if LL_IO_URING
+    if (allow_io_uring)
+    {
+        std::unique_ptr<LLFileIOUringEngine> engine(new LLFileIOUringEngine(queue_depth));
+        if (engine->init())
+        {
+            return std::move(engine);
+        }
+    }
+#endif
+
+    return std::unique_ptr<LLFileIOEngine>(new LLFileIOThreadEngine(queue_depth));
+}
@@ -0,0 +1,125 @@
+/**
+ * @file llfileioengine.h
+ * @brief Asynchronous positional file reads and writes
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFILEIOENGINE_H
+#define LL_LLFILEIOENGINE_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+//============================================================================
+// Keeps up to a fixed number of file reads and writes in flight at once so
+// that fast disks see more than one request at a time.  On Linux this uses
+// io_uring when the kernel allows it, everywhere else (or if io_uring can't
+// be set up) a few worker threads doing ordinary blocking I/O.
+//
+// An engine is driven by one thread: submit() and poll() must not be called
+// concurrently.
+//============================================================================
+
+class LLFileIOEngine
+{
+public:
+    class Op
+    {
+    public:
+        enum EType
+        {
+            READ,
+            WRITE
+        };
+
+        Op(EType type, const std::string& filename, U8* buffer, S32 offset, S32 bytes)
+        :   mType(type),
+            mFilename(filename),
+            mBuffer(buffer),
+            mOffset(offset),
+            mBytes(bytes),
+            mResult(0),
+            mDone(false),
+            mFile(-1),
+            mIOVec(NULL)
+        {
+        }
+
+        bool isDone() const { return mDone; }
+        // Bytes read or written, 0 on failure; valid once isDone()
+        S32 getResult() const { return mResult; }
+
+        const EType mType;
+        const std::string mFilename;
+        U8* const mBuffer;
+        const S32 mOffset;  // offset into the file, -1 = append (WRITE only) or end of file (READ)
+        const S32 mBytes;
+
+    private:
+        friend class LLFileIOEngine;
+        friend class LLFileIOThreadEngine;
+        friend class LLFileIOUringEngine;
+
+        S32 mResult;
+        std::atomic<bool> mDone;
+        int mFile;          // descriptor while the op is in an io_uring
+        void* mIOVec;       // struct iovec for io_uring readv/writev
+    };
+
+    // An engine keeping up to queue_depth ops in flight.  io_uring is only
+    // tried if allow_io_uring is set.
+    static std::unique_ptr<LLFileIOEngine> create(U32 queue_depth, bool allow_io_uring);
+
+    virtual ~LLFileIOEngine();
+
+    virtual const char* getName() const = 0;
+
+    // Start op.  Returns false, and leaves op alone, if queue_depth ops are
+    // already in flight.  op must stay alive until it's done.
+    virtual bool submit(Op* op) = 0;
+
+    // Mark finished ops as done.  If wait is set and an op is in flight,
+    // block until at least one finishes.
+    virtual void poll(bool wait) = 0;
+
+    // Poll until op is done
+    void waitFor(Op* op);
+
+    U32 getQueueDepth() const { return mQueueDepth; }
+    U32 getInFlight() const { return mInFlight; }
+    bool isFull() const { return mInFlight >= mQueueDepth; }
+
+    // Do op right now on the calling thread
+    static void perform(Op* op);
+
+protected:
+    LLFileIOEngine(U32 queue_depth);
+
+    void complete(Op* op, S32 result);
+
+    const U32 mQueueDepth;
+    U32 mInFlight;
+};
+
+#endif // LL_LLFILEIOENGINE_H
@@ -33,6 +33,8 @@
 #include "llfilesystem.h"
 #include "llfasttimer.h"
 #include "lldiskcache.h"
+#include "llfilehandlecache.h"
+#include "lltimer.h"
 
 const S32 LLFileSystem::READ        = 0x00000001;
 const S32 LLFileSystem::WRITE       = 0x00000002;
@@ -41,6 +43,19 @@ const S32 LLFileSystem::APPEND      = 0x00000006;  // 0x00000004 & LLFileSystem:
 
 static LLTrace::BlockTimerStatHandle FTM_VFILE_WAIT("VFile Wait");
 
+// static
+LLFileHandleCache& LLFileHandleCache::instance()
+{
+    static LLFileHandleCache sInstance([](const LLUUID& id)
+        {
+            std::string id_str;
+            id.toString(id_str);
+            const std::string extra_info = "";
+            return LLDiskCache::getInstance()->metaDataToFilepath(id_str, LLAssetType::AT_NONE, extra_info);
+        });
+    return sInstance;
+}
+
 LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_type, S32 mode)
 {
     mFileType = file_type;
@@ -54,21 +69,11 @@ LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_
     // we decided to follow Henri's suggestion and move the code to update the last access time here.
     if (mode == LLFileSystem::READ)
     {
-        // build the filename (TODO: we do this in a few places - perhaps we should factor into a single function)
-        std::string id;
-        mFileID.toString(id);
-        const std::string extra_info = "";
-        const std::string filename = LLDiskCache::getInstance()->metaDataToFilepath(id, mFileType, extra_info);
-
         // update the last access time for the file if it exists - this is required
         // even though we are reading and not writing because this is the
         // way the cache works - it relies on a valid "last accessed time" for
         // each file so it knows how to remove the oldest, unused files
-        bool exists = gDirUtilp->fileExists(filename);
-        if (exists)
-        {
-            LLDiskCache::getInstance()->updateFileAccessTime(filename);
-        }
+        LLFileHandleCache::instance().touch(mFileID);
     }
 }
 
@@ -79,27 +84,15 @@ LLFileSystem::~LLFileSystem()
 // static
 bool LLFileSystem::getExists(const LLUUID& file_id, const LLAssetType::EType file_type)
 {
-    std::string id_str;
-    file_id.toString(id_str);
-    const std::string extra_info = "";
-    const std::string filename = LLDiskCache::getInstance()->metaDataToFilepath(id_str, file_type, extra_info);
-
-    llifstream file(filename, std::ios::binary);
-    if (file.is_open())
-    {
-        file.seekg(0, std::ios::end);
-        return file.tellg() > 0;
-    }
-    return false;
+    return LLFileHandleCache::instance().getSize(file_id) > 0;
 }
 
 // static
 bool LLFileSystem::removeFile(const LLUUID& file_id, const LLAssetType::EType file_type, int suppress_error /*= 0*/)
 {
-    std::string id_str;
-    file_id.toString(id_str);
-    const std::string extra_info = "";
-    const std::string filename =  LLDiskCache::getInstance()->metaDataToFilepath(id_str, file_type, extra_info);
+    LLFileHandleCache& cache = LLFileHandleCache::instance();
+    const std::string filename = cache.getFilepath(file_id);
+    cache.invalidate(file_id);
 
     LLFile::remove(filename.c_str(), suppress_error);
 
@@ -110,26 +103,23 @@ bool LLFileSystem::removeFile(const LLUUID& file_id, const LLAssetType::EType fi
 bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::EType old_file_type,
                               const LLUUID& new_file_id, const LLAssetType::EType new_file_type)
 {
-    std::string old_id_str;
-    old_file_id.toString(old_id_str);
-    const std::string extra_info = "";
-    const std::string old_filename =  LLDiskCache::getInstance()->metaDataToFilepath(old_id_str, old_file_type, extra_info);
-
-    std::string new_id_str;
-    new_file_id.toString(new_id_str);
-    const std::string new_filename =  LLDiskCache::getInstance()->metaDataToFilepath(new_id_str, new_file_type, extra_info);
+    LLFileHandleCache& cache = LLFileHandleCache::instance();
+    const std::string old_filename = cache.getFilepath(old_file_id);
+    const std::string new_filename = cache.getFilepath(new_file_id);
 
     // Rename needs the new file to not exist.
     LLFileSystem::removeFile(new_file_id, new_file_type, ENOENT);
 
+    cache.invalidate(old_file_id);
     if (LLFile::rename(old_filename, new_filename) != 0)
     {
         // We would like to return FALSE here indicating the operation
         // failed but the original code does not and doing so seems to
         // break a lot of things so we go with the flow...
         //return FALSE;
-        LL_WARNS() << "Failed to rename " << old_file_id << " to " << new_id_str << " reason: "  << strerror(errno) << LL_ENDL;
+        LL_WARNS() << "Failed to rename " << old_file_id << " to " << new_file_id << " reason: "  << strerror(errno) << LL_ENDL;
     }
+    cache.invalidate(new_file_id);
 
     return TRUE;
 }
@@ -137,48 +127,17 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
 // static
 S32 LLFileSystem::getFileSize(const LLUUID& file_id, const LLAssetType::EType file_type)
 {
-    std::string id_str;
-    file_id.toString(id_str);
-    const std::string extra_info = "";
-    const std::string filename =  LLDiskCache::getInstance()->metaDataToFilepath(id_str, file_type, extra_info);
-
-    S32 file_size = 0;
-    llifstream file(filename, std::ios::binary);
-    if (file.is_open())
-    {
-        file.seekg(0, std::ios::end);
-        file_size = file.tellg();
-    }
-
-    return file_size;
+    return llmax(LLFileHandleCache::instance().getSize(file_id), 0);
 }
 
 BOOL LLFileSystem::read(U8* buffer, S32 bytes)
 {
     BOOL success = FALSE;
 
-    std::string id;
-    mFileID.toString(id);
-    const std::string extra_info = "";
-    const std::string filename =  LLDiskCache::getInstance()->metaDataToFilepath(id, mFileType, extra_info);
-
-    llifstream file(filename, std::ios::binary);
-    if (file.is_open())
+    S32 bytes_read = LLFileHandleCache::instance().read(mFileID, mPosition, buffer, bytes);
+    if (bytes_read >= 0)
     {
-        file.seekg(mPosition, std::ios::beg);
-
-        file.read((char*)buffer, bytes);
-
-        if (file)
-        {
-            mBytesRead = bytes;
-        }
-        else
-        {
-            mBytesRead = file.gcount();
-        }
-
-        file.close();
+        mBytesRead = bytes_read;
 
         mPosition += mBytesRead;
         if (mBytesRead)
@@ -202,64 +161,39 @@ BOOL LLFileSystem::eof()
 
 BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
 {
-    std::string id_str;
-    mFileID.toString(id_str);
-    const std::string extra_info = "";
-    const std::string filename =  LLDiskCache::getInstance()->metaDataToFilepath(id_str, mFileType, extra_info);
-
-    BOOL success = FALSE;
-
+    LLFileHandleCache::EWriteMode write_mode;
     if (mMode == APPEND)
     {
-        llofstream ofs(filename, std::ios::app | std::ios::binary);
-        if (ofs)
-        {
-            ofs.write((const char*)buffer, bytes);
-
-            mPosition = ofs.tellp(); // <FS:Ansariel> Fix asset caching
-
-            success = TRUE;
-        }
+        write_mode = LLFileHandleCache::WRITE_APPEND;
     }
     // <FS:Ansariel> Fix asset caching
     else if (mMode == READ_WRITE)
     {
         // Don't truncate if file already exists
-        llofstream ofs(filename, std::ios::in | std::ios::binary);
-        if (ofs)
-        {
-            ofs.seekp(mPosition, std::ios::beg);
-            ofs.write((const char*)buffer, bytes);
-            mPosition += bytes;
-            success = TRUE;
-        }
-        else
-        {
-            // File doesn't exist - open in write mode
-            ofs.open(filename, std::ios::binary);
-            if (ofs.is_open())
-            {
-                ofs.write((const char*)buffer, bytes);
-                mPosition += bytes;
-                success = TRUE;
-            }
-        }
+        write_mode = LLFileHandleCache::WRITE_AT_OFFSET;
     }
     // </FS:Ansariel>
     else
     {
-        llofstream ofs(filename, std::ios::binary);
-        if (ofs)
-        {
-            ofs.write((const char*)buffer, bytes);
+        write_mode = LLFileHandleCache::WRITE_TRUNCATE;
+    }
 
-            mPosition += bytes;
+    S32 end = LLFileHandleCache::instance().write(mFileID, write_mode, mPosition, buffer, bytes);
+    if (end < 0)
+    {
+        return FALSE;
+    }
 
-            success = TRUE;
-        }
+    if (mMode == APPEND)
+    {
+        mPosition = end; // <FS:Ansariel> Fix asset caching
+    }
+    else
+    {
+        mPosition += bytes;
     }
 
-    return success;
+    return TRUE;
 }
 
 BOOL LLFileSystem::seek(S32 offset, S32 origin)
@@ -324,3 +258,87 @@ BOOL LLFileSystem::remove()
 
     return TRUE;
 }
+
+// static
+void LLFileSystem::runBenchmark(U32 asset_count, S32 chunk_size)
+{
+    const S32 ASSET_SIZE = 16 * 1024;
+
+    std::vector<U8> data(ASSET_SIZE);
+    for (S32 i = 0; i < ASSET_SIZE; ++i)
+    {
+        data[i] = (U8) i;
+    }
+
+    std::vector<LLUUID> ids(asset_count);
+    for (LLUUID& id : ids)
+    {
+        id.generate();
+        LLFileSystem file(id, LLAssetType::AT_TEXTURE, LLFileSystem::WRITE);
+        file.write(&data[0], ASSET_SIZE);
+    }
+
+    std::vector<U8> buffer(chunk_size);
+    S64 bytes_total = (S64) asset_count * ASSET_SIZE;
+
+    // the way reads went before LLFileHandleCache: the path is rebuilt, the
+    // file opened and closed for every chunk, and the size and access time
+    // looked up on every open
+    U64 legacy_opens = 0;
+    U64 legacy_stats = 0;
+    LLTimer timer;
+    for (const LLUUID& id : ids)
+    {
+        std::string id_str;
+        id.toString(id_str);
+        const std::string filename = LLDiskCache::getInstance()->metaDataToFilepath(id_str, LLAssetType::AT_TEXTURE, "");
+        legacy_stats += 2; // fileExists() and updateFileAccessTime()
+        gDirUtilp->fileExists(filename);
+
+        S32 size = 0;
+        {
+            llifstream file(filename, std::ios::binary);
+            ++legacy_opens;
+            file.seekg(0, std::ios::end);
+            size = (S32) file.tellg();
+        }
+
+        for (S32 position = 0; position < size; position += chunk_size)
+        {
+            llifstream file(filename, std::ios::binary);
+            ++legacy_opens;
+            file.seekg(position, std::ios::beg);
+            file.read((char*) &buffer[0], chunk_size);
+        }
+    }
+    F32 legacy_time = timer.getElapsedTimeF32();
+
+    LLFileHandleCache& cache = LLFileHandleCache::instance();
+    cache.invalidateAll();
+    cache.resetStats();
+    timer.reset();
+    for (const LLUUID& id : ids)
+    {
+        LLFileSystem file(id, LLAssetType::AT_TEXTURE, LLFileSystem::READ);
+        S32 size = file.getSize();
+        while (file.tell() < size && file.read(&buffer[0], chunk_size))
+        {
+        }
+    }
+    F32 cached_time = timer.getElapsedTimeF32();
+    LLFileHandleCache::Stats stats = cache.getStats();
+
+    for (const LLUUID& id : ids)
+    {
+        LLFileSystem::removeFile(id, LLAssetType::AT_TEXTURE);
+    }
+
+    F32 mb = bytes_total / (1024.f * 1024.f);
+    LL_INFOS("Benchmark") << "Disk cache benchmark, " << asset_count << " assets of " << ASSET_SIZE
+        << " bytes read in " << chunk_size << " byte chunks" << LL_ENDL;
+    LL_INFOS("Benchmark") << "Stream per read: " << legacy_time * 1000.f << " ms, " << mb / llmax(legacy_time, 0.001f)
+        << " MB/s, " << legacy_opens << " opens, " << legacy_stats << " stats" << LL_ENDL;
+    LL_INFOS("Benchmark") << "Handle cache: " << cached_time * 1000.f << " ms, " << mb / llmax(cached_time, 0.001f)
+        << " MB/s, " << stats.mOpens << " opens, " << stats.mStats << " stats, " << stats.mReads << " reads, "
+        << stats.mTouches << " access time updates" << LL_ENDL;
+}
@@ -59,6 +59,10 @@ class LLFileSystem
                                const LLUUID& new_file_id, const LLAssetType::EType new_file_type);
         static S32 getFileSize(const LLUUID& file_id, const LLAssetType::EType file_type);
 
+        // Time reading asset_count cache files chunk_size bytes at a time,
+        // through LLFileHandleCache and by reopening the file for each chunk
+        static void runBenchmark(U32 asset_count, S32 chunk_size);
+
     public:
         static const S32 READ;
         static const S32 WRITE;
@@ -28,6 +28,8 @@
 #include "lllfsthread.h"
 #include "llstl.h"
 #include "llapr.h"
+#include "lltimer.h"
+#include <boost/filesystem.hpp>
 
 //============================================================================
 
@@ -36,10 +38,10 @@
 //============================================================================
 // Run on MAIN thread
 //static
-void LLLFSThread::initClass(bool local_is_threaded)
+void LLLFSThread::initClass(bool local_is_threaded, U32 queue_depth, bool allow_io_uring)
 {
 	llassert(sLocal == NULL);
-	sLocal = new LLLFSThread(local_is_threaded);
+	sLocal = new LLLFSThread(local_is_threaded, queue_depth, allow_io_uring);
 }
 
 //static
@@ -64,22 +66,44 @@ void LLLFSThread::cleanupClass()
 
 //----------------------------------------------------------------------------
 
-LLLFSThread::LLLFSThread(bool threaded) :
+LLLFSThread::LLLFSThread(bool threaded, U32 queue_depth, bool allow_io_uring) :
 	LLQueuedThread("LFS", threaded),
-	mPriorityCounter(PRIORITY_LOWBITS)
+	mPriorityCounter(PRIORITY_LOWBITS),
+	mUnsubmitted(0),
+	mDraining(false)
 {
 	if(!mLocalAPRFilePoolp)
 	{
 		mLocalAPRFilePoolp = new LLVolatileAPRPool() ;
 	}
+	if (queue_depth > 1)
+	{
+		mIOEngine = LLFileIOEngine::create(queue_depth, allow_io_uring);
+		LL_INFOS() << "LLLFSThread using " << mIOEngine->getName() << " with queue depth " << mIOEngine->getQueueDepth() << LL_ENDL;
+	}
 }
 
 LLLFSThread::~LLLFSThread()
 {
+	// delete the requests while mIOEngine is still around to finish
+	// whatever they have in flight
+	shutdown();
+	mIOEngine.reset();
 	// mLocalAPRFilePoolp cleanup in LLThread
 	// ~LLQueuedThread() will be called here
 }
 
+// virtual
+S32 LLLFSThread::update(F32 max_time_ms)
+{
+	// the caller (flushLFSIO(), cleanupClass()) is waiting for everything
+	// to finish anyway, so block on the engine rather than spin
+	mDraining = !getThreaded() && max_time_ms == 0.f;
+	S32 res = LLQueuedThread::update(max_time_ms);
+	mDraining = false;
+	return res;
+}
+
 //----------------------------------------------------------------------------
 
 LLLFSThread::handle_t LLLFSThread::read(const std::string& filename,	/* Flawfinder: ignore */ 
@@ -127,6 +151,91 @@ LLLFSThread::handle_t LLLFSThread::write(const std::string& filename,
 	return handle;
 }
 
+namespace
+{
+	class BenchmarkResponder : public LLLFSThread::Responder
+	{
+	public:
+		BenchmarkResponder(LLAtomicS32& bytes, LLAtomicU32& count)
+		:	mBytes(bytes),
+			mCount(count)
+		{
+		}
+
+		/*virtual*/ void completed(S32 bytes)
+		{
+			mBytes += bytes;
+			mCount++;
+		}
+
+	private:
+		LLAtomicS32& mBytes;
+		LLAtomicU32& mCount;
+	};
+}
+
+//static
+void LLLFSThread::runBenchmark(const std::vector<std::string>& dirs, U32 max_files, bool allow_io_uring)
+{
+	// textures and meshes are read a header or a LOD at a time, not whole
+	const S32 MAX_READ_SIZE = 64 * 1024;
+
+	std::vector<std::pair<std::string, S32> > files;
+	for (const std::string& dir : dirs)
+	{
+		boost::system::error_code ec;
+		boost::filesystem::recursive_directory_iterator iter(dir, ec), end;
+		for ( ; !ec && iter != end && files.size() < max_files; iter.increment(ec))
+		{
+			if (boost::filesystem::is_regular_file(iter->status()))
+			{
+				S32 size = (S32) llmin(boost::filesystem::file_size(iter->path(), ec), (uintmax_t) MAX_READ_SIZE);
+				if (!ec && size > 0)
+				{
+					files.push_back(std::make_pair(iter->path().string(), size));
+				}
+			}
+		}
+	}
+	if (files.empty())
+	{
+		LL_WARNS("Benchmark") << "LFS benchmark found no files to read" << LL_ENDL;
+		return;
+	}
+
+	std::vector<std::vector<U8> > buffers(files.size());
+	for (U32 i = 0; i < files.size(); ++i)
+	{
+		buffers[i].resize(files[i].second);
+	}
+
+	LL_INFOS("Benchmark") << "LFS benchmark, reading " << files.size() << " files of up to " << MAX_READ_SIZE
+		<< " bytes. Everything after the first pass is likely to come from the OS file cache." << LL_ENDL;
+
+	const U32 depths[] = { 1, 4, 16, 64 };
+	for (U32 depth : depths)
+	{
+		LLLFSThread thread(true, depth, allow_io_uring);
+		LLAtomicS32 bytes(0);
+		LLAtomicU32 count(0);
+
+		LLTimer timer;
+		for (U32 i = 0; i < files.size(); ++i)
+		{
+			thread.read(files[i].first, &buffers[i][0], 0, files[i].second, new BenchmarkResponder(bytes, count));
+		}
+		while (count < files.size())
+		{
+			ms_sleep(1);
+		}
+		F32 elapsed = timer.getElapsedTimeF32();
+
+		LL_INFOS("Benchmark") << "Queue depth " << depth << " (" << (thread.mIOEngine ? thread.mIOEngine->getName() : "blocking")
+			<< "): " << elapsed * 1000.f << " ms, " << files.size() / llmax(elapsed, 0.001f) << " files/s, "
+			<< bytes / (1024.f * 1024.f) / llmax(elapsed, 0.001f) << " MB/s" << LL_ENDL;
+	}
+}
+
 //============================================================================
 
 LLLFSThread::Request::Request(LLLFSThread* thread,
@@ -142,12 +251,15 @@ LLLFSThread::Request::Request(LLLFSThread* thread,
 	mOffset(offset),
 	mBytes(numbytes),
 	mBytesRead(0),
-	mResponder(responder)
+	mResponder(responder),
+	mIOOp(op == FILE_READ ? LLFileIOEngine::Op::READ : LLFileIOEngine::Op::WRITE, filename, buffer, offset, numbytes),
+	mSubmitted(false)
 {
 	if (numbytes <= 0)
 	{
 		LL_WARNS() << "LLLFSThread: Request with numbytes = " << numbytes << LL_ENDL;
 	}
+	mThread->mUnsubmitted++;
 }
 
 LLLFSThread::Request::~Request()
@@ -157,6 +269,13 @@ LLLFSThread::Request::~Request()
 // virtual, called from own thread
 void LLLFSThread::Request::finishRequest(bool completed)
 {
+	if (mSubmitted && mThread->mIOEngine)
+	{
+		// aborted while in flight, don't tell the responder before the
+		// disk is done with the buffer.  Only blocks on the LFS thread, or
+		// when quitting; readyToAbort() keeps it off the main thread.
+		mThread->mIOEngine->waitFor(&mIOOp);
+	}
 	if (mResponder.notNull())
 	{
 		mResponder->completed(completed ? mBytesRead : 0);
@@ -164,12 +283,39 @@ void LLLFSThread::Request::finishRequest(bool completed)
 	}
 }
 
+// virtual, called from own thread
+bool LLLFSThread::Request::readyToAbort()
+{
+	LLFileIOEngine* engine = mThread->mIOEngine.get();
+	if (!mSubmitted || !engine || mThread->getThreaded())
+	{
+		return true;
+	}
+	// unthreaded, this is the main thread; stay queued until the op is
+	// reaped rather than wait for the disk in finishRequest(), unless
+	// update() is draining the queue anyway
+	if (!mIOOp.isDone())
+	{
+		engine->poll(mThread->mDraining);
+	}
+	return mIOOp.isDone();
+}
+
 void LLLFSThread::Request::deleteRequest()
 {
 	if (getStatus() == STATUS_QUEUED)
 	{
 		LL_ERRS() << "Attempt to delete a queued LLLFSThread::Request!" << LL_ENDL;
 	}	
+	if (!mSubmitted)
+	{
+		mThread->mUnsubmitted--;
+	}
+	else if (mThread->mIOEngine)
+	{
+		// deleted while in flight by shutdown()
+		mThread->mIOEngine->waitFor(&mIOOp);
+	}
 	if (mResponder.notNull())
 	{
 		mResponder->completed(0);
@@ -180,6 +326,42 @@ void LLLFSThread::Request::deleteRequest()
 
 bool LLLFSThread::Request::processRequest()
 {
+	LLFileIOEngine* engine = mThread->mIOEngine.get();
+	if (engine)
+	{
+		if (!mSubmitted)
+		{
+			if (engine->isFull())
+			{
+				// wait for a slot in threaded mode, never on the main thread
+				// unless it's draining the queue
+				engine->poll(mThread->getThreaded() || mThread->mDraining);
+			}
+			if (!engine->submit(&mIOOp))
+			{
+				return false;
+			}
+			mSubmitted = true;
+			mThread->mUnsubmitted--;
+		}
+
+		if (!mIOOp.isDone())
+		{
+			// block only if there's nothing else to start meanwhile
+			engine->poll((mThread->getThreaded() || mThread->mDraining) && mThread->mUnsubmitted == 0);
+		}
+		if (!mIOOp.isDone())
+		{
+			// go to the back of our priority band so the requests behind
+			// this one get started while the disk works on it
+			setPriority(getPriority() & PRIORITY_HIGHBITS);
+			return false;
+		}
+
+		mBytesRead = mIOOp.getResult();
+		return true;
+	}
+
 	bool complete = false;
 	if (mOperation ==  FILE_READ)
 	{
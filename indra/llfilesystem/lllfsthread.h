@@ -31,9 +31,11 @@
 #include <string>
 #include <map>
 #include <set>
+#include <vector>
 
 #include "llpointer.h"
 #include "llqueuedthread.h"
+#include "llfileioengine.h"
 
 //============================================================================
 // Threaded Local File System
@@ -96,6 +98,7 @@ public:
 		
 		/*virtual*/ bool processRequest();
 		/*virtual*/ void finishRequest(bool completed);
+		/*virtual*/ bool readyToAbort();
 		/*virtual*/ void deleteRequest();
 		
 	private:
@@ -110,11 +113,16 @@ public:
 		S32 mBytesRead;	// bytes read from file
 
 		LLPointer<Responder> mResponder;
+
+		LLFileIOEngine::Op mIOOp;	// used when the thread has an LLFileIOEngine
+		bool mSubmitted;
 	};
 
 	//------------------------------------------------------------------------
 public:
-	LLLFSThread(bool threaded = TRUE);
+	// With a queue_depth above 1, up to that many reads and writes are kept
+	// in flight at once by an LLFileIOEngine (io_uring if allowed and available)
+	LLLFSThread(bool threaded = TRUE, U32 queue_depth = 1, bool allow_io_uring = false);
 	~LLLFSThread();	
 
 	// Return a Request handle
@@ -127,15 +135,24 @@ public:
 	
 	// Misc
 	U32 priorityCounter() { return mPriorityCounter-- & PRIORITY_LOWBITS; } // Use to order IO operations
+
+	// With no time limit an unthreaded update waits on in-flight I/O
+	// instead of polling it in a loop
+	/*virtual*/ S32 update(F32 max_time_ms);
 	
 	// static initializers
-	static void initClass(bool local_is_threaded = TRUE); // Setup sLocal
+	static void initClass(bool local_is_threaded = TRUE, U32 queue_depth = 1, bool allow_io_uring = false); // Setup sLocal
 	static S32 updateClass(U32 ms_elapsed);
 	static void cleanupClass();		// Delete sLocal
 
+	// Time reading up to max_files files found under dirs at various queue depths
+	static void runBenchmark(const std::vector<std::string>& dirs, U32 max_files, bool allow_io_uring);
 	
 private:
 	U32 mPriorityCounter;
+	std::unique_ptr<LLFileIOEngine> mIOEngine;
+	LLAtomicU32 mUnsubmitted;	// requests that haven't been handed to mIOEngine yet
+	bool mDraining;				// unthreaded update() with no time limit in progress
 	
 public:
 	static LLLFSThread* sLocal;		// Default local file thread
@@ -0,0 +1,170 @@
+/**
+ * @file llfilehandlecache_test.cpp
+ * @brief LLFileHandleCache test cases.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "lltut.h"
+#include "../llfilehandlecache.h"
+
+#include "llfile.h"
+#include <boost/filesystem.hpp>
+
+namespace tut
+{
+    struct LLFileHandleCacheFixture
+    {
+        LLFileHandleCacheFixture()
+        {
+            mDir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+            boost::filesystem::create_directories(mDir);
+        }
+
+        ~LLFileHandleCacheFixture()
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove_all(mDir, ec);
+        }
+
+        LLFileHandleCache::path_func_t pathFunc()
+        {
+            boost::filesystem::path dir = mDir;
+            return [dir](const LLUUID& id)
+                {
+                    return (dir / (id.asString() + ".asset")).string();
+                };
+        }
+
+        boost::filesystem::path mDir;
+    };
+    typedef test_group<LLFileHandleCacheFixture> LLFileHandleCacheTest_factory;
+    typedef LLFileHandleCacheTest_factory::object LLFileHandleCacheTest_t;
+    LLFileHandleCacheTest_factory tf("LLFileHandleCache");
+
+    template<> template<>
+    void LLFileHandleCacheTest_t::test<1>()
+    {
+        set_test_name("missing files");
+        LLFileHandleCache cache(pathFunc());
+        LLUUID id;
+        id.generate();
+
+        U8 buffer[16];
+        ensure_equals("size of missing file", cache.getSize(id), -1);
+        ensure_equals("read of missing file", cache.read(id, 0, buffer, sizeof(buffer)), -1);
+        ensure("missing file created", !LLFile::isfile(cache.getFilepath(id)));
+    }
+
+    template<> template<>
+    void LLFileHandleCacheTest_t::test<2>()
+    {
+        set_test_name("write modes");
+        LLFileHandleCache cache(pathFunc());
+        LLUUID id;
+        id.generate();
+
+        const U8 first[] = "abcdef";
+        const U8 second[] = "XY";
+        ensure_equals("truncate end", cache.write(id, LLFileHandleCache::WRITE_TRUNCATE, 0, first, 6), 6);
+        ensure_equals("append end", cache.write(id, LLFileHandleCache::WRITE_APPEND, 0, second, 2), 8);
+        ensure_equals("offset end", cache.write(id, LLFileHandleCache::WRITE_AT_OFFSET, 1, second, 2), 3);
+        ensure_equals("size", cache.getSize(id), 8);
+
+        U8 buffer[16] = {};
+        ensure_equals("read all", cache.read(id, 0, buffer, sizeof(buffer)), 8);
+        ensure_memory_matches("contents", buffer, 8, "aXYdefXY", 8);
+        ensure_equals("read past end", cache.read(id, 8, buffer, sizeof(buffer)), 0);
+
+        ensure_equals("truncate again", cache.write(id, LLFileHandleCache::WRITE_TRUNCATE, 0, second, 2), 2);
+        ensure_equals("truncated size", cache.getSize(id), 2);
+        llstat file_status;
+        ensure_equals("stat", LLFile::stat(cache.getFilepath(id), &file_status), 0);
+        ensure_equals("size on disk", (S32) file_status.st_size, 2);
+    }
+
+    template<> template<>
+    void LLFileHandleCacheTest_t::test<3>()
+    {
+        set_test_name("handles are reused and limited");
+        LLFileHandleCache cache(pathFunc(), 2);
+        LLUUID ids[3];
+        const U8 data[] = "0123456789";
+        for (LLUUID& id : ids)
+        {
+            id.generate();
+            cache.write(id, LLFileHandleCache::WRITE_TRUNCATE, 0, data, 10);
+        }
+
+        LLFileHandleCache::Stats stats = cache.getStats();
+        ensure_equals("opens", stats.mOpens, (U64) 3);
+        ensure_equals("oldest closed", stats.mCloses, (U64) 1);
+
+        // many small reads of an open file only cost the reads
+        cache.resetStats();
+        U8 buffer[2];
+        for (S32 offset = 0; offset < 10; offset += 2)
+        {
+            ensure_equals("chunk", cache.read(ids[2], offset, buffer, 2), 2);
+            ensure_equals("chunk contents", buffer[0], data[offset]);
+        }
+        stats = cache.getStats();
+        ensure_equals("no opens", stats.mOpens, (U64) 0);
+        ensure_equals("no stats", stats.mStats, (U64) 0);
+        ensure_equals("reads", stats.mReads, (U64) 5);
+
+        // reopening the evicted file closes the least recently used one
+        ensure_equals("evicted file readable", cache.read(ids[0], 0, buffer, 2), 2);
+        stats = cache.getStats();
+        ensure_equals("reopened", stats.mOpens, (U64) 1);
+        ensure_equals("closed another", stats.mCloses, (U64) 1);
+    }
+
+    template<> template<>
+    void LLFileHandleCacheTest_t::test<4>()
+    {
+        set_test_name("invalidate");
+        LLFileHandleCache cache(pathFunc());
+        LLUUID id;
+        id.generate();
+        const U8 data[] = "0123456789";
+        cache.write(id, LLFileHandleCache::WRITE_TRUNCATE, 0, data, 10);
+
+        std::string path = cache.getFilepath(id);
+        cache.invalidatePath(path);
+        LLFile::remove(path);
+        ensure_equals("removed file", cache.getSize(id), -1);
+
+        // a file created behind the cache's back is picked up after invalidate()
+        LLFILE* file = LLFile::fopen(path, "wb");
+        ensure("created file", file != NULL);
+        fwrite(data, 1, 4, file);
+        fclose(file);
+        ensure_equals("stale size", cache.getSize(id), -1);
+        cache.invalidate(id);
+        ensure_equals("new size", cache.getSize(id), 4);
+
+        cache.invalidateAll();
+        ensure_equals("size after invalidateAll", cache.getSize(id), 4);
+    }
+}
@@ -0,0 +1,172 @@
+/**
+ * @file llfileioengine_test.cpp
+ * @brief LLFileIOEngine test cases.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "lltut.h"
+#include "../llfileioengine.h"
+
+#include <boost/filesystem.hpp>
+#include <memory>
+#include <vector>
+
+namespace tut
+{
+    struct LLFileIOEngineFixture
+    {
+        typedef std::unique_ptr<LLFileIOEngine::Op> op_ptr_t;
+
+        LLFileIOEngineFixture()
+        {
+            mDir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+            boost::filesystem::create_directories(mDir);
+        }
+
+        ~LLFileIOEngineFixture()
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove_all(mDir, ec);
+        }
+
+        std::string path(S32 i)
+        {
+            return (mDir / llformat("%d.dat", i)).string();
+        }
+
+        // Push every op through engine, more than its queue depth at a time
+        void runAll(LLFileIOEngine& engine, std::vector<op_ptr_t>& ops)
+        {
+            size_t next = 0;
+            while (true)
+            {
+                while (next < ops.size() && engine.submit(ops[next].get()))
+                {
+                    next++;
+                }
+                engine.poll(true);
+
+                bool done = next == ops.size();
+                for (const op_ptr_t& op : ops)
+                {
+                    done = done && op->isDone();
+                }
+                if (done)
+                {
+                    break;
+                }
+            }
+        }
+
+        void checkEngine(LLFileIOEngine& engine)
+        {
+            const S32 FILE_COUNT = 64;
+            const S32 FILE_SIZE = 4096;
+
+            std::vector<U8> data(FILE_COUNT * FILE_SIZE);
+            for (size_t i = 0; i < data.size(); ++i)
+            {
+                data[i] = (U8) (i * 7);
+            }
+
+            std::vector<op_ptr_t> writes;
+            for (S32 i = 0; i < FILE_COUNT; ++i)
+            {
+                writes.emplace_back(new LLFileIOEngine::Op(LLFileIOEngine::Op::WRITE, path(i), &data[i * FILE_SIZE], 0, FILE_SIZE));
+            }
+            runAll(engine, writes);
+            for (const op_ptr_t& op : writes)
+            {
+                ensure_equals("bytes written", op->getResult(), FILE_SIZE);
+            }
+            ensure_equals("nothing in flight", engine.getInFlight(), 0U);
+
+            LLFileIOEngine::Op append(LLFileIOEngine::Op::WRITE, path(0), &data[0], -1, 16);
+            ensure("append submitted", engine.submit(&append));
+            engine.waitFor(&append);
+            ensure_equals("bytes appended", append.getResult(), 16);
+            ensure_equals("size after append", (S32) boost::filesystem::file_size(path(0)), FILE_SIZE + 16);
+
+            std::vector<U8> buffer(FILE_COUNT * FILE_SIZE);
+            std::vector<op_ptr_t> reads;
+            for (S32 i = 1; i < FILE_COUNT; ++i)
+            {
+                reads.emplace_back(new LLFileIOEngine::Op(LLFileIOEngine::Op::READ, path(i), &buffer[i * FILE_SIZE], 1000, FILE_SIZE));
+            }
+            runAll(engine, reads);
+            for (S32 i = 1; i < FILE_COUNT; ++i)
+            {
+                ensure_equals("short read at end of file", reads[i - 1]->getResult(), FILE_SIZE - 1000);
+                ensure_memory_matches("read back", &buffer[i * FILE_SIZE], FILE_SIZE - 1000,
+                                      &data[i * FILE_SIZE + 1000], FILE_SIZE - 1000);
+            }
+
+            LLFileIOEngine::Op missing(LLFileIOEngine::Op::READ, path(FILE_COUNT), &buffer[0], 0, 16);
+            ensure("missing submitted", engine.submit(&missing));
+            engine.waitFor(&missing);
+            ensure_equals("missing file", missing.getResult(), 0);
+        }
+
+        boost::filesystem::path mDir;
+    };
+    typedef test_group<LLFileIOEngineFixture> LLFileIOEngineTest_factory;
+    typedef LLFileIOEngineTest_factory::object LLFileIOEngineTest_t;
+    LLFileIOEngineTest_factory tf("LLFileIOEngine");
+
+    template<> template<>
+    void LLFileIOEngineTest_t::test<1>()
+    {
+        set_test_name("worker threads");
+        std::unique_ptr<LLFileIOEngine> engine = LLFileIOEngine::create(8, false);
+        ensure_equals("engine", std::string(engine->getName()), std::string("threads"));
+        checkEngine(*engine);
+    }
+
+    template<> template<>
+    void LLFileIOEngineTest_t::test<2>()
+    {
+        set_test_name("io_uring if available");
+        std::unique_ptr<LLFileIOEngine> engine = LLFileIOEngine::create(8, true);
+        checkEngine(*engine);
+    }
+
+    template<> template<>
+    void LLFileIOEngineTest_t::test<3>()
+    {
+        set_test_name("queue depth");
+        std::unique_ptr<LLFileIOEngine> engine = LLFileIOEngine::create(2, false);
+        std::vector<U8> data(16);
+        LLFileIOEngine::Op a(LLFileIOEngine::Op::WRITE, path(0), &data[0], 0, 16);
+        LLFileIOEngine::Op b(LLFileIOEngine::Op::WRITE, path(1), &data[0], 0, 16);
+        LLFileIOEngine::Op c(LLFileIOEngine::Op::WRITE, path(2), &data[0], 0, 16);
+        ensure("first", engine->submit(&a));
+        ensure("second", engine->submit(&b));
+        ensure("full", !engine->submit(&c));
+        engine->waitFor(&a);
+        ensure("slot freed", engine->submit(&c));
+        engine->waitFor(&b);
+        engine->waitFor(&c);
+        ensure_equals("all written", a.getResult() + b.getResult() + c.getResult(), 48);
+    }
+}
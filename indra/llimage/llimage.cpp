@@ -39,6 +39,7 @@
 #include "llimagepng.h"
 #include "llimagedxt.h"
 #include "llmemory.h"
+#include "lltracememaccount.h"
 
 #include <boost/preprocessor.hpp>
 
@@ -622,6 +623,9 @@ void LLImage::setLastError(const std::string& message)
 // LLImageBase
 //---------------------------------------------------------------------------
 
+// Raw and compressed image data, whichever thread it was decoded on
+static LLTrace::MemAccount sImageMemAccount("LLImage");
+
 LLImageBase::LLImageBase()
 :	mData(NULL),
 	mDataSize(0),
@@ -630,12 +634,15 @@ LLImageBase::LLImageBase()
 	mComponents(0),
 	mBadBufferAllocation(false),
 	mAllowOverSize(false)
-{}
+{
+	sImageMemAccount.claim(0);
+}
 
 // virtual
 LLImageBase::~LLImageBase()
 {
 	deleteData(); // virtual
+	sImageMemAccount.disclaim(0);
 }
 
 // virtual
@@ -672,6 +679,7 @@ void LLImageBase::sanityCheck()
 void LLImageBase::deleteData()
 {
 	ll_aligned_free_16(mData);
+	sImageMemAccount.adjust(-S64(mDataSize));
 	mDataSize = 0;
 	mData = NULL;
 }
@@ -728,6 +736,7 @@ U8* LLImageBase::allocateData(S32 size)
 			mData = NULL;
 		}
 	}
+	sImageMemAccount.adjust(S64(size) - S64(mDataSize));
 	mDataSize = size;
 
 	return mData;
@@ -749,6 +758,7 @@ U8* LLImageBase::reallocateData(S32 size)
 		ll_aligned_free_16(mData) ;
 	}
 	mData = new_datap;
+	sImageMemAccount.adjust(S64(size) - S64(mDataSize));
 	mDataSize = size;
 	mBadBufferAllocation = false;
 	return mData;
@@ -2253,6 +2263,7 @@ void LLImageBase::setDataAndSize(U8 *data, S32 size)
 { 
 	ll_assert_aligned(data, 16);
 	mData = data; 
+	sImageMemAccount.adjust(S64(size) - S64(mDataSize));
 	mDataSize = size; 
 }	
 
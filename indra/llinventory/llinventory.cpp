@@ -36,6 +36,7 @@
 #include <boost/tokenizer.hpp>
 
 #include "llsdutil.h"
+#include "lltracememaccount.h"
 
 ///----------------------------------------------------------------------------
 /// Exported functions
@@ -66,6 +67,10 @@ static const std::string INV_FOLDER_ID_LABEL_WS("category_id");
 
 const LLUUID MAGIC_ID("3c115e51-04f4-523c-9fa6-98aff1034730");	
 
+// Items and categories, counted at their base class size: names and
+// descriptions, and anything a subclass adds, aren't included.
+static LLTrace::MemAccount sInventoryMemAccount("LLInventoryObject");
+
 ///----------------------------------------------------------------------------
 /// Class LLInventoryObject
 ///----------------------------------------------------------------------------
@@ -306,6 +311,7 @@ LLInventoryItem::LLInventoryItem(const LLUUID& uuid,
 	LLStringUtil::replaceChar(mDescription, '|', ' ');
 
 	mPermissions.initMasks(inv_type);
+	sInventoryMemAccount.claim(sizeof(LLInventoryItem));
 }
 
 LLInventoryItem::LLInventoryItem() :
@@ -318,16 +324,19 @@ LLInventoryItem::LLInventoryItem() :
 	mFlags(0)
 {
 	mCreationDate = 0;
+	sInventoryMemAccount.claim(sizeof(LLInventoryItem));
 }
 
 LLInventoryItem::LLInventoryItem(const LLInventoryItem* other) :
 	LLInventoryObject()
 {
 	copyItem(other);
+	sInventoryMemAccount.claim(sizeof(LLInventoryItem));
 }
 
 LLInventoryItem::~LLInventoryItem()
 {
+	sInventoryMemAccount.disclaim(sizeof(LLInventoryItem));
 }
 
 // virtual
@@ -1112,22 +1121,26 @@ LLInventoryCategory::LLInventoryCategory(const LLUUID& uuid,
 	LLInventoryObject(uuid, parent_uuid, LLAssetType::AT_CATEGORY, name),
 	mPreferredType(preferred_type)
 {
+	sInventoryMemAccount.claim(sizeof(LLInventoryCategory));
 }
 
 LLInventoryCategory::LLInventoryCategory() :
 	mPreferredType(LLFolderType::FT_NONE)
 {
 	mType = LLAssetType::AT_CATEGORY;
+	sInventoryMemAccount.claim(sizeof(LLInventoryCategory));
 }
 
 LLInventoryCategory::LLInventoryCategory(const LLInventoryCategory* other) :
 	LLInventoryObject()
 {
 	copyCategory(other);
+	sInventoryMemAccount.claim(sizeof(LLInventoryCategory));
 }
 
 LLInventoryCategory::~LLInventoryCategory()
 {
+	sInventoryMemAccount.disclaim(sizeof(LLInventoryCategory));
 }
 
 // virtual
@@ -51,6 +51,7 @@
 #include "llmatrix4a.h"
 #include "llmeshoptimizer.h"
 #include "lltimer.h"
+#include "lltracememaccount.h"
 
 #define DEBUG_SILHOUETTE_BINORMALS 0
 #define DEBUG_SILHOUETTE_NORMALS 0 // TomY: Use this to display normals using the silhouette
@@ -4686,6 +4687,10 @@ std::ostream& operator<<(std::ostream &s, const LLVolume *volumep)
 	return s;
 }
 
+// Vertex and index data of every volume face, whether built here from
+// prim parameters or decoded from a mesh asset on the mesh thread
+static LLTrace::MemAccount sVolumeFaceMemAccount("LLVolumeFace");
+
 LLVolumeFace::LLVolumeFace() : 
 	mID(0),
 	mTypeMask(0),
@@ -4709,8 +4714,10 @@ LLVolumeFace::LLVolumeFace() :
     mWeightsScrubbed(FALSE),
 	mOctree(NULL),
     mOctreeTriangles(NULL),
-	mOptimized(FALSE)
+	mOptimized(FALSE),
+	mAccountedBytes(0)
 {
+	sVolumeFaceMemAccount.claim(sizeof(LLVolumeFace) + sizeof(LLVector4a)*3);
 	mExtents = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a)*3);
 	mExtents[0].splat(-0.5f);
 	mExtents[1].splat(0.5f);
@@ -4739,8 +4746,10 @@ LLVolumeFace::LLVolumeFace(const LLVolumeFace& src)
 #endif
     mWeightsScrubbed(FALSE),
     mOctree(NULL),
-    mOctreeTriangles(NULL)
+    mOctreeTriangles(NULL),
+	mAccountedBytes(0)
 {
+	sVolumeFaceMemAccount.claim(sizeof(LLVolumeFace) + sizeof(LLVector4a)*3);
 	mExtents = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a)*3);
 	mCenter = mExtents+2;
 	*this = src;
@@ -4843,6 +4852,7 @@ LLVolumeFace& LLVolumeFace::operator=(const LLVolumeFace& src)
     }
 
 	mOptimized = src.mOptimized;
+	updateMemAccount();
 
 	//delete 
 	return *this;
@@ -4855,6 +4865,7 @@ LLVolumeFace::~LLVolumeFace()
 	mCenter = NULL;
 
 	freeData();
+	sVolumeFaceMemAccount.disclaim(sizeof(LLVolumeFace) + sizeof(LLVector4a)*3);
 }
 
 void LLVolumeFace::freeData()
@@ -4881,6 +4892,42 @@ void LLVolumeFace::freeData()
 #endif
 
     destroyOctree();
+    updateMemAccount();
+}
+
+// Bytes held by the buffers above, derived from the allocation sizes used
+// below. Called after anything that reallocates them.
+void LLVolumeFace::updateMemAccount()
+{
+	S64 bytes = 0;
+	if (mPositions)
+	{
+		bytes += S64(mNumAllocatedVertices)*sizeof(LLVector4a)*2 + (((mNumAllocatedVertices*sizeof(LLVector2)) + 0xF) & ~0xF);
+	}
+	if (mIndices)
+	{
+		bytes += ((mNumIndices*sizeof(U16)) + 0xF) & ~0xF;
+	}
+	if (mTangents)
+	{
+		bytes += S64(mNumVertices)*sizeof(LLVector4a);
+	}
+	if (mWeights)
+	{
+		bytes += S64(mNumVertices)*sizeof(LLVector4a);
+	}
+#if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
+	if (mJustWeights)
+	{
+		bytes += S64(mNumVertices)*sizeof(LLVector4a);
+	}
+	if (mJointIndices)
+	{
+		bytes += S64(mNumVertices)*sizeof(U8)*4;
+	}
+#endif
+	sVolumeFaceMemAccount.adjust(bytes - mAccountedBytes);
+	mAccountedBytes = bytes;
 }
 
 BOOL LLVolumeFace::create(LLVolume* volume, BOOL partial_build)
@@ -4996,6 +5043,7 @@ void LLVolumeFace::remap()
     mTexCoords = remap_tex_coords;
     mNumVertices = remap_vertices_count;
     mNumAllocatedVertices = remap_vertices_count;
+    updateMemAccount();
 }
 
 void LLVolumeFace::optimize(F32 angle_cutoff)
@@ -5590,6 +5638,8 @@ bool LLVolumeFace::cacheOptimize()
 	mTexCoords = tc;
 	mWeights = wght;    
 	mTangents = binorm;
+	mNumAllocatedVertices = num_verts;
+	updateMemAccount();
 
 	//std::string result = llformat("ACMR pre/post: %.3f/%.3f  --  %d triangles %d breaks", pre_acmr, post_acmr, mNumIndices/3, breaks);
 	//LL_INFOS() << result << LL_ENDL;
@@ -5696,7 +5746,10 @@ void LLVolumeFace::swapData(LLVolumeFace& rhs)
 	llswap(rhs.mTexCoords, mTexCoords);
 	llswap(rhs.mIndices,mIndices);
 	llswap(rhs.mNumVertices, mNumVertices);
+	llswap(rhs.mNumAllocatedVertices, mNumAllocatedVertices);
 	llswap(rhs.mNumIndices, mNumIndices);
+	updateMemAccount();
+	rhs.updateMemAccount();
 }
 
 void	LerpPlanarVertex(LLVolumeFace::VertexData& v0,
@@ -6474,6 +6527,7 @@ void LLVolumeFace::resizeVertices(S32 num_verts)
 
     // Force update
     mJointRiggingInfoTab.clear();
+    updateMemAccount();
 }
 
 void LLVolumeFace::pushVertex(const LLVolumeFace::VertexData& cv)
@@ -6521,7 +6575,7 @@ void LLVolumeFace::pushVertex(const LLVector4a& pos, const LLVector4a& norm, con
 		ll_aligned_free<64>(old_buf);
 
 		mNumAllocatedVertices = new_verts;
-
+		updateMemAccount();
 	}
 
 	mPositions[mNumVertices] = pos;
@@ -6535,13 +6589,14 @@ void LLVolumeFace::allocateTangents(S32 num_verts)
 {
 	ll_aligned_free_16(mTangents);
 	mTangents = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a)*num_verts);
+	updateMemAccount();
 }
 
 void LLVolumeFace::allocateWeights(S32 num_verts)
 {
 	ll_aligned_free_16(mWeights);
 	mWeights = (LLVector4a*)ll_aligned_malloc_16(sizeof(LLVector4a)*num_verts);
-    
+	updateMemAccount();
 }
 
 void LLVolumeFace::allocateJointIndices(S32 num_verts)
@@ -6552,6 +6607,7 @@ void LLVolumeFace::allocateJointIndices(S32 num_verts)
 
     mJointIndices = (U8*)ll_aligned_malloc_16(sizeof(U8) * 4 * num_verts);    
     mJustWeights = (LLVector4a*)ll_aligned_malloc_16(sizeof(LLVector4a) * num_verts);    
+    updateMemAccount();
 #endif
 }
 
@@ -6581,6 +6637,7 @@ void LLVolumeFace::resizeIndices(S32 num_indices)
         // Either num_indices is zero or allocation failure
         mNumIndices = 0;
     }
+    updateMemAccount();
 }
 
 void LLVolumeFace::pushIndex(const U16& idx)
@@ -6596,6 +6653,10 @@ void LLVolumeFace::pushIndex(const U16& idx)
 	}
 	
 	mIndices[mNumIndices++] = idx;
+	if (new_size != old_size)
+	{
+		updateMemAccount();
+	}
 }
 
 void LLVolumeFace::fillFromLegacyData(std::vector<LLVolumeFace::VertexData>& v, std::vector<U16>& idx)
@@ -868,6 +868,7 @@ public:
 	~LLVolumeFace();
 private:
 	void freeData();
+	void updateMemAccount();
 public:
 
 	BOOL create(LLVolume* volume, BOOL partial_build = FALSE);
@@ -988,6 +989,8 @@ public:
 private:
     LLOctreeNode<LLVolumeTriangle, LLVolumeTriangle*>* mOctree;
     LLVolumeTriangle* mOctreeTriangles;
+	// buffer bytes currently reported to the "LLVolumeFace" MemAccount
+	S64 mAccountedBytes;
 
 	BOOL createUnCutCubeCap(LLVolume* volume, BOOL partial_build = FALSE);
 	BOOL createCap(LLVolume* volume, BOOL partial_build = FALSE);
@@ -0,0 +1,104 @@
+/**
+ * @file llassetfetchqueue.cpp
+ * @brief Asset fetches waiting to start, ordered by priority
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llassetfetchqueue.h"
+
+LLAssetFetchQueue::LLAssetFetchQueue()
+    : mNextSequence(0)
+{
+}
+
+bool LLAssetFetchQueue::push(const LLUUID& id, LLAssetType::EType type, EPriority priority)
+{
+    asset_key_t key(id, type);
+    if (mIndex.find(key) != mIndex.end())
+    {
+        raisePriority(id, type, priority);
+        return false;
+    }
+
+    order_t order(-(S32)priority, mNextSequence++);
+    mQueue[order] = key;
+    mIndex[key] = order;
+    return true;
+}
+
+bool LLAssetFetchQueue::raisePriority(const LLUUID& id, LLAssetType::EType type, EPriority priority)
+{
+    std::map<asset_key_t, order_t>::iterator iter = mIndex.find(asset_key_t(id, type));
+    if (iter == mIndex.end() || iter->second.first <= -(S32)priority)
+    {
+        return false;
+    }
+
+    // Keep the sequence so the fetch is ordered among the other high
+    // priority ones by when it was first asked for
+    mQueue.erase(iter->second);
+    iter->second.first = -(S32)priority;
+    mQueue[iter->second] = iter->first;
+    return true;
+}
+
+bool LLAssetFetchQueue::pop(LLUUID& id, LLAssetType::EType& type)
+{
+    if (mQueue.empty())
+    {
+        return false;
+    }
+
+    std::map<order_t, asset_key_t>::iterator iter = mQueue.begin();
+    id = iter->second.first;
+    type = iter->second.second;
+    mIndex.erase(iter->second);
+    mQueue.erase(iter);
+    return true;
+}
+
+bool LLAssetFetchQueue::remove(const LLUUID& id, LLAssetType::EType type)
+{
+    std::map<asset_key_t, order_t>::iterator iter = mIndex.find(asset_key_t(id, type));
+    if (iter == mIndex.end())
+    {
+        return false;
+    }
+
+    mQueue.erase(iter->second);
+    mIndex.erase(iter);
+    return true;
+}
+
+bool LLAssetFetchQueue::contains(const LLUUID& id, LLAssetType::EType type) const
+{
+    return mIndex.find(asset_key_t(id, type)) != mIndex.end();
+}
+
+void LLAssetFetchQueue::clear()
+{
+    mQueue.clear();
+    mIndex.clear();
+}
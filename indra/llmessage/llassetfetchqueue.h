@@ -0,0 +1,81 @@
+/**
+ * @file llassetfetchqueue.h
+ * @brief Asset fetches waiting to start, ordered by priority
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLASSETFETCHQUEUE_H
+#define LL_LLASSETFETCHQUEUE_H
+
+#include "llassettype.h"
+#include "lluuid.h"
+
+#include <map>
+
+/**
+ * Fetches that can't start yet because the fetcher is busy.  Each asset is
+ * queued at most once; a fetch wanted by several callers is queued at the
+ * highest priority any of them asked for.  pop() hands out high priority
+ * fetches (things the user is looking at) before normal ones, and fetches
+ * of the same priority in the order they were first queued.
+ */
+class LLAssetFetchQueue
+{
+public:
+    enum EPriority
+    {
+        PRIORITY_NORMAL = 0,
+        PRIORITY_HIGH = 1
+    };
+
+    LLAssetFetchQueue();
+
+    // Queue a fetch of the asset.  If it's already queued it stays where it
+    // is, unless priority is higher, and false is returned.
+    bool push(const LLUUID& id, LLAssetType::EType type, EPriority priority);
+
+    // Move an already queued fetch up to priority.  Returns false if it
+    // isn't queued or is already at that priority or higher.
+    bool raisePriority(const LLUUID& id, LLAssetType::EType type, EPriority priority);
+
+    // Take the next fetch to start.  Returns false if the queue is empty.
+    bool pop(LLUUID& id, LLAssetType::EType& type);
+
+    bool remove(const LLUUID& id, LLAssetType::EType type);
+    bool contains(const LLUUID& id, LLAssetType::EType type) const;
+
+    bool empty() const { return mQueue.empty(); }
+    size_t size() const { return mQueue.size(); }
+    void clear();
+
+private:
+    typedef std::pair<LLUUID, LLAssetType::EType> asset_key_t;
+    // (priority, sequence) with higher priorities sorting first
+    typedef std::pair<S32, U64> order_t;
+
+    std::map<order_t, asset_key_t> mQueue;
+    std::map<asset_key_t, order_t> mIndex;
+    U64 mNextSequence;
+};
+
+#endif // LL_LLASSETFETCHQUEUE_H
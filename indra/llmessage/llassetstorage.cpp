@@ -408,7 +408,7 @@ void LLAssetStorage::_cleanupRequests(BOOL all, S32 error)
                                          << LLAssetType::lookup(tmp->getType()) << LL_ENDL;
                 
                 timed_out.push_front(tmp);
-                iter = requests->erase(curiter);
+                iter = (RT_DOWNLOAD == rt) ? removePendingDownload(curiter) : requests->erase(curiter);
             }
         }
     }
@@ -550,24 +550,22 @@ void LLAssetStorage::getAssetData(const LLUUID uuid,
         BOOL duplicate = FALSE;
         
         // check to see if there's a pending download of this uuid already
-        for (request_list_t::iterator iter = mPendingDownloads.begin();
-             iter != mPendingDownloads.end(); ++iter )
+        std::pair<download_index_t::iterator, download_index_t::iterator> range =
+            mPendingDownloadIndex.equal_range(asset_key_t(uuid, type));
+        for (download_index_t::iterator iter = range.first; iter != range.second; ++iter)
         {
-            LLAssetRequest  *tmp = *iter;
-            if ((type == tmp->getType()) && (uuid == tmp->getUUID()))
+            LLAssetRequest  *tmp = *iter->second;
+            if (callback == tmp->mDownCallback && user_data == tmp->mUserData)
             {
-                if (callback == tmp->mDownCallback && user_data == tmp->mUserData)
-                {
-                    // this is a duplicate from the same subsystem - throw it away
-                    LL_WARNS("AssetStorage") << "Discarding duplicate request for asset " << uuid
-                                             << "." << LLAssetType::lookup(type) << LL_ENDL;
-                    return;
-                }
-                
-                // this is a duplicate request
-                // queue the request, but don't actually ask for it again
-                duplicate = TRUE;
+                // this is a duplicate from the same subsystem - throw it away
+                LL_WARNS("AssetStorage") << "Discarding duplicate request for asset " << uuid
+                                         << "." << LLAssetType::lookup(type) << LL_ENDL;
+                return;
             }
+
+            // this is a duplicate request
+            // queue the request, but don't actually ask for it again
+            duplicate = TRUE;
         }
         if (duplicate)
         {
@@ -588,17 +586,15 @@ void LLAssetStorage::removeAndCallbackPendingDownloads(const LLUUID& file_id, LL
     // SJB: We process the callbacks in reverse order, I do not know if this is important,
     //      but I didn't want to mess with it.
     request_list_t requests;
-    for (request_list_t::iterator iter = gAssetStorage->mPendingDownloads.begin();
-         iter != gAssetStorage->mPendingDownloads.end();  )
+    download_index_t& index = gAssetStorage->mPendingDownloadIndex;
+    std::pair<download_index_t::iterator, download_index_t::iterator> range =
+        index.equal_range(asset_key_t(file_id, file_type));
+    for (download_index_t::iterator iter = range.first; iter != range.second; ++iter)
     {
-        request_list_t::iterator curiter = iter++;
-        LLAssetRequest* tmp = *curiter;
-        if ((tmp->getUUID() == file_id) && (tmp->getType()== file_type))
-        {
-            requests.push_front(tmp);
-            iter = gAssetStorage->mPendingDownloads.erase(curiter);
-        }
+        requests.push_front(*iter->second);
+        gAssetStorage->mPendingDownloads.erase(iter->second);
     }
+    index.erase(range.first, range.second);
     for (request_list_t::iterator iter = requests.begin();
          iter != requests.end();  )
     {
@@ -643,13 +639,7 @@ void LLAssetStorage::downloadCompleteCallback(
     LLUUID callback_id;
     LLAssetType::EType callback_type;
 
-    // Inefficient since we're doing a find through a list that may have thousands of elements.
-    // This is due for refactoring; we will probably change mPendingDownloads into a set.
-    request_list_t::iterator download_iter = std::find(gAssetStorage->mPendingDownloads.begin(), 
-                                                       gAssetStorage->mPendingDownloads.end(),
-                                                       req);
-
-    if (download_iter != gAssetStorage->mPendingDownloads.end())
+    if (gAssetStorage->isPendingDownload(req))
     {
         callback_id = file_id;
         callback_type = file_type;
@@ -674,17 +664,12 @@ void LLAssetStorage::downloadCompleteCallback(
         }
         else
         {
-#if 1
-            for (request_list_t::iterator iter = gAssetStorage->mPendingDownloads.begin();
-                 iter != gAssetStorage->mPendingDownloads.end(); ++iter  )
+            std::pair<download_index_t::iterator, download_index_t::iterator> range =
+                gAssetStorage->mPendingDownloadIndex.equal_range(asset_key_t(file_id, file_type));
+            for (download_index_t::iterator iter = range.first; iter != range.second; ++iter)
             {
-                LLAssetRequest* dlreq = *iter;
-                if ((dlreq->getUUID() == file_id) && (dlreq->getType()== file_type))
-                {
-                    dlreq->mBytesFetched = vfile.getSize();
-                }
+                (*iter->second)->mBytesFetched = vfile.getSize();
             }
-#endif
         }
     }
 
@@ -1070,6 +1055,66 @@ void LLAssetStorage::_callUploadCallbacks(const LLUUID &uuid, LLAssetType::EType
     }
 }
 
+void LLAssetStorage::addPendingDownload(LLAssetRequest* req)
+{
+    request_list_t::iterator iter = mPendingDownloads.insert(mPendingDownloads.end(), req);
+    mPendingDownloadIndex.insert(std::make_pair(asset_key_t(req->getUUID(), req->getType()), iter));
+}
+
+LLAssetStorage::request_list_t::iterator LLAssetStorage::removePendingDownload(LLAssetStorage::request_list_t::iterator iter)
+{
+    LLAssetRequest* req = *iter;
+    std::pair<download_index_t::iterator, download_index_t::iterator> range =
+        mPendingDownloadIndex.equal_range(asset_key_t(req->getUUID(), req->getType()));
+    for (download_index_t::iterator index_iter = range.first; index_iter != range.second; ++index_iter)
+    {
+        if (index_iter->second == iter)
+        {
+            mPendingDownloadIndex.erase(index_iter);
+            break;
+        }
+    }
+    return mPendingDownloads.erase(iter);
+}
+
+bool LLAssetStorage::removePendingDownload(LLAssetRequest* req)
+{
+    std::pair<download_index_t::iterator, download_index_t::iterator> range =
+        mPendingDownloadIndex.equal_range(asset_key_t(req->getUUID(), req->getType()));
+    for (download_index_t::iterator index_iter = range.first; index_iter != range.second; ++index_iter)
+    {
+        if (*index_iter->second == req)
+        {
+            mPendingDownloads.erase(index_iter->second);
+            mPendingDownloadIndex.erase(index_iter);
+            return true;
+        }
+    }
+    return false;
+}
+
+LLAssetRequest* LLAssetStorage::findPendingDownload(const LLUUID& uuid, LLAssetType::EType type) const
+{
+    // lower_bound rather than find, which may return any of several equal keys
+    asset_key_t key(uuid, type);
+    download_index_t::const_iterator iter = mPendingDownloadIndex.lower_bound(key);
+    return (iter != mPendingDownloadIndex.end() && iter->first == key) ? *iter->second : NULL;
+}
+
+bool LLAssetStorage::isPendingDownload(const LLAssetRequest* req) const
+{
+    std::pair<download_index_t::const_iterator, download_index_t::const_iterator> range =
+        mPendingDownloadIndex.equal_range(asset_key_t(req->getUUID(), req->getType()));
+    for (download_index_t::const_iterator iter = range.first; iter != range.second; ++iter)
+    {
+        if (*iter->second == req)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 LLAssetStorage::request_list_t* LLAssetStorage::getRequestList(LLAssetStorage::ERequestType rt)
 {
     switch (rt)
@@ -1276,7 +1321,14 @@ bool LLAssetStorage::deletePendingRequestImpl(LLAssetStorage::request_list_t* re
     if (req)
     {
         // Remove the request from this list.
-        requests->remove(req);
+        if (requests == &mPendingDownloads)
+        {
+            removePendingDownload(req);
+        }
+        else
+        {
+            requests->remove(req);
+        }
         S32 error = LL_ERR_TCP_TIMEOUT;
         // Run callbacks.
         if (req->mUpCallback)
@@ -1351,16 +1403,15 @@ void LLAssetStorage::getAssetData(const LLUUID uuid,
                                   BOOL is_priority)
 {
     // check for duplicates here, since we're about to fool the normal duplicate checker
-    for (request_list_t::iterator iter = mPendingDownloads.begin();
-         iter != mPendingDownloads.end();  )
+    std::pair<download_index_t::iterator, download_index_t::iterator> range =
+        mPendingDownloadIndex.equal_range(asset_key_t(uuid, type));
+    for (download_index_t::iterator iter = range.first; iter != range.second; ++iter)
     {
-        LLAssetRequest* tmp = *iter++;
+        LLAssetRequest* tmp = *iter->second;
 
         auto cbptr = tmp->mDownCallback.target<void(*)(const LLUUID &, LLAssetType::EType, void *, S32, LLExtStat)>();
 
-        if (type == tmp->getType() && 
-            uuid == tmp->getUUID() &&
-            (cbptr && (*cbptr == legacyGetDataCallback)) &&
+        if ((cbptr && (*cbptr == legacyGetDataCallback)) &&
             callback == ((LLLegacyAssetRequest *)tmp->mUserData)->mDownCallback &&
             user_data == ((LLLegacyAssetRequest *)tmp->mUserData)->mUserData)
         {
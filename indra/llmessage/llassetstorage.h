@@ -220,6 +220,12 @@ protected:
 	request_list_t mPendingDownloads;
 	request_list_t mPendingUploads;
 	request_list_t mPendingLocalUploads;
+
+	// mPendingDownloads by asset, in the order they were added, so requests
+	// for an asset already being fetched are found without scanning the list
+	typedef std::pair<LLUUID, LLAssetType::EType> asset_key_t;
+	typedef std::multimap<asset_key_t, request_list_t::iterator> download_index_t;
+	download_index_t mPendingDownloadIndex;
 	
 	// Map of toxic assets - these caused problems when recently rezzed, so avoid them
 	toxic_asset_map_t	mToxicAssetMap;		// Objects in this list are known to cause problems and are not loaded
@@ -277,6 +283,14 @@ public:
 	void		markAssetToxic( const LLUUID& uuid );
 
 protected:
+	// All changes to mPendingDownloads go through these to keep mPendingDownloadIndex in step
+	void addPendingDownload(LLAssetRequest* req);
+	request_list_t::iterator removePendingDownload(request_list_t::iterator iter);
+	bool removePendingDownload(LLAssetRequest* req);
+	// Oldest pending download of the asset, or NULL
+	LLAssetRequest* findPendingDownload(const LLUUID& uuid, LLAssetType::EType type) const;
+	bool isPendingDownload(const LLAssetRequest* req) const;
+
 	bool findInCacheAndInvokeCallback(const LLUUID& uuid, LLAssetType::EType type,
 										  LLGetAssetCallback callback, void *user_data);
 
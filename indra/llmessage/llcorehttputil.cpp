@@ -35,8 +35,6 @@
 #include "llsd.h"
 #include "llsdjson.h"
 #include "llsdserialize.h"
-#include "reader.h" // JSON
-#include "writer.h" // JSON
 #include "llfilesystem.h"
 
 #include "message.h" // for getting the port
@@ -63,6 +61,23 @@ namespace
         return mBoolSettingGet(HTTP_LOGBODY_KEY);
     }
 
+    // Parse a JSON response body straight into LLSD. On failure, returns
+    // false with the parser's description of the problem in error.
+    bool parseJsonBody(BufferArray * body, LLSD & result, std::string & error)
+    {
+        // the body may be split across several blocks: make it contiguous
+        std::string text(body->size(), '\0');
+        text.resize(body->read(0, &text[0], text.size()));
+        return LlsdFromJsonString(text, result, &error);
+    }
+
+    void writeJsonBody(BufferArray * rawbody, const LLSD & body, const char * tag)
+    {
+        std::string text(LlsdToJsonString(body));
+        LL_DEBUGS(tag) << "JSON Generates: \"" << text << "\"" << LL_ENDL;
+        rawbody->append(text.data(), text.size());
+    }
+
 }
 
 void setPropertyMethods(BoolSettingQuery_t queryfn, BoolSettingUpdate_t updatefn)
@@ -256,8 +271,8 @@ std::string responseToString(LLCore::HttpResponse * response)
 
 //========================================================================
 
-HttpCoroHandler::HttpCoroHandler(LLEventStream &reply) :
-    mReplyPump(reply)
+HttpCoroHandler::HttpCoroHandler(LLEventChannel<LLSD> &reply) :
+    mReplyChannel(reply)
 {
 }
 
@@ -325,7 +340,7 @@ void HttpCoroHandler::onCompleted(LLCore::HttpHandle handle, LLCore::HttpRespons
         }
     }
 
-    mReplyPump.post(result);
+    mReplyChannel.post(result);
 }
 
 void HttpCoroHandler::buildStatusEntry(LLCore::HttpResponse *response, LLCore::HttpStatus status, LLSD &result)
@@ -385,7 +400,7 @@ void HttpCoroHandler::writeStatusCodes(LLCore::HttpStatus status, const std::str
 class HttpCoroLLSDHandler : public HttpCoroHandler
 {
 public:
-    HttpCoroLLSDHandler(LLEventStream &reply);
+    HttpCoroLLSDHandler(LLEventChannel<LLSD> &reply);
 
 protected:
     virtual LLSD handleSuccess(LLCore::HttpResponse * response, LLCore::HttpStatus &status);
@@ -393,7 +408,7 @@ protected:
 };
 
 //-------------------------------------------------------------------------
-HttpCoroLLSDHandler::HttpCoroLLSDHandler(LLEventStream &reply):
+HttpCoroLLSDHandler::HttpCoroLLSDHandler(LLEventChannel<LLSD> &reply):
     HttpCoroHandler(reply)
 {
 }
@@ -493,14 +508,14 @@ LLSD HttpCoroLLSDHandler::parseBody(LLCore::HttpResponse *response, bool &succes
 class HttpCoroRawHandler : public HttpCoroHandler
 {
 public:
-    HttpCoroRawHandler(LLEventStream &reply);
+    HttpCoroRawHandler(LLEventChannel<LLSD> &reply);
 
     virtual LLSD handleSuccess(LLCore::HttpResponse * response, LLCore::HttpStatus &status);
     virtual LLSD parseBody(LLCore::HttpResponse *response, bool &success);
 };
 
 //-------------------------------------------------------------------------
-HttpCoroRawHandler::HttpCoroRawHandler(LLEventStream &reply):
+HttpCoroRawHandler::HttpCoroRawHandler(LLEventChannel<LLSD> &reply):
     HttpCoroHandler(reply)
 {
 }
@@ -568,14 +583,14 @@ LLSD HttpCoroRawHandler::parseBody(LLCore::HttpResponse *response, bool &success
 class HttpCoroJSONHandler : public HttpCoroHandler
 {
 public:
-    HttpCoroJSONHandler(LLEventStream &reply);
+    HttpCoroJSONHandler(LLEventChannel<LLSD> &reply);
 
     virtual LLSD handleSuccess(LLCore::HttpResponse * response, LLCore::HttpStatus &status);
     virtual LLSD parseBody(LLCore::HttpResponse *response, bool &success);
 };
 
 //-------------------------------------------------------------------------
-HttpCoroJSONHandler::HttpCoroJSONHandler(LLEventStream &reply) :
+HttpCoroJSONHandler::HttpCoroJSONHandler(LLEventChannel<LLSD> &reply) :
     HttpCoroHandler(reply)
 {
 }
@@ -590,23 +605,16 @@ LLSD HttpCoroJSONHandler::handleSuccess(LLCore::HttpResponse * response, LLCore:
         return result;
     }
 
-    LLCore::BufferArrayStream bas(body);
-    Json::Value jsonRoot;
-
-    try
-    {
-        bas >> jsonRoot;
-    }
-    catch (std::runtime_error& e)
+    // Parse the JSON directly into LLSD
+    LLSD parsed;
+    std::string error;
+    if (!parseJsonBody(body, parsed, error))
     {   // deserialization failed.  Record the reason and pass back an empty map for markup.
-        status = LLCore::HttpStatus(499, std::string(e.what()));
+        status = LLCore::HttpStatus(499, error);
         return result;
     }
 
-    // Convert the JSON structure to LLSD
-    result = LlsdFromJson(jsonRoot);
-
-    return result;
+    return parsed;
 }
 
 LLSD HttpCoroJSONHandler::parseBody(LLCore::HttpResponse *response, bool &success)
@@ -618,21 +626,11 @@ LLSD HttpCoroJSONHandler::parseBody(LLCore::HttpResponse *response, bool &succes
         return LLSD();
     }
 
-    LLCore::BufferArrayStream bas(body);
-    Json::Value jsonRoot;
-
-    try
-    {
-        bas >> jsonRoot;
-    }
-    catch (std::runtime_error&)
-    {   
-        success = false;
-        return LLSD();
-    }
-
-    // Convert the JSON structure to LLSD
-    return LlsdFromJson(jsonRoot);
+    // Parse the JSON directly into LLSD
+    LLSD result;
+    std::string error;
+    success = parseJsonBody(body, result, error);
+    return result;
 }
 
 //========================================================================
@@ -691,8 +689,8 @@ LLSD HttpCoroutineAdapter::postAndSuspend(LLCore::HttpRequest::ptr_t request,
     const std::string & url, const LLSD & body,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
-    LLEventStream  replyPump(mAdapterName, true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyPump));
+    LLEventChannel<LLSD> replyChannel;
+    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyChannel));
 
     return postAndSuspend_(request, url, body, options, headers, httpHandler);
 }
@@ -718,7 +716,7 @@ LLSD HttpCoroutineAdapter::postAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     }
 
     saveState(hhandle, request, handler);
-    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
+    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyChannel());
     cleanState();
 
     return results;
@@ -728,8 +726,8 @@ LLSD HttpCoroutineAdapter::postAndSuspend(LLCore::HttpRequest::ptr_t request,
     const std::string & url, LLCore::BufferArray::ptr_t rawbody,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
-    LLEventStream  replyPump(mAdapterName, true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyPump));
+    LLEventChannel<LLSD> replyChannel;
+    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyChannel));
 
     return postAndSuspend_(request, url, rawbody, options, headers, httpHandler);
 }
@@ -738,8 +736,8 @@ LLSD HttpCoroutineAdapter::postRawAndSuspend(LLCore::HttpRequest::ptr_t request,
     const std::string & url, LLCore::BufferArray::ptr_t rawbody,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
-    LLEventStream  replyPump(mAdapterName, true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroRawHandler(replyPump));
+    LLEventChannel<LLSD> replyChannel;
+    HttpCoroHandler::ptr_t httpHandler(new HttpCoroRawHandler(replyChannel));
 
     return postAndSuspend_(request, url, rawbody, options, headers, httpHandler);
 }
@@ -802,20 +800,12 @@ LLSD HttpCoroutineAdapter::postJsonAndSuspend(LLCore::HttpRequest::ptr_t request
     const std::string & url, const LLSD & body,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
-    LLEventStream  replyPump(mAdapterName, true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroJSONHandler(replyPump));
+    LLEventChannel<LLSD> replyChannel;
+    HttpCoroHandler::ptr_t httpHandler(new HttpCoroJSONHandler(replyChannel));
 
     LLCore::BufferArray::ptr_t rawbody(new LLCore::BufferArray);
 
-    {
-        LLCore::BufferArrayStream outs(rawbody.get());
-        Json::Value root = LlsdToJson(body);
-        Json::FastWriter writer;
-
-        LL_WARNS("Http::post") << "JSON Generates: \"" << writer.write(root) << "\"" << LL_ENDL;
-
-        outs << writer.write(root);
-    }
+    writeJsonBody(rawbody.get(), body, "Http::post");
 
     return postAndSuspend_(request, url, rawbody, options, headers, httpHandler);
 }
@@ -841,7 +831,7 @@ LLSD HttpCoroutineAdapter::postAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     }
 
     saveState(hhandle, request, handler);
-    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
+    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyChannel());
     cleanState();
 
     return results;
@@ -851,8 +841,8 @@ LLSD HttpCoroutineAdapter::putAndSuspend(LLCore::HttpRequest::ptr_t request,
     const std::string & url, const LLSD & body,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
-    LLEventStream  replyPump(mAdapterName + "Reply", true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyPump));
+    LLEventChannel<LLSD> replyChannel;
+    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyChannel));
 
     return putAndSuspend_(request, url, body, options, headers, httpHandler);
 }
@@ -861,19 +851,12 @@ LLSD HttpCoroutineAdapter::putJsonAndSuspend(LLCore::HttpRequest::ptr_t request,
     const std::string & url, const LLSD & body,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
-    LLEventStream  replyPump(mAdapterName, true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroJSONHandler(replyPump));
+    LLEventChannel<LLSD> replyChannel;
+    HttpCoroHandler::ptr_t httpHandler(new HttpCoroJSONHandler(replyChannel));
 
     LLCore::BufferArray::ptr_t rawbody(new LLCore::BufferArray);
 
-    {
-        LLCore::BufferArrayStream outs(rawbody.get());
-        Json::Value root = LlsdToJson(body);
-        Json::FastWriter writer;
-
-        LL_WARNS("Http::put") << "JSON Generates: \"" << writer.write(root) << "\"" << LL_ENDL;
-        outs << writer.write(root);
-    }
+    writeJsonBody(rawbody.get(), body, "Http::put");
 
     return putAndSuspend_(request, url, rawbody, options, headers, httpHandler);
 }
@@ -899,7 +882,7 @@ LLSD HttpCoroutineAdapter::putAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     }
 
     saveState(hhandle, request, handler);
-    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
+    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyChannel());
     cleanState();
 
     return results;
@@ -925,7 +908,7 @@ LLSD HttpCoroutineAdapter::putAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     }
 
     saveState(hhandle, request, handler);
-    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
+    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyChannel());
     cleanState();
 
     return results;
@@ -936,8 +919,8 @@ LLSD HttpCoroutineAdapter::getAndSuspend(LLCore::HttpRequest::ptr_t request,
     const std::string & url,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
-    LLEventStream  replyPump(mAdapterName + "Reply", true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyPump));
+    LLEventChannel<LLSD> replyChannel;
+    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyChannel));
 
     return getAndSuspend_(request, url, options, headers, httpHandler);
 }
@@ -946,8 +929,8 @@ LLSD HttpCoroutineAdapter::getRawAndSuspend(LLCore::HttpRequest::ptr_t request,
     const std::string & url,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
-    LLEventStream  replyPump(mAdapterName + "Reply", true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroRawHandler(replyPump));
+    LLEventChannel<LLSD> replyChannel;
+    HttpCoroHandler::ptr_t httpHandler(new HttpCoroRawHandler(replyChannel));
 
     return getAndSuspend_(request, url, options, headers, httpHandler);
 }
@@ -955,8 +938,8 @@ LLSD HttpCoroutineAdapter::getRawAndSuspend(LLCore::HttpRequest::ptr_t request,
 LLSD HttpCoroutineAdapter::getJsonAndSuspend(LLCore::HttpRequest::ptr_t request,
     const std::string & url, LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
-    LLEventStream  replyPump(mAdapterName + "Reply", true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroJSONHandler(replyPump));
+    LLEventChannel<LLSD> replyChannel;
+    HttpCoroHandler::ptr_t httpHandler(new HttpCoroJSONHandler(replyChannel));
 
     return getAndSuspend_(request, url, options, headers, httpHandler);
 }
@@ -981,7 +964,7 @@ LLSD HttpCoroutineAdapter::getAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     }
 
     saveState(hhandle, request, handler);
-    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
+    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyChannel());
     cleanState();
 
     return results;
@@ -992,8 +975,8 @@ LLSD HttpCoroutineAdapter::deleteAndSuspend(LLCore::HttpRequest::ptr_t request,
     const std::string & url,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
-    LLEventStream  replyPump(mAdapterName + "Reply", true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyPump));
+    LLEventChannel<LLSD> replyChannel;
+    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyChannel));
 
     return deleteAndSuspend_(request, url, options, headers, httpHandler);
 }
@@ -1002,8 +985,8 @@ LLSD HttpCoroutineAdapter::deleteJsonAndSuspend(LLCore::HttpRequest::ptr_t reque
     const std::string & url, 
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
-    LLEventStream  replyPump(mAdapterName + "Reply", true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroJSONHandler(replyPump));
+    LLEventChannel<LLSD> replyChannel;
+    HttpCoroHandler::ptr_t httpHandler(new HttpCoroJSONHandler(replyChannel));
 
     return deleteAndSuspend_(request, url, options, headers, httpHandler);
 }
@@ -1027,7 +1010,7 @@ LLSD HttpCoroutineAdapter::deleteAndSuspend_(LLCore::HttpRequest::ptr_t &request
     }
 
     saveState(hhandle, request, handler);
-    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
+    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyChannel());
     cleanState();
 
     return results;
@@ -1037,8 +1020,8 @@ LLSD HttpCoroutineAdapter::patchAndSuspend(LLCore::HttpRequest::ptr_t request,
     const std::string & url, const LLSD & body,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
-    LLEventStream  replyPump(mAdapterName + "Reply", true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyPump));
+    LLEventChannel<LLSD> replyChannel;
+    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyChannel));
 
     return patchAndSuspend_(request, url, body, options, headers, httpHandler);
 }
@@ -1065,7 +1048,7 @@ LLSD HttpCoroutineAdapter::patchAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     }
 
     saveState(hhandle, request, handler);
-    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
+    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyChannel());
     cleanState();
 
     return results;
@@ -1075,8 +1058,8 @@ LLSD HttpCoroutineAdapter::copyAndSuspend(LLCore::HttpRequest::ptr_t request,
     const std::string & url, const std::string dest,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
-    LLEventStream  replyPump(mAdapterName + "Reply", true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyPump));
+    LLEventChannel<LLSD> replyChannel;
+    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyChannel));
 
     if (!headers)
         headers.reset(new LLCore::HttpHeaders);
@@ -1107,7 +1090,7 @@ LLSD HttpCoroutineAdapter::copyAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     }
 
     saveState(hhandle, request, handler);
-    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
+    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyChannel());
     cleanState();
 
     return results;
@@ -1117,8 +1100,8 @@ LLSD HttpCoroutineAdapter::moveAndSuspend(LLCore::HttpRequest::ptr_t request,
     const std::string & url, const std::string dest,
     LLCore::HttpOptions::ptr_t options, LLCore::HttpHeaders::ptr_t headers)
 {
-    LLEventStream  replyPump(mAdapterName + "Reply", true);
-    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyPump));
+    LLEventChannel<LLSD> replyChannel;
+    HttpCoroHandler::ptr_t httpHandler(new HttpCoroLLSDHandler(replyChannel));
 
     if (!headers)
         headers.reset(new LLCore::HttpHeaders);
@@ -1149,7 +1132,7 @@ LLSD HttpCoroutineAdapter::moveAndSuspend_(LLCore::HttpRequest::ptr_t &request,
     }
 
     saveState(hhandle, request, handler);
-    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyPump());
+    LLSD results = llcoro::suspendUntilEventOn(handler->getReplyChannel());
     cleanState();
 
     return results;
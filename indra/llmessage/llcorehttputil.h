@@ -43,6 +43,7 @@
 #include "llevents.h"
 #include "llcoros.h"
 #include "lleventcoro.h"
+#include "lleventchannel.h"
 #include "llassettype.h"
 #include "lluuid.h"
 
@@ -258,7 +259,7 @@ inline LLCore::HttpHandle requestPatchWithLLSD(LLCore::HttpRequest::ptr_t & requ
 //=========================================================================
 /// The HttpCoroHandler is a specialization of the LLCore::HttpHandler for 
 /// interacting with coroutines. When the request is completed the response 
-/// will be posted onto the supplied Event Pump.
+/// will be posted onto the supplied event channel.
 /// 
 /// The LLSD posted back to the coroutine will have the following additions:
 /// llsd["http_result"] -+- ["message"] - An error message returned from the HTTP status
@@ -275,15 +276,15 @@ public:
     typedef boost::shared_ptr<HttpCoroHandler>  ptr_t;
     typedef boost::weak_ptr<HttpCoroHandler>    wptr_t;
 
-    HttpCoroHandler(LLEventStream &reply);
+    HttpCoroHandler(LLEventChannel<LLSD> &reply);
 
     static void writeStatusCodes(LLCore::HttpStatus status, const std::string &url, LLSD &result);
 
     virtual void onCompleted(LLCore::HttpHandle handle, LLCore::HttpResponse * response);
 
-    inline LLEventStream &getReplyPump()
+    inline LLEventChannel<LLSD> &getReplyChannel()
     {
-        return mReplyPump;
+        return mReplyChannel;
     }
 
 protected:
@@ -294,7 +295,7 @@ protected:
 private:
     void buildStatusEntry(LLCore::HttpResponse *response, LLCore::HttpStatus status, LLSD &result);
 
-    LLEventStream &mReplyPump;
+    LLEventChannel<LLSD> &mReplyChannel;
 };
 
 //=========================================================================
@@ -0,0 +1,210 @@
+/**
+ * @file llassetfetchqueue_test.cpp
+ * @brief LLAssetFetchQueue test cases.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "lltut.h"
+#include "../llassetfetchqueue.h"
+
+#include <map>
+#include <vector>
+
+namespace tut
+{
+    struct LLAssetFetchQueueFixture
+    {
+        LLAssetFetchQueueFixture()
+        {
+            for (S32 i = 0; i < 8; ++i)
+            {
+                mIDs[i].generate();
+            }
+        }
+
+        LLUUID mIDs[8];
+    };
+    typedef test_group<LLAssetFetchQueueFixture> LLAssetFetchQueueTest_factory;
+    typedef LLAssetFetchQueueTest_factory::object LLAssetFetchQueueTest_t;
+    LLAssetFetchQueueTest_factory tf("LLAssetFetchQueue");
+
+    template<> template<>
+    void LLAssetFetchQueueTest_t::test<1>()
+    {
+        set_test_name("order");
+        LLAssetFetchQueue queue;
+        ensure("normal", queue.push(mIDs[0], LLAssetType::AT_SOUND, LLAssetFetchQueue::PRIORITY_NORMAL));
+        ensure("high", queue.push(mIDs[1], LLAssetType::AT_SOUND, LLAssetFetchQueue::PRIORITY_HIGH));
+        ensure("second normal", queue.push(mIDs[2], LLAssetType::AT_SOUND, LLAssetFetchQueue::PRIORITY_NORMAL));
+        ensure("second high", queue.push(mIDs[3], LLAssetType::AT_SOUND, LLAssetFetchQueue::PRIORITY_HIGH));
+        ensure("other type", queue.push(mIDs[0], LLAssetType::AT_ANIMATION, LLAssetFetchQueue::PRIORITY_NORMAL));
+        ensure_equals("size", queue.size(), (size_t) 5);
+
+        const S32 expected[] = { 1, 3, 0, 2, 0 };
+        for (S32 i = 0; i < 5; ++i)
+        {
+            LLUUID id;
+            LLAssetType::EType type;
+            ensure("pop", queue.pop(id, type));
+            ensure_equals("popped", id, mIDs[expected[i]]);
+        }
+        LLUUID id;
+        LLAssetType::EType type;
+        ensure("empty", !queue.pop(id, type));
+    }
+
+    template<> template<>
+    void LLAssetFetchQueueTest_t::test<2>()
+    {
+        set_test_name("coalescing and priority changes");
+        LLAssetFetchQueue queue;
+        queue.push(mIDs[0], LLAssetType::AT_NOTECARD, LLAssetFetchQueue::PRIORITY_NORMAL);
+        queue.push(mIDs[1], LLAssetType::AT_NOTECARD, LLAssetFetchQueue::PRIORITY_NORMAL);
+        queue.push(mIDs[2], LLAssetType::AT_NOTECARD, LLAssetFetchQueue::PRIORITY_HIGH);
+
+        ensure("duplicate", !queue.push(mIDs[0], LLAssetType::AT_NOTECARD, LLAssetFetchQueue::PRIORITY_NORMAL));
+        ensure_equals("no new entry", queue.size(), (size_t) 3);
+        ensure("not lowered", !queue.raisePriority(mIDs[2], LLAssetType::AT_NOTECARD, LLAssetFetchQueue::PRIORITY_NORMAL));
+        ensure("not queued", !queue.raisePriority(mIDs[3], LLAssetType::AT_NOTECARD, LLAssetFetchQueue::PRIORITY_HIGH));
+
+        // a high priority duplicate moves the queued fetch up, keeping its
+        // place relative to high priority fetches asked for later
+        ensure("raised by duplicate", !queue.push(mIDs[1], LLAssetType::AT_NOTECARD, LLAssetFetchQueue::PRIORITY_HIGH));
+        LLUUID id;
+        LLAssetType::EType type;
+        queue.pop(id, type);
+        ensure_equals("raised first", id, mIDs[1]);
+        queue.pop(id, type);
+        ensure_equals("later high second", id, mIDs[2]);
+
+        ensure("remove", queue.remove(mIDs[0], LLAssetType::AT_NOTECARD));
+        ensure("removed", !queue.contains(mIDs[0], LLAssetType::AT_NOTECARD));
+        ensure("empty", queue.empty());
+    }
+
+    template<> template<>
+    void LLAssetFetchQueueTest_t::test<3>()
+    {
+        set_test_name("stress against a simulated asset server");
+
+        // Stands in for the asset HTTP service: a few connections, each
+        // fetch taking a while, with many callers asking for a small set of
+        // assets.  Callers wanting an asset that is already queued or being
+        // fetched attach to that fetch, the way LLAssetStorage does.
+        const S32 CONNECTIONS = 4;
+        const S32 ASSETS = 200;
+        const S32 REQUESTS = 5000;
+
+        std::vector<LLUUID> assets(ASSETS);
+        for (LLUUID& id : assets)
+        {
+            id.generate();
+        }
+
+        struct Fetch
+        {
+            LLUUID mID;
+            S32 mDoneTick;
+        };
+
+        LLAssetFetchQueue queue;
+        std::vector<Fetch> active;
+        // asset -> (tick asked, interactive) for each caller waiting on it
+        std::map<LLUUID, std::vector<std::pair<S32, bool> > > waiting;
+        U64 fetches = 0;
+        U64 callbacks = 0;
+        U64 high_wait = 0, high_count = 0;
+        U64 normal_wait = 0, normal_count = 0;
+        U32 seed = 1;
+        auto next_random = [&seed]() { seed = seed * 1103515245 + 12345; return (seed >> 16) & 0x7fff; };
+
+        S32 issued = 0;
+        for (S32 tick = 0; issued < REQUESTS || !waiting.empty(); ++tick)
+        {
+            // finish fetches, calling back everyone waiting on them
+            for (size_t i = 0; i < active.size(); )
+            {
+                if (active[i].mDoneTick > tick)
+                {
+                    ++i;
+                    continue;
+                }
+                const LLUUID id = active[i].mID;
+                for (const std::pair<S32, bool>& caller : waiting[id])
+                {
+                    ++callbacks;
+                    if (caller.second)
+                    {
+                        high_wait += tick - caller.first;
+                        ++high_count;
+                    }
+                    else
+                    {
+                        normal_wait += tick - caller.first;
+                        ++normal_count;
+                    }
+                }
+                waiting.erase(id);
+                active.erase(active.begin() + i);
+            }
+
+            // new requests, one in ten of them interactive
+            for (S32 i = 0; i < 3 && issued < REQUESTS; ++i, ++issued)
+            {
+                const LLUUID& id = assets[next_random() % ASSETS];
+                bool high = (next_random() % 10) == 0;
+                bool duplicate = waiting.find(id) != waiting.end();
+                waiting[id].push_back(std::make_pair(tick, high));
+                if (!duplicate)
+                {
+                    queue.push(id, LLAssetType::AT_SOUND,
+                               high ? LLAssetFetchQueue::PRIORITY_HIGH : LLAssetFetchQueue::PRIORITY_NORMAL);
+                }
+                else if (high)
+                {
+                    queue.raisePriority(id, LLAssetType::AT_SOUND, LLAssetFetchQueue::PRIORITY_HIGH);
+                }
+            }
+
+            // start fetches on free connections
+            LLUUID id;
+            LLAssetType::EType type;
+            while ((S32)active.size() < CONNECTIONS && queue.pop(id, type))
+            {
+                for (const Fetch& fetch : active)
+                {
+                    ensure("asset fetched twice at once", fetch.mID != id);
+                }
+                Fetch fetch = { id, tick + 1 + (S32)(next_random() % 8) };
+                active.push_back(fetch);
+                ++fetches;
+            }
+        }
+
+        ensure_equals("every caller called back", callbacks, (U64)REQUESTS);
+        ensure("duplicates coalesced", fetches < (U64)REQUESTS / 2);
+        ensure("interactive requests served", high_count > 0 && normal_count > 0);
+        ensure("interactive requests jump the queue", high_wait / high_count * 4 < normal_wait / normal_count);
+    }
+}
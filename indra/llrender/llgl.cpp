@@ -37,6 +37,7 @@
 
 #include "llgl.h"
 #include "llglstates.h"
+#include "llglstatestats.h"
 #include "llrender.h"
 
 #include "llerror.h"
@@ -190,6 +191,13 @@ PFNGLISVERTEXARRAYPROC glIsVertexArray = NULL;
 PFNGLMAPBUFFERRANGEPROC			glMapBufferRange = NULL;
 PFNGLFLUSHMAPPEDBUFFERRANGEPROC	glFlushMappedBufferRange = NULL;
 
+// GL_ARB_buffer_storage (4.4 core), GL_ARB_copy_buffer (3.1 core)
+PFNGLBUFFERSTORAGEPROC			glBufferStorage = NULL;
+PFNGLCOPYBUFFERSUBDATAPROC		glCopyBufferSubData = NULL;
+
+// GL 1.4 core
+PFNGLMULTIDRAWELEMENTSPROC		glMultiDrawElements = NULL;
+
 // GL_ARB_sync
 PFNGLFENCESYNCPROC				glFenceSync = NULL;
 PFNGLISSYNCPROC					glIsSync = NULL;
@@ -257,6 +265,11 @@ PFNGLTRANSFORMFEEDBACKVARYINGSPROC glTransformFeedbackVaryings = NULL;
 PFNGLBINDBUFFERRANGEPROC glBindBufferRange = NULL;
 PFNGLBINDBUFFERBASEPROC glBindBufferBase = NULL;
 
+//GL_ARB_get_program_binary (4.1 core)
+PFNGLGETPROGRAMBINARYPROC glGetProgramBinary = NULL;
+PFNGLPROGRAMBINARYPROC glProgramBinary = NULL;
+PFNGLPROGRAMPARAMETERIPROC glProgramParameteri = NULL;
+
 //GL_ARB_debug_output
 PFNGLDEBUGMESSAGECONTROLARBPROC glDebugMessageControlARB = NULL;
 PFNGLDEBUGMESSAGEINSERTARBPROC glDebugMessageInsertARB = NULL;
@@ -421,6 +434,8 @@ LLGLManager::LLGLManager() :
 	mHasVertexBufferObject(FALSE),
 	mHasVertexArrayObject(FALSE),
 	mHasMapBufferRange(FALSE),
+	mHasBufferStorage(FALSE),
+	mHasMultiDrawElements(FALSE),
 	mHasFlushBufferRange(FALSE),
 	mHasPBuffer(FALSE),
 	mNumTextureImageUnits(0),
@@ -432,6 +447,7 @@ LLGLManager::LLGLManager() :
 	mHasTextureRectangle(FALSE),
 	mHasTextureMultisample(FALSE),
 	mHasTransformFeedback(FALSE),
+	mHasProgramBinary(FALSE),
 	mMaxSampleMaskWords(0),
 	mMaxColorTextureSamples(0),
 	mMaxDepthTextureSamples(0),
@@ -895,6 +911,8 @@ void LLGLManager::asLLSD(LLSD& info)
 	info["has_vertex_array_object"] = mHasVertexArrayObject;
 	info["has_sync"] = mHasSync;
 	info["has_map_buffer_range"] = mHasMapBufferRange;
+	info["has_buffer_storage"] = mHasBufferStorage;
+	info["has_multi_draw_elements"] = mHasMultiDrawElements;
 	info["has_flush_buffer_range"] = mHasFlushBufferRange;
 	info["has_pbuffer"] = mHasPBuffer;
     info["has_shader_objects"] = std::string("Assumed TRUE");   // was mHasShaderObjects;
@@ -910,6 +928,7 @@ void LLGLManager::asLLSD(LLSD& info)
 	info["has_texture_rectangle"] = mHasTextureRectangle;
 	info["has_texture_multisample"] = mHasTextureMultisample;
 	info["has_transform_feedback"] = mHasTransformFeedback;
+	info["has_program_binary"] = mHasProgramBinary;
 	info["max_sample_mask_words"] = mMaxSampleMaskWords;
 	info["max_color_texture_samples"] = mMaxColorTextureSamples;
 	info["max_depth_texture_samples"] = mMaxDepthTextureSamples;
@@ -994,6 +1013,21 @@ void LLGLManager::initExtensions()
 #else
 	mHasBlendFuncSeparate = FALSE;
 # endif // GL_EXT_blend_func_separate
+# if defined(GL_ARB_buffer_storage) && defined(GL_ARB_copy_buffer)
+	mHasBufferStorage = TRUE;
+# else
+	mHasBufferStorage = FALSE;
+# endif // GL_ARB_buffer_storage
+# ifdef GL_VERSION_1_4
+	mHasMultiDrawElements = TRUE;
+# else
+	mHasMultiDrawElements = FALSE;
+# endif // GL_VERSION_1_4
+# ifdef GL_ARB_get_program_binary
+	mHasProgramBinary = TRUE;
+# else
+	mHasProgramBinary = FALSE;
+# endif // GL_ARB_get_program_binary
 	mHasMipMapGeneration = FALSE;
 	mHasSeparateSpecularColor = FALSE;
 	mHasAnisotropic = FALSE;
@@ -1018,6 +1052,12 @@ void LLGLManager::initExtensions()
 	mHasVertexArrayObject = ExtensionExists("GL_ARB_vertex_array_object", gGLHExts.mSysExts);
 	mHasSync = ExtensionExists("GL_ARB_sync", gGLHExts.mSysExts);
 	mHasMapBufferRange = ExtensionExists("GL_ARB_map_buffer_range", gGLHExts.mSysExts);
+#if !LL_DARWIN
+	mHasBufferStorage = mHasSync && mHasMapBufferRange &&
+		(mGLVersion >= 4.4f || ExtensionExists("GL_ARB_buffer_storage", gGLHExts.mSysExts)) &&
+		(mGLVersion >= 3.1f || ExtensionExists("GL_ARB_copy_buffer", gGLHExts.mSysExts));
+#endif
+	mHasMultiDrawElements = mGLVersion >= 1.4f;
 	mHasFlushBufferRange = ExtensionExists("GL_APPLE_flush_buffer_range", gGLHExts.mSysExts);
     // NOTE: Using extensions breaks reflections when Shadows are set to projector.  See: SL-16727
     //mHasDepthClamp = ExtensionExists("GL_ARB_depth_clamp", gGLHExts.mSysExts) || ExtensionExists("GL_NV_depth_clamp", gGLHExts.mSysExts);
@@ -1056,6 +1096,7 @@ void LLGLManager::initExtensions()
 	mHasDebugOutput = ExtensionExists("GL_ARB_debug_output", gGLHExts.mSysExts);
 	mHasTransformFeedback = mGLVersion >= 4.f ? TRUE : FALSE;
 #if !LL_DARWIN
+	mHasProgramBinary = mGLVersion >= 4.1f || ExtensionExists("GL_ARB_get_program_binary", gGLHExts.mSysExts);
 	mHasPointParameters = ExtensionExists("GL_ARB_point_parameters", gGLHExts.mSysExts);
 #endif
 #endif
@@ -1225,6 +1266,16 @@ void LLGLManager::initExtensions()
 		glMapBufferRange = (PFNGLMAPBUFFERRANGEPROC) GLH_EXT_GET_PROC_ADDRESS("glMapBufferRange");
 		glFlushMappedBufferRange = (PFNGLFLUSHMAPPEDBUFFERRANGEPROC) GLH_EXT_GET_PROC_ADDRESS("glFlushMappedBufferRange");
 	}
+	if (mHasBufferStorage)
+	{
+		glBufferStorage = (PFNGLBUFFERSTORAGEPROC) GLH_EXT_GET_PROC_ADDRESS("glBufferStorage");
+		glCopyBufferSubData = (PFNGLCOPYBUFFERSUBDATAPROC) GLH_EXT_GET_PROC_ADDRESS("glCopyBufferSubData");
+	}
+	if (mHasMultiDrawElements)
+	{
+		glMultiDrawElements = (PFNGLMULTIDRAWELEMENTSPROC) GLH_EXT_GET_PROC_ADDRESS("glMultiDrawElements");
+		mHasMultiDrawElements = glMultiDrawElements != NULL;
+	}
 	if (mHasFramebufferObject)
 	{
 		LL_INFOS() << "initExtensions() FramebufferObject-related procs..." << LL_ENDL;
@@ -1272,6 +1323,12 @@ void LLGLManager::initExtensions()
 		glBindBufferRange = (PFNGLBINDBUFFERRANGEPROC) GLH_EXT_GET_PROC_ADDRESS("glBindBufferRange");
 		glBindBufferBase = (PFNGLBINDBUFFERBASEPROC) GLH_EXT_GET_PROC_ADDRESS("glBindBufferBase");
 	}
+	if (mHasProgramBinary)
+	{
+		glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC) GLH_EXT_GET_PROC_ADDRESS("glGetProgramBinary");
+		glProgramBinary = (PFNGLPROGRAMBINARYPROC) GLH_EXT_GET_PROC_ADDRESS("glProgramBinary");
+		glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC) GLH_EXT_GET_PROC_ADDRESS("glProgramParameteri");
+	}
 	if (mHasDebugOutput)
 	{
 		glDebugMessageControlARB = (PFNGLDEBUGMESSAGECONTROLARBPROC) GLH_EXT_GET_PROC_ADDRESS("glDebugMessageControlARB");
@@ -1905,12 +1962,18 @@ void LLGLState::setEnabled(S32 enabled)
 		gGL.flush();
 		glEnable(mState);
 		sStateMap[mState] = GL_TRUE;
+		gGLStateStats.count(LLGLStateStats::CAPABILITY, true);
 	}
 	else if (enabled == FALSE && sStateMap[mState] != GL_FALSE)
 	{
 		gGL.flush();
 		glDisable(mState);
 		sStateMap[mState] = GL_FALSE;
+		gGLStateStats.count(LLGLStateStats::CAPABILITY, true);
+	}
+	else
+	{
+		gGLStateStats.count(LLGLStateStats::CAPABILITY, false);
 	}
 	mIsEnabled = enabled;
 }
@@ -1939,6 +2002,7 @@ LLGLState::~LLGLState()
 		if (mIsEnabled != mWasEnabled)
 		{
 			gGL.flush();
+			gGLStateStats.count(LLGLStateStats::CAPABILITY, true);
 			if (mWasEnabled)
 			{
 				glEnable(mState);
@@ -2165,6 +2229,7 @@ LLGLDepthTest::LLGLDepthTest(GLboolean depth_enabled, GLboolean write_enabled, G
 		write_enabled = FALSE;
 	}
 
+	gGLStateStats.count(LLGLStateStats::DEPTH, depth_enabled != sDepthEnabled);
 	if (depth_enabled != sDepthEnabled)
 	{
 		gGL.flush();
@@ -2172,12 +2237,14 @@ LLGLDepthTest::LLGLDepthTest(GLboolean depth_enabled, GLboolean write_enabled, G
 		else glDisable(GL_DEPTH_TEST);
 		sDepthEnabled = depth_enabled;
 	}
+	gGLStateStats.count(LLGLStateStats::DEPTH, depth_func != sDepthFunc);
 	if (depth_func != sDepthFunc)
 	{
 		gGL.flush();
 		glDepthFunc(depth_func);
 		sDepthFunc = depth_func;
 	}
+	gGLStateStats.count(LLGLStateStats::DEPTH, write_enabled != sWriteEnabled);
 	if (write_enabled != sWriteEnabled)
 	{
 		gGL.flush();
@@ -2192,6 +2259,7 @@ LLGLDepthTest::~LLGLDepthTest()
 	if (sDepthEnabled != mPrevDepthEnabled )
 	{
 		gGL.flush();
+		gGLStateStats.count(LLGLStateStats::DEPTH, true);
 		if (mPrevDepthEnabled) glEnable(GL_DEPTH_TEST);
 		else glDisable(GL_DEPTH_TEST);
 		sDepthEnabled = mPrevDepthEnabled;
@@ -2199,12 +2267,14 @@ LLGLDepthTest::~LLGLDepthTest()
 	if (sDepthFunc != mPrevDepthFunc)
 	{
 		gGL.flush();
+		gGLStateStats.count(LLGLStateStats::DEPTH, true);
 		glDepthFunc(mPrevDepthFunc);
 		sDepthFunc = mPrevDepthFunc;
 	}
 	if (sWriteEnabled != mPrevWriteEnabled )
 	{
 		gGL.flush();
+		gGLStateStats.count(LLGLStateStats::DEPTH, true);
 		glDepthMask(mPrevWriteEnabled);
 		sWriteEnabled = mPrevWriteEnabled;
 	}
@@ -93,6 +93,8 @@ public:
 	BOOL mHasVertexArrayObject;
 	BOOL mHasSync;
 	BOOL mHasMapBufferRange;
+	BOOL mHasBufferStorage;
+	BOOL mHasMultiDrawElements;
 	BOOL mHasFlushBufferRange;
 	BOOL mHasPBuffer;
 	S32  mNumTextureImageUnits;
@@ -105,6 +107,7 @@ public:
 	BOOL mHasTextureRectangle;
 	BOOL mHasTextureMultisample;
 	BOOL mHasTransformFeedback;
+	BOOL mHasProgramBinary;
 	S32 mMaxSampleMaskWords;
 	S32 mMaxColorTextureSamples;
 	S32 mMaxDepthTextureSamples;
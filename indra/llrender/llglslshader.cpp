@@ -32,6 +32,7 @@
 #include "llfile.h"
 #include "llrender.h"
 #include "llvertexbuffer.h"
+#include "llglstatestats.h"
 
 #if LL_DARWIN
 #include "OpenGL/OpenGL.h"
@@ -41,6 +42,9 @@
 // i.e. On macOS / OSX the AMD GLSL linker will display an error if a varying is left in an undefined state.
 #define DEBUG_SHADER_INCLUDES 0
 
+// Matrix uniforms up to this size (four 4x4 matrices) remember their last value
+static const U32 MAX_CACHED_MATRIX_FLOATS = 64;
+
 // Lots of STL stuff in here, using namespace std to keep things more readable
 using std::vector;
 using std::pair;
@@ -317,6 +321,7 @@ LLGLSLShader::LLGLSLShader()
       mShaderLevel(0), 
       mShaderGroup(SG_DEFAULT), 
       mUniformsDirty(FALSE),
+      mLoadedFromCache(false),
       mTimerQuery(0),
       mSamplesQuery(0)
 
@@ -388,6 +393,7 @@ BOOL LLGLSLShader::createShader(std::vector<LLStaticHashedString> * attributes,
     LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
 
     unloadInternal();
+    mLoadedFromCache = false;
 
     sInstances.insert(this);
 
@@ -421,26 +427,73 @@ BOOL LLGLSLShader::createShader(std::vector<LLStaticHashedString> * attributes,
     fprintf(stderr, "--- %s ---\n", mName.c_str());
 #endif // DEBUG_SHADER_INCLUDES
 
-    //compile new source
-    vector< pair<string,GLenum> >::iterator fileIter = mShaderFiles.begin();
-    for ( ; fileIter != mShaderFiles.end(); fileIter++ )
+    //attachShaderFeatures may change the number of indexed texture channels, but our own files
+    //are compiled with the original number
+    S32 texture_index_channels = mFeatures.mIndexedTextureChannels;
+    S32 shader_level = mShaderLevel;
+
+    //a cached binary of this exact program saves compiling and linking our files
+    std::string cache_key;
+    if (LLShaderMgr::instance()->usingProgramCache())
     {
-        GLhandleARB shaderhandle = LLShaderMgr::instance()->loadShaderFile((*fileIter).first, mShaderLevel, (*fileIter).second, &mDefines, mFeatures.mIndexedTextureChannels);
-        LL_DEBUGS("ShaderLoading") << "SHADER FILE: " << (*fileIter).first << " mShaderLevel=" << mShaderLevel << LL_ENDL;
-        if (shaderhandle)
+        //the key covers the feature objects, which are looked up by attaching them
+        if (!LLShaderMgr::instance()->attachShaderFeatures(this))
         {
-            attachObject(shaderhandle);
+            return FALSE;
         }
-        else
+        cache_key = getProgramCacheKey(texture_index_channels, varying_count, varyings);
+        mLoadedFromCache = !cache_key.empty() && LLShaderMgr::instance()->loadProgramBinary(cache_key, mProgramObject);
+
+        if (!mLoadedFromCache)
         {
-            success = FALSE;
+            //take them off again, so they're attached after our files like always
+            GLhandleARB obj[1024];
+            GLsizei count = 0;
+            glGetAttachedObjectsARB(mProgramObject, 1024, &count, obj);
+            for (GLsizei i = 0; i < count; i++)
+            {
+                glDetachObjectARB(mProgramObject, obj[i]);
+            }
         }
     }
 
-    // Attach existing objects
-    if (!LLShaderMgr::instance()->attachShaderFeatures(this))
+    if (!mLoadedFromCache)
     {
-        return FALSE;
+        //compile new source
+        vector< pair<string,GLenum> >::iterator fileIter = mShaderFiles.begin();
+        for ( ; fileIter != mShaderFiles.end(); fileIter++ )
+        {
+            GLhandleARB shaderhandle = LLShaderMgr::instance()->loadShaderFile((*fileIter).first, mShaderLevel, (*fileIter).second, &mDefines, texture_index_channels);
+            LL_DEBUGS("ShaderLoading") << "SHADER FILE: " << (*fileIter).first << " mShaderLevel=" << mShaderLevel << LL_ENDL;
+            if (shaderhandle)
+            {
+                attachObject(shaderhandle);
+            }
+            else
+            {
+                success = FALSE;
+            }
+        }
+
+        // Attach existing objects
+        if (!LLShaderMgr::instance()->attachShaderFeatures(this))
+        {
+            return FALSE;
+        }
+
+#ifdef GL_INTERLEAVED_ATTRIBS
+        if (varying_count > 0 && varyings)
+        {
+            glTransformFeedbackVaryings(mProgramObject, varying_count, varyings, GL_INTERLEAVED_ATTRIBS);
+        }
+#endif
+
+#if !LL_DARWIN
+        if (!cache_key.empty())
+        {
+            glProgramParameteri(mProgramObject, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+#endif
     }
 
     if (gGLManager.mGLSLVersionMajor < 2 && gGLManager.mGLSLVersionMinor < 3)
@@ -449,13 +502,6 @@ BOOL LLGLSLShader::createShader(std::vector<LLStaticHashedString> * attributes,
         mFeatures.mIndexedTextureChannels = llmin(mFeatures.mIndexedTextureChannels, 1);
     }
 
-#ifdef GL_INTERLEAVED_ATTRIBS
-    if (varying_count > 0 && varyings)
-    {
-        glTransformFeedbackVaryings(mProgramObject, varying_count, varyings, GL_INTERLEAVED_ATTRIBS);
-    }
-#endif
-
     // Map attributes and uniforms
     if (success)
     {
@@ -465,6 +511,10 @@ BOOL LLGLSLShader::createShader(std::vector<LLStaticHashedString> * attributes,
     {
         success = mapUniforms(uniforms);
     }
+    if (success && !mLoadedFromCache && !cache_key.empty() && mShaderLevel == shader_level)
+    { //don't cache a fallback to a lower shader level: it isn't what cache_key describes
+        LLShaderMgr::instance()->saveProgramBinary(cache_key, mProgramObject);
+    }
     if( !success )
     {
         LL_SHADER_LOADING_WARNS() << "Failed to link shader: " << mName << LL_ENDL;
@@ -525,6 +575,43 @@ void dumpAttachObject( const char *func_name, GLhandleARB program_object, const
 }
 #endif // DEBUG_SHADER_INCLUDES
 
+std::string LLGLSLShader::getProgramCacheKey(S32 texture_index_channels, U32 varying_count, const char** varyings)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
+
+    std::vector<std::string> hashes;
+    //our own files, as loadShaderFile would compile them
+    for (const auto& file : mShaderFiles)
+    {
+        std::string hash = LLShaderMgr::instance()->hashShaderFile(file.first, mShaderLevel, file.second, &mDefines, texture_index_channels);
+        if (hash.empty())
+        {
+            return std::string();
+        }
+        hashes.push_back(hash);
+    }
+
+    //plus the feature objects attachShaderFeatures attached
+    GLhandleARB attached[1024];
+    GLsizei count = 0;
+    glGetAttachedObjectsARB(mProgramObject, LL_ARRAY_SIZE(attached), &count, attached);
+    if (count >= (GLsizei) LL_ARRAY_SIZE(attached))
+    {
+        return std::string();
+    }
+    for (GLsizei i = 0; i < count; ++i)
+    {
+        auto found = LLShaderMgr::instance()->mShaderObjectHashes.find(attached[i]);
+        if (found == LLShaderMgr::instance()->mShaderObjectHashes.end())
+        {
+            return std::string();
+        }
+        hashes.push_back(found->second);
+    }
+
+    return LLShaderMgr::instance()->getProgramCacheKey(hashes, varying_count, varyings);
+}
+
 BOOL LLGLSLShader::attachVertexObject(std::string object_path)
 {
     if (LLShaderMgr::instance()->mVertexShaderObjects.count(object_path) > 0)
@@ -593,15 +680,19 @@ BOOL LLGLSLShader::mapAttributes(const std::vector<LLStaticHashedString> * attri
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
 
-    //before linking, make sure reserved attributes always have consistent locations
-    for (U32 i = 0; i < LLShaderMgr::instance()->mReservedAttribs.size(); i++)
+    BOOL res = TRUE;
+    if (!mLoadedFromCache)
     {
-        const char* name = LLShaderMgr::instance()->mReservedAttribs[i].c_str();
-        glBindAttribLocationARB(mProgramObject, i, (const GLcharARB *) name);
+        //before linking, make sure reserved attributes always have consistent locations
+        for (U32 i = 0; i < LLShaderMgr::instance()->mReservedAttribs.size(); i++)
+        {
+            const char* name = LLShaderMgr::instance()->mReservedAttribs[i].c_str();
+            glBindAttribLocationARB(mProgramObject, i, (const GLcharARB *) name);
+        }
+
+        //link the program
+        res = link();
     }
-    
-    //link the program
-    BOOL res = link();
 
     mAttribute.clear();
     U32 numAttributes = (attributes == NULL) ? 0 : attributes->size();
@@ -802,6 +893,7 @@ BOOL LLGLSLShader::mapUniforms(const vector<LLStaticHashedString> * uniforms)
 	mUniformNameMap.clear();
 	mTexture.clear();
 	mValue.clear();
+	mMatrixValue.clear();
 	//initialize arrays
 	U32 numUniforms = (uniforms == NULL) ? 0 : uniforms->size();
 	mUniform.resize(numUniforms + LLShaderMgr::instance()->mReservedUniforms.size(), -1);
@@ -954,6 +1046,7 @@ void LLGLSLShader::bind()
 
     gGL.flush();
 
+    gGLStateStats.count(LLGLStateStats::SHADER, sCurBoundShader != mProgramObject);
     if (sCurBoundShader != mProgramObject)  // Don't re-bind current shader
     {
         LLVertexBuffer::unbind();
@@ -989,8 +1082,12 @@ void LLGLSLShader::unbind()
     gGL.flush();
     stop_glerror();
     LLVertexBuffer::unbind();
-    glUseProgramObjectARB(0);
-    sCurBoundShader = 0;
+    gGLStateStats.count(LLGLStateStats::SHADER, sCurBoundShader != 0);
+    if (sCurBoundShader)
+    {
+        glUseProgramObjectARB(0);
+        sCurBoundShader = 0;
+    }
     sCurBoundShaderPtr = NULL;
     stop_glerror();
 }
@@ -1128,7 +1225,9 @@ void LLGLSLShader::uniform1i(U32 index, GLint x)
         if (mUniform[index] >= 0)
         {
             const auto& iter = mValue.find(mUniform[index]);
-            if (iter == mValue.end() || iter->second.mV[0] != x)
+            bool changed = iter == mValue.end() || iter->second.mV[0] != x;
+            gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+            if (changed)
             {
                 glUniform1iARB(mUniform[index], x);
                 mValue[mUniform[index]] = LLVector4(x,0.f,0.f,0.f);
@@ -1151,7 +1250,9 @@ void LLGLSLShader::uniform1f(U32 index, GLfloat x)
         if (mUniform[index] >= 0)
         {
             const auto& iter = mValue.find(mUniform[index]);
-            if (iter == mValue.end() || iter->second.mV[0] != x)
+            bool changed = iter == mValue.end() || iter->second.mV[0] != x;
+            gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+            if (changed)
             {
                 glUniform1fARB(mUniform[index], x);
                 mValue[mUniform[index]] = LLVector4(x,0.f,0.f,0.f);
@@ -1174,7 +1275,9 @@ void LLGLSLShader::uniform2f(U32 index, GLfloat x, GLfloat y)
         {
             const auto& iter = mValue.find(mUniform[index]);
             LLVector4 vec(x,y,0.f,0.f);
-            if (iter == mValue.end() || shouldChange(iter->second,vec))
+            bool changed = iter == mValue.end() || shouldChange(iter->second,vec);
+            gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+            if (changed)
             {
                 glUniform2fARB(mUniform[index], x, y);
                 mValue[mUniform[index]] = vec;
@@ -1197,7 +1300,9 @@ void LLGLSLShader::uniform3f(U32 index, GLfloat x, GLfloat y, GLfloat z)
         {
             const auto& iter = mValue.find(mUniform[index]);
             LLVector4 vec(x,y,z,0.f);
-            if (iter == mValue.end() || shouldChange(iter->second,vec))
+            bool changed = iter == mValue.end() || shouldChange(iter->second,vec);
+            gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+            if (changed)
             {
                 glUniform3fARB(mUniform[index], x, y, z);
                 mValue[mUniform[index]] = vec;
@@ -1220,7 +1325,9 @@ void LLGLSLShader::uniform4f(U32 index, GLfloat x, GLfloat y, GLfloat z, GLfloat
         {
             const auto& iter = mValue.find(mUniform[index]);
             LLVector4 vec(x,y,z,w);
-            if (iter == mValue.end() || shouldChange(iter->second,vec))
+            bool changed = iter == mValue.end() || shouldChange(iter->second,vec);
+            gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+            if (changed)
             {
                 glUniform4fARB(mUniform[index], x, y, z, w);
                 mValue[mUniform[index]] = vec;
@@ -1243,7 +1350,9 @@ void LLGLSLShader::uniform1iv(U32 index, U32 count, const GLint* v)
         {
             const auto& iter = mValue.find(mUniform[index]);
             LLVector4 vec(v[0],0.f,0.f,0.f);
-            if (iter == mValue.end() || shouldChange(iter->second,vec) || count != 1)
+            bool changed = iter == mValue.end() || shouldChange(iter->second,vec) || count != 1;
+            gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+            if (changed)
             {
                 glUniform1ivARB(mUniform[index], count, v);
                 mValue[mUniform[index]] = vec;
@@ -1266,7 +1375,9 @@ void LLGLSLShader::uniform1fv(U32 index, U32 count, const GLfloat* v)
         {
             const auto& iter = mValue.find(mUniform[index]);
             LLVector4 vec(v[0],0.f,0.f,0.f);
-            if (iter == mValue.end() || shouldChange(iter->second,vec) || count != 1)
+            bool changed = iter == mValue.end() || shouldChange(iter->second,vec) || count != 1;
+            gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+            if (changed)
             {
                 glUniform1fvARB(mUniform[index], count, v);
                 mValue[mUniform[index]] = vec;
@@ -1289,7 +1400,9 @@ void LLGLSLShader::uniform2fv(U32 index, U32 count, const GLfloat* v)
         {
             const auto& iter = mValue.find(mUniform[index]);
             LLVector4 vec(v[0],v[1],0.f,0.f);
-            if (iter == mValue.end() || shouldChange(iter->second,vec) || count != 1)
+            bool changed = iter == mValue.end() || shouldChange(iter->second,vec) || count != 1;
+            gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+            if (changed)
             {
                 glUniform2fvARB(mUniform[index], count, v);
                 mValue[mUniform[index]] = vec;
@@ -1312,7 +1425,9 @@ void LLGLSLShader::uniform3fv(U32 index, U32 count, const GLfloat* v)
         {
             const auto& iter = mValue.find(mUniform[index]);
             LLVector4 vec(v[0],v[1],v[2],0.f);
-            if (iter == mValue.end() || shouldChange(iter->second,vec) || count != 1)
+            bool changed = iter == mValue.end() || shouldChange(iter->second,vec) || count != 1;
+            gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+            if (changed)
             {
                 glUniform3fvARB(mUniform[index], count, v);
                 mValue[mUniform[index]] = vec;
@@ -1335,7 +1450,9 @@ void LLGLSLShader::uniform4fv(U32 index, U32 count, const GLfloat* v)
         {
             const auto& iter = mValue.find(mUniform[index]);
             LLVector4 vec(v[0],v[1],v[2],v[3]);
-            if (iter == mValue.end() || shouldChange(iter->second,vec) || count != 1)
+            bool changed = iter == mValue.end() || shouldChange(iter->second,vec) || count != 1;
+            gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+            if (changed)
             {
                 LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
                 glUniform4fvARB(mUniform[index], count, v);
@@ -1345,6 +1462,23 @@ void LLGLSLShader::uniform4fv(U32 index, U32 count, const GLfloat* v)
     }
 }
 
+bool LLGLSLShader::matrixChanged(GLint location, U32 size, GLboolean transpose, const GLfloat* v)
+{
+    bool changed = true;
+    // bone palettes change every draw, comparing them would only add work
+    if (!transpose && size <= MAX_CACHED_MATRIX_FLOATS)
+    {
+        std::vector<F32>& value = mMatrixValue[location];
+        changed = value.size() != size || !std::equal(v, v + size, value.begin());
+        if (changed)
+        {
+            value.assign(v, v + size);
+        }
+    }
+    gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+    return changed;
+}
+
 void LLGLSLShader::uniformMatrix2fv(U32 index, U32 count, GLboolean transpose, const GLfloat *v)
 {
     if (mProgramObject)
@@ -1355,7 +1489,7 @@ void LLGLSLShader::uniformMatrix2fv(U32 index, U32 count, GLboolean transpose, c
             return;
         }
 
-        if (mUniform[index] >= 0)
+        if (mUniform[index] >= 0 && matrixChanged(mUniform[index], count * 4, transpose, v))
         {
             glUniformMatrix2fvARB(mUniform[index], count, transpose, v);
         }
@@ -1372,7 +1506,7 @@ void LLGLSLShader::uniformMatrix3fv(U32 index, U32 count, GLboolean transpose, c
             return;
         }
 
-        if (mUniform[index] >= 0)
+        if (mUniform[index] >= 0 && matrixChanged(mUniform[index], count * 9, transpose, v))
         {
             glUniformMatrix3fvARB(mUniform[index], count, transpose, v);
         }
@@ -1391,7 +1525,7 @@ void LLGLSLShader::uniformMatrix3x4fv(U32 index, U32 count, GLboolean transpose,
 			return;
 		}
 
-		if (mUniform[index] >= 0)
+		if (mUniform[index] >= 0 && matrixChanged(mUniform[index], count * 12, transpose, v))
 		{
 			glUniformMatrix3x4fv(mUniform[index], count, transpose, v);
 		}
@@ -1408,7 +1542,7 @@ void LLGLSLShader::uniformMatrix4fv(U32 index, U32 count, GLboolean transpose, c
             return;
         }
 
-        if (mUniform[index] >= 0)
+        if (mUniform[index] >= 0 && matrixChanged(mUniform[index], count * 16, transpose, v))
         {
             glUniformMatrix4fvARB(mUniform[index], count, transpose, v);
         }
@@ -1481,7 +1615,9 @@ void LLGLSLShader::uniform1i(const LLStaticHashedString& uniform, GLint v)
     {
         const auto& iter = mValue.find(location);
         LLVector4 vec(v,0.f,0.f,0.f);
-        if (iter == mValue.end() || shouldChange(iter->second,vec))
+        bool changed = iter == mValue.end() || shouldChange(iter->second,vec);
+        gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+        if (changed)
         {
             glUniform1iARB(location, v);
             mValue[location] = vec;
@@ -1497,7 +1633,9 @@ void LLGLSLShader::uniform2i(const LLStaticHashedString& uniform, GLint i, GLint
     {
         const auto& iter = mValue.find(location);
         LLVector4 vec(i,j,0.f,0.f);
-        if (iter == mValue.end() || shouldChange(iter->second,vec))
+        bool changed = iter == mValue.end() || shouldChange(iter->second,vec);
+        gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+        if (changed)
         {
             glUniform2iARB(location, i, j);
             mValue[location] = vec;
@@ -1514,7 +1652,9 @@ void LLGLSLShader::uniform1f(const LLStaticHashedString& uniform, GLfloat v)
     {
         const auto& iter = mValue.find(location);
         LLVector4 vec(v,0.f,0.f,0.f);
-        if (iter == mValue.end() || shouldChange(iter->second,vec))
+        bool changed = iter == mValue.end() || shouldChange(iter->second,vec);
+        gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+        if (changed)
         {
             glUniform1fARB(location, v);
             mValue[location] = vec;
@@ -1530,7 +1670,9 @@ void LLGLSLShader::uniform2f(const LLStaticHashedString& uniform, GLfloat x, GLf
     {
         const auto& iter = mValue.find(location);
         LLVector4 vec(x,y,0.f,0.f);
-        if (iter == mValue.end() || shouldChange(iter->second,vec))
+        bool changed = iter == mValue.end() || shouldChange(iter->second,vec);
+        gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+        if (changed)
         {
             glUniform2fARB(location, x,y);
             mValue[location] = vec;
@@ -1547,7 +1689,9 @@ void LLGLSLShader::uniform3f(const LLStaticHashedString& uniform, GLfloat x, GLf
     {
         const auto& iter = mValue.find(location);
         LLVector4 vec(x,y,z,0.f);
-        if (iter == mValue.end() || shouldChange(iter->second,vec))
+        bool changed = iter == mValue.end() || shouldChange(iter->second,vec);
+        gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+        if (changed)
         {
             glUniform3fARB(location, x,y,z);
             mValue[location] = vec;
@@ -1563,7 +1707,9 @@ void LLGLSLShader::uniform1fv(const LLStaticHashedString& uniform, U32 count, co
     {
         const auto& iter = mValue.find(location);
         LLVector4 vec(v[0],0.f,0.f,0.f);
-        if (iter == mValue.end() || shouldChange(iter->second,vec) || count != 1)
+        bool changed = iter == mValue.end() || shouldChange(iter->second,vec) || count != 1;
+        gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+        if (changed)
         {
             glUniform1fvARB(location, count, v);
             mValue[location] = vec;
@@ -1579,7 +1725,9 @@ void LLGLSLShader::uniform2fv(const LLStaticHashedString& uniform, U32 count, co
     {
         const auto& iter = mValue.find(location);
         LLVector4 vec(v[0],v[1],0.f,0.f);
-        if (iter == mValue.end() || shouldChange(iter->second,vec) || count != 1)
+        bool changed = iter == mValue.end() || shouldChange(iter->second,vec) || count != 1;
+        gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+        if (changed)
         {
             glUniform2fvARB(location, count, v);
             mValue[location] = vec;
@@ -1595,7 +1743,9 @@ void LLGLSLShader::uniform3fv(const LLStaticHashedString& uniform, U32 count, co
     {
         const auto& iter = mValue.find(location);
         LLVector4 vec(v[0],v[1],v[2],0.f);
-        if (iter == mValue.end() || shouldChange(iter->second,vec) || count != 1)
+        bool changed = iter == mValue.end() || shouldChange(iter->second,vec) || count != 1;
+        gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+        if (changed)
         {
             glUniform3fvARB(location, count, v);
             mValue[location] = vec;
@@ -1611,7 +1761,9 @@ void LLGLSLShader::uniform4fv(const LLStaticHashedString& uniform, U32 count, co
     {
         LLVector4 vec(v);
         const auto& iter = mValue.find(location);
-        if (iter == mValue.end() || shouldChange(iter->second,vec) || count != 1)
+        bool changed = iter == mValue.end() || shouldChange(iter->second,vec) || count != 1;
+        gGLStateStats.count(LLGLStateStats::UNIFORM, changed);
+        if (changed)
         {
             LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
             glUniform4fvARB(location, count, v);
@@ -1624,7 +1776,7 @@ void LLGLSLShader::uniformMatrix4fv(const LLStaticHashedString& uniform, U32 cou
 {
     GLint location = getUniformLocation(uniform);
                 
-    if (location >= 0)
+    if (location >= 0 && matrixChanged(location, count * 16, transpose, v))
     {
         stop_glerror();
         glUniformMatrix4fvARB(location, count, transpose, v);
@@ -259,12 +259,15 @@ public:
     typedef std::unordered_map<GLint, LLVector4> uniform_value_map_t;
     uniform_name_map_t mUniformNameMap; //lookup map of uniform location to uniform name
 	uniform_value_map_t mValue; //lookup map of uniform location to last known value
+    typedef std::unordered_map<GLint, std::vector<F32> > uniform_matrix_map_t;
+	uniform_matrix_map_t mMatrixValue; //lookup map of matrix uniform location to last known value
 	std::vector<GLint> mTexture;
 	S32 mTotalUniformSize;
 	S32 mActiveTextureChannels;
 	S32 mShaderLevel;
 	S32 mShaderGroup; // see LLGLSLShader::eGroup
 	BOOL mUniformsDirty;
+	bool mLoadedFromCache; // linked program came from LLShaderMgr's program binary cache
 	LLShaderFeatures mFeatures;
 	std::vector< std::pair< std::string, GLenum > > mShaderFiles;
 	std::string mName;
@@ -292,6 +295,9 @@ public:
 
 private:
 	void unloadInternal();
+	std::string getProgramCacheKey(S32 texture_index_channels, U32 varying_count, const char** varyings);
+	// true if a matrix uniform must be sent, remembers small matrices to skip resending them
+	bool matrixChanged(GLint location, U32 size, GLboolean transpose, const GLfloat* v);
 };
 
 //UI shader (declared here so llui_libtest will link properly)
@@ -0,0 +1,102 @@
+/**
+ * @file   llglstatestats.cpp
+ * @date   2023-04-24
+ * @brief  Implementation for llglstatestats.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "llglstatestats.h"
+// STL headers
+// std headers
+#include <cstring>
+// external library headers
+// other Linden headers
+
+thread_local LLGLStateStats gGLStateStats;
+
+U32 LLGLStateStats::Counts::getIssued() const
+{
+    U32 total = 0;
+    for (U32 i = 0; i < NUM_STATE_TYPES; ++i)
+    {
+        total += mIssued[i];
+    }
+    return total;
+}
+
+U32 LLGLStateStats::Counts::getRedundant() const
+{
+    U32 total = 0;
+    for (U32 i = 0; i < NUM_STATE_TYPES; ++i)
+    {
+        total += mRedundant[i];
+    }
+    return total;
+}
+
+LLGLStateStats::LLGLStateStats():
+    mScope(0)
+{
+    reset();
+}
+
+U32 LLGLStateStats::setScope(U32 scope)
+{
+    llassert(scope < MAX_SCOPES);
+    U32 prev = mScope;
+    mScope = scope < MAX_SCOPES ? scope : 0;
+    return prev;
+}
+
+LLGLStateStats::Counts LLGLStateStats::getTotal() const
+{
+    Counts total;
+    memset(&total, 0, sizeof(total));
+    for (U32 scope = 0; scope < MAX_SCOPES; ++scope)
+    {
+        for (U32 i = 0; i < NUM_STATE_TYPES; ++i)
+        {
+            total.mIssued[i] += mCounts[scope].mIssued[i];
+            total.mRedundant[i] += mCounts[scope].mRedundant[i];
+        }
+    }
+    return total;
+}
+
+void LLGLStateStats::reset()
+{
+    memset(mCounts, 0, sizeof(mCounts));
+}
+
+// static
+const char* LLGLStateStats::getTypeName(eStateType type)
+{
+    static const char* names[NUM_STATE_TYPES] =
+    {
+        "Shader",
+        "Uniform",
+        "Texture",
+        "Buffer",
+        "Blend",
+        "Depth",
+        "Cap"
+    };
+
+    return type < NUM_STATE_TYPES ? names[type] : "Unknown";
+}
+
+LLGLStateStats::Scope::Scope(U32 scope):
+    mPrevScope(gGLStateStats.setScope(scope))
+{
+}
+
+LLGLStateStats::Scope::~Scope()
+{
+    gGLStateStats.setScope(mPrevScope);
+}
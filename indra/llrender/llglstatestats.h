@@ -0,0 +1,106 @@
+/**
+ * @file   llglstatestats.h
+ * @date   2023-04-24
+ * @brief  Counts of GL state changes issued to the driver versus skipped
+ *         because the cached state already matched, per draw pool.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_LLGLSTATESTATS_H)
+#define LL_LLGLSTATESTATS_H
+
+#include "stdtypes.h"
+
+/**
+ * The render state caches (LLGLState, LLGLDepthTest, LLRender::blendFunc,
+ * LLTexUnit, LLVertexBuffer, LLGLSLShader) report every state change they
+ * are asked for here, as either issued (a GL call was made) or redundant
+ * (the cache already held that state and the call was skipped).
+ *
+ * Counts go to the current scope, which the pipeline sets to the type of
+ * the draw pool being rendered. Scope 0 collects everything outside a draw
+ * pool (UI, occlusion, post effects).
+ *
+ * gGLStateStats is thread_local, so threads with their own GL context
+ * (the LLImageGL texture threads) don't contend on or pollute the render
+ * thread's counts.  The caches being counted aren't per thread: gGL is a
+ * single LLRender owned by the main thread, and other threads must not
+ * update its cached state.
+ */
+class LLGLStateStats
+{
+public:
+    typedef enum
+    {
+        SHADER = 0,     // program binds
+        UNIFORM,        // uniform values, including matrices
+        TEXTURE,        // texture binds and active texture unit
+        BUFFER,         // vertex array, vertex and index buffer binds
+        BLEND,          // blend functions
+        DEPTH,          // depth test, func and write mask
+        CAPABILITY,     // other glEnable/glDisable caps
+        NUM_STATE_TYPES
+    } eStateType;
+
+    static const U32 MAX_SCOPES = 32;
+
+    struct Counts
+    {
+        U32 mIssued[NUM_STATE_TYPES];
+        U32 mRedundant[NUM_STATE_TYPES];
+
+        U32 getIssued() const;
+        U32 getRedundant() const;
+    };
+
+    LLGLStateStats();
+
+    /// Record a requested change of @a type, which was either sent to GL
+    /// (@a issued) or skipped by a cache.
+    void count(eStateType type, bool issued)
+    {
+        Counts& counts = mCounts[mScope];
+        if (issued)
+        {
+            counts.mIssued[type]++;
+        }
+        else
+        {
+            counts.mRedundant[type]++;
+        }
+    }
+
+    /// Set the scope counts go to, returning the previous one.
+    U32 setScope(U32 scope);
+    U32 getScope() const { return mScope; }
+
+    const Counts& getCounts(U32 scope) const { return mCounts[scope]; }
+    /// Sum of all scopes.
+    Counts getTotal() const;
+
+    void reset();
+
+    static const char* getTypeName(eStateType type);
+
+    /// Counts to @a scope for the lifetime of this object.
+    class Scope
+    {
+    public:
+        Scope(U32 scope);
+        ~Scope();
+
+    private:
+        U32 mPrevScope;
+    };
+
+private:
+    U32 mScope;
+    Counts mCounts[MAX_SCOPES];
+};
+
+extern thread_local LLGLStateStats gGLStateStats;
+
+#endif /* ! defined(LL_LLGLSTATESTATS_H) */
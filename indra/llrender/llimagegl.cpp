@@ -57,6 +57,10 @@ U32 wpo2(U32 i);
 
 U32 LLImageGL::sUniqueCount				= 0;
 U32 LLImageGL::sBindCount				= 0;
+std::atomic<U32> LLImageGL::sCreateCount(0);
+std::atomic<U32> LLImageGL::sUploadCount(0);
+std::atomic<U64> LLImageGL::sUploadBytes(0);
+std::atomic<U64> LLImageGL::sThreadCreateTime(0);
 S32Bytes LLImageGL::sGlobalTextureMemory(0);
 S32Bytes LLImageGL::sBoundTextureMemory(0);
 S32Bytes LLImageGL::sCurBoundTextureMemory(0);
@@ -72,6 +76,45 @@ std::set<LLImageGL*> LLImageGL::sImageList;
 
 bool LLImageGLThread::sEnabled = false;
 
+thread_local LLPixelUnpackPool* LLPixelUnpackPool::sCurrent = NULL;
+
+// the main thread's pool, LLImageGLThread keeps its own
+static LLPixelUnpackPool sMainUnpackPool;
+
+// bytes glTexImage2D reads for an uncompressed image, 0 for formats uploads aren't staged for
+// (GL_UNPACK_ALIGNMENT is 1, so rows are not padded)
+static U32 unpack_bytes(U32 pixformat, U32 pixtype, S32 width, S32 height)
+{
+    if (pixtype != GL_UNSIGNED_BYTE)
+    {
+        return 0;
+    }
+
+    U32 components = 0;
+    switch (pixformat)
+    {
+    case GL_RGBA:
+    case GL_BGRA:
+        components = 4;
+        break;
+    case GL_RGB:
+        components = 3;
+        break;
+    case GL_LUMINANCE_ALPHA:
+        components = 2;
+        break;
+    case GL_RED:
+    case GL_ALPHA:
+    case GL_LUMINANCE:
+        components = 1;
+        break;
+    default:
+        break;
+    }
+
+    return (U32) width * (U32) height * components;
+}
+
 //****************************************************************************************************
 //The below for texture auditing use only
 //****************************************************************************************************
@@ -180,14 +223,19 @@ BOOL is_little_endian()
 }
 
 //static 
-void LLImageGL::initClass(LLWindow* window, S32 num_catagories, BOOL skip_analyze_alpha /* = false */, bool multi_threaded /* = false */)
+void LLImageGL::initClass(LLWindow* window, S32 num_catagories, BOOL skip_analyze_alpha /* = false */, bool multi_threaded /* = false */, bool unpack_buffers /* = false */)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
 	sSkipAnalyzeAlpha = skip_analyze_alpha;
 
+    if (unpack_buffers)
+    {
+        sMainUnpackPool.init();
+    }
+
     if (multi_threaded)
     {
-        LLImageGLThread::createInstance(window);
+        LLImageGLThread::createInstance(window, unpack_buffers);
     }
 }
 
@@ -196,6 +244,7 @@ void LLImageGL::cleanupClass()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
     LLImageGLThread::deleteSingleton();
+    sMainUnpackPool.cleanup();
 }
 
 //static
@@ -680,6 +729,7 @@ void LLImageGL::setImage(const LLImageRaw* imageraw)
 BOOL LLImageGL::setImage(const U8* data_in, BOOL data_hasmips /* = FALSE */, S32 usename /* = 0 */)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    sUploadCount.fetch_add(1, std::memory_order_relaxed);
 	bool is_compressed = false;
 
     switch (mFormatPrimary)
@@ -696,6 +746,14 @@ BOOL LLImageGL::setImage(const U8* data_in, BOOL data_hasmips /* = FALSE */, S32
         break;
     }
 	
+	//batched UI quads may still sample the old contents of a texture that
+	//is already in use.  A fresh name can't be referenced by them, and gGL
+	//belongs to the main thread, so texture threads leave it alone.
+	if (mTexName != 0 && (usename == 0 || (LLGLuint)usename == mTexName) && on_main_thread())
+	{
+		gGL.flush();
+	}
+
 	if (mUseMipMaps)
 	{
 		//set has mip maps to true before binding image so tex parameters get set properly
@@ -741,8 +799,7 @@ BOOL LLImageGL::setImage(const U8* data_in, BOOL data_hasmips /* = FALSE */, S32
 				if (is_compressed)
 				{
  					S32 tex_size = dataFormatBytes(mFormatPrimary, w, h);
-					glCompressedTexImage2DARB(mTarget, gl_level, mFormatPrimary, w, h, 0, tex_size, (GLvoid *)data_in);
-					stop_glerror();
+					setCompressedImage(mTarget, gl_level, mFormatPrimary, w, h, tex_size, data_in);
 				}
 				else
 				{
@@ -936,8 +993,7 @@ BOOL LLImageGL::setImage(const U8* data_in, BOOL data_hasmips /* = FALSE */, S32
 		if (is_compressed)
 		{
 			S32 tex_size = dataFormatBytes(mFormatPrimary, w, h);
-			glCompressedTexImage2DARB(mTarget, 0, mFormatPrimary, w, h, 0, tex_size, (GLvoid *)data_in);
-			stop_glerror();
+			setCompressedImage(mTarget, 0, mFormatPrimary, w, h, tex_size, data_in);
 		}
 		else
 		{
@@ -1106,6 +1162,7 @@ BOOL LLImageGL::setSubImage(const U8* datap, S32 data_width, S32 data_height, S3
 	}
 	else
 	{
+		sUploadCount.fetch_add(1, std::memory_order_relaxed);
 		if (mUseMipMaps)
 		{
 			dump();
@@ -1159,6 +1216,7 @@ BOOL LLImageGL::setSubImage(const U8* datap, S32 data_width, S32 data_height, S3
 		stop_glerror();
 
 		glTexSubImage2D(mTarget, 0, x_pos, y_pos, width, height, mFormatPrimary, mFormatType, datap);
+		sUploadBytes.fetch_add(unpack_bytes(mFormatPrimary, mFormatType, width, height), std::memory_order_relaxed);
 		gGL.getTexUnit(0)->disable();
 		stop_glerror();
 
@@ -1205,6 +1263,8 @@ void LLImageGL::generateTextures(S32 numTextures, U32 *textures)
     static thread_local U32 name_pool[pool_size]; // pool of texture names
     static thread_local U32 name_count = 0; // number of available names in the pool
 
+    sCreateCount.fetch_add(numTextures, std::memory_order_relaxed);
+
     if (name_count == 0)
     {
         LL_PROFILE_ZONE_NAMED("iglgt - reup pool");
@@ -1231,7 +1291,19 @@ void LLImageGL::deleteTextures(S32 numTextures, const U32 *textures)
 {
 	if (gGLManager.mInited)
 	{
+		//batched UI quads may still sample these, unless this is a texture
+		//thread, whose names the main thread's batches and unit caches never
+		//saw (textures it replaces are deleted back on the main thread)
+		bool main_thread = on_main_thread();
+		if (main_thread)
+		{
+			gGL.flush();
+		}
 		glDeleteTextures(numTextures, textures);
+		if (main_thread)
+		{
+			gGL.forgetTextures(numTextures, textures);
+		}
 	}
 }
 
@@ -1365,19 +1437,54 @@ void LLImageGL::setManualImage(U32 target, S32 miplevel, S32 intformat, S32 widt
         }
     }
 
+    const void* src = use_scratch ? scratch : pixels;
+    U32 bytes = src ? unpack_bytes(pixformat, pixtype, width, height) : 0;
+    LLPixelUnpackPool* unpack_pool = LLPixelUnpackPool::getCurrent();
+    if (unpack_pool && bytes)
+    {
+        src = unpack_pool->stage(src, bytes);
+    }
+    sUploadBytes.fetch_add(bytes, std::memory_order_relaxed);
+
     stop_glerror();
     {
         LL_PROFILE_ZONE_NAMED("glTexImage2D");
-        glTexImage2D(target, miplevel, intformat, width, height, 0, pixformat, pixtype, use_scratch ? scratch : pixels);
+        glTexImage2D(target, miplevel, intformat, width, height, 0, pixformat, pixtype, src);
     }
     stop_glerror();
 
+    if (unpack_pool)
+    {
+        unpack_pool->release();
+    }
+
     if (use_scratch)
     {
         delete[] scratch;
     }
 }
 
+// static
+void LLImageGL::setCompressedImage(U32 target, S32 miplevel, U32 format, S32 width, S32 height, S32 size, const void* data)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    const void* src = data;
+    LLPixelUnpackPool* unpack_pool = LLPixelUnpackPool::getCurrent();
+    if (unpack_pool && size > 0)
+    {
+        src = unpack_pool->stage(data, size);
+    }
+    sUploadBytes.fetch_add(size, std::memory_order_relaxed);
+
+    glCompressedTexImage2DARB(target, miplevel, format, width, height, 0, size, src);
+    stop_glerror();
+
+    if (unpack_pool)
+    {
+        unpack_pool->release();
+    }
+}
+
 //create an empty GL texture: just create a texture name
 //the texture is assiciate with some image by calling glTexImage outside LLImageGL
 BOOL LLImageGL::createGLTexture()
@@ -1538,6 +1645,20 @@ BOOL LLImageGL::createGLTexture(S32 discard_level, const U8* data_in, BOOL data_
 
     bool main_thread = on_main_thread();
 
+    // time the main thread would otherwise have spent here
+    struct ThreadCreateTimer
+    {
+        ThreadCreateTimer(bool main_thread) : mStart(main_thread ? 0 : LLTimer::getTotalTime().value()) {}
+        ~ThreadCreateTimer()
+        {
+            if (mStart)
+            {
+                sThreadCreateTime.fetch_add(LLTimer::getTotalTime().value() - mStart, std::memory_order_relaxed);
+            }
+        }
+        U64 mStart;
+    } thread_create_timer(main_thread);
+
     if (defer_copy)
     {
         data_in = nullptr;
@@ -2426,12 +2547,13 @@ void LLImageGL::checkActiveThread()
 
 std::atomic<S32> LLImageGLThread::sFreeVRAMMegabytes(4096); //if free vram is unknown, default to 4GB
 
-LLImageGLThread::LLImageGLThread(LLWindow* window)
+LLImageGLThread::LLImageGLThread(LLWindow* window, bool unpack_buffers)
     // We want exactly one thread, but a very large capacity: we never want
     // anyone, especially inner-loop render code, to have to block on post()
     // because we're full.
     : ThreadPool("LLImageGL", 1, 1024*1024)
     , mWindow(window)
+    , mUnpackBuffers(unpack_buffers)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
     sEnabled = true;
@@ -2448,7 +2570,13 @@ void LLImageGLThread::run()
     // WorkQueue, likewise cleanup afterwards.
     mWindow->makeContextCurrent(mContext);
     gGL.init(false);
+    LLPixelUnpackPool unpack_pool;
+    if (mUnpackBuffers)
+    {
+        unpack_pool.init();
+    }
     ThreadPool::run();
+    unpack_pool.cleanup();
     gGL.shutdown();
     mWindow->destroySharedContext(mContext);
 }
@@ -2458,3 +2586,140 @@ S32 LLImageGLThread::getFreeVRAMMegabytes()
     return sFreeVRAMMegabytes;
 }
 
+//============================================================================
+
+LLPixelUnpackPool::LLPixelUnpackPool()
+:   mBytesStaged(0),
+    mStalls(0),
+    mNext(0),
+    mStaged(-1)
+{
+    memset(mBuffers, 0, sizeof(mBuffers));
+}
+
+bool LLPixelUnpackPool::init()
+{
+    cleanup();
+
+    if (!gGLManager.mHasSync || !gGLManager.mHasMapBufferRange)
+    {
+        return false;
+    }
+
+    for (U32 i = 0; i < POOL_SIZE; ++i)
+    {
+        glGenBuffersARB(1, &mBuffers[i].mName);
+    }
+
+    sCurrent = this;
+    LL_INFOS("RenderInit") << "Staging texture uploads through " << POOL_SIZE << " pixel unpack buffers." << LL_ENDL;
+    return true;
+}
+
+void LLPixelUnpackPool::cleanup()
+{
+    if (sCurrent == this)
+    {
+        sCurrent = NULL;
+    }
+
+    for (U32 i = 0; i < POOL_SIZE; ++i)
+    {
+        Buffer& buffer = mBuffers[i];
+        if (buffer.mFence)
+        {
+            glDeleteSync(buffer.mFence);
+        }
+        if (buffer.mName)
+        {
+            glDeleteBuffersARB(1, &buffer.mName);
+        }
+    }
+
+    memset(mBuffers, 0, sizeof(mBuffers));
+    mNext = 0;
+    mStaged = -1;
+}
+
+const void* LLPixelUnpackPool::stage(const void* data, U32 size)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    llassert(mStaged == -1);
+
+    if (!data || size == 0 || size > MAX_STAGED_BYTES)
+    {
+        return data;
+    }
+
+    U32 index = acquire();
+    Buffer& buffer = mBuffers[index];
+
+    glBindBufferARB(GL_PIXEL_UNPACK_BUFFER, buffer.mName);
+    if (buffer.mSize < size)
+    { //grow in 256 KB steps so a few large uploads don't keep reallocating
+        buffer.mSize = (size + 0x3FFFF) & ~0x3FFFF;
+        glBufferDataARB(GL_PIXEL_UNPACK_BUFFER, buffer.mSize, NULL, GL_STREAM_DRAW_ARB);
+    }
+
+    // the buffer's fence has signaled, nothing can still be reading it
+    void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (!dst)
+    {
+        log_glerror();
+        glBindBufferARB(GL_PIXEL_UNPACK_BUFFER, 0);
+        return data;
+    }
+
+    memcpy(dst, data, size);
+    glUnmapBufferARB(GL_PIXEL_UNPACK_BUFFER);
+
+    mStaged = index;
+    mNext = (index + 1) % POOL_SIZE;
+    mBytesStaged += size;
+
+    // offset 0 into the bound buffer
+    return NULL;
+}
+
+void LLPixelUnpackPool::release()
+{
+    if (mStaged == -1)
+    {
+        return;
+    }
+
+    mBuffers[mStaged].mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindBufferARB(GL_PIXEL_UNPACK_BUFFER, 0);
+    mStaged = -1;
+}
+
+U32 LLPixelUnpackPool::acquire()
+{
+    // buffers are handed out in turn, but skip ahead past any still in flight
+    for (U32 i = 0; i < POOL_SIZE; ++i)
+    {
+        U32 index = (mNext + i) % POOL_SIZE;
+        Buffer& buffer = mBuffers[index];
+        if (buffer.mFence && glClientWaitSync(buffer.mFence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            continue;
+        }
+
+        if (buffer.mFence)
+        {
+            glDeleteSync(buffer.mFence);
+            buffer.mFence = 0;
+        }
+        return index;
+    }
+
+    // every buffer is in flight, wait for the oldest
+    mStalls++;
+    Buffer& buffer = mBuffers[mNext];
+    while (glClientWaitSync(buffer.mFence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_WAIT_TIME_NANOSECONDS) == GL_TIMEOUT_EXPIRED)
+    {
+    }
+    glDeleteSync(buffer.mFence);
+    buffer.mFence = 0;
+    return mNext;
+}
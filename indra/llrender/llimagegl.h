@@ -107,6 +107,7 @@ public:
 	void setAllowCompression(bool allow) { mAllowCompression = allow; }
 
 	static void setManualImage(U32 target, S32 miplevel, S32 intformat, S32 width, S32 height, U32 pixformat, U32 pixtype, const void *pixels, bool allow_compression = true);
+	static void setCompressedImage(U32 target, S32 miplevel, U32 format, S32 width, S32 height, S32 size, const void* data);
     
 	BOOL createGLTexture() ;
 	BOOL createGLTexture(S32 discard_level, const LLImageRaw* imageraw, S32 usename = 0, BOOL to_create = TRUE,
@@ -270,6 +271,10 @@ public:
 	static S32Bytes sCurBoundTextureMemory;		// Tracks bound texmem for current frame
 	static U32 sBindCount;					// Tracks number of texture binds for current frame
 	static U32 sUniqueCount;				// Tracks number of unique texture binds for current frame
+	static std::atomic<U32> sCreateCount;	// Running total of texture names generated, any thread
+	static std::atomic<U32> sUploadCount;	// Running total of setImage()/setSubImage() uploads, any thread
+	static std::atomic<U64> sUploadBytes;	// Running total of texel bytes handed to GL, any thread
+	static std::atomic<U64> sThreadCreateTime;	// Running total of microseconds spent creating textures off the main thread
 	static BOOL sGlobalUseAnisotropic;
 	static LLImageGL* sDefaultGLTexture ;	
 	static BOOL sAutomatedTest;
@@ -282,7 +287,7 @@ public:
 #endif
 
 public:
-	static void initClass(LLWindow* window, S32 num_catagories, BOOL skip_analyze_alpha = false, bool multi_threaded = false); 
+	static void initClass(LLWindow* window, S32 num_catagories, BOOL skip_analyze_alpha = false, bool multi_threaded = false, bool unpack_buffers = false); 
 	static void cleanupClass() ;
 
 private:
@@ -321,6 +326,68 @@ public:
 
 };
 
+// Pool of pixel unpack buffers texture uploads are staged through.
+//
+// stage() copies the texels into a free buffer and binds it to
+// GL_PIXEL_UNPACK_BUFFER, so the glTexImage2D that follows sources from the
+// buffer instead of client memory and the driver can transfer it without the
+// caller waiting.  release() fences the buffer and unbinds it; a buffer is
+// only written again once its fence has signaled.
+//
+// GL objects belong to a context, so there is one pool per thread that
+// creates textures: the main thread's is set up in LLImageGL::initClass and
+// LLImageGLThread sets up its own.
+class LLPixelUnpackPool
+{
+public:
+    // buffers in flight per pool
+    static const U32 POOL_SIZE = 4;
+    // uploads larger than this go straight from client memory
+    static const U32 MAX_STAGED_BYTES = 4 * 1024 * 1024;
+
+    // pool for the calling thread's context, NULL if uploads are not staged
+    static LLPixelUnpackPool* getCurrent() { return sCurrent; }
+
+    LLPixelUnpackPool();
+
+    // create the pool's buffers and make it current for the calling thread,
+    // returns false if the driver can't fence and map buffers
+    bool init();
+
+    // delete the buffers and fences, the pool is no longer current
+    void cleanup();
+
+    // copy size bytes at data into a buffer and bind it, returns what to
+    // pass to glTex*Image as the pixel pointer (data itself if the upload
+    // was not staged)
+    const void* stage(const void* data, U32 size);
+
+    // fence and unbind the buffer bound by the last stage(), if any
+    void release();
+
+    // bytes uploaded through the pool since init
+    U64 mBytesStaged;
+    // number of uploads that had to wait for the GPU to release a buffer
+    U32 mStalls;
+
+private:
+    // index of a buffer whose last upload has completed
+    U32 acquire();
+
+    struct Buffer
+    {
+        GLuint mName;
+        U32 mSize;
+        GLsync mFence;
+    };
+
+    Buffer mBuffers[POOL_SIZE];
+    U32 mNext;
+    S32 mStaged;
+
+    static thread_local LLPixelUnpackPool* sCurrent;
+};
+
 class LLImageGLThread : public LLSimpleton<LLImageGLThread>, LL::ThreadPool
 {
 public:
@@ -333,7 +400,7 @@ public:
     // free video memory in megabytes
     static std::atomic<S32> sFreeVRAMMegabytes;
 
-    LLImageGLThread(LLWindow* window);
+    LLImageGLThread(LLWindow* window, bool unpack_buffers);
 
     // post a function to be executed on the LLImageGL background thread
     template <typename CALLABLE>
@@ -349,6 +416,7 @@ public:
 private:
     LLWindow* mWindow;
     void* mContext = nullptr;
+    bool mUnpackBuffers;
     LLAtomicBool mFinished;
 };
 
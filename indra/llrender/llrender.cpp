@@ -31,6 +31,7 @@
 #include "llvertexbuffer.h"
 #include "llcubemap.h"
 #include "llglslshader.h"
+#include "llglstatestats.h"
 #include "llimagegl.h"
 #include "llrendertarget.h"
 #include "lltexture.h"
@@ -58,6 +59,7 @@ S32	gGLViewport[4];
 
 U32 LLRender::sUICalls = 0;
 U32 LLRender::sUIVerts = 0;
+U32 LLRender::sUIMergedCalls = 0;
 U32 LLTexUnit::sWhiteTexture = 0;
 bool LLRender::sGLCoreProfile = false;
 bool LLRender::sNsightDebugSupport = false;
@@ -84,6 +86,9 @@ static const GLint sGLAddressMode[] =
 
 const U32 immediate_mask = LLVertexBuffer::MAP_VERTEX | LLVertexBuffer::MAP_COLOR | LLVertexBuffer::MAP_TEXCOORD0;
 
+// vertices LLRender can hold back for one batched UI draw
+const U32 LL_UI_BATCH_VERTICES = 16384;
+
 static const GLenum sGLBlendFactor[] =
 {
 	GL_ONE,
@@ -145,6 +150,11 @@ void LLTexUnit::activate(void)
 		gGL.flush();
 		glActiveTextureARB(GL_TEXTURE0_ARB + mIndex);
 		gGL.mCurrTextureUnitIndex = mIndex;
+		gGLStateStats.count(LLGLStateStats::TEXTURE, true);
+	}
+	else
+	{
+		gGLStateStats.count(LLGLStateStats::TEXTURE, false);
 	}
 }
 
@@ -187,18 +197,37 @@ void LLTexUnit::bindFast(LLTexture* texture)
 {
     LLImageGL* gl_tex = texture->getGLTexture();
 
-    glActiveTextureARB(GL_TEXTURE0_ARB + mIndex);
-    gGL.mCurrTextureUnitIndex = mIndex;
-    mCurrTexture = gl_tex->getTexName();
-    if (!mCurrTexture)
+    // skips the flush and enable of bind(), but not the binding caches
+    bool activate = (S32)gGL.mCurrTextureUnitIndex != mIndex || gGL.mDirty;
+    gGLStateStats.count(LLGLStateStats::TEXTURE, activate);
+    if (activate)
+    {
+        glActiveTextureARB(GL_TEXTURE0_ARB + mIndex);
+        gGL.mCurrTextureUnitIndex = mIndex;
+    }
+
+    U32 texname = gl_tex->getTexName();
+    if (!texname)
     {
         LL_PROFILE_ZONE_NAMED("MISSING TEXTURE");
+        mCurrTexture = 0;
         //if deleted, will re-generate it immediately
         texture->forceImmediateUpdate();
         gl_tex->forceUpdateBindStats();
         texture->bindDefaultImage(mIndex);
+        glBindTexture(sGLTextureType[gl_tex->getTarget()], mCurrTexture);
+        gGLStateStats.count(LLGLStateStats::TEXTURE, true);
+    }
+    else
+    {
+        bool bind = mCurrTexture != texname || gGL.mDirty;
+        gGLStateStats.count(LLGLStateStats::TEXTURE, bind);
+        if (bind)
+        {
+            mCurrTexture = texname;
+            glBindTexture(sGLTextureType[gl_tex->getTarget()], mCurrTexture);
+        }
     }
-    glBindTexture(sGLTextureType[gl_tex->getTarget()], mCurrTexture);
     mHasMipMaps = gl_tex->mHasMipMaps;
 }
 
@@ -208,8 +237,6 @@ bool LLTexUnit::bind(LLTexture* texture, bool for_rendering, bool forceBind)
 	stop_glerror();
 	if (mIndex >= 0)
 	{
-		gGL.flush();
-
 		LLImageGL* gl_tex = NULL ;
 
 		if (texture != NULL && (gl_tex = texture->getGLTexture()))
@@ -217,8 +244,11 @@ bool LLTexUnit::bind(LLTexture* texture, bool for_rendering, bool forceBind)
 			if (gl_tex->getTexName()) //if texture exists
 			{
 				//in audit, replace the selected texture by the default one.
-				if ((mCurrTexture != gl_tex->getTexName()) || forceBind)
+				bool bind = (mCurrTexture != gl_tex->getTexName()) || forceBind;
+				gGLStateStats.count(LLGLStateStats::TEXTURE, bind);
+				if (bind)
 				{
+					gGL.flushTexture(mIndex);
 					activate();
 					enable(gl_tex->getTarget());
 					mCurrTexture = gl_tex->getTexName();
@@ -291,9 +321,11 @@ bool LLTexUnit::bind(LLImageGL* texture, bool for_rendering, bool forceBind, S32
 		return false ;
 	}
 
-	if ((mCurrTexture != texname) || forceBind)
+	bool bind = (mCurrTexture != texname) || forceBind;
+	gGLStateStats.count(LLGLStateStats::TEXTURE, bind);
+	if (bind)
 	{
-		gGL.flush();
+		gGL.flushTexture(mIndex);
 		stop_glerror();
 		activate();
 		stop_glerror();
@@ -332,7 +364,9 @@ bool LLTexUnit::bind(LLCubeMap* cubeMap)
 		return false;
 	}
 
-	if (mCurrTexture != cubeMap->mImages[0]->getTexName())
+	bool bind = mCurrTexture != cubeMap->mImages[0]->getTexName();
+	gGLStateStats.count(LLGLStateStats::TEXTURE, bind);
+	if (bind)
 	{
 		if (gGLManager.mHasCubeMap && LLCubeMap::sUseCubeMaps)
 		{
@@ -391,6 +425,7 @@ bool LLTexUnit::bindManual(eTextureType type, U32 texture, bool hasMips)
 		return false;
 	}
 	
+	gGLStateStats.count(LLGLStateStats::TEXTURE, mCurrTexture != texture);
 	if(mCurrTexture != texture)
 	{
 		gGL.flush();
@@ -413,13 +448,15 @@ void LLTexUnit::unbind(eTextureType type)
 
 	//always flush and activate for consistency 
 	//   some code paths assume unbind always flushes and sets the active texture
-	gGL.flush();
+	//   (inside a UI batch the pending quads are kept instead, see flushTexture)
+	gGL.flushTexture(mIndex);
 	activate();
 
 	// Disabled caching of binding state.
 	if (mCurrTexType == type)
 	{
 		mCurrTexture = 0;
+		gGLStateStats.count(LLGLStateStats::TEXTURE, true);
 
         // Always make sure our texture color space is reset to linear.  SRGB sampling should be opt-in in the vast majority of cases.  Also prevents color space "popping".
         mTexColorSpace = TCS_LINEAR;
@@ -443,6 +480,7 @@ void LLTexUnit::unbindFast(eTextureType type)
     if (mCurrTexType == type)
     {
         mCurrTexture = 0;
+        gGLStateStats.count(LLGLStateStats::TEXTURE, true);
 
         // Always make sure our texture color space is reset to linear.  SRGB sampling should be opt-in in the vast majority of cases.  Also prevents color space "popping".
         mTexColorSpace = TCS_LINEAR;
@@ -828,6 +866,8 @@ LLRender::LLRender()
 	mQuadCycle(0),
     mMode(LLRender::TRIANGLES),
     mCurrTextureUnitIndex(0),
+    mUIBatching(false),
+    mUIBatch(LL_UI_BATCH_VERTICES),
     mMaxAnisotropy(0.f) 
 {	
 	mTexUnits.reserve(LL_NUM_TEXTURE_LAYERS);
@@ -912,12 +952,17 @@ void LLRender::initVertexBuffer()
     mBuffer->getVertexStrider(mVerticesp);
     mBuffer->getTexCoord0Strider(mTexcoordsp);
     mBuffer->getColorStrider(mColorsp);
+    mUIBatchBuffer = new LLVertexBuffer(immediate_mask, GL_STREAM_DRAW_ARB);
+    mUIBatchBuffer->allocateBuffer(LL_UI_BATCH_VERTICES, 0, TRUE);
     stop_glerror();
 }
 
 void LLRender::resetVertexBuffer()
 {
+    mUIBatching = false;
+    mUIBatch.clear();
     mBuffer = NULL;
+    mUIBatchBuffer = NULL;
 }
 
 void LLRender::shutdown()
@@ -1460,8 +1505,10 @@ void LLRender::blendFunc(eBlendFactor sfactor, eBlendFactor dfactor)
 {
 	llassert(sfactor < BF_UNDEF);
 	llassert(dfactor < BF_UNDEF);
-	if (mCurrBlendColorSFactor != sfactor || mCurrBlendColorDFactor != dfactor ||
-	    mCurrBlendAlphaSFactor != sfactor || mCurrBlendAlphaDFactor != dfactor)
+	bool changed = mCurrBlendColorSFactor != sfactor || mCurrBlendColorDFactor != dfactor ||
+				   mCurrBlendAlphaSFactor != sfactor || mCurrBlendAlphaDFactor != dfactor;
+	gGLStateStats.count(LLGLStateStats::BLEND, changed);
+	if (changed)
 	{
 		mCurrBlendColorSFactor = sfactor;
 		mCurrBlendAlphaSFactor = sfactor;
@@ -1485,8 +1532,10 @@ void LLRender::blendFunc(eBlendFactor color_sfactor, eBlendFactor color_dfactor,
 		blendFunc(color_sfactor, color_dfactor);
 		return;
 	}
-	if (mCurrBlendColorSFactor != color_sfactor || mCurrBlendColorDFactor != color_dfactor ||
-	    mCurrBlendAlphaSFactor != alpha_sfactor || mCurrBlendAlphaDFactor != alpha_dfactor)
+	bool changed = mCurrBlendColorSFactor != color_sfactor || mCurrBlendColorDFactor != color_dfactor ||
+				   mCurrBlendAlphaSFactor != alpha_sfactor || mCurrBlendAlphaDFactor != alpha_dfactor;
+	gGLStateStats.count(LLGLStateStats::BLEND, changed);
+	if (changed)
 	{
 		mCurrBlendColorSFactor = color_sfactor;
 		mCurrBlendAlphaSFactor = alpha_sfactor;
@@ -1596,6 +1645,15 @@ void LLRender::end()
 }
 void LLRender::flush()
 {
+	if (!mUIBatch.empty())
+	{ //draw in submission order: the held back quads, then anything pending
+		if (mCount > 0)
+		{
+			batchPendingQuads();
+		}
+		drawUIBatch();
+	}
+
 	if (mCount > 0)
 	{
         LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
@@ -1674,6 +1732,159 @@ void LLRender::flush()
 	}
 }
 
+void LLRender::flushTexture(S32 tex_unit)
+{
+	if (tex_unit != 0 || !mUIBatching || !batchPendingQuads())
+	{
+		flush();
+	}
+}
+
+void LLRender::forgetTextures(S32 count, const U32* textures)
+{
+	//the unit caches belong to the main thread
+	llassert(on_main_thread());
+
+	for (U32 i = 0; i < mTexUnits.size(); ++i)
+	{
+		LLTexUnit* unit = mTexUnits[i];
+		for (S32 j = 0; j < count; ++j)
+		{
+			if (unit->mCurrTexture == textures[j])
+			{ //deleting a bound texture reverts the unit to texture 0
+				unit->mCurrTexture = 0;
+			}
+		}
+	}
+}
+
+void LLRender::beginUIBatch()
+{
+	flush();
+	mUIBatching = mUIBatchBuffer.notNull();
+}
+
+void LLRender::endUIBatch()
+{
+	flush();
+	mUIBatching = false;
+}
+
+// move complete quads drawn with the current unit 0 texture into mUIBatch
+// returns false if there are none or they can't be batched
+bool LLRender::batchPendingQuads()
+{
+	LLTexUnit* unit = mTexUnits[0];
+	U32 count = mCount;
+
+	if (!mUIBatching || count == 0 || mMode != LLRender::QUADS ||
+		unit->mCurrTexType == LLTexUnit::TT_NONE ||
+		count % (sGLCoreProfile ? 6 : 4) != 0)
+	{
+		return false;
+	}
+
+	if (!mUIBatch.hasRoom(count))
+	{
+		drawUIBatch();
+	}
+
+	LLUIBatch::Texture texture;
+	texture.mTarget = LLTexUnit::getInternalType(unit->mCurrTexType);
+	texture.mName = unit->mCurrTexture;
+	if (!texture.mName && unit->mCurrTexType == LLTexUnit::TT_TEXTURE)
+	{ //unbind leaves the white texture bound
+		texture.mName = LLTexUnit::sWhiteTexture;
+	}
+
+	mUIBatch.add(texture, mVerticesp, mTexcoordsp, mColorsp, count);
+
+	//same bookkeeping as a flush
+	mVerticesp[0] = mVerticesp[count];
+	mTexcoordsp[0] = mTexcoordsp[count];
+	mColorsp[0] = mColorsp[count];
+	mCount = 0;
+	if (sGLCoreProfile)
+	{
+		mQuadCycle = 1;
+	}
+
+	return true;
+}
+
+void LLRender::drawUIBatch()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+
+	const std::vector<LLUIBatch::Group>& groups = mUIBatch.sort();
+
+	LLStrider<LLVector3> vertices;
+	LLStrider<LLVector2> texcoords;
+	LLStrider<LLColor4U> colors;
+	U32 total = mUIBatch.getVertexCount();
+	mUIBatchBuffer->getVertexStrider(vertices, 0, total);
+	mUIBatchBuffer->getTexCoord0Strider(texcoords, 0, total);
+	mUIBatchBuffer->getColorStrider(colors, 0, total);
+
+	//lay the runs out in drawing order
+	U32 index = 0;
+	for (U32 i = 0; i < groups.size(); ++i)
+	{
+		const LLUIBatch::Group& group = groups[i];
+		for (U32 j = 0; j < group.mRuns.size(); ++j)
+		{
+			const LLUIBatch::Run& run = mUIBatch.getRun(group.mRuns[j]);
+			for (U32 k = run.mStart; k < run.mStart + run.mCount; ++k, ++index)
+			{
+				vertices[index] = mUIBatch.getVertices()[k];
+				texcoords[index] = mUIBatch.getTexCoords()[k];
+				colors[index] = mUIBatch.getColors()[k];
+			}
+		}
+	}
+
+	mUIBatchBuffer->flush();
+	mUIBatchBuffer->setBuffer(immediate_mask);
+
+	//textures are bound directly so unit 0's cached state stays what the
+	//caller last set, and is restored afterwards
+	if (mCurrTextureUnitIndex != 0)
+	{
+		glActiveTextureARB(GL_TEXTURE0_ARB);
+	}
+
+	U32 mode = sGLCoreProfile ? LLRender::TRIANGLES : LLRender::QUADS;
+	U32 first = 0;
+	for (U32 i = 0; i < groups.size(); ++i)
+	{
+		const LLUIBatch::Group& group = groups[i];
+		glBindTexture(group.mTexture.mTarget, group.mTexture.mName);
+		mUIBatchBuffer->drawArrays(mode, first, group.mCount);
+		first += group.mCount;
+		sUICalls++;
+		sUIVerts += group.mCount;
+	}
+	sUIMergedCalls += mUIBatch.getRunCount() - groups.size();
+
+	LLTexUnit* unit = mTexUnits[0];
+	if (unit->mCurrTexType != LLTexUnit::TT_NONE)
+	{
+		U32 name = unit->mCurrTexture;
+		if (!name && unit->mCurrTexType == LLTexUnit::TT_TEXTURE)
+		{
+			name = LLTexUnit::sWhiteTexture;
+		}
+		glBindTexture(LLTexUnit::getInternalType(unit->mCurrTexType), name);
+	}
+
+	if (mCurrTextureUnitIndex != 0)
+	{
+		glActiveTextureARB(GL_TEXTURE0_ARB + mCurrTextureUnitIndex);
+	}
+
+	mUIBatch.clear();
+}
+
 void LLRender::vertex3f(const GLfloat& x, const GLfloat& y, const GLfloat& z)
 { 
 	//the range of mVerticesp, mColorsp and mTexcoordsp is [0, 4095]
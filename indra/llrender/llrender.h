@@ -43,6 +43,7 @@
 #include "llglheaders.h"
 #include "llmatrix4a.h"
 #include "glh/glh_linear.h"
+#include "lluibatch.h"
 
 class LLVertexBuffer;
 class LLCubeMap;
@@ -392,6 +393,21 @@ public:
 
 	void flush();
 
+	// Called before the texture bound to tex_unit changes.  Flushes, unless
+	// UI batching is on and the pending quads can be kept for a merged draw.
+	void flushTexture(S32 tex_unit);
+
+	// Between beginUIBatch() and endUIBatch(), quads drawn on texture unit 0
+	// are not drawn when only that texture changes; they're collected and
+	// drawn grouped by texture at the next real flush.  See LLUIBatch.
+	void beginUIBatch();
+	void endUIBatch();
+	bool isUIBatching() const { return mUIBatching; }
+
+	// Called after textures are deleted, so no unit skips binding a new
+	// texture that reuses one of the names.  Main thread only.
+	void forgetTextures(S32 count, const U32* textures);
+
 	void begin(const GLuint& mode);
 	void end();
 	void vertex2i(const GLint& x, const GLint& y);
@@ -455,6 +471,7 @@ public:
 public:
 	static U32 sUICalls;
 	static U32 sUIVerts;
+	static U32 sUIMergedCalls; // draw calls saved by UI batching
 	static bool sGLCoreProfile;
 	static bool sNsightDebugSupport;
 	static LLVector2 sUIGLScaleFactor;
@@ -462,6 +479,9 @@ public:
 private:
 	friend class LLLightState;
 
+	bool batchPendingQuads();
+	void drawUIBatch();
+
 	eMatrixMode mMatrixMode;
 	U32 mMatIdx[NUM_MATRIX_MODES];
 	U32 mMatHash[NUM_MATRIX_MODES];
@@ -481,6 +501,9 @@ private:
 	LLStrider<LLVector3>		mVerticesp;
 	LLStrider<LLVector2>		mTexcoordsp;
 	LLStrider<LLColor4U>		mColorsp;
+	bool				mUIBatching;
+	LLUIBatch			mUIBatch;
+	LLPointer<LLVertexBuffer>	mUIBatchBuffer;
 	std::vector<LLTexUnit*>		mTexUnits;
 	LLTexUnit*			mDummyTexUnit;
 	std::vector<LLLightState*> mLightState;
@@ -27,7 +27,11 @@
 #include "linden_common.h"
 #include "llshadermgr.h"
 #include "llrender.h"
+#include "lldir.h"
 #include "llfile.h"
+#include "llmd5.h"
+
+#include <algorithm>
 
 #if LL_DARWIN
 #include "OpenGL/OpenGL.h"
@@ -39,9 +43,34 @@ using std::pair;
 using std::make_pair;
 using std::string;
 
+namespace
+{
+	//we can't have any lines longer than 1024 characters 
+	//or any shaders longer than 4096 lines... deal - DaveP
+	const U32 MAX_EXTRA_CODE_LINES = 1024;
+	const U32 MAX_SHADER_CODE_LINES = 4096 + MAX_EXTRA_CODE_LINES;
+
+	// Each file in the program binary cache starts with this. The key is
+	// repeated so a file can never be taken for another program's.
+	struct ProgramBinaryHeader
+	{
+		U32 mMagic;
+		U32 mVersion;
+		U32 mFormat;
+		U32 mLength;
+		char mKey[MD5HEX_STR_SIZE];
+	};
+	const U32 PROGRAM_BINARY_MAGIC = 0x42504c4c; // "LLPB"
+	const U32 PROGRAM_BINARY_VERSION = 1;
+	// anything larger is a corrupt header
+	const U32 MAX_PROGRAM_BINARY_LENGTH = 64 * 1024 * 1024;
+}
+
 LLShaderMgr * LLShaderMgr::sInstance = NULL;
 
 LLShaderMgr::LLShaderMgr()
+:	mProgramCacheHits(0),
+	mProgramCacheMisses(0)
 {
 }
 
@@ -600,7 +629,7 @@ void LLShaderMgr::dumpObjectLog(GLhandleARB ret, BOOL warns, const std::string&
 	}
  }
 
-GLhandleARB LLShaderMgr::loadShaderFile(const std::string& filename, S32 & shader_level, GLenum type, std::unordered_map<std::string, std::string>* defines, S32 texture_index_channels)
+GLuint LLShaderMgr::readShaderFile(const std::string& filename, S32 shader_level, GLenum type, std::unordered_map<std::string, std::string>* defines, S32 texture_index_channels, GLcharARB** shader_code_text, std::string& open_file_name)
 {
 
 // endsure work-around for missing GLSL funcs gets propogated to feature shader files (e.g. srgbF.glsl)
@@ -611,14 +640,6 @@ GLhandleARB LLShaderMgr::loadShaderFile(const std::string& filename, S32 & shade
     }
 #endif
 
-	GLenum error = GL_NO_ERROR;
-
-	error = glGetError();
-	if (error != GL_NO_ERROR)
-	{
-		LL_SHADER_LOADING_WARNS() << "GL ERROR entering loadShaderFile(): " << error << " for file: " << filename << LL_ENDL;
-	}
-	
 	if (filename.empty()) 
 	{
 		return 0;
@@ -631,7 +652,6 @@ GLhandleARB LLShaderMgr::loadShaderFile(const std::string& filename, S32 & shade
 	S32 try_gpu_class = shader_level;
 	S32 gpu_class;
 
-    std::string open_file_name;
 	//find the most relevant file
 	for (gpu_class = try_gpu_class; gpu_class > 0; gpu_class--)
 	{	//search from the current gpu class down to class 1 to find the most relevant shader
@@ -669,13 +689,9 @@ GLhandleARB LLShaderMgr::loadShaderFile(const std::string& filename, S32 & shade
 		return 0;
 	}
 
-	//we can't have any lines longer than 1024 characters 
-	//or any shaders longer than 4096 lines... deal - DaveP
     GLcharARB buff[1024];
-    GLcharARB *extra_code_text[1024];
-    GLcharARB *shader_code_text[4096 + LL_ARRAY_SIZE(extra_code_text)] = { NULL };
+    GLcharARB *extra_code_text[MAX_EXTRA_CODE_LINES];
     GLuint extra_code_count = 0, shader_code_count = 0;
-    BOOST_STATIC_ASSERT(LL_ARRAY_SIZE(extra_code_text) < LL_ARRAY_SIZE(shader_code_text));
     
     
 	S32 major_version = gGLManager.mGLSLVersionMajor;
@@ -893,7 +909,7 @@ GLhandleARB LLShaderMgr::loadShaderFile(const std::string& filename, S32 & shade
 	GLuint out_of_extra_block_counter = 0, start_shader_code = shader_code_count, file_lines_count = 0;
 	
 	while(NULL != fgets((char *)buff, 1024, file)
-		  && shader_code_count < (LL_ARRAY_SIZE(shader_code_text) - LL_ARRAY_SIZE(extra_code_text)))
+		  && shader_code_count < (MAX_SHADER_CODE_LINES - MAX_EXTRA_CODE_LINES))
 	{
 		file_lines_count++;
 
@@ -915,7 +931,7 @@ GLhandleARB LLShaderMgr::loadShaderFile(const std::string& filename, S32 & shade
 		  
 			//copy extra code
 			for(GLuint n = 0; n < extra_code_count
-				&& shader_code_count < (LL_ARRAY_SIZE(shader_code_text) - LL_ARRAY_SIZE(extra_code_text)); ++n)
+				&& shader_code_count < (MAX_SHADER_CODE_LINES - MAX_EXTRA_CODE_LINES); ++n)
 			{
 				shader_code_text[shader_code_count++] = extra_code_text[n];
 			}
@@ -963,6 +979,62 @@ GLhandleARB LLShaderMgr::loadShaderFile(const std::string& filename, S32 & shade
 
 	fclose(file);
 
+	return shader_code_count;
+}
+
+// static
+std::string LLShaderMgr::hashShaderSource(GLenum type, GLuint shader_code_count, GLcharARB** shader_code_text)
+{
+	LLMD5 md5;
+	md5.update(llformat("%u\n", (U32) type));
+	for (GLuint i = 0; i < shader_code_count; i++)
+	{
+		md5.update((const unsigned char*) shader_code_text[i], (U32) strlen(shader_code_text[i]));
+	}
+	md5.finalize();
+	char digest[MD5HEX_STR_SIZE];
+	md5.hex_digest(digest);
+	return digest;
+}
+
+std::string LLShaderMgr::hashShaderFile(const std::string& filename, S32 shader_level, GLenum type, std::unordered_map<std::string, std::string>* defines, S32 texture_index_channels)
+{
+	GLcharARB *shader_code_text[MAX_SHADER_CODE_LINES] = { NULL };
+	std::string open_file_name;
+	GLuint shader_code_count = readShaderFile(filename, shader_level, type, defines, texture_index_channels, shader_code_text, open_file_name);
+	if (! shader_code_count)
+	{
+		return std::string();
+	}
+
+	std::string hash = hashShaderSource(type, shader_code_count, shader_code_text);
+	for (GLuint i = 0; i < shader_code_count; i++)
+	{
+		free(shader_code_text[i]);
+	}
+	return hash;
+}
+
+GLhandleARB LLShaderMgr::loadShaderFile(const std::string& filename, S32 & shader_level, GLenum type, std::unordered_map<std::string, std::string>* defines, S32 texture_index_channels)
+{
+	GLenum error = GL_NO_ERROR;
+
+	error = glGetError();
+	if (error != GL_NO_ERROR)
+	{
+		LL_SHADER_LOADING_WARNS() << "GL ERROR entering loadShaderFile(): " << error << " for file: " << filename << LL_ENDL;
+	}
+
+	S32 try_gpu_class = shader_level;
+
+	GLcharARB *shader_code_text[MAX_SHADER_CODE_LINES] = { NULL };
+	std::string open_file_name;
+	GLuint shader_code_count = readShaderFile(filename, try_gpu_class, type, defines, texture_index_channels, shader_code_text, open_file_name);
+	if (! shader_code_count)
+	{
+		return 0;
+	}
+
 	//create shader object
 	GLhandleARB ret = glCreateShaderObjectARB(type);
 
@@ -1012,6 +1084,11 @@ GLhandleARB LLShaderMgr::loadShaderFile(const std::string& filename, S32 & shade
 	}
 	stop_glerror();
 
+	if (ret)
+	{
+		mShaderObjectHashes[ret] = hashShaderSource(type, shader_code_count, shader_code_text);
+	}
+
 	//free memory
 	for (GLuint i = 0; i < shader_code_count; i++)
 	{
@@ -1084,6 +1161,176 @@ BOOL LLShaderMgr::validateProgramObject(GLhandleARB obj)
 	return success;
 }
 
+void LLShaderMgr::setProgramCacheDir(const std::string& dir)
+{
+	mProgramCacheDir.clear();
+#if !LL_DARWIN
+	if (dir.empty() || !gGLManager.mHasProgramBinary)
+	{
+		return;
+	}
+
+	// some drivers expose the entry points but have no binary format to offer
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	if (formats <= 0)
+	{
+		LL_INFOS("ShaderLoading") << "Driver supports no program binary formats, not caching shaders" << LL_ENDL;
+		return;
+	}
+
+	if (LLFile::mkdir(dir) != 0)
+	{
+		LL_WARNS("ShaderLoading") << "Could not create shader cache " << dir << LL_ENDL;
+		return;
+	}
+	mProgramCacheDir = dir;
+#endif
+}
+
+std::string LLShaderMgr::getProgramCacheKey(std::vector<std::string> object_hashes, U32 varying_count, const char** varyings) const
+{
+	LLMD5 md5;
+	// a driver update invalidates everything
+	const GLenum driver_strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION };
+	for (GLenum name : driver_strings)
+	{
+		md5.update(ll_safe_string((const char*) glGetString(name)) + "\n");
+	}
+
+	// attachment order doesn't affect the linked program
+	std::sort(object_hashes.begin(), object_hashes.end());
+	for (const std::string& hash : object_hashes)
+	{
+		md5.update(hash + "\n");
+	}
+
+	// bound before linking, so baked into the binary
+	for (const std::string& attrib : mReservedAttribs)
+	{
+		md5.update("attrib " + attrib + "\n");
+	}
+	for (U32 i = 0; i < varying_count; ++i)
+	{
+		md5.update(std::string("varying ") + varyings[i] + "\n");
+	}
+
+	md5.finalize();
+	char digest[MD5HEX_STR_SIZE];
+	md5.hex_digest(digest);
+	return digest;
+}
+
+bool LLShaderMgr::loadProgramBinary(const std::string& key, GLhandleARB program)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
+#if LL_DARWIN
+	return false;
+#else
+	if (mProgramCacheDir.empty())
+	{
+		return false;
+	}
+
+	std::string filename = gDirUtilp->add(mProgramCacheDir, key + ".bin");
+	LLFILE* file = LLFile::fopen(filename, "rb");
+	if (!file)
+	{
+		++mProgramCacheMisses;
+		return false;
+	}
+
+	ProgramBinaryHeader header;
+	std::vector<U8> binary;
+	bool valid = fread(&header, sizeof(header), 1, file) == 1
+		&& header.mMagic == PROGRAM_BINARY_MAGIC
+		&& header.mVersion == PROGRAM_BINARY_VERSION
+		&& header.mLength > 0 && header.mLength <= MAX_PROGRAM_BINARY_LENGTH
+		&& strncmp(header.mKey, key.c_str(), sizeof(header.mKey)) == 0;
+	if (valid)
+	{
+		binary.resize(header.mLength);
+		valid = fread(&binary[0], 1, binary.size(), file) == binary.size();
+	}
+	fclose(file);
+
+	if (valid)
+	{
+		// The driver validates the binary itself: a different driver or
+		// GPU simply fails to link, and we compile from source instead.
+		glProgramBinary(program, header.mFormat, &binary[0], header.mLength);
+		GLint success = GL_FALSE;
+		glGetObjectParameterivARB(program, GL_OBJECT_LINK_STATUS_ARB, &success);
+		valid = success == GL_TRUE;
+	}
+	// clear any error from a rejected binary
+	glGetError();
+
+	if (!valid)
+	{
+		LL_DEBUGS("ShaderLoading") << "Discarding stale program binary " << filename << LL_ENDL;
+		LLFile::remove(filename);
+		++mProgramCacheMisses;
+		return false;
+	}
+
+	++mProgramCacheHits;
+	return true;
+#endif
+}
+
+void LLShaderMgr::saveProgramBinary(const std::string& key, GLhandleARB program)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_SHADER;
+#if !LL_DARWIN
+	if (mProgramCacheDir.empty())
+	{
+		return;
+	}
+
+	GLint length = 0;
+	glGetObjectParameterivARB(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0 || (U32) length > MAX_PROGRAM_BINARY_LENGTH)
+	{
+		return;
+	}
+
+	std::vector<U8> binary(length);
+	GLenum format = 0;
+	GLsizei written = 0;
+	glGetProgramBinary(program, length, &written, &format, &binary[0]);
+	if (glGetError() != GL_NO_ERROR || written <= 0)
+	{
+		return;
+	}
+
+	ProgramBinaryHeader header;
+	memset(&header, 0, sizeof(header));
+	header.mMagic = PROGRAM_BINARY_MAGIC;
+	header.mVersion = PROGRAM_BINARY_VERSION;
+	header.mFormat = format;
+	header.mLength = written;
+	strncpy(header.mKey, key.c_str(), sizeof(header.mKey) - 1);
+
+	// write under a temporary name so a crash or another viewer never
+	// leaves a truncated file under the real one
+	std::string filename = gDirUtilp->add(mProgramCacheDir, key + ".bin");
+	std::string temp_name = filename + ".tmp";
+	LLFILE* file = LLFile::fopen(temp_name, "wb");
+	if (!file)
+	{
+		return;
+	}
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(&binary[0], 1, written, file) == (size_t) written;
+	ok = fclose(file) == 0 && ok;
+	if (!ok || LLFile::rename(temp_name, filename, TRUE) != 0)
+	{
+		LLFile::remove(temp_name, TRUE);
+	}
+#endif
+}
+
 //virtual
 void LLShaderMgr::initAttribsAndUniforms()
 {
@@ -265,6 +265,18 @@ public:
 	BOOL	linkProgramObject(GLhandleARB obj, BOOL suppress_errors = FALSE);
 	BOOL	validateProgramObject(GLhandleARB obj);
 	GLhandleARB loadShaderFile(const std::string& filename, S32 & shader_level, GLenum type, std::unordered_map<std::string, std::string>* defines = NULL, S32 texture_index_channels = -1);
+	// Hash of the source loadShaderFile() would compile for these arguments, without compiling it.
+	// Empty if there is no such file.
+	std::string hashShaderFile(const std::string& filename, S32 shader_level, GLenum type, std::unordered_map<std::string, std::string>* defines = NULL, S32 texture_index_channels = -1);
+
+	// Linked program binaries are cached in dir, keyed by the driver and the hashes of every
+	// shader object in the program. An empty dir (the default) disables the cache.
+	void setProgramCacheDir(const std::string& dir);
+	bool usingProgramCache() const { return !mProgramCacheDir.empty(); }
+	std::string getProgramCacheKey(std::vector<std::string> object_hashes, U32 varying_count, const char** varyings) const;
+	// Replace program's executable with the cached binary for key. False if there is none or the driver rejects it.
+	bool loadProgramBinary(const std::string& key, GLhandleARB program);
+	void saveProgramBinary(const std::string& key, GLhandleARB program);
 
 	// Implemented in the application to actually point to the shader directory.
 	virtual std::string getShaderDirPrefix(void) = 0; // Pure Virtual
@@ -276,6 +288,8 @@ public:
 	// Map of shader names to compiled
     std::map<std::string, GLhandleARB> mVertexShaderObjects;
     std::map<std::string, GLhandleARB> mFragmentShaderObjects;
+	// Source hash of each compiled shader object
+	std::map<GLhandleARB, std::string> mShaderObjectHashes;
 
 	//global (reserved slot) shader parameters
 	std::vector<std::string> mReservedAttribs;
@@ -285,7 +299,15 @@ public:
 	//preprocessor definitions (name/value)
 	std::map<std::string, std::string> mDefinitions;
 
+	// lookups that found or missed a program in the binary cache
+	U32 mProgramCacheHits;
+	U32 mProgramCacheMisses;
+
 protected:
+	GLuint readShaderFile(const std::string& filename, S32 shader_level, GLenum type, std::unordered_map<std::string, std::string>* defines, S32 texture_index_channels, GLcharARB** shader_code_text, std::string& open_file_name);
+	static std::string hashShaderSource(GLenum type, GLuint shader_code_count, GLcharARB** shader_code_text);
+
+	std::string mProgramCacheDir;
 
 	// our parameter manager singleton instance
 	static LLShaderMgr * sInstance;
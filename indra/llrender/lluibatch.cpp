@@ -0,0 +1,121 @@
+/**
+ * @file   lluibatch.cpp
+ * @date   2023-04-17
+ * @brief  Implementation for lluibatch.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "lluibatch.h"
+// STL headers
+// std headers
+// external library headers
+// other Linden headers
+
+namespace
+{
+    // How many groups back a run may look for one with its texture. Past
+    // this a UI frame is usually overlapping everything anyway.
+    const size_t MAX_GROUP_LOOKBACK = 32;
+}
+
+LLUIBatch::LLUIBatch(U32 max_vertices):
+    mMaxVertices(max_vertices)
+{
+    mVertices.reserve(max_vertices);
+    mTexCoords.reserve(max_vertices);
+    mColors.reserve(max_vertices);
+}
+
+void LLUIBatch::add(const Texture& texture, LLStrider<LLVector3>& verts, LLStrider<LLVector2>& uvs,
+                    LLStrider<LLColor4U>& colors, U32 count)
+{
+    if (! count)
+    {
+        return;
+    }
+    llassert(hasRoom(count));
+
+    if (mRuns.empty() || ! (mRuns.back().mTexture == texture))
+    {
+        Run run;
+        run.mTexture = texture;
+        run.mStart = mVertices.size();
+        run.mCount = 0;
+        run.mBounds = LLRectf(verts[0].mV[VX], verts[0].mV[VY], verts[0].mV[VX], verts[0].mV[VY]);
+        mRuns.push_back(run);
+    }
+
+    Run& run = mRuns.back();
+    for (U32 i = 0; i < count; ++i)
+    {
+        const LLVector3& vert = verts[i];
+        run.mBounds.mLeft = llmin(run.mBounds.mLeft, vert.mV[VX]);
+        run.mBounds.mRight = llmax(run.mBounds.mRight, vert.mV[VX]);
+        run.mBounds.mBottom = llmin(run.mBounds.mBottom, vert.mV[VY]);
+        run.mBounds.mTop = llmax(run.mBounds.mTop, vert.mV[VY]);
+        mVertices.push_back(vert);
+        mTexCoords.push_back(uvs[i]);
+        mColors.push_back(colors[i]);
+    }
+    run.mCount += count;
+}
+
+const std::vector<LLUIBatch::Group>& LLUIBatch::sort()
+{
+    mGroups.clear();
+
+    for (U32 r = 0; r < mRuns.size(); ++r)
+    {
+        const Run& run = mRuns[r];
+
+        // Walk back from the most recent group. Joining a group draws this
+        // run before every group after it, which is only safe if it doesn't
+        // overlap any of them.
+        size_t target = mGroups.size();
+        size_t lookback = llmin(mGroups.size(), MAX_GROUP_LOOKBACK);
+        for (size_t i = 0; i < lookback; ++i)
+        {
+            Group& group = mGroups[mGroups.size() - 1 - i];
+            if (group.mTexture == run.mTexture)
+            {
+                target = mGroups.size() - 1 - i;
+                break;
+            }
+            if (overlaps(group.mBounds, run.mBounds))
+            {
+                break;
+            }
+        }
+
+        if (target == mGroups.size())
+        {
+            Group group;
+            group.mTexture = run.mTexture;
+            group.mCount = 0;
+            group.mBounds = run.mBounds;
+            mGroups.push_back(group);
+        }
+
+        Group& group = mGroups[target];
+        group.mRuns.push_back(r);
+        group.mCount += run.mCount;
+        group.mBounds.unionWith(run.mBounds);
+    }
+
+    return mGroups;
+}
+
+void LLUIBatch::clear()
+{
+    mVertices.clear();
+    mTexCoords.clear();
+    mColors.clear();
+    mRuns.clear();
+    mGroups.clear();
+}
@@ -0,0 +1,109 @@
+/**
+ * @file   lluibatch.h
+ * @date   2023-04-17
+ * @brief  Collects immediate mode UI quads across texture changes and
+ *         regroups them by texture where drawing order allows.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_LLUIBATCH_H)
+#define LL_LLUIBATCH_H
+
+#include "llrect.h"
+#include "llstrider.h"
+#include "v2math.h"
+#include "v3math.h"
+#include "v4coloru.h"
+#include <vector>
+
+/**
+ * LLUIBatch holds the vertices of UI quads that LLRender would otherwise
+ * have drawn each time the texture on unit 0 changed. Everything in a batch
+ * was submitted with the same shader, blend state, scissor and matrices
+ * (any change to those flushes the batch), so the only thing that differs
+ * between runs is the texture.
+ *
+ * sort() regroups the runs so that runs sharing a texture are drawn with a
+ * single call. A run may only move ahead of runs it does not overlap on
+ * screen, which keeps alpha blending identical to drawing in submission
+ * order.
+ *
+ * This class does no GL calls; LLRender uploads and draws the groups.
+ */
+class LLUIBatch
+{
+public:
+    /// texture bound to unit 0 for a run
+    struct Texture
+    {
+        U32 mName;
+        U32 mTarget;
+
+        bool operator==(const Texture& other) const
+        {
+            return mName == other.mName && mTarget == other.mTarget;
+        }
+    };
+
+    /// vertices submitted with one texture, in submission order
+    struct Run
+    {
+        Texture mTexture;
+        U32 mStart;
+        U32 mCount;
+        LLRectf mBounds;
+    };
+
+    /// runs to draw with one call, in drawing order
+    struct Group
+    {
+        Texture mTexture;
+        U32 mCount;
+        LLRectf mBounds;
+        std::vector<U32> mRuns;
+    };
+
+    LLUIBatch(U32 max_vertices);
+
+    bool empty() const { return mRuns.empty(); }
+    U32 getVertexCount() const { return mVertices.size(); }
+    U32 getRunCount() const { return mRuns.size(); }
+    /// Can @a count more vertices be added?
+    bool hasRoom(U32 count) const { return mVertices.size() + count <= mMaxVertices; }
+
+    /// Append @a count vertices drawn with @a texture. Consecutive calls
+    /// with the same texture extend the same run.
+    void add(const Texture& texture, LLStrider<LLVector3>& verts, LLStrider<LLVector2>& uvs,
+             LLStrider<LLColor4U>& colors, U32 count);
+
+    /// Group the runs by texture as far as drawing order allows, and return
+    /// the groups in the order they should be drawn.
+    const std::vector<Group>& sort();
+
+    const Run& getRun(U32 index) const { return mRuns[index]; }
+    const LLVector3* getVertices() const { return mVertices.data(); }
+    const LLVector2* getTexCoords() const { return mTexCoords.data(); }
+    const LLColor4U* getColors() const { return mColors.data(); }
+
+    void clear();
+
+private:
+    // strict overlap: quads that only share an edge never cover the same pixel
+    static bool overlaps(const LLRectf& a, const LLRectf& b)
+    {
+        return a.mLeft < b.mRight && b.mLeft < a.mRight &&
+               a.mBottom < b.mTop && b.mBottom < a.mTop;
+    }
+
+    const U32 mMaxVertices;
+    std::vector<LLVector3> mVertices;
+    std::vector<LLVector2> mTexCoords;
+    std::vector<LLColor4U> mColors;
+    std::vector<Run> mRuns;
+    std::vector<Group> mGroups;
+};
+
+#endif /* ! defined(LL_LLUIBATCH_H) */
@@ -35,7 +35,9 @@
 #include "llvector4a.h"
 #include "llshadermgr.h"
 #include "llglslshader.h"
+#include "llglstatestats.h"
 #include "llmemory.h"
+#include "lltracememaccount.h"
 
 //Next Highest Power Of Two
 //helper function, returns first number > v that is a power of 2, or v if v is already a power of 2
@@ -79,6 +81,8 @@ U32 vbo_block_index(U32 size)
 
 const U32 LL_VBO_POOL_SEED_COUNT = vbo_block_index(LL_VBO_POOL_MAX_SEED_SIZE);
 
+const U32 LL_VBO_STREAM_RING_SIZE = 16*1024*1024;
+
 
 //============================================================================
 
@@ -88,6 +92,10 @@ LLVBOPool LLVertexBuffer::sDynamicVBOPool(GL_DYNAMIC_DRAW_ARB, GL_ARRAY_BUFFER_A
 LLVBOPool LLVertexBuffer::sDynamicCopyVBOPool(GL_DYNAMIC_COPY_ARB, GL_ARRAY_BUFFER_ARB);
 LLVBOPool LLVertexBuffer::sStreamIBOPool(GL_STREAM_DRAW_ARB, GL_ELEMENT_ARRAY_BUFFER_ARB);
 LLVBOPool LLVertexBuffer::sDynamicIBOPool(GL_DYNAMIC_DRAW_ARB, GL_ELEMENT_ARRAY_BUFFER_ARB);
+LLVBOStreamRing LLVertexBuffer::sStreamRing;
+
+// Client-side copies of vertex and index data, pooled or in use
+static LLTrace::MemAccount sClientDataMemAccount("LLVertexBuffer");
 
 U32 LLVBOPool::sBytesPooled = 0;
 U32 LLVBOPool::sIndexBytesPooled = 0;
@@ -192,7 +200,7 @@ U8* LLVBOPool::allocate(U32& name, U32 size, bool for_seed)
 			LLVertexBuffer::sAllocatedIndexBytes += size;
 		}
 
-		if (LLVertexBuffer::sDisableVBOMapping || mUsage != GL_DYNAMIC_DRAW_ARB)
+		if (LLVertexBuffer::sDisableVBOMapping || LLVertexBuffer::sStreamRing.isValid() || mUsage != GL_DYNAMIC_DRAW_ARB)
 		{
 			glBufferDataARB(mType, size, 0, mUsage);
 			if (mUsage != GL_DYNAMIC_COPY_ARB)
@@ -208,6 +216,7 @@ U8* LLVBOPool::allocate(U32& name, U32 size, bool for_seed)
 							  << " Pooled Index Bytes: " << sIndexBytesPooled
 							  << LL_ENDL;
 				}
+				sClientDataMemAccount.claim(size);
 			}
 		}
 		else
@@ -261,7 +270,11 @@ void LLVBOPool::release(U32 name, U8* buffer, U32 size)
 	llassert(vbo_block_size(size) == size);
 
 	deleteBuffer(name);
-	ll_aligned_free_fallback((U8*) buffer);
+	if (buffer)
+	{
+		ll_aligned_free_fallback((U8*) buffer);
+		sClientDataMemAccount.disclaim(size);
+	}
 
 	if (mType == GL_ARRAY_BUFFER_ARB)
 	{
@@ -318,6 +331,7 @@ void LLVBOPool::cleanup()
 			if (r.mClientData)
 			{
 				ll_aligned_free<64>((void*) r.mClientData);
+				sClientDataMemAccount.disclaim(size);
 			}
 
 			l.pop_front();
@@ -342,6 +356,178 @@ void LLVBOPool::cleanup()
 }
 
 
+//============================================================================
+
+LLVBOStreamRing::LLVBOStreamRing()
+:	mBytesStreamed(0),
+	mStalls(0),
+	mGLName(0),
+	mMappedData(NULL),
+	mSize(0),
+	mHead(0),
+	mRetired(0),
+	mFenced(0)
+{
+}
+
+bool LLVBOStreamRing::init(U32 size)
+{
+	cleanup();
+
+#ifdef GL_ARB_buffer_storage
+	if (!gGLManager.mHasBufferStorage || size == 0)
+	{
+		return false;
+	}
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffersARB(1, &mGLName);
+	glBindBufferARB(GL_COPY_READ_BUFFER, mGLName);
+	glBufferStorage(GL_COPY_READ_BUFFER, size, NULL, flags);
+	mMappedData = (U8*) glMapBufferRange(GL_COPY_READ_BUFFER, 0, size, flags);
+	glBindBufferARB(GL_COPY_READ_BUFFER, 0);
+
+	if (!mMappedData)
+	{
+		log_glerror();
+		LL_WARNS("RenderInit") << "Failed to map " << size << " byte stream ring, falling back to buffer mapping." << LL_ENDL;
+		glDeleteBuffersARB(1, &mGLName);
+		mGLName = 0;
+		return false;
+	}
+
+	mSize = size;
+	LL_INFOS("RenderInit") << "Uploading stream and dynamic vertex data through a " << size / 1024 << " KB persistent mapped ring." << LL_ENDL;
+	return true;
+#else
+	return false;
+#endif
+}
+
+void LLVBOStreamRing::cleanup()
+{
+#ifdef GL_ARB_buffer_storage
+	for (std::deque<Fence>::iterator iter = mFences.begin(); iter != mFences.end(); ++iter)
+	{
+		glDeleteSync(iter->mSync);
+	}
+	mFences.clear();
+
+	if (mGLName)
+	{
+		if (mMappedData)
+		{
+			glBindBufferARB(GL_COPY_READ_BUFFER, mGLName);
+			glUnmapBufferARB(GL_COPY_READ_BUFFER);
+			glBindBufferARB(GL_COPY_READ_BUFFER, 0);
+		}
+		glDeleteBuffersARB(1, &mGLName);
+	}
+#endif
+
+	mGLName = 0;
+	mMappedData = NULL;
+	mSize = 0;
+	mHead = 0;
+	mRetired = 0;
+	mFenced = 0;
+}
+
+bool LLVBOStreamRing::upload(U32 name, U32 offset, U32 size, const U8* data)
+{
+	llassert(isValid());
+
+#ifdef GL_ARB_buffer_storage
+	if (size > mSize / 4)
+	{ //too big to share the ring with anything else
+		return false;
+	}
+
+	if (size == 0)
+	{
+		return true;
+	}
+
+	U32 src = allocate(size);
+	memcpy(mMappedData + src, data, size);
+
+	// the ring is coherently mapped, so the copy sees the memcpy above
+	glBindBufferARB(GL_COPY_READ_BUFFER, mGLName);
+	glBindBufferARB(GL_COPY_WRITE_BUFFER, name);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, src, offset, size);
+
+	mBytesStreamed += size;
+
+	if (mHead - mFenced >= mSize / 8)
+	{
+		placeFence();
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+U32 LLVBOStreamRing::allocate(U32 size)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VERTEX;
+
+	// keep uploads 64 byte aligned and never split one across the end of the ring
+	U64 start = (mHead + 63) & ~((U64) 63);
+	if (start % mSize + size > mSize)
+	{
+		start += mSize - start % mSize;
+	}
+	U64 end = start + size;
+
+#ifdef GL_ARB_buffer_storage
+	// the space between mRetired and mHead may still be read by copies in flight,
+	// retire fences until everything we're about to overwrite is free
+	bool stalled = false;
+	while (end > mRetired + mSize)
+	{
+		if (mFences.empty())
+		{ //nothing fenced yet covers the space we need
+			placeFence();
+		}
+
+		Fence& fence = mFences.front();
+		if (glClientWaitSync(fence.mSync, 0, 0) == GL_TIMEOUT_EXPIRED)
+		{
+			stalled = true;
+			while (glClientWaitSync(fence.mSync, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_WAIT_TIME_NANOSECONDS) == GL_TIMEOUT_EXPIRED)
+			{
+			}
+		}
+
+		mRetired = fence.mEnd;
+		glDeleteSync(fence.mSync);
+		mFences.pop_front();
+	}
+
+	if (stalled)
+	{
+		mStalls++;
+	}
+#endif
+
+	mHead = end;
+	return (U32) (start % mSize);
+}
+
+void LLVBOStreamRing::placeFence()
+{
+#ifdef GL_ARB_buffer_storage
+	Fence fence;
+	fence.mSync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	fence.mEnd = mHead;
+	mFences.push_back(fence);
+#endif
+	mFenced = mHead;
+}
+
 //NOTE: each component must be AT LEAST 4 bytes in size to avoid a performance penalty on AMD hardware
 const S32 LLVertexBuffer::sTypeSize[LLVertexBuffer::TYPE_MAX] =
 {
@@ -647,6 +833,33 @@ void LLVertexBuffer::drawRangeFast(U32 mode, U32 start, U32 end, U32 count, U32
             idx);
 }
 
+void LLVertexBuffer::drawMultiFast(U32 mode, const S32* counts, const U32* indices_offsets, U32 draw_count) const
+{
+    mMappable = false;
+    gGL.syncMatrices();
+
+    U16* idx = (U16*)getIndicesPointer();
+
+    if (!gGLManager.mHasMultiDrawElements)
+    {
+        for (U32 i = 0; i < draw_count; ++i)
+        {
+            glDrawElements(sGLMode[mode], counts[i], GL_UNSIGNED_SHORT, idx + indices_offsets[i]);
+        }
+        return;
+    }
+
+    static thread_local std::vector<const GLvoid*> indices;
+    indices.resize(draw_count);
+    for (U32 i = 0; i < draw_count; ++i)
+    {
+        indices[i] = idx + indices_offsets[i];
+    }
+
+    LL_PROFILER_GPU_ZONEC("gl.MultiDrawElements", 0xFFFF00)
+        glMultiDrawElements(sGLMode[mode], counts, GL_UNSIGNED_SHORT, indices.data(), draw_count);
+}
+
 void LLVertexBuffer::draw(U32 mode, U32 count, U32 indices_offset) const
 {
 	llassert(LLGLSLShader::sCurBoundShaderPtr != NULL);
@@ -746,10 +959,22 @@ void LLVertexBuffer::drawArrays(U32 mode, U32 first, U32 count) const
 }
 
 //static
-void LLVertexBuffer::initClass(bool use_vbo, bool no_vbo_mapping)
+void LLVertexBuffer::initClass(bool use_vbo, bool no_vbo_mapping, bool use_stream_ring)
 {
 	sEnableVBOs = use_vbo && gGLManager.mHasVertexBufferObject;
 	sDisableVBOMapping = sEnableVBOs && no_vbo_mapping;
+
+	if (sEnableVBOs && use_stream_ring && gGLManager.mHasBufferStorage)
+	{
+		if (!sStreamRing.isValid())
+		{
+			sStreamRing.init(LL_VBO_STREAM_RING_SIZE);
+		}
+	}
+	else
+	{
+		sStreamRing.cleanup();
+	}
 }
 
 //static 
@@ -792,6 +1017,7 @@ void LLVertexBuffer::cleanupClass()
 	sStreamVBOPool.cleanup();
 	sDynamicVBOPool.cleanup();
 	sDynamicCopyVBOPool.cleanup();
+	sStreamRing.cleanup();
 }
 
 //----------------------------------------------------------------------------
@@ -863,7 +1089,7 @@ LLVertexBuffer::LLVertexBuffer(U32 typemask, S32 usage)
 	mMappable(false),
 	mFence(NULL)
 {
-	mMappable = (mUsage == GL_DYNAMIC_DRAW_ARB && !sDisableVBOMapping);
+	mMappable = (mUsage == GL_DYNAMIC_DRAW_ARB && !sDisableVBOMapping && !sStreamRing.isValid());
 
 	//zero out offsets
 	for (U32 i = 0; i < TYPE_MAX; i++)
@@ -1081,6 +1307,10 @@ bool LLVertexBuffer::createGLBuffer(U32 size)
 		mGLBuffer = ++gl_buffer_idx;
 		mMappedData = (U8*)ll_aligned_malloc_16(size);
 		mSize = size;
+		if (mMappedData)
+		{
+			sClientDataMemAccount.claim(size);
+		}
 	}
 
 	if (!mMappedData)
@@ -1123,6 +1353,10 @@ bool LLVertexBuffer::createGLIndices(U32 size)
 		static int gl_buffer_idx = 0;
 		mGLIndices = ++gl_buffer_idx;
 		mIndicesSize = size;
+		if (mMappedIndexData)
+		{
+			sClientDataMemAccount.claim(size);
+		}
 	}
 
 	if (!mMappedIndexData)
@@ -1142,6 +1376,10 @@ void LLVertexBuffer::destroyGLBuffer()
 		}
 		else
 		{
+			if (mMappedData)
+			{
+				sClientDataMemAccount.disclaim(mSize);
+			}
 			ll_aligned_free_16((void*)mMappedData);
 			mMappedData = NULL;
 			mEmpty = true;
@@ -1162,6 +1400,10 @@ void LLVertexBuffer::destroyGLIndices()
 		}
 		else
 		{
+			if (mMappedIndexData)
+			{
+				sClientDataMemAccount.disclaim(mIndicesSize);
+			}
 			ll_aligned_free_16((void*)mMappedIndexData);
 			mMappedIndexData = NULL;
 			mEmpty = true;
@@ -1770,6 +2012,17 @@ U8* LLVertexBuffer::mapIndexBuffer(S32 index, S32 count, bool map_range)
 	}
 }
 
+// copy client side data to the given buffer, which is bound to target, through
+// the stream ring when there is one
+static void upload_buffer_data(U32 target, U32 name, S32 offset, S32 length, const U8* data)
+{
+	if (!LLVertexBuffer::sStreamRing.isValid() ||
+		!LLVertexBuffer::sStreamRing.upload(name, offset, length, data))
+	{
+		glBufferSubDataARB(target, offset, length, data);
+	}
+}
+
 void LLVertexBuffer::unmapBuffer()
 {
 	if (!useVBOs())
@@ -1797,7 +2050,7 @@ void LLVertexBuffer::unmapBuffer()
 					S32 length = sTypeSize[region.mType]*region.mCount;
 					if (mSize >= length + offset)
 					{
-						glBufferSubDataARB(GL_ARRAY_BUFFER_ARB, offset, length, (U8*)mMappedData + offset);
+						upload_buffer_data(GL_ARRAY_BUFFER_ARB, mGLBuffer, offset, length, (U8*) mMappedData + offset);
 					}
 					else
 					{
@@ -1818,7 +2071,7 @@ void LLVertexBuffer::unmapBuffer()
 			else
 			{
 				stop_glerror();
-				glBufferSubDataARB(GL_ARRAY_BUFFER_ARB, 0, getSize(), (U8*) mMappedData);
+				upload_buffer_data(GL_ARRAY_BUFFER_ARB, mGLBuffer, 0, getSize(), (U8*) mMappedData);
 				stop_glerror();
 			}
 		}
@@ -1877,7 +2130,7 @@ void LLVertexBuffer::unmapBuffer()
 					S32 length = sizeof(U16)*region.mCount;
 					if (mIndicesSize >= length + offset)
 					{
-						glBufferSubDataARB(GL_ELEMENT_ARRAY_BUFFER_ARB, offset, length, (U8*) mMappedIndexData+offset);
+						upload_buffer_data(GL_ELEMENT_ARRAY_BUFFER_ARB, mGLIndices, offset, length, (U8*) mMappedIndexData+offset);
 					}
 					else
 					{
@@ -1898,7 +2151,7 @@ void LLVertexBuffer::unmapBuffer()
 			else
 			{
 				stop_glerror();
-				glBufferSubDataARB(GL_ELEMENT_ARRAY_BUFFER_ARB, 0, getIndicesSize(), (U8*) mMappedIndexData);
+				upload_buffer_data(GL_ELEMENT_ARRAY_BUFFER_ARB, mGLIndices, 0, getIndicesSize(), (U8*) mMappedIndexData);
 				stop_glerror();
 			}
 		}
@@ -2244,7 +2497,7 @@ void LLVertexBuffer::setBuffer(U32 data_mask)
 	{
 		if (mGLArray)
 		{
-			bindGLArray();
+			gGLStateStats.count(LLGLStateStats::BUFFER, bindGLArray());
 			setup = false; //do NOT perform pointer setup if using VAO
 		}
 		else
@@ -2252,6 +2505,12 @@ void LLVertexBuffer::setBuffer(U32 data_mask)
 			const bool bindBuffer = bindGLBuffer();
 			const bool bindIndices = bindGLIndices();
 			
+			gGLStateStats.count(LLGLStateStats::BUFFER, bindBuffer);
+			if (mGLIndices)
+			{
+				gGLStateStats.count(LLGLStateStats::BUFFER, bindIndices);
+			}
+
 			setup = setup || bindBuffer || bindIndices;
 		}
 
@@ -2355,6 +2614,9 @@ void LLVertexBuffer::setBufferFast(U32 data_mask)
         const bool bindBuffer = bindGLBufferFast();
         const bool bindIndices = bindGLIndicesFast();
 
+        gGLStateStats.count(LLGLStateStats::BUFFER, bindBuffer);
+        gGLStateStats.count(LLGLStateStats::BUFFER, bindIndices);
+
         setup = setup || bindBuffer || bindIndices;
         
         setupClientArrays(data_mask);
@@ -35,6 +35,7 @@
 #include "llstrider.h"
 #include "llrender.h"
 #include "lltrace.h"
+#include <deque>
 #include <set>
 #include <vector>
 #include <list>
@@ -94,6 +95,64 @@ public:
 	static U32 sNameIdx;
 };
 
+//============================================================================
+// persistently mapped staging buffer for stream and dynamic uploads
+// (GL_ARB_buffer_storage)
+//
+// Uploads are copied into the ring with memcpy and then moved into their
+// destination buffer with glCopyBufferSubData, so updating a buffer never
+// maps it or waits on it.  The ring is reused front to back; a fence is
+// placed after every eighth of the ring has been handed out, and space is
+// only reused once the fence covering it has signaled.
+class LLVBOStreamRing
+{
+public:
+	LLVBOStreamRing();
+
+	//create and map the ring, returns false if the driver can't provide one
+	bool init(U32 size);
+
+	//unmap and delete the ring and any outstanding fences
+	void cleanup();
+
+	bool isValid() const { return mMappedData != NULL; }
+	U32 getSize() const { return mSize; }
+
+	//copy size bytes at data to offset in the buffer object name
+	//uses the GL_COPY_READ_BUFFER and GL_COPY_WRITE_BUFFER bindings, so the
+	//array and element array bindings are left alone
+	//returns false if the upload is too large for the ring, in which case
+	//the caller should fall back to glBufferSubData
+	bool upload(U32 name, U32 offset, U32 size, const U8* data);
+
+	//bytes uploaded through the ring since startup
+	U64 mBytesStreamed;
+	//number of uploads that had to wait for the GPU to release ring space
+	U32 mStalls;
+
+private:
+	//reserve size bytes of ring space, returns the offset into the ring
+	U32 allocate(U32 size);
+	void placeFence();
+
+#ifdef GL_ARB_buffer_storage
+	struct Fence
+	{
+		GLsync mSync;
+		U64 mEnd; //ring position covered by this fence
+	};
+	std::deque<Fence> mFences;
+#endif
+
+	U32 mGLName;
+	U8* mMappedData;
+	U32 mSize;
+	//monotonic ring positions; the offset into the ring is position % mSize
+	U64 mHead;
+	U64 mRetired; //everything before this position is free to overwrite
+	U64 mFenced; //position of the most recent fence
+};
+
 
 //============================================================================
 // base class 
@@ -137,12 +196,15 @@ public:
 	static bool sUseVAO;
 	static bool	sPreferStreamDraw;
 
+	//staging ring for stream and dynamic uploads, valid only when enabled in initClass
+	static LLVBOStreamRing sStreamRing;
+
 	static void seedPools();
 
 	static U32 getVAOName();
 	static void releaseVAOName(U32 name);
 
-	static void initClass(bool use_vbo, bool no_vbo_mapping);
+	static void initClass(bool use_vbo, bool no_vbo_mapping, bool use_stream_ring = false);
 	static void cleanupClass();
 	static void setupClientArrays(U32 data_mask);
 	static void drawArrays(U32 mode, const std::vector<LLVector3>& pos);
@@ -296,6 +358,9 @@ public:
     //implementation for inner loops that does no safety checking
     void drawRangeFast(U32 mode, U32 start, U32 end, U32 count, U32 indices_offset) const;
 
+    //draw draw_count index ranges with one glMultiDrawElements, no safety checking
+    void drawMultiFast(U32 mode, const S32* counts, const U32* indices_offsets, U32 draw_count) const;
+
 	//for debugging, validate data in given range is valid
 	void validateRange(U32 start, U32 end, U32 count, U32 offset) const;
 
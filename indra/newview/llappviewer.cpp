@@ -69,7 +69,10 @@
 #endif
 #include "lltexturestats.h"
 #include "lltrace.h"
+#include "lltracehitchcapture.h"
+#include "lltracememaccount.h"
 #include "lltracethreadrecorder.h"
+#include "lltracetimeline.h"
 #include "llviewerwindow.h"
 #include "llviewerdisplay.h"
 #include "llviewermedia.h"
@@ -113,6 +116,7 @@
 #include "llavatarnamecache.h"
 #include "lldiriterator.h"
 #include "llexperiencecache.h"
+#include "llimagegl.h"
 #include "llimagej2c.h"
 #include "llmemory.h"
 #include "llprimitive.h"
@@ -758,6 +762,9 @@ bool LLAppViewer::init()
 	//set the max heap size.
 	initMaxHeapSize() ;
 	LLCoros::instance().setStackSize(gSavedSettings.getS32("CoroutineStackSize"));
+	LLCoros::instance().setStackPoolSize(gSavedSettings.getU32("CoroutineStackPoolSize"));
+	LLTrace::Timeline::setThreadName("main");
+	LLTrace::Timeline::setEnabled(gSavedSettings.getBOOL("TimelineTraceEnabled"));
 
 
 	// Although initLoggingAndGetLastDuration() is the right place to mess with
@@ -1389,13 +1396,18 @@ bool LLAppViewer::doFrame()
 
 	{
         LL_PROFILE_ZONE_NAMED_CATEGORY_APP("df LLTrace");
-        if (LLFloaterReg::instanceVisible("block_timers"))
+        // hitch capture needs the timer tree kept up to date too
+        if (LLFloaterReg::instanceVisible("block_timers") || mHitchCapture)
         {
 	LLTrace::BlockTimer::processTimes();
         }
         
+	// before nextPeriod(), so the sizes land in the frame just ending
+	LLTrace::MemAccount::updateStats();
 	LLTrace::get_frame_recording().nextPeriod();
 	LLTrace::BlockTimer::logStats();
+	checkTimelineSpike();
+	captureHitchFrame();
 	}
 
 	LLTrace::get_thread_recorder()->pullFromChildren();
@@ -1676,6 +1688,116 @@ bool LLAppViewer::doFrame()
 	return ! LLApp::isRunning();
 }
 
+void LLAppViewer::saveTimelineTrace(const std::string& prefix)
+{
+	std::string filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS,
+		llformat("%s_%u.json", prefix.c_str(), gFrameCount));
+	LLTrace::Timeline::writeChromeTrace(filename);
+}
+
+namespace
+{
+	// Writing a trace or capture is itself slow; don't let a run of bad
+	// frames turn into a run of files.
+	class SpikeSaveLimiter
+	{
+	public:
+		bool allow()
+		{
+			F64 now = LLTimer::getTotalSeconds();
+			if (mSaved >= MAX_SAVES || now - mLastSaved < MIN_INTERVAL)
+			{
+				return false;
+			}
+			mLastSaved = now;
+			++mSaved;
+			return true;
+		}
+
+	private:
+		static constexpr F64 MIN_INTERVAL = 10.0;
+		static constexpr U32 MAX_SAVES = 20;
+		F64 mLastSaved = -MIN_INTERVAL;
+		U32 mSaved = 0;
+	};
+
+	// one limit shared by timeline spike traces and hitch captures
+	SpikeSaveLimiter sSpikeSaveLimiter;
+}
+
+void LLAppViewer::checkTimelineSpike()
+{
+	static LLCachedControl<F32> spike_threshold(gSavedSettings, "TimelineSpikeThreshold", 0.f);
+	if (!LLTrace::Timeline::isEnabled()
+		|| spike_threshold <= 0.f
+		|| LLStartUp::getStartupState() != STATE_STARTED
+		|| gFrameIntervalSeconds.value() * 1000.f < spike_threshold)
+	{
+		return;
+	}
+
+	if (!sSpikeSaveLimiter.allow())
+	{
+		return;
+	}
+
+	LL_INFOS("Timeline") << "Frame took " << gFrameIntervalSeconds.value() * 1000.f
+						 << " ms, saving timeline trace" << LL_ENDL;
+	saveTimelineTrace("timeline_spike");
+}
+
+void LLAppViewer::captureHitchFrame()
+{
+	static LLCachedControl<bool> capture_enabled(gSavedSettings, "HitchCaptureEnabled", false);
+	static LLCachedControl<U32> capture_frames(gSavedSettings, "HitchCaptureFrames", 120);
+	static LLCachedControl<F32> hitch_threshold(gSavedSettings, "HitchCaptureThreshold", 0.f);
+	if (!capture_enabled)
+	{
+		mHitchCapture.reset();
+		return;
+	}
+	if (!mHitchCapture)
+	{
+		mHitchCapture.reset(new LLTrace::HitchCapture(capture_frames));
+		mHitchCapture->addCounter("textures created",
+			[]{ return U64(LLImageGL::sCreateCount.load(std::memory_order_relaxed)); });
+		mHitchCapture->addCounter("GL uploads",
+			[]{ return U64(LLImageGL::sUploadCount.load(std::memory_order_relaxed)); });
+		mHitchCapture->addCounter("objects updated",
+			[]{ return U64(gObjectList.mNumIdleUpdates); });
+		mHitchCapture->addCounter("meshes decoded",
+			[]{ return U64(LLMeshRepository::sLODDecodeCount.load(std::memory_order_relaxed)); });
+		// processTimes() hasn't been maintaining the timer tree; start
+		// capturing next frame.
+		return;
+	}
+	if (mHitchCapture->getFrameCount() != capture_frames)
+	{
+		mHitchCapture->setFrameCount(capture_frames);
+	}
+
+	LLTrace::Recording& last_frame = LLTrace::get_frame_recording().getLastRecording();
+	mHitchCapture->captureFrame(gFrameCount, last_frame);
+
+	F32 frame_ms = F32(last_frame.getDuration().value() * 1000.0);
+	if (hitch_threshold <= 0.f
+		|| LLStartUp::getStartupState() != STATE_STARTED
+		|| frame_ms < hitch_threshold)
+	{
+		return;
+	}
+
+	if (!sSpikeSaveLimiter.allow())
+	{
+		return;
+	}
+
+	LL_INFOS("HitchCapture") << "Frame took " << frame_ms << " ms, saving last "
+							 << mHitchCapture->size() << " frames" << LL_ENDL;
+	mHitchCapture->write(gDirUtilp->getExpandedFilename(LL_PATH_LOGS,
+		llformat("hitch_%u.llhc", gFrameCount)));
+}
+
 S32 LLAppViewer::updateTextureThreads(F32 max_time)
 {
 	S32 work_pending = 0;
@@ -2173,6 +2295,9 @@ bool LLAppViewer::cleanup()
 
     LL_INFOS() << "Goodbye!" << LL_ENDL;
 
+	// write out anything still queued and stop the log writer thread
+	LLError::setAsyncLogging(false);
+
 	removeDumpDir();
 
 	// return 0;
@@ -2203,7 +2328,9 @@ bool LLAppViewer::initThreads()
 
 	LLImage::initClass(gSavedSettings.getBOOL("TextureNewByteRange"),gSavedSettings.getS32("TextureReverseByteRange"));
 
-	LLLFSThread::initClass(enable_threads && false);
+	LLLFSThread::initClass(enable_threads && false,
+						   gSavedSettings.getU32("LFSQueueDepth"),
+						   gSavedSettings.getBOOL("LFSUseIOUring"));
 
 	// Image decoding
 	LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(enable_threads && true);
@@ -4450,6 +4577,11 @@ void LLAppViewer::purgeCache()
 		// cef does not support clear_cache and clear_cookies, so clear what we can manually.
 		gDirUtilp->deleteDirAndContents(browser_cache);
 	}
+	std::string shader_cache = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "shader_cache");
+	if (LLFile::isdir(shader_cache))
+	{
+		gDirUtilp->deleteDirAndContents(shader_cache);
+	}
 	gDirUtilp->deleteFilesInDir(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, ""), "*");
 }
 
@@ -51,6 +51,7 @@
 #include "llappcorehttp.h"
 
 #include <boost/signals2.hpp>
+#include <memory>
 
 class LLCommandLineParser;
 class LLFrameTimer;
@@ -68,6 +69,11 @@ namespace LL
     class ThreadPool;
 }
 
+namespace LLTrace
+{
+    class HitchCapture;
+}
+
 extern LLTrace::BlockTimerStatHandle FTM_FRAME;
 
 class LLAppViewer : public LLApp
@@ -192,6 +198,10 @@ public:
 	void resumeMainloopTimeout(const std::string& state = "", F32 secs = -1.0f);
 	void pingMainloopTimeout(const std::string& state, F32 secs = -1.0f);
 
+	// Write recorded LLTrace::Timeline events to a Chrome trace file in the
+	// logs directory.
+	void saveTimelineTrace(const std::string& prefix);
+
 	// Handle the 'login completed' event.
 	// *NOTE:Mani Fix this for login abstraction!!
 	void handleLoginComplete();
@@ -247,6 +257,8 @@ protected:
 private:
 
 	bool doFrame();
+	void checkTimelineSpike(); // save the timeline if the last frame ran long
+	void captureHitchFrame(); // keep the last frame's timers, save them all if it ran long
 
 	void initMaxHeapSize();
 	bool initThreads(); // Initialize viewer threads, return false on failure.
@@ -323,6 +335,8 @@ private:
 
 	// For performance and metric gathering
 	class LLThread*	mFastTimerLogThread;
+	// recent frames' timer trees, while HitchCaptureEnabled
+	std::unique_ptr<LLTrace::HitchCapture> mHitchCapture;
 
 	// for tracking viewer<->region circuit death
 	bool mAgentRegionLastAlive;
@@ -126,6 +126,34 @@ LLDrawPool *LLDrawPool::createPool(const U32 type, LLViewerTexture *tex0)
 	return poolp;
 }
 
+//static
+const char* LLDrawPool::getTypeName(U32 type)
+{
+	switch (type)
+	{
+	case POOL_SIMPLE:					return "Simple";
+	case POOL_GROUND:					return "Ground";
+	case POOL_FULLBRIGHT:				return "Fullbright";
+	case POOL_BUMP:						return "Bump";
+	case POOL_MATERIALS:				return "Materials";
+	case POOL_TERRAIN:					return "Terrain";
+	case POOL_SKY:						return "Sky";
+	case POOL_WL_SKY:					return "WL Sky";
+	case POOL_TREE:						return "Tree";
+	case POOL_ALPHA_MASK:				return "Alpha Mask";
+	case POOL_FULLBRIGHT_ALPHA_MASK:	return "Fullbright Alpha Mask";
+	case POOL_GRASS:					return "Grass";
+	case POOL_INVISIBLE:				return "Invisible";
+	case POOL_AVATAR:					return "Avatar";
+	case POOL_CONTROL_AV:				return "Animesh";
+	case POOL_VOIDWATER:				return "Void Water";
+	case POOL_WATER:					return "Water";
+	case POOL_GLOW:						return "Glow";
+	case POOL_ALPHA:					return "Alpha";
+	default:							return "Other";
+	}
+}
+
 LLDrawPool::LLDrawPool(const U32 type)
 {
 	mType = type;
@@ -376,6 +404,9 @@ void LLFacePool::LLOverrideFaceColor::setColor(F32 r, F32 g, F32 b, F32 a)
 //=============================
 // Render Pass Implementation
 //=============================
+U32 LLRenderPass::sDrawInfoCount = 0;
+U32 LLRenderPass::sDrawInfoCalls = 0;
+
 LLRenderPass::LLRenderPass(const U32 type)
 : LLDrawPool(type)
 {
@@ -427,16 +458,35 @@ void LLRenderPass::renderRiggedGroup(LLSpatialGroup* group, U32 type, U32 mask,
     }
 }
 
+// static
+LLDrawInfo** LLRenderPass::getMultiDrawEnd(LLDrawInfo** begin, LLDrawInfo** end)
+{
+	LLDrawInfo** last = begin + 1;
+	if (LLPipeline::RenderMultiDrawBatches)
+	{
+		while (last != end && *last && (*last)->canMultiDraw(**begin))
+		{
+			++last;
+		}
+	}
+	return last;
+}
+
 void LLRenderPass::pushBatches(U32 type, U32 mask, BOOL texture, BOOL batch_textures)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
-	for (LLCullResult::drawinfo_iterator i = gPipeline.beginRenderMap(type); i != gPipeline.endRenderMap(type); ++i)	
+	LLCullResult::drawinfo_iterator end = gPipeline.endRenderMap(type);
+	for (LLCullResult::drawinfo_iterator i = gPipeline.beginRenderMap(type); i != end; )
 	{
-		LLDrawInfo* pparams = *i;
-		if (pparams) 
+		if (!*i)
 		{
-			pushBatch(*pparams, mask, texture, batch_textures);
+			++i;
+			continue;
 		}
+
+		LLCullResult::drawinfo_iterator last = getMultiDrawEnd(i, end);
+		pushMultiBatch(i, last - i, mask, texture, batch_textures);
+		i = last;
 	}
 }
 
@@ -466,14 +516,20 @@ void LLRenderPass::pushRiggedBatches(U32 type, U32 mask, BOOL texture, BOOL batc
 void LLRenderPass::pushMaskBatches(U32 type, U32 mask, BOOL texture, BOOL batch_textures)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
-	for (LLCullResult::drawinfo_iterator i = gPipeline.beginRenderMap(type); i != gPipeline.endRenderMap(type); ++i)	
+	LLCullResult::drawinfo_iterator end = gPipeline.endRenderMap(type);
+	for (LLCullResult::drawinfo_iterator i = gPipeline.beginRenderMap(type); i != end; )
 	{
-		LLDrawInfo* pparams = *i;
-		if (pparams) 
+		if (!*i)
 		{
-			LLGLSLShader::sCurBoundShaderPtr->setMinimumAlpha(pparams->mAlphaMaskCutoff);
-			pushBatch(*pparams, mask, texture, batch_textures);
+			++i;
+			continue;
 		}
+
+		// every LLDrawInfo in a run has the same cutoff
+		LLGLSLShader::sCurBoundShaderPtr->setMinimumAlpha((*i)->mAlphaMaskCutoff);
+		LLCullResult::drawinfo_iterator last = getMultiDrawEnd(i, end);
+		pushMultiBatch(i, last - i, mask, texture, batch_textures);
+		i = last;
 	}
 }
 
@@ -533,41 +589,8 @@ void LLRenderPass::pushBatch(LLDrawInfo& params, U32 mask, BOOL texture, BOOL ba
 
 	applyModelMatrix(params);
 
-	bool tex_setup = false;
+	bool tex_setup = texture && bindBatchTextures(params, batch_textures);
 
-	if (texture)
-	{
-		if (batch_textures && params.mTextureList.size() > 1)
-		{
-			for (U32 i = 0; i < params.mTextureList.size(); ++i)
-			{
-				if (params.mTextureList[i].notNull())
-				{
-					gGL.getTexUnit(i)->bindFast(params.mTextureList[i]);
-				}
-			}
-		}
-		else
-		{ //not batching textures or batch has only 1 texture -- might need a texture matrix
-			if (params.mTexture.notNull())
-			{
-				gGL.getTexUnit(0)->bindFast(params.mTexture);
-				if (params.mTextureMatrix)
-				{
-					tex_setup = true;
-					gGL.getTexUnit(0)->activate();
-					gGL.matrixMode(LLRender::MM_TEXTURE);
-					gGL.loadMatrix((GLfloat*) params.mTextureMatrix->mMatrix);
-					gPipeline.mTextureMatrixOps++;
-				}
-			}
-			else
-			{
-				gGL.getTexUnit(0)->unbindFast(LLTexUnit::TT_TEXTURE);
-			}
-		}
-	}
-	
     if (params.mGroup)
     {
         params.mGroup->rebuildMesh();
@@ -580,12 +603,110 @@ void LLRenderPass::pushBatch(LLDrawInfo& params, U32 mask, BOOL texture, BOOL ba
 
 	if (tex_setup)
 	{
-        gGL.matrixMode(LLRender::MM_TEXTURE0);
-		gGL.loadIdentity();
-		gGL.matrixMode(LLRender::MM_MODELVIEW);
+		resetTextureMatrix();
 	}
 }
 
+void LLRenderPass::pushMultiBatch(LLDrawInfo** batch, U32 count, U32 mask, BOOL texture, BOOL batch_textures)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
+	sDrawInfoCount += count;
+	sDrawInfoCalls++;
+
+	if (count == 1)
+	{
+		pushBatch(**batch, mask, texture, batch_textures);
+		return;
+	}
+
+	static thread_local std::vector<S32> counts;
+	static thread_local std::vector<U32> offsets;
+	counts.clear();
+	offsets.clear();
+
+	for (U32 i = 0; i < count; ++i)
+	{
+		if (batch[i]->mCount)
+		{
+			counts.push_back(batch[i]->mCount);
+			offsets.push_back(batch[i]->mOffset);
+		}
+	}
+
+	if (counts.empty())
+	{
+		return;
+	}
+
+	// everything but the index range is shared by the run (see LLDrawInfo::canMultiDraw)
+	LLDrawInfo& params = **batch;
+
+	applyModelMatrix(params);
+
+	bool tex_setup = texture && bindBatchTextures(params, batch_textures);
+
+	if (params.mGroup)
+	{
+		params.mGroup->rebuildMesh();
+	}
+
+	LLGLEnableFunc stencil_test(GL_STENCIL_TEST, params.mSelected, &LLGLCommonFunc::selected_stencil_test);
+
+	params.mVertexBuffer->setBufferFast(mask);
+	params.mVertexBuffer->drawMultiFast(params.mDrawMode, counts.data(), offsets.data(), counts.size());
+
+	if (tex_setup)
+	{
+		resetTextureMatrix();
+	}
+}
+
+// static
+bool LLRenderPass::bindBatchTextures(LLDrawInfo& params, BOOL batch_textures)
+{
+	bool tex_setup = false;
+
+	if (batch_textures && params.mTextureList.size() > 1)
+	{
+		for (U32 i = 0; i < params.mTextureList.size(); ++i)
+		{
+			if (params.mTextureList[i].notNull())
+			{
+				gGL.getTexUnit(i)->bindFast(params.mTextureList[i]);
+			}
+		}
+	}
+	else
+	{ //not batching textures or batch has only 1 texture -- might need a texture matrix
+		if (params.mTexture.notNull())
+		{
+			gGL.getTexUnit(0)->bindFast(params.mTexture);
+			if (params.mTextureMatrix)
+			{
+				tex_setup = true;
+				gGL.getTexUnit(0)->activate();
+				gGL.matrixMode(LLRender::MM_TEXTURE);
+				gGL.loadMatrix((GLfloat*) params.mTextureMatrix->mMatrix);
+				gPipeline.mTextureMatrixOps++;
+			}
+		}
+		else
+		{
+			gGL.getTexUnit(0)->unbindFast(LLTexUnit::TT_TEXTURE);
+		}
+	}
+
+	return tex_setup;
+}
+
+// static
+void LLRenderPass::resetTextureMatrix()
+{
+    gGL.matrixMode(LLRender::MM_TEXTURE0);
+	gGL.loadIdentity();
+	gGL.matrixMode(LLRender::MM_MODELVIEW);
+}
+
 // static
 bool LLRenderPass::uploadMatrixPalette(LLDrawInfo& params)
 {
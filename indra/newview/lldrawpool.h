@@ -82,6 +82,8 @@ public:
 
 	S32 getId() const { return mId; }
 	U32 getType() const { return mType; }
+	// display name of a pool type, "Other" for anything outside a pool
+	static const char* getTypeName(U32 type);
 
 	BOOL getSkipRenderFlag() const { return mSkipRender;}
 	void setSkipRenderFlag( BOOL flag ) { mSkipRender = flag; }
@@ -206,10 +208,24 @@ public:
 	virtual void pushMaskBatches(U32 type, U32 mask, BOOL texture = TRUE, BOOL batch_textures = FALSE);
     virtual void pushRiggedMaskBatches(U32 type, U32 mask, BOOL texture = TRUE, BOOL batch_textures = FALSE);
 	virtual void pushBatch(LLDrawInfo& params, U32 mask, BOOL texture, BOOL batch_textures = FALSE);
+	// draw count LLDrawInfos for which canMultiDraw() holds with one call
+	virtual void pushMultiBatch(LLDrawInfo** batch, U32 count, U32 mask, BOOL texture, BOOL batch_textures = FALSE);
     static bool uploadMatrixPalette(LLDrawInfo& params);
     static bool uploadMatrixPalette(LLVOAvatar* avatar, LLMeshSkinInfo* skinInfo);
 	virtual void renderGroup(LLSpatialGroup* group, U32 type, U32 mask, BOOL texture = TRUE);
     virtual void renderRiggedGroup(LLSpatialGroup* group, U32 type, U32 mask, BOOL texture = TRUE);
+
+	// LLDrawInfos pushed by the batch functions above, and the draw calls
+	// they took after merging, since the last frame stats update
+	static U32 sDrawInfoCount;
+	static U32 sDrawInfoCalls;
+
+protected:
+	// end of the run of LLDrawInfos starting at begin that can share a draw call
+	static LLDrawInfo** getMultiDrawEnd(LLDrawInfo** begin, LLDrawInfo** end);
+	// bind the textures of params, returns true if a texture matrix was loaded
+	static bool bindBatchTextures(LLDrawInfo& params, BOOL batch_textures);
+	static void resetTextureMatrix();
 };
 
 class LLFacePool : public LLDrawPool
@@ -38,6 +38,7 @@
 #include "lldrawable.h"
 #include "lldrawpoolbump.h"
 #include "llface.h"
+#include "llimpostoratlas.h"
 #include "llmeshrepository.h"
 #include "llsky.h"
 #include "llviewercamera.h"
@@ -847,15 +848,15 @@ void LLDrawPoolAvatar::renderAvatars(LLVOAvatar* single_avatar, S32 pass)
 //		if (impostor || (LLVOAvatar::AV_DO_NOT_RENDER == avatarp->getVisualMuteSettings() && !avatarp->needsImpostorUpdate()))
 		if (impostor || (LLVOAvatar::AOA_NORMAL != avatarp->getOverallAppearance() && !avatarp->needsImpostorUpdate()))
 		{
-			if (LLPipeline::sRenderDeferred && !LLPipeline::sReflectionRender && avatarp->mImpostor.isComplete()) 
+			if (LLPipeline::sRenderDeferred && !LLPipeline::sReflectionRender && avatarp->hasImpostor()) 
 			{
 				if (normal_channel > -1)
 				{
-					avatarp->mImpostor.bindTexture(2, normal_channel);
+					gImpostorAtlas.getTarget().bindTexture(2, normal_channel);
 				}
 				if (specular_channel > -1)
 				{
-					avatarp->mImpostor.bindTexture(1, specular_channel);
+					gImpostorAtlas.getTarget().bindTexture(1, specular_channel);
 				}
 			}
 			avatarp->renderImpostor(avatarp->getMutedAVColor(), sDiffuseChannel);
@@ -48,6 +48,11 @@
 #include "llspatialpartition.h"
 #include "llviewershadermgr.h"
 #include "llmodel.h"
+#include "llrand.h"
+#include "llsimdmath.h"
+
+#include <atomic>
+#include <thread>
 
 //#include "llimagebmp.h"
 //#include "../tools/imdebug/imdebug.h"
@@ -56,6 +61,7 @@
 LLStandardBumpmap gStandardBumpmapList[TEM_BUMPMAP_COUNT]; 
 LL::WorkQueue::weak_t LLBumpImageList::sMainQueue;
 LL::WorkQueue::weak_t LLBumpImageList::sTexUpdateQueue;
+LL::WorkQueue::weak_t LLBumpImageList::sGeneralQueue;
 LLRenderTarget LLBumpImageList::sRenderTarget;
 
 // static
@@ -776,6 +782,7 @@ void LLBumpImageList::init()
 	LLStandardBumpmap::restoreGL();
     sMainQueue = LL::WorkQueue::getInstance("mainloop");
     sTexUpdateQueue = LL::WorkQueue::getInstance("LLImageGL"); // Share work queue with tex loader.
+    sGeneralQueue = LL::WorkQueue::getInstance("General");
 }
 
 void LLBumpImageList::clear()
@@ -793,6 +800,9 @@ void LLBumpImageList::clear()
 void LLBumpImageList::shutdown()
 {
 	clear();
+	mBumpMapCache.clear();
+	mBumpMapCacheBytes = 0;
+	mBumpMapRequests.clear();
 	LLStandardBumpmap::shutdown();
 }
 
@@ -951,7 +961,7 @@ void LLBumpImageList::onSourceBrightnessLoaded( BOOL success, LLViewerFetchedTex
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
 	LLUUID* source_asset_id = (LLUUID*)userdata;
-	LLBumpImageList::onSourceLoaded( success, src_vi, src, *source_asset_id, BE_BRIGHTNESS );
+	LLBumpImageList::onSourceLoaded( success, src_vi, src, *source_asset_id, BE_BRIGHTNESS, discard_level );
 	if( final )
 	{
 		delete source_asset_id;
@@ -962,7 +972,7 @@ void LLBumpImageList::onSourceBrightnessLoaded( BOOL success, LLViewerFetchedTex
 void LLBumpImageList::onSourceDarknessLoaded( BOOL success, LLViewerFetchedTexture *src_vi, LLImageRaw* src, LLImageRaw* aux_src, S32 discard_level, BOOL final, void* userdata )
 {
 	LLUUID* source_asset_id = (LLUUID*)userdata;
-	LLBumpImageList::onSourceLoaded( success, src_vi, src, *source_asset_id, BE_DARKNESS );
+	LLBumpImageList::onSourceLoaded( success, src_vi, src, *source_asset_id, BE_DARKNESS, discard_level );
 	if( final )
 	{
 		delete source_asset_id;
@@ -997,51 +1007,279 @@ void LLBumpImageList::generateNormalMapFromAlpha(LLImageRaw* src, LLImageRaw* nr
 
 	F32 norm_scale = gSavedSettings.getF32("RenderNormalMapScale");
 
-	U32 idx = 0;
-	//generate normal map from pseudo-heightfield
+	// The normal at each texel is the sum of the cross products of the four
+	// vectors to its neighbours, which works out to
+	//   (2s(left - right), 2s(up - down), 4s^2)
+	// so the center height drops out and four texels go through at a time.
+	const __m128 scale = _mm_set1_ps(2.f * norm_scale);
+	const __m128 nz = _mm_set1_ps(4.f * norm_scale * norm_scale);
+	const __m128 nz2 = _mm_mul_ps(nz, nz);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 to_byte = _mm_set1_ps(255.f);
+	const __m128 min_mag2 = _mm_set1_ps(FP_MAG_THRESHOLD * FP_MAG_THRESHOLD); // as LLVector3::normVec()
+
+	LL_ALIGN_16(F32 dx[4]);
+	LL_ALIGN_16(F32 dy[4]);
+	LL_ALIGN_16(S32 out[3][4]);
+
+	//generate normal map from pseudo-heightfield (last component)
+	const U8* height = src_data + src_cmp - 1;
 	for (S32 j = 0; j < resY; ++j)
 	{
-		for (S32 i = 0; i < resX; ++i)
+		const U8* row = height + j*resX*src_cmp;
+		const U8* up_row = height + ((j+resY-1)%resY)*resX*src_cmp;
+		const U8* down_row = height + ((j+1)%resY)*resX*src_cmp;
+		U8* dst = nrm_data + j*resX*4;
+
+		for (S32 i = 0; i < resX; i += 4)
 		{
-			S32 rX = (i+1)%resX;
-			S32 rY = (j+1)%resY;
-			S32 lX = (i-1)%resX;
-			S32 lY = (j-1)%resY;
+			S32 count = llmin(resX - i, 4);
+			for (S32 k = 0; k < 4; ++k)
+			{
+				S32 x = k < count ? i + k : i;
+				S32 lX = x == 0 ? resX - 1 : x - 1;
+				S32 rX = x == resX - 1 ? 0 : x + 1;
+				dx[k] = (F32) row[lX*src_cmp] - (F32) row[rX*src_cmp];
+				dy[k] = (F32) up_row[x*src_cmp] - (F32) down_row[x*src_cmp];
+			}
+
+			__m128 nx = _mm_mul_ps(_mm_load_ps(dx), scale);
+			__m128 ny = _mm_mul_ps(_mm_load_ps(dy), scale);
+			__m128 mag2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), nz2);
+			__m128 inv_mag = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(mag2)), _mm_cmpgt_ps(mag2, min_mag2));
 
-			if (lX < 0)
+			__m128 norm[3] = { _mm_mul_ps(nx, inv_mag), _mm_mul_ps(ny, inv_mag), _mm_mul_ps(nz, inv_mag) };
+			for (S32 c = 0; c < 3; ++c)
 			{
-				lX += resX;
+				__m128 v = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(norm[c], half), half), to_byte);
+				_mm_store_si128((__m128i*) out[c], _mm_cvttps_epi32(v));
 			}
-			if (lY < 0)
+
+			for (S32 k = 0; k < count; ++k)
 			{
-				lY += resY;
+				U8* texel = dst + (i+k)*4;
+				texel[0] = (U8) out[0][k];
+				texel[1] = (U8) out[1][k];
+				texel[2] = (U8) out[2][k];
+				texel[3] = row[(i+k)*src_cmp];
 			}
+		}
+	}
+}
 
-			F32 cH = (F32) src_data[(j*resX+i)*src_cmp+src_cmp-1];
+// Convert to luminance with the weights below.  Fixed point so we don't have
+// to worry about precision/clamping.
+static const S32 LUM_FIXED_PT = 8;
+static const S32 LUM_R_WEIGHT = S32(0.2995f * (1<<LUM_FIXED_PT));
+static const S32 LUM_G_WEIGHT = S32(0.5875f * (1<<LUM_FIXED_PT));
+static const S32 LUM_B_WEIGHT = S32(0.1145f * (1<<LUM_FIXED_PT));
+
+// Luminance of count pixels of any component count, tracking the range
+static void get_luminance(const U8* src_data, U8* dst_data, S32 count, S32 src_components, S32& minimum, S32& maximum)
+{
+	if (src_components < 3)
+	{
+		for( S32 i = 0, j=0; i < count; i++, j+= src_components )
+		{
+			dst_data[i] = src_data[j];
+			minimum = llmin(minimum, (S32) dst_data[i]);
+			maximum = llmax(maximum, (S32) dst_data[i]);
+		}
+	}
+	else
+	{
+		for( S32 i = 0, j=0; i < count; i++, j+= src_components )
+		{
+			// RGB to luminance
+			dst_data[i] = (LUM_R_WEIGHT * src_data[j] + LUM_G_WEIGHT * src_data[j+1] + LUM_B_WEIGHT * src_data[j+2]) >> LUM_FIXED_PT;
+			minimum = llmin(minimum, (S32) dst_data[i]);
+			maximum = llmax(maximum, (S32) dst_data[i]);
+		}
+	}
+}
 
-			LLVector3 right = LLVector3(norm_scale, 0, (F32) src_data[(j*resX+rX)*src_cmp+src_cmp-1]-cH);
-			LLVector3 left = LLVector3(-norm_scale, 0, (F32) src_data[(j*resX+lX)*src_cmp+src_cmp-1]-cH);
-			LLVector3 up = LLVector3(0, -norm_scale, (F32) src_data[(lY*resX+i)*src_cmp+src_cmp-1]-cH);
-			LLVector3 down = LLVector3(0, norm_scale, (F32) src_data[(rY*resX+i)*src_cmp+src_cmp-1]-cH);
+// Same as get_luminance() for RGBA, sixteen pixels at a time.  Returns the
+// number of pixels done, leaving the remainder to get_luminance().
+static S32 get_luminance_rgba(const U8* src_data, U8* dst_data, S32 count, S32& minimum, S32& maximum)
+{
+	const __m128i weights = _mm_set_epi16(0, LUM_B_WEIGHT, LUM_G_WEIGHT, LUM_R_WEIGHT, 0, LUM_B_WEIGHT, LUM_G_WEIGHT, LUM_R_WEIGHT);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i vmin = _mm_set1_epi8((char) 0xFF);
+	__m128i vmax = zero;
 
-			LLVector3 norm = right%down + down%left + left%up + up%right;
-		
-			norm.normVec();
-			
-			norm *= 0.5f;
-			norm += LLVector3(0.5f,0.5f,0.5f);
-
-			idx = (j*resX+i)*4;
-			nrm_data[idx+0]= (U8) (norm.mV[0]*255);
-			nrm_data[idx+1]= (U8) (norm.mV[1]*255);
-			nrm_data[idx+2]= (U8) (norm.mV[2]*255);
-			nrm_data[idx+3]= src_data[(j*resX+i)*src_cmp+src_cmp-1];
+	S32 i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i lum[4];
+		for (S32 k = 0; k < 4; ++k)
+		{
+			// 4 pixels, widened to 16 bits and weighted, leaves R+G and B+A sums
+			// for each pixel in adjacent 32 bit lanes
+			__m128i px = _mm_loadu_si128((const __m128i*) (src_data + (i + k*4)*4));
+			__m128 lo = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpacklo_epi8(px, zero), weights));
+			__m128 hi = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpackhi_epi8(px, zero), weights));
+			__m128i rg = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+			__m128i ba = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+			lum[k] = _mm_srli_epi32(_mm_add_epi32(rg, ba), LUM_FIXED_PT);
+		}
+
+		__m128i out = _mm_packus_epi16(_mm_packs_epi32(lum[0], lum[1]), _mm_packs_epi32(lum[2], lum[3]));
+		_mm_storeu_si128((__m128i*) (dst_data + i), out);
+		vmin = _mm_min_epu8(vmin, out);
+		vmax = _mm_max_epu8(vmax, out);
+	}
+
+	if (i > 0)
+	{
+		LL_ALIGN_16(U8 lanes[16]);
+		_mm_store_si128((__m128i*) lanes, vmin);
+		for (S32 k = 0; k < 16; ++k)
+		{
+			minimum = llmin(minimum, (S32) lanes[k]);
+		}
+		_mm_store_si128((__m128i*) lanes, vmax);
+		for (S32 k = 0; k < 16; ++k)
+		{
+			maximum = llmax(maximum, (S32) lanes[k]);
+		}
+	}
+
+	return i;
+}
+
+// Scale and bias luminance in [minimum, maximum] to the bump range for bump_code
+static void apply_bias_and_scale(U8* dst_data, S32 dst_data_size, S32 minimum, S32 maximum, EBumpEffect bump_code)
+{
+	if( maximum > minimum )
+	{
+		U8 bias_and_scale_lut[256];
+		F32 twice_one_over_range = 2.f / (maximum - minimum);
+		S32 i;
+
+		const F32 ARTIFICIAL_SCALE = 2.f;  // Advantage: exaggerates the effect in midrange.  Disadvantage: clamps at the extremes.
+		if (BE_DARKNESS == bump_code)
+		{
+			for( i = minimum; i <= maximum; i++ )
+			{
+				F32 minus_one_to_one = F32(maximum - i) * twice_one_over_range - 1.f;
+				bias_and_scale_lut[i] = llclampb(ll_round(127 * minus_one_to_one * ARTIFICIAL_SCALE + 128));
+			}
+		}
+		else
+		{
+			for( i = minimum; i <= maximum; i++ )
+			{
+				F32 minus_one_to_one = F32(i - minimum) * twice_one_over_range - 1.f;
+				bias_and_scale_lut[i] = llclampb(ll_round(127 * minus_one_to_one * ARTIFICIAL_SCALE + 128));
+			}
+		}
+
+		for( i = 0; i < dst_data_size; i++ )
+		{
+			dst_data[i] = bias_and_scale_lut[dst_data[i]];
+		}
+	}
+}
+
+// static
+void LLBumpImageList::generateBrightnessDarknessMap(LLImageRaw* src, LLImageRaw* dst_image, EBumpEffect bump_code)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
+
+	U8* dst_data = dst_image->getData();
+	S32 dst_data_size = dst_image->getDataSize();
+
+	U8* src_data = src->getData();
+	S32 src_data_size = src->getDataSize();
+
+	S32 src_components = src->getComponents();
+
+	// Convert to luminance and then scale and bias that to get ready for
+	// embossed bump mapping.  (0-255 maps to 127-255)
+
+	if (src_components < 1 || src_components > 4 ||
+		src_data_size != dst_data_size * src_components)
+	{
+		llassert(0);
+		dst_image->clear();
+		return;
+	}
+
+	S32 minimum = 255;
+	S32 maximum = 0;
+
+	S32 done = 0;
+	if (src_components == 4)
+	{
+		done = get_luminance_rgba(src_data, dst_data, dst_data_size, minimum, maximum);
+	}
+	get_luminance(src_data + done*src_components, dst_data + done, dst_data_size - done, src_components, minimum, maximum);
+
+	apply_bias_and_scale(dst_data, dst_data_size, minimum, maximum, bump_code);
+}
+
+bool LLBumpImageList::BumpMapKey::operator<(const BumpMapKey& rhs) const
+{
+	if (mID != rhs.mID)
+	{
+		return mID < rhs.mID;
+	}
+	if (mBumpCode != rhs.mBumpCode)
+	{
+		return mBumpCode < rhs.mBumpCode;
+	}
+	return mDiscardLevel < rhs.mDiscardLevel;
+}
+
+LLImageRaw* LLBumpImageList::findCachedBumpMap(const BumpMapKey& key, S32 width, S32 height)
+{
+	bump_map_cache_t::iterator iter = mBumpMapCache.find(key);
+	if (iter == mBumpMapCache.end() ||
+		iter->second.mImage->getWidth() != width ||
+		iter->second.mImage->getHeight() != height)
+	{
+		return NULL;
+	}
+
+	iter->second.mLastUsed = ++mBumpMapCacheClock;
+	return iter->second.mImage;
+}
+
+void LLBumpImageList::addCachedBumpMap(const BumpMapKey& key, LLImageRaw* image)
+{
+	static LLCachedControl<U32> cache_mb(gSavedSettings, "RenderBumpmapCacheMB", 64);
+	S64 budget = (S64) cache_mb * 1024 * 1024;
+	if (image->getDataSize() > budget)
+	{
+		return;
+	}
+
+	CachedBumpMap& entry = mBumpMapCache[key];
+	if (entry.mImage.notNull())
+	{
+		mBumpMapCacheBytes -= entry.mImage->getDataSize();
+	}
+	entry.mImage = image;
+	entry.mLastUsed = ++mBumpMapCacheClock;
+	mBumpMapCacheBytes += image->getDataSize();
+
+	while (mBumpMapCacheBytes > budget)
+	{ //drop the least recently used, which is never the one just added
+		bump_map_cache_t::iterator oldest = mBumpMapCache.begin();
+		for (bump_map_cache_t::iterator iter = mBumpMapCache.begin(); iter != mBumpMapCache.end(); ++iter)
+		{
+			if (iter->second.mLastUsed < oldest->second.mLastUsed)
+			{
+				oldest = iter;
+			}
 		}
+		mBumpMapCacheBytes -= oldest->second.mImage->getDataSize();
+		mBumpMapCache.erase(oldest);
 	}
 }
 
 // static
-void LLBumpImageList::onSourceLoaded( BOOL success, LLViewerTexture *src_vi, LLImageRaw* src, LLUUID& source_asset_id, EBumpEffect bump_code )
+void LLBumpImageList::onSourceLoaded( BOOL success, LLViewerTexture *src_vi, LLImageRaw* src, LLUUID& source_asset_id, EBumpEffect bump_code, S32 discard_level )
 {
     LL_PROFILE_ZONE_SCOPED;
 
@@ -1067,262 +1305,300 @@ void LLBumpImageList::onSourceLoaded( BOOL success, LLViewerTexture *src_vi, LLI
 		if (iter->second->getWidth() != src->getWidth() ||
 			iter->second->getHeight() != src->getHeight()) // bump not cached yet or has changed resolution
 		{
-			LLPointer<LLImageRaw> dst_image = new LLImageRaw(src->getWidth(), src->getHeight(), 1);
-			U8* dst_data = dst_image->getData();
-			S32 dst_data_size = dst_image->getDataSize();
+			BumpMapKey key;
+			key.mID = src_vi->getID();
+			key.mBumpCode = bump_code;
+			key.mDiscardLevel = discard_level;
 
-			U8* src_data = src->getData();
-			S32 src_data_size = src->getDataSize();
+			std::pair<LLUUID, U8> request_key(key.mID, key.mBumpCode);
 
-			S32 src_components = src->getComponents();
+			LLPointer<LLImageRaw> dst_image = gBumpImageList.findCachedBumpMap(key, src->getWidth(), src->getHeight());
+			if (dst_image.isNull())
+			{
+				bump_map_request_map_t::iterator request = gBumpImageList.mBumpMapRequests.find(request_key);
+				if (request != gBumpImageList.mBumpMapRequests.end() &&
+					request->second.mDiscardLevel == discard_level)
+				{ //already converting this one
+					return;
+				}
 
-			// Convert to luminance and then scale and bias that to get ready for
-			// embossed bump mapping.  (0-255 maps to 127-255)
+#if LL_BUMPLIST_MULTITHREADED
+				auto main_queue = sMainQueue.lock();
 
-			// Convert to fixed point so we don't have to worry about precision/clamping.
-			const S32 FIXED_PT = 8;
-			const S32 R_WEIGHT = S32(0.2995f * (1<<FIXED_PT));
-			const S32 G_WEIGHT = S32(0.5875f * (1<<FIXED_PT));
-			const S32 B_WEIGHT = S32(0.1145f * (1<<FIXED_PT));
+				if (main_queue && sGeneralQueue.lock())
+				{ //convert on the general thread pool, create the texture back on the main thread
+					BumpMapRequest& new_request = gBumpImageList.mBumpMapRequests[request_key];
+					new_request.mSerial = ++gBumpImageList.mBumpMapSerial;
+					new_request.mDiscardLevel = discard_level;
+					U32 serial = new_request.mSerial;
 
-			S32 minimum = 255;
-			S32 maximum = 0;
+					// the source's raw image may be replaced while we work, take a copy
+					LLPointer<LLImageRaw> src_copy = new LLImageRaw(src->getData(), src->getWidth(), src->getHeight(), src->getComponents());
 
-			switch( src_components )
-			{
-			case 1:
-			case 2:
-				{
-					if( src_data_size == dst_data_size * src_components )
-					{
-						for( S32 i = 0, j=0; i < dst_data_size; i++, j+= src_components )
+					main_queue->postTo(
+						sGeneralQueue,
+						[src_copy, bump_code]()
 						{
-							dst_data[i] = src_data[j];
-							if( dst_data[i] < minimum )
-							{
-								minimum = dst_data[i];
-							}
-							if( dst_data[i] > maximum )
-							{
-								maximum = dst_data[i];
-							}
-						}
-					}
-					else
-					{
-						llassert(0);
-						dst_image->clear();
-					}
-				}
-				break;
-			case 3:
-			case 4:
-				{
-					if( src_data_size == dst_data_size * src_components )
-					{
-						for( S32 i = 0, j=0; i < dst_data_size; i++, j+= src_components )
+							LLPointer<LLImageRaw> dst = new LLImageRaw(src_copy->getWidth(), src_copy->getHeight(), 1);
+							generateBrightnessDarknessMap(src_copy, dst, bump_code);
+							return dst;
+						},
+						[key, serial](LLPointer<LLImageRaw> dst)
 						{
-							// RGB to luminance
-							dst_data[i] = (R_WEIGHT * src_data[j] + G_WEIGHT * src_data[j+1] + B_WEIGHT * src_data[j+2]) >> FIXED_PT;
-							//llassert( dst_data[i] <= 255 );true because it's 8bit
-							if( dst_data[i] < minimum )
-							{
-								minimum = dst_data[i];
-							}
-							if( dst_data[i] > maximum )
-							{
-								maximum = dst_data[i];
-							}
-						}
-					}
-					else
-					{
-						llassert(0);
-						dst_image->clear();
-					}
+							gBumpImageList.onBumpMapGenerated(key, serial, dst);
+						});
+					return;
 				}
-				break;
-			default:
-				llassert(0);
-				dst_image->clear();
-				break;
+#endif
+
+				dst_image = new LLImageRaw(src->getWidth(), src->getHeight(), 1);
+				generateBrightnessDarknessMap(src, dst_image, bump_code);
+				gBumpImageList.addCachedBumpMap(key, dst_image);
 			}
 
-			if( maximum > minimum )
-			{
-				U8 bias_and_scale_lut[256];
-				F32 twice_one_over_range = 2.f / (maximum - minimum);
-				S32 i;
+			// anything still converting for this image is older than what we have now
+			gBumpImageList.mBumpMapRequests.erase(request_key);
 
-				const F32 ARTIFICIAL_SCALE = 2.f;  // Advantage: exaggerates the effect in midrange.  Disadvantage: clamps at the extremes.
-				if (BE_DARKNESS == bump_code)
-				{
-					for( i = minimum; i <= maximum; i++ )
-					{
-						F32 minus_one_to_one = F32(maximum - i) * twice_one_over_range - 1.f;
-						bias_and_scale_lut[i] = llclampb(ll_round(127 * minus_one_to_one * ARTIFICIAL_SCALE + 128));
-					}
-				}
-				else
-				{
-					for( i = minimum; i <= maximum; i++ )
-					{
-						F32 minus_one_to_one = F32(i - minimum) * twice_one_over_range - 1.f;
-						bias_and_scale_lut[i] = llclampb(ll_round(127 * minus_one_to_one * ARTIFICIAL_SCALE + 128));
-					}
-				}
+			createBumpTexture(iter->second, dst_image);
+		}
+	}
+}
 
-				for( i = 0; i < dst_data_size; i++ )
-				{
-					dst_data[i] = bias_and_scale_lut[dst_data[i]];
-				}
-			}
+void LLBumpImageList::onBumpMapGenerated(const BumpMapKey& key, U32 serial, LLImageRaw* dst_image)
+{
+	addCachedBumpMap(key, dst_image);
 
-			//---------------------------------------------------
-			// immediately assign bump to a smart pointer in case some local smart pointer
-			// accidentally releases it.
-            LLPointer<LLViewerTexture> bump = iter->second;
+	std::pair<LLUUID, U8> request_key(key.mID, key.mBumpCode);
+	bump_map_request_map_t::iterator request = mBumpMapRequests.find(request_key);
+	if (request == mBumpMapRequests.end() || request->second.mSerial != serial)
+	{ //superseded, or the list was cleared while we worked
+		return;
+	}
+	mBumpMapRequests.erase(request);
 
-			if (!LLPipeline::sRenderDeferred)
-			{
-				bump->setExplicitFormat(GL_ALPHA8, GL_ALPHA);
+	bump_image_map_t& entries_list(key.mBumpCode == BE_BRIGHTNESS ? mBrightnessEntries : mDarknessEntries);
+	bump_image_map_t::iterator iter = entries_list.find(key.mID);
+	if (iter != entries_list.end() && iter->second.notNull())
+	{
+		createBumpTexture(iter->second, dst_image);
+	}
+}
 
-#if LL_BUMPLIST_MULTITHREADED
-                auto tex_queue = LLImageGLThread::sEnabled ? sTexUpdateQueue.lock() : nullptr;
-
-                if (tex_queue)
-                { //dispatch creation to background thread
-                    LLImageRaw* dst_ptr = dst_image;
-                    LLViewerTexture* bump_ptr = bump;
-                    dst_ptr->ref();
-                    bump_ptr->ref();
-                    tex_queue->post(
-                        [=]()
-                        {
-                            LL_PROFILE_ZONE_NAMED("bil - create texture");
-                            bump_ptr->createGLTexture(0, dst_ptr);
-                            bump_ptr->unref();
-                            dst_ptr->unref();
-                        });
+// static
+void LLBumpImageList::createBumpTexture(LLViewerTexture* bump_texture, LLImageRaw* dst_image)
+{
+	//---------------------------------------------------
+	// immediately assign bump to a smart pointer in case some local smart pointer
+	// accidentally releases it.
+    LLPointer<LLViewerTexture> bump = bump_texture;
 
-                }
-                else
-#endif
-                {
-                    bump->createGLTexture(0, dst_image);
-                }
-			}
-			else 
-			{ //convert to normal map
-                LL_PROFILE_ZONE_NAMED("bil - create normal map");
-                LLImageGL* img = bump->getGLTexture();
-                LLImageRaw* dst_ptr = dst_image.get();
-                LLGLTexture* bump_ptr = bump.get();
-
-                dst_ptr->ref();
-                img->ref();
-                bump_ptr->ref();
-                auto create_func = [=]()
-                {
-                    img->setUseMipMaps(TRUE);
-                    // upload dst_image to GPU (greyscale in red channel)
-                    img->setExplicitFormat(GL_RED, GL_RED);
+	if (!LLPipeline::sRenderDeferred)
+	{
+		bump->setExplicitFormat(GL_ALPHA8, GL_ALPHA);
 
+#if LL_BUMPLIST_MULTITHREADED
+        auto tex_queue = LLImageGLThread::sEnabled ? sTexUpdateQueue.lock() : nullptr;
+
+        if (tex_queue)
+        { //dispatch creation to background thread
+            LLImageRaw* dst_ptr = dst_image;
+            LLViewerTexture* bump_ptr = bump;
+            dst_ptr->ref();
+            bump_ptr->ref();
+            tex_queue->post(
+                [=]()
+                {
+                    LL_PROFILE_ZONE_NAMED("bil - create texture");
                     bump_ptr->createGLTexture(0, dst_ptr);
+                    bump_ptr->unref();
                     dst_ptr->unref();
-                };
+                });
 
-                auto generate_func = [=]()
-                {
-                    // Allocate an empty RGBA texture at "tex_name" the same size as bump
-                    //  Note: bump will still point at GPU copy of dst_image
-                    bump_ptr->setExplicitFormat(GL_RGBA, GL_RGBA);
-                    LLGLuint tex_name;
-                    img->createGLTexture(0, nullptr, 0, 0, true, &tex_name);
+        }
+        else
+#endif
+        {
+            bump->createGLTexture(0, dst_image);
+        }
+	}
+	else 
+	{ //convert to normal map
+        LL_PROFILE_ZONE_NAMED("bil - create normal map");
+        LLImageGL* img = bump->getGLTexture();
+        LLImageRaw* dst_ptr = dst_image;
+        LLGLTexture* bump_ptr = bump.get();
+
+        dst_ptr->ref();
+        img->ref();
+        bump_ptr->ref();
+        auto create_func = [=]()
+        {
+            img->setUseMipMaps(TRUE);
+            // upload dst_image to GPU (greyscale in red channel)
+            img->setExplicitFormat(GL_RED, GL_RED);
 
-                    // point render target at empty buffer
-                    sRenderTarget.setColorAttachment(img, tex_name);
+            bump_ptr->createGLTexture(0, dst_ptr);
+            dst_ptr->unref();
+        };
 
-                    // generate normal map in empty texture
-                    {
-                        sRenderTarget.bindTarget();
+        auto generate_func = [=]()
+        {
+            // Allocate an empty RGBA texture at "tex_name" the same size as bump
+            //  Note: bump will still point at GPU copy of dst_image
+            bump_ptr->setExplicitFormat(GL_RGBA, GL_RGBA);
+            LLGLuint tex_name;
+            img->createGLTexture(0, nullptr, 0, 0, true, &tex_name);
 
-                        LLGLDepthTest depth(GL_FALSE);
-                        LLGLDisable cull(GL_CULL_FACE);
-                        LLGLDisable blend(GL_BLEND);
-                        gGL.setColorMask(TRUE, TRUE);
+            // point render target at empty buffer
+            sRenderTarget.setColorAttachment(img, tex_name);
 
-                        gNormalMapGenProgram.bind();
+            // generate normal map in empty texture
+            {
+                sRenderTarget.bindTarget();
 
-                        static LLStaticHashedString sNormScale("norm_scale");
-                        static LLStaticHashedString sStepX("stepX");
-                        static LLStaticHashedString sStepY("stepY");
+                LLGLDepthTest depth(GL_FALSE);
+                LLGLDisable cull(GL_CULL_FACE);
+                LLGLDisable blend(GL_BLEND);
+                gGL.setColorMask(TRUE, TRUE);
 
-                        gNormalMapGenProgram.uniform1f(sNormScale, gSavedSettings.getF32("RenderNormalMapScale"));
-                        gNormalMapGenProgram.uniform1f(sStepX, 1.f / bump_ptr->getWidth());
-                        gNormalMapGenProgram.uniform1f(sStepY, 1.f / bump_ptr->getHeight());
+                gNormalMapGenProgram.bind();
 
-                        gGL.getTexUnit(0)->bind(bump_ptr);
+                static LLStaticHashedString sNormScale("norm_scale");
+                static LLStaticHashedString sStepX("stepX");
+                static LLStaticHashedString sStepY("stepY");
 
-                        gGL.begin(LLRender::TRIANGLE_STRIP);
-                        gGL.texCoord2f(0, 0);
-                        gGL.vertex2f(0, 0);
+                gNormalMapGenProgram.uniform1f(sNormScale, gSavedSettings.getF32("RenderNormalMapScale"));
+                gNormalMapGenProgram.uniform1f(sStepX, 1.f / bump_ptr->getWidth());
+                gNormalMapGenProgram.uniform1f(sStepY, 1.f / bump_ptr->getHeight());
 
-                        gGL.texCoord2f(0, 1);
-                        gGL.vertex2f(0, 1);
+                gGL.getTexUnit(0)->bind(bump_ptr);
 
-                        gGL.texCoord2f(1, 0);
-                        gGL.vertex2f(1, 0);
+                gGL.begin(LLRender::TRIANGLE_STRIP);
+                gGL.texCoord2f(0, 0);
+                gGL.vertex2f(0, 0);
 
-                        gGL.texCoord2f(1, 1);
-                        gGL.vertex2f(1, 1);
+                gGL.texCoord2f(0, 1);
+                gGL.vertex2f(0, 1);
 
-                        gGL.end();
+                gGL.texCoord2f(1, 0);
+                gGL.vertex2f(1, 0);
 
-                        gGL.flush();
+                gGL.texCoord2f(1, 1);
+                gGL.vertex2f(1, 1);
 
-                        gNormalMapGenProgram.unbind();
+                gGL.end();
 
-                        sRenderTarget.flush();
-                        sRenderTarget.releaseColorAttachment();
-                    }
+                gGL.flush();
 
-                    // point bump at normal map and free gpu copy of dst_image
-                    img->syncTexName(tex_name);
+                gNormalMapGenProgram.unbind();
 
-                    // generate mipmap
-                    gGL.getTexUnit(0)->bind(img);
-                    glGenerateMipmap(GL_TEXTURE_2D);
-                    gGL.getTexUnit(0)->disable();
+                sRenderTarget.flush();
+                sRenderTarget.releaseColorAttachment();
+            }
 
-                    bump_ptr->unref();
-                    img->unref();
-                };
+            // point bump at normal map and free gpu copy of dst_image
+            img->syncTexName(tex_name);
+
+            // generate mipmap
+            gGL.getTexUnit(0)->bind(img);
+            glGenerateMipmap(GL_TEXTURE_2D);
+            gGL.getTexUnit(0)->disable();
+
+            bump_ptr->unref();
+            img->unref();
+        };
 
 #if LL_BUMPLIST_MULTITHREADED
-                auto main_queue = LLImageGLThread::sEnabled ? sMainQueue.lock() : nullptr;
-
-                if (main_queue)
-                { //dispatch texture upload to background thread, issue GPU commands to generate normal map on main thread
-                    main_queue->postTo(
-                        sTexUpdateQueue,
-                        create_func,
-                        generate_func);
-                }
-                else
+        auto main_queue = LLImageGLThread::sEnabled ? sMainQueue.lock() : nullptr;
+
+        if (main_queue)
+        { //dispatch texture upload to background thread, issue GPU commands to generate normal map on main thread
+            main_queue->postTo(
+                sTexUpdateQueue,
+                create_func,
+                generate_func);
+        }
+        else
 #endif
-                { // immediate upload texture and generate normal map
-                    create_func();
-                    generate_func();
-                }
+        { // immediate upload texture and generate normal map
+            create_func();
+            generate_func();
+        }
+	}
+}
 
+// static
+void LLBumpImageList::runBenchmark(U32 image_count)
+{
+	const S32 RES = 1024;
 
-			}
+	std::vector<LLPointer<LLImageRaw> > images;
+	for (U32 i = 0; i < image_count; ++i)
+	{
+		LLPointer<LLImageRaw> image = new LLImageRaw(RES, RES, 4);
+		U8* data = image->getData();
+		for (S32 j = 0; j < RES*RES*4; ++j)
+		{
+			data[j] = (U8) ll_rand(256);
+		}
+		images.push_back(image);
+	}
+
+	LLPointer<LLImageRaw> dst_image = new LLImageRaw(RES, RES, 1);
+	LLPointer<LLImageRaw> nrm_image = new LLImageRaw(RES, RES, 4);
+
+	LLTimer timer;
+	for (U32 i = 0; i < image_count; ++i)
+	{
+		S32 minimum = 255;
+		S32 maximum = 0;
+		get_luminance(images[i]->getData(), dst_image->getData(), RES*RES, 4, minimum, maximum);
+		apply_bias_and_scale(dst_image->getData(), RES*RES, minimum, maximum, BE_BRIGHTNESS);
+	}
+	F32 scalar_time = timer.getElapsedTimeF32();
+
+	timer.reset();
+	for (U32 i = 0; i < image_count; ++i)
+	{
+		generateBrightnessDarknessMap(images[i], dst_image, BE_BRIGHTNESS);
+	}
+	F32 simd_time = timer.getElapsedTimeF32();
+
+	timer.reset();
+	for (U32 i = 0; i < image_count; ++i)
+	{
+		generateNormalMapFromAlpha(images[i], nrm_image);
+	}
+	F32 normal_time = timer.getElapsedTimeF32();
 
-			iter->second = bump; // derefs (and deletes) old image
-			//---------------------------------------------------
+	F32 pool_time = 0.f;
+	auto general_queue = sGeneralQueue.lock();
+	if (general_queue)
+	{
+		std::atomic<U32> remaining(image_count);
+		timer.reset();
+		for (U32 i = 0; i < image_count; ++i)
+		{
+			LLPointer<LLImageRaw> image = images[i];
+			general_queue->post(
+				[image, &remaining]()
+				{
+					LLPointer<LLImageRaw> dst = new LLImageRaw(image->getWidth(), image->getHeight(), 1);
+					generateBrightnessDarknessMap(image, dst, BE_BRIGHTNESS);
+					--remaining;
+				});
+		}
+		while (remaining > 0)
+		{
+			std::this_thread::yield();
 		}
+		pool_time = timer.getElapsedTimeF32();
 	}
+
+	LL_INFOS("Benchmark") << "Bump map benchmark, " << image_count << " " << RES << "x" << RES << " images" << LL_ENDL;
+	LL_INFOS("Benchmark") << "Brightness map, scalar: " << scalar_time * 1000.f << " ms, SIMD: " << simd_time * 1000.f
+		<< " ms, SIMD on general pool: " << pool_time * 1000.f << " ms" << LL_ENDL;
+	LL_INFOS("Benchmark") << "Normal map from alpha, SIMD: " << normal_time * 1000.f << " ms" << LL_ENDL;
 }
 
 void LLDrawPoolBump::renderBump(U32 type, U32 mask)
@@ -1365,6 +1641,17 @@ void LLDrawPoolBump::renderBump(U32 type, U32 mask)
 	}
 }
 
+void LLDrawPoolBump::pushMultiBatch(LLDrawInfo** batch, U32 count, U32 mask, BOOL texture, BOOL batch_textures)
+{
+	// shiny and bump state is set up per LLDrawInfo in pushBatch, so draw them one at a time
+	sDrawInfoCount += count;
+	sDrawInfoCalls += count;
+	for (U32 i = 0; i < count; ++i)
+	{
+		pushBatch(*batch[i], mask, texture, batch_textures);
+	}
+}
+
 void LLDrawPoolBump::pushBatch(LLDrawInfo& params, U32 mask, BOOL texture, BOOL batch_textures)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_DRAWPOOL;
@@ -32,6 +32,7 @@
 #include "lltextureentry.h"
 #include "lluuid.h"
 
+#include <map>
 #include <unordered_map>
 
 class LLImageRaw;
@@ -56,6 +57,7 @@ public:
 	virtual S32	 getNumPasses() override;
 	/*virtual*/ void prerender() override;
 	void pushBatch(LLDrawInfo& params, U32 mask, BOOL texture, BOOL batch_textures = FALSE) override;
+	void pushMultiBatch(LLDrawInfo** batch, U32 count, U32 mask, BOOL texture, BOOL batch_textures = FALSE) override;
 
 	void renderBump(U32 type, U32 mask);
 	void renderGroup(LLSpatialGroup* group, U32 type, U32 mask, BOOL texture) override;
@@ -153,16 +155,65 @@ public:
 	static void onSourceStandardLoaded( BOOL success, LLViewerFetchedTexture *src_vi, LLImageRaw* src, LLImageRaw* aux_src, S32 discard_level, BOOL final, void* userdata );
 	static void generateNormalMapFromAlpha(LLImageRaw* src, LLImageRaw* nrm_image);
 
+	// Fill the one-component dst with src's luminance, scaled and biased for
+	// bump_code.  dst must be the same size as src.  Safe on any thread.
+	static void generateBrightnessDarknessMap(LLImageRaw* src, LLImageRaw* dst, EBumpEffect bump_code);
+
+	// Convert image_count synthetic 1024x1024 images with the scalar loop, the
+	// SIMD loop and the SIMD loop on the general thread pool, and log the timings
+	static void runBenchmark(U32 image_count);
 
 private:
-	static void onSourceLoaded( BOOL success, LLViewerTexture *src_vi, LLImageRaw* src, LLUUID& source_asset_id, EBumpEffect bump );
+	static void onSourceLoaded( BOOL success, LLViewerTexture *src_vi, LLImageRaw* src, LLUUID& source_asset_id, EBumpEffect bump, S32 discard_level );
+	static void createBumpTexture(LLViewerTexture* bump, LLImageRaw* dst_image);
+
+	// Generated bump maps are kept by source texture, effect and discard level,
+	// so a bump texture that was dropped or a source that reloads doesn't
+	// convert the same pixels again
+	struct BumpMapKey
+	{
+		LLUUID	mID;
+		U8		mBumpCode;
+		S32		mDiscardLevel;
+
+		bool operator<(const BumpMapKey& rhs) const;
+	};
+
+	struct CachedBumpMap
+	{
+		LLPointer<LLImageRaw> mImage;
+		U32 mLastUsed;
+	};
+
+	// Latest conversion posted to the general thread pool for a source texture
+	// and effect; older results that come back are cached but not applied
+	struct BumpMapRequest
+	{
+		U32 mSerial;
+		S32 mDiscardLevel;
+	};
+
+	LLImageRaw* findCachedBumpMap(const BumpMapKey& key, S32 width, S32 height);
+	void addCachedBumpMap(const BumpMapKey& key, LLImageRaw* image);
+	void onBumpMapGenerated(const BumpMapKey& key, U32 serial, LLImageRaw* dst_image);
 
 private:
 	typedef std::unordered_map<LLUUID, LLPointer<LLViewerTexture> > bump_image_map_t;
 	bump_image_map_t mBrightnessEntries;
 	bump_image_map_t mDarknessEntries;
+
+	typedef std::map<BumpMapKey, CachedBumpMap> bump_map_cache_t;
+	bump_map_cache_t mBumpMapCache;
+	S64 mBumpMapCacheBytes = 0;
+	U32 mBumpMapCacheClock = 0;
+
+	typedef std::map<std::pair<LLUUID, U8>, BumpMapRequest> bump_map_request_map_t;
+	bump_map_request_map_t mBumpMapRequests;
+	U32 mBumpMapSerial = 0;
+
     static LL::WorkQueue::weak_t sMainQueue;
     static LL::WorkQueue::weak_t sTexUpdateQueue;
+    static LL::WorkQueue::weak_t sGeneralQueue;
     static LLRenderTarget sRenderTarget;
 };
 
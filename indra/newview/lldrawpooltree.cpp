@@ -95,6 +95,12 @@ void LLDrawPoolTree::render(S32 pass)
 	gGL.getTexUnit(sDiffTex)->bindFast(mTexturep);
     gPipeline.touchTexture(mTexturep, 1024.f * 1024.f); // <=== keep Linden tree textures at full res
 
+	//trees of the same species and LOD share a mesh, so draw them together
+	//and only switch buffers between meshes
+	std::sort(mDrawFace.begin(), mDrawFace.end(), LLFace::CompareVertexBuffer());
+
+	LLVertexBuffer* last_buff = NULL;
+
 	for (std::vector<LLFace*>::iterator iter = mDrawFace.begin();
 		 iter != mDrawFace.end(); iter++)
 	{
@@ -103,21 +109,23 @@ void LLDrawPoolTree::render(S32 pass)
 
 		if(buff)
 		{
-			LLMatrix4* model_matrix = &(face->getDrawable()->getRegion()->mRenderMatrix);
+			LLVOTree* tree = (LLVOTree*) face->getViewerObject();
+
+			//the mesh is in tree space, each tree gets its own transform
+			tree->mDrawMatrix = tree->mInstanceMatrix;
+			tree->mDrawMatrix *= face->getDrawable()->getRegion()->mRenderMatrix;
 
-			if (model_matrix != gGLLastMatrix)
+			gGLLastMatrix = &tree->mDrawMatrix;
+			gGL.loadMatrix(gGLModelView);
+			llassert(gGL.getMatrixMode() == LLRender::MM_MODELVIEW);
+			gGL.multMatrix((GLfloat*) tree->mDrawMatrix.mMatrix);
+			gPipeline.mMatrixOpCount++;
+
+			if (buff != last_buff)
 			{
-				gGLLastMatrix = model_matrix;
-				gGL.loadMatrix(gGLModelView);
-				if (model_matrix)
-				{
-					llassert(gGL.getMatrixMode() == LLRender::MM_MODELVIEW);
-					gGL.multMatrix((GLfloat*) model_matrix->mMatrix);
-				}
-				gPipeline.mMatrixOpCount++;
+				buff->setBufferFast(LLDrawPoolTree::VERTEX_DATA_MASK);
+				last_buff = buff;
 			}
-
-			buff->setBufferFast(LLDrawPoolTree::VERTEX_DATA_MASK);
 			buff->drawRangeFast(LLRender::TRIANGLES, 0, buff->getNumVerts()-1, buff->getNumIndices(), 0); 
 		}
 	}
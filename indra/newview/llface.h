@@ -371,6 +371,14 @@ public:
 		}
 	};
 
+	struct CompareVertexBuffer
+	{
+		bool operator()(const LLFace* const& lhs, const LLFace* const& rhs)
+		{
+			return lhs->getVertexBuffer() < rhs->getVertexBuffer();
+		}
+	};
+
 	struct CompareTextureAndTime
 	{
 		bool operator()(const LLFace* const& lhs, const LLFace* const& rhs)
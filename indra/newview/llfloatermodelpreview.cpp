@@ -814,6 +814,9 @@ void LLFloaterModelPreview::draw()
 
 	if (!mModelPreview->mLoading)
 	{
+		U32 lod_jobs_done = 0;
+		U32 lod_jobs_total = 0;
+
 		if ( mModelPreview->getLoadState() == LLModelLoader::ERROR_MATERIALS )
 		{
 			childSetTextArg("status", "[STATUS]", getString("status_material_mismatch"));
@@ -834,6 +837,14 @@ void LLFloaterModelPreview::draw()
         {
 			childSetTextArg("status", "[STATUS]", getString("status_bind_shape_orientation"));
         }
+		else
+		if (mModelPreview->getMeshOptimizerProgress(lod_jobs_done, lod_jobs_total))
+		{
+			LLStringUtil::format_map_t args;
+			args["[DONE]"] = llformat("%d", lod_jobs_done);
+			args["[TOTAL]"] = llformat("%d", lod_jobs_total);
+			childSetTextArg("status", "[STATUS]", getString("status_generating_lods", args));
+		}
 		else
 		{
 			childSetTextArg("status", "[STATUS]", getString("status_idle"));
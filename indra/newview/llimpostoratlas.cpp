@@ -0,0 +1,321 @@
+/**
+ * @file llimpostoratlas.cpp
+ * @brief Shared render target that avatar impostors are packed into
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llimpostoratlas.h"
+
+#include "llvoavatar.h"
+
+LLImpostorAtlas gImpostorAtlas;
+
+LLImpostorAtlas::LLImpostorAtlas()
+:	mImpostorCount(0)
+{
+}
+
+LLImpostorAtlas::~LLImpostorAtlas()
+{
+	// avatars are gone by now, don't touch the owners
+	mTarget.release();
+}
+
+S32 LLImpostorAtlas::allocate(LLVOAvatar* avatar, U32 res_x, U32 res_y)
+{
+	llassert(avatar);
+
+	U32 cell_size = MIN_CELL_SIZE;
+	while (cell_size < llmax(res_x, res_y) && cell_size < PAGE_SIZE)
+	{
+		cell_size *= 2;
+	}
+
+	S32 slot = avatar->mImpostorSlot;
+	if (slot >= 0 && mPages[slot / MAX_CELLS_PER_PAGE].mCellSize == cell_size)
+	{ //same size as last time, render over the old impostor
+		Cell& cell = mPages[slot / MAX_CELLS_PER_PAGE].mCells[slot % MAX_CELLS_PER_PAGE];
+		cell.mResX = llmin(res_x, cell_size);
+		cell.mResY = llmin(res_y, cell_size);
+		cell.mLastUsed = gFrameCount;
+		return slot;
+	}
+
+	release(avatar);
+
+	// shrink the impostor rather than evict one that's on screen,
+	// unless it's already as small as it gets
+	U32 size = cell_size;
+	slot = -1;
+	while (slot < 0)
+	{
+		slot = findCell(size, size == MIN_CELL_SIZE);
+		if (slot < 0)
+		{
+			size /= 2;
+		}
+	}
+
+	Page& page = mPages[slot / MAX_CELLS_PER_PAGE];
+	Cell& cell = page.mCells[slot % MAX_CELLS_PER_PAGE];
+	cell.mOwner = avatar;
+	cell.mResX = llmax(llmin(res_x * size / cell_size, size), (U32) 1);
+	cell.mResY = llmax(llmin(res_y * size / cell_size, size), (U32) 1);
+	cell.mLastUsed = gFrameCount;
+	page.mUsedCells++;
+	mImpostorCount++;
+
+	avatar->mImpostorSlot = slot;
+	return slot;
+}
+
+S32 LLImpostorAtlas::findCell(U32 cell_size, bool evict_recent)
+{
+	U32 cells_per_page = (PAGE_SIZE / cell_size) * (PAGE_SIZE / cell_size);
+
+	//a free cell in a page of this size
+	for (U32 p = 0; p < PAGE_COUNT; ++p)
+	{
+		Page& page = mPages[p];
+		if (page.mCellSize == cell_size && page.mUsedCells < cells_per_page)
+		{
+			for (U32 c = 0; c < cells_per_page; ++c)
+			{
+				if (!page.mCells[c].mOwner)
+				{
+					return p * MAX_CELLS_PER_PAGE + c;
+				}
+			}
+		}
+	}
+
+	//an empty page, in which case take it for this size
+	for (U32 p = 0; p < PAGE_COUNT; ++p)
+	{
+		Page& page = mPages[p];
+		if (page.mUsedCells == 0)
+		{
+			page.mCellSize = cell_size;
+			page.mCells.assign(cells_per_page, Cell());
+			return p * MAX_CELLS_PER_PAGE;
+		}
+	}
+
+	//atlas is full, find the least recently drawn impostor of this size
+	//and the least recently drawn page of any other size
+	S32 lru_cell = -1;
+	U32 lru_cell_frame = U32_MAX;
+	S32 lru_page = -1;
+	U32 lru_page_frame = U32_MAX;
+
+	for (U32 p = 0; p < PAGE_COUNT; ++p)
+	{
+		Page& page = mPages[p];
+		if (page.mCellSize == cell_size)
+		{
+			for (U32 c = 0; c < cells_per_page; ++c)
+			{
+				if (page.mCells[c].mLastUsed < lru_cell_frame)
+				{
+					lru_cell = p * MAX_CELLS_PER_PAGE + c;
+					lru_cell_frame = page.mCells[c].mLastUsed;
+				}
+			}
+		}
+		else
+		{
+			U32 page_frame = 0;
+			for (std::vector<Cell>::iterator iter = page.mCells.begin(); iter != page.mCells.end(); ++iter)
+			{
+				if (iter->mOwner)
+				{
+					page_frame = llmax(page_frame, iter->mLastUsed);
+				}
+			}
+			if (page_frame < lru_page_frame)
+			{
+				lru_page = p;
+				lru_page_frame = page_frame;
+			}
+		}
+	}
+
+	//anything drawn last frame or this one is on screen
+	U32 recent = gFrameCount > 0 ? gFrameCount - 1 : 0;
+
+	if (lru_cell >= 0 && (evict_recent || lru_cell_frame < recent))
+	{
+		evict(lru_cell / MAX_CELLS_PER_PAGE, lru_cell % MAX_CELLS_PER_PAGE);
+		return lru_cell;
+	}
+
+	if (lru_page >= 0 && (evict_recent || lru_page_frame < recent))
+	{
+		evictPage(lru_page);
+		Page& page = mPages[lru_page];
+		page.mCellSize = cell_size;
+		page.mCells.assign(cells_per_page, Cell());
+		return lru_page * MAX_CELLS_PER_PAGE;
+	}
+
+	return -1;
+}
+
+void LLImpostorAtlas::evict(U32 page, U32 cell)
+{
+	Cell& entry = mPages[page].mCells[cell];
+	if (entry.mOwner)
+	{
+		entry.mOwner->mImpostorSlot = -1;
+		entry.mOwner->mNeedsImpostorUpdate = TRUE;
+		entry.mOwner->mLastImpostorUpdateReason = 12;
+		entry.mOwner = NULL;
+		mPages[page].mUsedCells--;
+		mImpostorCount--;
+	}
+}
+
+void LLImpostorAtlas::evictPage(U32 page)
+{
+	for (U32 c = 0; c < mPages[page].mCells.size(); ++c)
+	{
+		evict(page, c);
+	}
+}
+
+void LLImpostorAtlas::release(LLVOAvatar* avatar)
+{
+	S32 slot = avatar->mImpostorSlot;
+	if (slot < 0)
+	{
+		return;
+	}
+
+	Page& page = mPages[slot / MAX_CELLS_PER_PAGE];
+	Cell& cell = page.mCells[slot % MAX_CELLS_PER_PAGE];
+	llassert(cell.mOwner == avatar);
+	cell = Cell();
+	page.mUsedCells--;
+	mImpostorCount--;
+
+	if (page.mUsedCells == 0)
+	{ //let the page go to whatever size needs it next
+		page.mCellSize = 0;
+		page.mCells.clear();
+	}
+
+	avatar->mImpostorSlot = -1;
+}
+
+void LLImpostorAtlas::touch(S32 slot)
+{
+	mPages[slot / MAX_CELLS_PER_PAGE].mCells[slot % MAX_CELLS_PER_PAGE].mLastUsed = gFrameCount;
+}
+
+LLRect LLImpostorAtlas::getRect(S32 slot) const
+{
+	U32 p = slot / MAX_CELLS_PER_PAGE;
+	U32 c = slot % MAX_CELLS_PER_PAGE;
+	const Page& page = mPages[p];
+	const Cell& cell = page.mCells[c];
+
+	U32 cells_per_row = PAGE_SIZE / page.mCellSize;
+	S32 left = (p % PAGES_PER_ROW) * PAGE_SIZE + (c % cells_per_row) * page.mCellSize;
+	S32 bottom = (p / PAGES_PER_ROW) * PAGE_SIZE + (c / cells_per_row) * page.mCellSize;
+
+	return LLRect(left, bottom + cell.mResY, left + cell.mResX, bottom);
+}
+
+LLVector4 LLImpostorAtlas::getTexCoords(S32 slot) const
+{
+	LLRect rect = getRect(slot);
+	F32 scale = 1.f / ATLAS_SIZE;
+	return LLVector4(rect.mLeft * scale, rect.mBottom * scale, rect.mRight * scale, rect.mTop * scale);
+}
+
+void LLImpostorAtlas::bindCell(S32 slot)
+{
+	// the atlas is released whenever sUseFBO changes, so it has an FBO
+	// exactly when sUseFBO is set
+	LLRect rect = getRect(slot);
+	if (!LLRenderTarget::sUseFBO)
+	{
+		rect.translate(-rect.mLeft, -rect.mBottom);
+	}
+
+	mTarget.bindTarget();
+	glViewport(rect.mLeft, rect.mBottom, rect.getWidth(), rect.getHeight());
+	glScissor(rect.mLeft, rect.mBottom, rect.getWidth(), rect.getHeight());
+}
+
+void LLImpostorAtlas::clearCell()
+{
+	if (LLRenderTarget::sUseFBO)
+	{
+		mTarget.clear();
+	}
+	else
+	{ //LLRenderTarget::clear() would widen the scissor rect to the whole atlas
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	}
+}
+
+void LLImpostorAtlas::flushCell(S32 slot)
+{
+	if (LLRenderTarget::sUseFBO)
+	{
+		mTarget.flush();
+		return;
+	}
+
+	//LLRenderTarget::flush() would copy the whole atlas size out of the
+	//back buffer over every other impostor
+	LLRect rect = getRect(slot);
+	gGL.flush();
+	gGL.getTexUnit(0)->bind(&mTarget);
+	glCopyTexSubImage2D(LLTexUnit::getInternalType(mTarget.getUsage()), 0, rect.mLeft, rect.mBottom,
+						0, 0, rect.getWidth(), rect.getHeight());
+	gGL.getTexUnit(0)->disable();
+}
+
+F32 LLImpostorAtlas::getOccupancy() const
+{
+	U32 pixels = 0;
+	for (U32 p = 0; p < PAGE_COUNT; ++p)
+	{
+		pixels += mPages[p].mUsedCells * mPages[p].mCellSize * mPages[p].mCellSize;
+	}
+	return (F32) pixels / (ATLAS_SIZE * ATLAS_SIZE);
+}
+
+void LLImpostorAtlas::destroyGL()
+{
+	for (U32 p = 0; p < PAGE_COUNT; ++p)
+	{
+		evictPage(p);
+		mPages[p] = Page();
+	}
+	mTarget.release();
+}
@@ -0,0 +1,122 @@
+/**
+ * @file llimpostoratlas.h
+ * @brief Shared render target that avatar impostors are packed into
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2023, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLIMPOSTORATLAS_H
+#define LL_LLIMPOSTORATLAS_H
+
+#include "llrendertarget.h"
+#include "llrect.h"
+#include "v4math.h"
+
+class LLVOAvatar;
+
+// Every impostor lives in a cell of one ATLAS_SIZE x ATLAS_SIZE render target
+// instead of in a render target of its own.  The atlas is split into pages of
+// PAGE_SIZE pixels, and each page is split into square cells of a single power
+// of two size, so impostors of the same size share pages.  When the atlas is
+// full the least recently drawn impostors are evicted and their avatars are
+// flagged for an impostor update.
+class LLImpostorAtlas
+{
+public:
+	static const U32 ATLAS_SIZE = 2048;
+	static const U32 PAGE_SIZE = 512;
+	static const U32 MIN_CELL_SIZE = 32;
+	static const U32 PAGES_PER_ROW = ATLAS_SIZE / PAGE_SIZE;
+	static const U32 PAGE_COUNT = PAGES_PER_ROW * PAGES_PER_ROW;
+	static const U32 MAX_CELLS_PER_PAGE = (PAGE_SIZE / MIN_CELL_SIZE) * (PAGE_SIZE / MIN_CELL_SIZE);
+
+	LLImpostorAtlas();
+	~LLImpostorAtlas();
+
+	// Render target holding every impostor; allocated by the pipeline on first use
+	LLRenderTarget& getTarget() { return mTarget; }
+
+	// Give avatar a cell for a res_x by res_y impostor, reusing its current
+	// cell when the size matches.  If no cell of that size can be found
+	// without evicting an impostor drawn in the last frame, a smaller cell is
+	// tried.  Returns the avatar's new slot.
+	S32 allocate(LLVOAvatar* avatar, U32 res_x, U32 res_y);
+
+	// Free the avatar's cell, if it has one
+	void release(LLVOAvatar* avatar);
+
+	// Mark the slot as drawn this frame
+	void touch(S32 slot);
+
+	// Pixel rect the slot's impostor was rendered to
+	LLRect getRect(S32 slot) const;
+
+	// Texture coordinates of the slot's impostor (left, bottom, right, top)
+	LLVector4 getTexCoords(S32 slot) const;
+
+	// Bind the atlas for rendering the slot's impostor, with the viewport and
+	// scissor rect on the area it's drawn to.  Without FBOs that's the lower
+	// left corner of the back buffer, which flushCell() copies into the cell,
+	// so the rest of the atlas is left alone.
+	void bindCell(S32 slot);
+	// Clear the area the impostor is drawn to
+	void clearCell();
+	// Finish rendering the slot's impostor
+	void flushCell(S32 slot);
+
+	// Fraction of the atlas area held by impostors
+	F32 getOccupancy() const;
+	U32 getImpostorCount() const { return mImpostorCount; }
+
+	// Drop every impostor and release the render target
+	void destroyGL();
+
+private:
+	struct Cell
+	{
+		Cell() : mOwner(NULL), mResX(0), mResY(0), mLastUsed(0) { }
+		LLVOAvatar* mOwner;
+		U32 mResX;
+		U32 mResY;
+		U32 mLastUsed;	//gFrameCount the impostor was last drawn
+	};
+
+	struct Page
+	{
+		Page() : mCellSize(0), mUsedCells(0) { }
+		U32 mCellSize;	//0 if the page isn't assigned to a size yet
+		U32 mUsedCells;
+		std::vector<Cell> mCells;
+	};
+
+	S32 findCell(U32 cell_size, bool evict_recent);
+	void evict(U32 page, U32 cell);
+	void evictPage(U32 page);
+
+	LLRenderTarget mTarget;
+	Page mPages[PAGE_COUNT];
+	U32 mImpostorCount;
+};
+
+extern LLImpostorAtlas gImpostorAtlas;
+
+#endif // LL_LLIMPOSTORATLAS_H
@@ -1339,7 +1339,7 @@ void LLInventoryModel::moveObject(const LLUUID& object_id, const LLUUID& cat_id)
 		return;
 	}
 
-	if((object_id == cat_id) || !is_in_map(mCategoryMap, cat_id))
+	if((object_id == cat_id) || !mCategoryMap.count(cat_id))
 	{
 		LL_WARNS(LOG_INV) << "Could not move inventory object " << object_id << " to "
 						  << cat_id << LL_ENDL;
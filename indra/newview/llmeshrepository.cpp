@@ -245,7 +245,7 @@
 //     sActiveHeaderRequests    mMutex        rw.any.mMutex, ro.repo.none [1]
 //     sActiveLODRequests       mMutex        rw.any.mMutex, ro.repo.none [1]
 //     sMaxConcurrentRequests   mMutex        wo.main.none, ro.repo.none, ro.main.mMutex
-//     mMeshHeader              mHeaderMutex  rw.repo.mHeaderMutex, ro.main.mHeaderMutex, ro.main.none [0]
+//     mMeshHeader              mHeaderMutex  rw.repo.mHeaderMutex, ro.any.mHeaderMutex
 //     mMeshHeaderSize          mHeaderMutex  rw.repo.mHeaderMutex
 //     mSkinRequests            mMutex        rw.repo.mMutex, ro.repo.none [5]
 //     mSkinInfoQ               mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
@@ -389,6 +389,7 @@ U32 LLMeshRepository::sCacheBytesDecomps = 0;
 U32 LLMeshRepository::sCacheReads = 0;
 U32 LLMeshRepository::sCacheWrites = 0;
 U32 LLMeshRepository::sMaxLockHoldoffs = 0;
+std::atomic<U32> LLMeshRepository::sLODDecodeCount(0);
 	
 LLDeadmanTimer LLMeshRepository::sQuiescentTimer(15.0, false);	// true -> gather cpu metrics
 
@@ -1179,8 +1180,14 @@ void LLMeshRepoThread::lockAndLoadMeshLOD(const LLVolumeParams& mesh_params, S32
 void LLMeshRepoThread::loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod)
 { //could be called from any thread
 	LLMutexLock lock(mMutex);
-	mesh_header_map::iterator iter = mMeshHeader.find(mesh_params.getSculptID());
-	if (iter != mMeshHeader.end())
+	bool has_header = false;
+	{
+		// mMeshHeader is written by the repo thread under mHeaderMutex
+		// only, and an insert can rehash the table under a lookup
+		LLMutexLock header_lock(mHeaderMutex);
+		has_header = mMeshHeader.find(mesh_params.getSculptID()) != mMeshHeader.end();
+	}
+	if (has_header)
 	{ //if we have the header, request LOD byte range
 		LODRequest req(mesh_params, lod);
 		{
@@ -1938,6 +1945,7 @@ EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_p
 				// might be good idea to turn mesh into pointer to avoid making a copy
 				mesh.mVolume = NULL;
 			}
+			LLMeshRepository::sLODDecodeCount.fetch_add(1, std::memory_order_relaxed);
 			return MESH_OK;
 		}
 	}
@@ -27,10 +27,12 @@
 #ifndef LL_MESH_REPOSITORY_H
 #define LL_MESH_REPOSITORY_H
 
+#include <atomic>
 #include <unordered_map>
 #include "llassettype.h"
 #include "llmodel.h"
 #include "lluuid.h"
+#include "lluuidhashmap.h"
 #include "llviewertexture.h"
 #include "llvolume.h"
 #include "lldeadmantimer.h"
@@ -210,10 +212,10 @@ public:
 	LLCondition* mSignal;
 
 	//map of known mesh headers
-	typedef std::map<LLUUID, LLSD> mesh_header_map;
+	typedef LLUUIDHashMap<LLSD> mesh_header_map;
 	mesh_header_map mMeshHeader;
 	
-	std::map<LLUUID, U32> mMeshHeaderSize;
+	LLUUIDHashMap<U32> mMeshHeaderSize;
 
 	class HeaderRequest : public RequestStats
 	{ 
@@ -560,6 +562,7 @@ public:
 	static U32 sCacheReads;						
 	static U32 sCacheWrites;
 	static U32 sMaxLockHoldoffs;				// Maximum sequential locking failures
+	static std::atomic<U32> sLODDecodeCount;	// Mesh LODs successfully decoded
 	
 	static LLDeadmanTimer sQuiescentTimer;		// Time-to-complete-mesh-downloads after significant events
 
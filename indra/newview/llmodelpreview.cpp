@@ -59,6 +59,8 @@
 #include "llviewertexturelist.h"
 #include "llvoavatar.h"
 #include "pipeline.h"
+#include "threadpool.h"
+#include "workqueue.h"
 
 // ui controls (from floater)
 #include "llbutton.h"
@@ -69,6 +71,10 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 bool LLModelPreview::sIgnoreLoadedCallback = false;
 
 // Extra configurability, to be exposed later in xml (LLModelPreview probably
@@ -129,6 +135,83 @@ std::string getLodSuffix(S32 lod)
     return suffix;
 }
 
+// A genMeshOptimizerLODs() request split into one job per model per lod.
+// Jobs are run by threads of the general pool and by whichever thread calls
+// wait().  A job only reads its base model and writes its target model;
+// since LLModel isn't refcounted thread safely, jobs are only added, results
+// only read and models only released on the main thread.
+class LLModelLODJobs : public std::enable_shared_from_this<LLModelLODJobs>
+{
+public:
+    LLModelLODJobs(S32 which_lod, S32 meshopt_mode, U32 lod_mode, U32 decimation)
+        : mRequestedLOD(which_lod),
+          mMeshoptMode(meshopt_mode),
+          mLODMode(lod_mode),
+          mDecimation(decimation),
+          mJobCount(0),
+          mNextJob(0),
+          mCompletedJobs(0),
+          mCancelled(false)
+    {
+        for (S32 lod = 0; lod < LLModel::NUM_LODS; ++lod)
+        {
+            mHasLOD[lod] = false;
+        }
+    }
+
+    // Creates a target model for each base model and a job to simplify it
+    void addLOD(S32 lod, const LLModelLoader::model_list& base_models, F32 indices_decimator, F32 error_threshold);
+
+    // Hands the jobs to up to threads threads of the general pool.  Returns
+    // how many were given work, jobs not taken are left to wait().
+    size_t start(size_t threads);
+    // Runs jobs on this thread until none are left, then waits for the
+    // ones other threads are running
+    void wait();
+    // Jobs not started yet are skipped
+    void cancel() { mCancelled = true; }
+    // Drops the models, once done
+    void release();
+
+    bool isDone() const { return mCompletedJobs == mJobCount; }
+    bool hasLOD(S32 lod) const { return mHasLOD[lod]; }
+    S32 getRequestedLOD() const { return mRequestedLOD; }
+    U32 getCompleted() const { return mCompletedJobs; }
+    U32 getCount() const { return mJobCount; }
+    const LLModelLoader::model_list& getBaseModels() const { return mBaseModels; }
+    const LLModelLoader::model_list& getTargets(S32 lod) const { return mTargets[lod]; }
+
+private:
+    void runJobs();
+
+    struct Job
+    {
+        LLModel* mBase;
+        LLModel* mTarget;
+        S32 mLOD;
+        F32 mIndicesDecimator;
+        F32 mErrorThreshold;
+    };
+
+    const S32 mRequestedLOD;
+    const S32 mMeshoptMode;
+    const U32 mLODMode;
+    const U32 mDecimation;
+
+    // references keeping the models of the jobs alive
+    LLModelLoader::model_list mBaseModels;
+    LLModelLoader::model_list mTargets[LLModel::NUM_LODS];
+    bool mHasLOD[LLModel::NUM_LODS];
+
+    std::vector<Job> mJobs;
+    U32 mJobCount;
+    std::atomic<U32> mNextJob;
+    std::atomic<U32> mCompletedJobs;
+    std::atomic<bool> mCancelled;
+    std::mutex mDoneMutex;
+    std::condition_variable mDoneCondition;
+};
+
 void FindModel(LLModelLoader::scene& scene, const std::string& name_to_match, LLModel*& baseModelOut, LLMatrix4& matOut)
 {
     LLModelLoader::scene::iterator base_iter = scene.begin();
@@ -209,6 +292,8 @@ LLModelPreview::LLModelPreview(S32 width, S32 height, LLFloater* fmp)
 
 LLModelPreview::~LLModelPreview()
 {
+    cancelMeshOptimizerLODs();
+
     if (mModelLoader)
     {
         mModelLoader->shutdown();
@@ -676,6 +761,11 @@ void LLModelPreview::clearModel(S32 lod)
         return;
     }
 
+    if (mLODJobs && mLODJobs->hasLOD(lod))
+    {
+        cancelMeshOptimizerLODs();
+    }
+
     mVertexBuffer[lod].clear();
     mModel[lod].clear();
     mScene[lod].clear();
@@ -845,6 +935,8 @@ void LLModelPreview::clearIncompatible(S32 lod)
 
                 if (i == LLModel::LOD_HIGH)
                 {
+                    // anything being generated from the old base is stale
+                    cancelMeshOptimizerLODs();
                     mBaseModel = mModel[lod];
                     mBaseScene = mScene[lod];
                     mVertexBuffer[5].clear();
@@ -859,7 +951,7 @@ void LLModelPreview::clearIncompatible(S32 lod)
         // In case base was replaced, we might need to restart generation
 
         // Check if already started
-        bool subscribe_for_generation = mLodsQuery.empty();
+        bool subscribe_for_generation = mLodsQuery.empty() && !mLODJobs;
         
         // Remove previously scheduled work
         mLodsQuery.clear();
@@ -910,6 +1002,13 @@ void LLModelPreview::loadModelCallback(S32 loaded_lod)
         return;
     }
 
+    // A model from file replaces whatever is being generated for its lod,
+    // and a new high lod makes anything being generated stale
+    if (mLODJobs && (loaded_lod == -1 || loaded_lod == LLModel::LOD_HIGH || mLODJobs->hasLOD(loaded_lod)))
+    {
+        cancelMeshOptimizerLODs();
+    }
+
     mLodsWithParsingError.erase(std::remove(mLodsWithParsingError.begin(), mLodsWithParsingError.end(), loaded_lod), mLodsWithParsingError.end());
     if (mLodsWithParsingError.empty())
     {
@@ -1183,6 +1282,9 @@ void LLModelPreview::generateNormals()
 {
     assert_main_thread();
 
+    // LOD generation reads the base models changed here
+    finishMeshOptimizerLODs(true);
+
     S32 which_lod = mPreviewLOD;
 
     if (which_lod > 4 || which_lod < 0 ||
@@ -1242,6 +1344,9 @@ void LLModelPreview::generateNormals()
 
 void LLModelPreview::restoreNormals()
 {
+    // LOD generation reads the base models changed here
+    finishMeshOptimizerLODs(true);
+
     S32 which_lod = mPreviewLOD;
 
     if (which_lod > 4 || which_lod < 0 ||
@@ -1705,7 +1810,104 @@ F32 LLModelPreview::genMeshOptimizerPerFace(LLModel *base_model, LLModel *target
     return (F32)size_indices / (F32)size_new_indices;
 }
 
+void LLModelLODJobs::addLOD(S32 lod, const LLModelLoader::model_list& base_models, F32 indices_decimator, F32 error_threshold)
+{
+    assert_main_thread();
+
+    mBaseModels = base_models;
+    mHasLOD[lod] = true;
+    mTargets[lod].resize(base_models.size());
+
+    for (U32 mdl_idx = 0; mdl_idx < base_models.size(); ++mdl_idx)
+    {
+        LLModel* base = base_models[mdl_idx];
+
+        LLVolumeParams volume_params;
+        volume_params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+        LLModel* target_model = new LLModel(volume_params, 0.f);
+
+        target_model->mLabel = base->mLabel + getLodSuffix(lod);
+        target_model->mSubmodelID = base->mSubmodelID;
+        target_model->setNumVolumeFaces(base->getNumVolumeFaces());
+
+        mTargets[lod][mdl_idx] = target_model;
+
+        Job job = { base, target_model, lod, indices_decimator, error_threshold };
+        mJobs.push_back(job);
+    }
+
+    mJobCount = (U32)mJobs.size();
+}
+
+size_t LLModelLODJobs::start(size_t threads)
+{
+    LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+    if (!general_queue)
+    {
+        return 0;
+    }
+
+    // Runners hold a reference so that one starting after the jobs are all
+    // done still finds this, it just has nothing left to run
+    std::shared_ptr<LLModelLODJobs> self = shared_from_this();
+    size_t started = 0;
+    for (; started < llmin(threads, (size_t)mJobCount); ++started)
+    {
+        if (!general_queue->postIfOpen([self]() { self->runJobs(); }))
+        {
+            break;
+        }
+    }
+    return started;
+}
+
+void LLModelLODJobs::runJobs()
+{
+    U32 idx;
+    while ((idx = mNextJob++) < mJobCount)
+    {
+        if (!mCancelled)
+        {
+            const Job& job = mJobs[idx];
+            LLModelPreview::genMeshOptimizerModelLOD(job.mBase, job.mTarget, job.mLOD, mMeshoptMode, mLODMode, mDecimation, job.mIndicesDecimator, job.mErrorThreshold);
+        }
+
+        if (++mCompletedJobs == mJobCount)
+        {
+            std::lock_guard<std::mutex> lock(mDoneMutex);
+            mDoneCondition.notify_all();
+        }
+    }
+}
+
+void LLModelLODJobs::wait()
+{
+    runJobs();
+
+    std::unique_lock<std::mutex> lock(mDoneMutex);
+    mDoneCondition.wait(lock, [this]() { return isDone(); });
+}
+
+void LLModelLODJobs::release()
+{
+    assert_main_thread();
+    llassert(isDone());
+
+    mJobs.clear();
+    mBaseModels.clear();
+    for (S32 lod = 0; lod < LLModel::NUM_LODS; ++lod)
+    {
+        mTargets[lod].clear();
+    }
+}
+
 void LLModelPreview::genMeshOptimizerLODs(S32 which_lod, S32 meshopt_mode, U32 decimation, bool enforce_tri_limit)
+{
+    startMeshOptimizerLODs(which_lod, meshopt_mode, decimation, enforce_tri_limit);
+    finishMeshOptimizerLODs(true);
+}
+
+void LLModelPreview::startMeshOptimizerLODs(S32 which_lod, S32 meshopt_mode, U32 decimation, bool enforce_tri_limit)
 {
     LL_INFOS() << "Generating lod " << which_lod << " using meshoptimizer" << LL_ENDL;
     // Allow LoD from -1 to LLModel::LOD_PHYSICS
@@ -1715,7 +1917,7 @@ void LLModelPreview::genMeshOptimizerLODs(S32 which_lod, S32 meshopt_mode, U32 d
         out << "Invalid level of detail: " << which_lod;
         LL_WARNS() << out.str() << LL_ENDL;
         LLFloaterModelPreview::addStringToLog(out, false);
-        assert(lod >= -1 && lod < LLModel::NUM_LODS);
+        assert(which_lod >= -1 && which_lod < LLModel::NUM_LODS);
         return;
     }
 
@@ -1724,6 +1926,9 @@ void LLModelPreview::genMeshOptimizerLODs(S32 which_lod, S32 meshopt_mode, U32 d
         return;
     }
 
+    // Results of a generation still running would overwrite these
+    finishMeshOptimizerLODs(true);
+
     //get the triangle count for all base models
     S32 base_triangle_count = 0;
     for (S32 i = 0; i < mBaseModel.size(); ++i)
@@ -1795,6 +2000,8 @@ void LLModelPreview::genMeshOptimizerLODs(S32 which_lod, S32 meshopt_mode, U32 d
         end = which_lod;
     }
 
+    mLODJobs = std::make_shared<LLModelLODJobs>(which_lod, meshopt_mode, lod_mode, decimation);
+
     for (S32 lod = start; lod >= end; --lod)
     {
         if (which_lod == -1)
@@ -1811,232 +2018,285 @@ void LLModelPreview::genMeshOptimizerLODs(S32 which_lod, S32 meshopt_mode, U32 d
         mRequestedErrorThreshold[lod] = lod_error_threshold * 100;
         mRequestedLoDMode[lod] = lod_mode;
 
-        mModel[lod].clear();
-        mModel[lod].resize(mBaseModel.size());
-        mVertexBuffer[lod].clear();
+        mLODJobs->addLOD(lod, mBaseModel, indices_decimator, lod_error_threshold);
+    }
 
+    // Models are simplified in parallel, one job per model per lod
+    const LL::ThreadPool::ptr_t general_thread_pool = LL::ThreadPool::getInstance("General");
+    if (!general_thread_pool || !mLODJobs->start(general_thread_pool->getWidth()))
+    {
+        // Nothing to hand the jobs to, so run them here
+        mLODJobs->wait();
+    }
+}
 
-        for (U32 mdl_idx = 0; mdl_idx < mBaseModel.size(); ++mdl_idx)
-        {
-            LLModel* base = mBaseModel[mdl_idx];
+bool LLModelPreview::finishMeshOptimizerLODs(bool wait)
+{
+    assert_main_thread();
+
+    if (!mLODJobs)
+    {
+        return true;
+    }
 
-            LLVolumeParams volume_params;
-            volume_params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
-            mModel[lod][mdl_idx] = new LLModel(volume_params, 0.f);
+    if (!mLODJobs->isDone())
+    {
+        if (!wait)
+        {
+            return false;
+        }
+        mLODJobs->wait();
+    }
 
-            std::string name = base->mLabel + getLodSuffix(lod);
+    std::shared_ptr<LLModelLODJobs> jobs = mLODJobs;
+    mLODJobs.reset();
 
-            mModel[lod][mdl_idx]->mLabel = name;
-            mModel[lod][mdl_idx]->mSubmodelID = base->mSubmodelID;
-            mModel[lod][mdl_idx]->setNumVolumeFaces(base->getNumVolumeFaces());
+    const LLModelLoader::model_list& base_models = jobs->getBaseModels();
+    for (S32 lod = LLModel::LOD_HIGH; lod >= 0; --lod)
+    {
+        if (!jobs->hasLOD(lod))
+        {
+            continue;
+        }
 
-            LLModel* target_model = mModel[lod][mdl_idx];
+        mModel[lod] = jobs->getTargets(lod);
+        mVertexBuffer[lod].clear();
 
-            S32 model_meshopt_mode = meshopt_mode;
+        //rebuild scene based on mBaseScene
+        mScene[lod].clear();
+        mScene[lod] = mBaseScene;
 
-            // Ideally this should run not per model,
-            // but combine all submodels with origin model as well
-            if (model_meshopt_mode == MESH_OPTIMIZER_PRECISE)
+        for (U32 i = 0; i < base_models.size(); ++i)
+        {
+            LLModel* mdl = base_models[i];
+            LLModel* target = mModel[lod][i];
+            if (target)
             {
-                // Run meshoptimizer for each face
-                for (U32 face_idx = 0; face_idx < base->getNumVolumeFaces(); ++face_idx)
+                for (LLModelLoader::scene::iterator iter = mScene[lod].begin(); iter != mScene[lod].end(); ++iter)
                 {
-                    F32 res = genMeshOptimizerPerFace(base, target_model, face_idx, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_FULL);
-                    if (res < 0)
+                    for (U32 j = 0; j < iter->second.size(); ++j)
                     {
-                        // Mesh optimizer failed and returned an invalid model
-                        const LLVolumeFace &face = base->getVolumeFace(face_idx);
-                        LLVolumeFace &new_face = target_model->getVolumeFace(face_idx);
-                        new_face = face;
+                        if (iter->second[j].mModel == mdl)
+                        {
+                            iter->second[j].mModel = target;
+                        }
                     }
                 }
             }
+        }
+    }
 
-            if (model_meshopt_mode == MESH_OPTIMIZER_SLOPPY)
+    jobs->release();
+    return true;
+}
+
+void LLModelPreview::cancelMeshOptimizerLODs()
+{
+    assert_main_thread();
+
+    if (mLODJobs)
+    {
+        // Models being simplified right now still finish, the rest are skipped
+        mLODJobs->cancel();
+        mLODJobs->wait();
+        mLODJobs->release();
+        mLODJobs.reset();
+    }
+}
+
+bool LLModelPreview::getMeshOptimizerProgress(U32& done, U32& total) const
+{
+    if (!mLODJobs)
+    {
+        return false;
+    }
+
+    done = mLODJobs->getCompleted();
+    total = mLODJobs->getCount();
+    return true;
+}
+
+// static
+void LLModelPreview::genMeshOptimizerModelLOD(LLModel *base_model, LLModel *target_model, S32 lod, S32 meshopt_mode, U32 lod_mode, U32 decimation, F32 indices_decimator, F32 error_threshold)
+{
+    // Ideally this should run not per model,
+    // but combine all submodels with origin model as well
+    if (meshopt_mode == MESH_OPTIMIZER_PRECISE)
+    {
+        // Run meshoptimizer for each face
+        for (U32 face_idx = 0; face_idx < base_model->getNumVolumeFaces(); ++face_idx)
+        {
+            F32 res = genMeshOptimizerPerFace(base_model, target_model, face_idx, indices_decimator, error_threshold, MESH_OPTIMIZER_FULL);
+            if (res < 0)
             {
-                // Run meshoptimizer for each face
-                for (U32 face_idx = 0; face_idx < base->getNumVolumeFaces(); ++face_idx)
-                {
-                    if (genMeshOptimizerPerFace(base, target_model, face_idx, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY) < 0)
-                    {
-                        // Sloppy failed and returned an invalid model
-                        genMeshOptimizerPerFace(base, target_model, face_idx, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_FULL);
-                    }
-                }
+                // Mesh optimizer failed and returned an invalid model
+                const LLVolumeFace &face = base_model->getVolumeFace(face_idx);
+                LLVolumeFace &new_face = target_model->getVolumeFace(face_idx);
+                new_face = face;
             }
+        }
+    }
 
-            if (model_meshopt_mode == MESH_OPTIMIZER_AUTO)
+    if (meshopt_mode == MESH_OPTIMIZER_SLOPPY)
+    {
+        // Run meshoptimizer for each face
+        for (U32 face_idx = 0; face_idx < base_model->getNumVolumeFaces(); ++face_idx)
+        {
+            if (genMeshOptimizerPerFace(base_model, target_model, face_idx, indices_decimator, error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY) < 0)
             {
-                // Remove progressively more data if we can't reach the target.
-                F32 allowed_ratio_drift = 1.8f;
-                F32 precise_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_FULL);
+                // Sloppy failed and returned an invalid model
+                genMeshOptimizerPerFace(base_model, target_model, face_idx, indices_decimator, error_threshold, MESH_OPTIMIZER_FULL);
+            }
+        }
+    }
 
-                if (precise_ratio < 0 || (precise_ratio * allowed_ratio_drift < indices_decimator))
-                {
-                    precise_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_NORMALS);
-                }
+    if (meshopt_mode == MESH_OPTIMIZER_AUTO)
+    {
+        // Remove progressively more data if we can't reach the target.
+        F32 allowed_ratio_drift = 1.8f;
+        F32 precise_ratio = genMeshOptimizerPerModel(base_model, target_model, indices_decimator, error_threshold, MESH_OPTIMIZER_FULL);
 
-                if (precise_ratio < 0 || (precise_ratio * allowed_ratio_drift < indices_decimator))
-                {
-                    precise_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_UVS);
-                }
-                
-                if (precise_ratio < 0 || (precise_ratio * allowed_ratio_drift < indices_decimator))
-                {
-                    // Try sloppy variant if normal one failed to simplify model enough.
-                    // Sloppy variant can fail entirely and has issues with precision,
-                    // so code needs to do multiple attempts with different decimators.
-                    // Todo: this is a bit of a mess, needs to be refined and improved
+        if (precise_ratio < 0 || (precise_ratio * allowed_ratio_drift < indices_decimator))
+        {
+            precise_ratio = genMeshOptimizerPerModel(base_model, target_model, indices_decimator, error_threshold, MESH_OPTIMIZER_NO_NORMALS);
+        }
 
-                    F32 last_working_decimator = 0.f;
-                    F32 last_working_ratio = F32_MAX;
+        if (precise_ratio < 0 || (precise_ratio * allowed_ratio_drift < indices_decimator))
+        {
+            precise_ratio = genMeshOptimizerPerModel(base_model, target_model, indices_decimator, error_threshold, MESH_OPTIMIZER_NO_UVS);
+        }
+        
+        if (precise_ratio < 0 || (precise_ratio * allowed_ratio_drift < indices_decimator))
+        {
+            // Try sloppy variant if normal one failed to simplify model enough.
+            // Sloppy variant can fail entirely and has issues with precision,
+            // so code needs to do multiple attempts with different decimators.
+            // Todo: this is a bit of a mess, needs to be refined and improved
 
-                    F32 sloppy_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY);
+            F32 last_working_decimator = 0.f;
+            F32 last_working_ratio = F32_MAX;
 
-                    if (sloppy_ratio > 0)
-                    {
-                        // Would be better to do a copy of target_model here, but if
-                        // we need to use sloppy decimation, model should be cheap
-                        // and fast to generate and it won't affect end result
-                        last_working_decimator = indices_decimator;
-                        last_working_ratio = sloppy_ratio;
-                    }
+            F32 sloppy_ratio = genMeshOptimizerPerModel(base_model, target_model, indices_decimator, error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY);
 
-                    // Sloppy has a tendecy to error into lower side, so a request for 100
-                    // triangles turns into ~70, so check for significant difference from target decimation
-                    F32 sloppy_ratio_drift = 1.4f;
-                    if (lod_mode == LIMIT_TRIANGLES
-                        && (sloppy_ratio > indices_decimator * sloppy_ratio_drift || sloppy_ratio < 0))
-                    {
-                        // Apply a correction to compensate.
+            if (sloppy_ratio > 0)
+            {
+                // Would be better to do a copy of target_model here, but if
+                // we need to use sloppy decimation, model should be cheap
+                // and fast to generate and it won't affect end result
+                last_working_decimator = indices_decimator;
+                last_working_ratio = sloppy_ratio;
+            }
 
-                        // (indices_decimator / res_ratio) by itself is likely to overshoot to a differend
-                        // side due to overal lack of precision, and we don't need an ideal result, which
-                        // likely does not exist, just a better one, so a partial correction is enough.
-                        F32 sloppy_decimator = indices_decimator * (indices_decimator / sloppy_ratio + 1) / 2;
-                        sloppy_ratio = genMeshOptimizerPerModel(base, target_model, sloppy_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY);
-                    }
+            // Sloppy has a tendecy to error into lower side, so a request for 100
+            // triangles turns into ~70, so check for significant difference from target decimation
+            F32 sloppy_ratio_drift = 1.4f;
+            if (lod_mode == LIMIT_TRIANGLES
+                && (sloppy_ratio > indices_decimator * sloppy_ratio_drift || sloppy_ratio < 0))
+            {
+                // Apply a correction to compensate.
 
-                    if (last_working_decimator > 0 && sloppy_ratio < last_working_ratio)
-                    {
-                        // Compensation didn't work, return back to previous decimator
-                        sloppy_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY);
-                    }
+                // (indices_decimator / res_ratio) by itself is likely to overshoot to a differend
+                // side due to overal lack of precision, and we don't need an ideal result, which
+                // likely does not exist, just a better one, so a partial correction is enough.
+                F32 sloppy_decimator = indices_decimator * (indices_decimator / sloppy_ratio + 1) / 2;
+                sloppy_ratio = genMeshOptimizerPerModel(base_model, target_model, sloppy_decimator, error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY);
+            }
 
-                    if (sloppy_ratio < 0)
-                    {
-                        // Sloppy method didn't work, try with smaller decimation values
-                        S32 size_vertices = 0;
+            if (last_working_decimator > 0 && sloppy_ratio < last_working_ratio)
+            {
+                // Compensation didn't work, return back to previous decimator
+                sloppy_ratio = genMeshOptimizerPerModel(base_model, target_model, indices_decimator, error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY);
+            }
 
-                        for (U32 face_idx = 0; face_idx < base->getNumVolumeFaces(); ++face_idx)
-                        {
-                            const LLVolumeFace &face = base->getVolumeFace(face_idx);
-                            size_vertices += face.mNumVertices;
-                        }
+            if (sloppy_ratio < 0)
+            {
+                // Sloppy method didn't work, try with smaller decimation values
+                S32 size_vertices = 0;
 
-                        // Complex models aren't supposed to get here, they are supposed
-                        // to work on a first try of sloppy due to having more viggle room.
-                        // If they didn't, something is likely wrong, no point locking the
-                        // thread in a long calculation that will fail.
-                        const U32 too_many_vertices = 27000;
-                        if (size_vertices > too_many_vertices)
-                        {
-                            LL_WARNS() << "Sloppy optimization method failed for a complex model " << target_model->getName() << LL_ENDL;
-                        }
-                        else
-                        {
-                            // Find a decimator that does work
-                            F32 sloppy_decimation_step = sqrt((F32)decimation); // example: 27->15->9->5->3
-                            F32 sloppy_decimator = indices_decimator / sloppy_decimation_step;
+                for (U32 face_idx = 0; face_idx < base_model->getNumVolumeFaces(); ++face_idx)
+                {
+                    const LLVolumeFace &face = base_model->getVolumeFace(face_idx);
+                    size_vertices += face.mNumVertices;
+                }
 
-                            while (sloppy_ratio < 0
-                                && sloppy_decimator > precise_ratio
-                                && sloppy_decimator > 1)// precise_ratio isn't supposed to be below 1, but check just in case
-                            {
-                                sloppy_ratio = genMeshOptimizerPerModel(base, target_model, sloppy_decimator, lod_error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY);
-                                sloppy_decimator = sloppy_decimator / sloppy_decimation_step;
-                            }
-                        }
-                    }
+                // Complex models aren't supposed to get here, they are supposed
+                // to work on a first try of sloppy due to having more viggle room.
+                // If they didn't, something is likely wrong, no point locking the
+                // thread in a long calculation that will fail.
+                const U32 too_many_vertices = 27000;
+                if (size_vertices > too_many_vertices)
+                {
+                    LL_WARNS() << "Sloppy optimization method failed for a complex model " << target_model->getName() << LL_ENDL;
+                }
+                else
+                {
+                    // Find a decimator that does work
+                    F32 sloppy_decimation_step = sqrt((F32)decimation); // example: 27->15->9->5->3
+                    F32 sloppy_decimator = indices_decimator / sloppy_decimation_step;
 
-                    if (sloppy_ratio < 0 || sloppy_ratio < precise_ratio)
+                    while (sloppy_ratio < 0
+                        && sloppy_decimator > precise_ratio
+                        && sloppy_decimator > 1)// precise_ratio isn't supposed to be below 1, but check just in case
                     {
-                        // Sloppy variant failed to generate triangles or is worse.
-                        // Can happen with models that are too simple as is.
+                        sloppy_ratio = genMeshOptimizerPerModel(base_model, target_model, sloppy_decimator, error_threshold, MESH_OPTIMIZER_NO_TOPOLOGY);
+                        sloppy_decimator = sloppy_decimator / sloppy_decimation_step;
+                    }
+                }
+            }
 
-                        if (precise_ratio < 0)
-                        {
-                            // Precise method failed as well, just copy face over
-                            target_model->copyVolumeFaces(base);
-                            precise_ratio = 1.f;
-                        }
-                        else
-                        {
-                            // Fallback to normal method
-                            precise_ratio = genMeshOptimizerPerModel(base, target_model, indices_decimator, lod_error_threshold, MESH_OPTIMIZER_FULL);
-                        }
+            if (sloppy_ratio < 0 || sloppy_ratio < precise_ratio)
+            {
+                // Sloppy variant failed to generate triangles or is worse.
+                // Can happen with models that are too simple as is.
 
-                        LL_INFOS() << "Model " << target_model->getName()
-                            << " lod " << which_lod
-                            << " resulting ratio " << precise_ratio
-                            << " simplified using per model method." << LL_ENDL;
-                    }
-                    else
-                    {
-                        LL_INFOS() << "Model " << target_model->getName()
-                            << " lod " << which_lod
-                            << " resulting ratio " << sloppy_ratio
-                            << " sloppily simplified using per model method." << LL_ENDL;
-                    }
+                if (precise_ratio < 0)
+                {
+                    // Precise method failed as well, just copy face over
+                    target_model->copyVolumeFaces(base_model);
+                    precise_ratio = 1.f;
                 }
                 else
                 {
-                    LL_INFOS() << "Model " << target_model->getName()
-                        << " lod " << which_lod
-                        << " resulting ratio " << precise_ratio
-                        << " simplified using per model method." << LL_ENDL;
+                    // Fallback to normal method
+                    precise_ratio = genMeshOptimizerPerModel(base_model, target_model, indices_decimator, error_threshold, MESH_OPTIMIZER_FULL);
                 }
-            }
 
-            //blind copy skin weights and just take closest skin weight to point on
-            //decimated mesh for now (auto-generating LODs with skin weights is still a bit
-            //of an open problem).
-            target_model->mPosition = base->mPosition;
-            target_model->mSkinWeights = base->mSkinWeights;
-            target_model->mSkinInfo = base->mSkinInfo;
-
-            //copy material list
-            target_model->mMaterialList = base->mMaterialList;
-
-            if (!validate_model(target_model))
+                LL_INFOS() << "Model " << target_model->getName()
+                    << " lod " << lod
+                    << " resulting ratio " << precise_ratio
+                    << " simplified using per model method." << LL_ENDL;
+            }
+            else
             {
-                LL_ERRS() << "Invalid model generated when creating LODs" << LL_ENDL;
+                LL_INFOS() << "Model " << target_model->getName()
+                    << " lod " << lod
+                    << " resulting ratio " << sloppy_ratio
+                    << " sloppily simplified using per model method." << LL_ENDL;
             }
         }
-
-        //rebuild scene based on mBaseScene
-        mScene[lod].clear();
-        mScene[lod] = mBaseScene;
-
-        for (U32 i = 0; i < mBaseModel.size(); ++i)
+        else
         {
-            LLModel* mdl = mBaseModel[i];
-            LLModel* target = mModel[lod][i];
-            if (target)
-            {
-                for (LLModelLoader::scene::iterator iter = mScene[lod].begin(); iter != mScene[lod].end(); ++iter)
-                {
-                    for (U32 j = 0; j < iter->second.size(); ++j)
-                    {
-                        if (iter->second[j].mModel == mdl)
-                        {
-                            iter->second[j].mModel = target;
-                        }
-                    }
-                }
-            }
+            LL_INFOS() << "Model " << target_model->getName()
+                << " lod " << lod
+                << " resulting ratio " << precise_ratio
+                << " simplified using per model method." << LL_ENDL;
         }
     }
+
+    //blind copy skin weights and just take closest skin weight to point on
+    //decimated mesh for now (auto-generating LODs with skin weights is still a bit
+    //of an open problem).
+    target_model->mPosition = base_model->mPosition;
+    target_model->mSkinWeights = base_model->mSkinWeights;
+    target_model->mSkinInfo = base_model->mSkinInfo;
+
+    //copy material list
+    target_model->mMaterialList = base_model->mMaterialList;
+
+    if (!validate_model(target_model))
+    {
+        LL_ERRS() << "Invalid model generated when creating LODs" << LL_ENDL;
+    }
 }
 
 void LLModelPreview::updateStatusMessages()
@@ -2844,7 +3104,7 @@ void LLModelPreview::update()
 {
     if (mGenLOD)
     {
-        bool subscribe_for_generation = mLodsQuery.empty();
+        bool subscribe_for_generation = mLodsQuery.empty() && !mLODJobs;
         mGenLOD = false;
         mDirty = true;
         mLodsQuery.clear();
@@ -2861,7 +3121,7 @@ void LLModelPreview::update()
         }
     }
 
-    if (mDirty && mLodsQuery.empty())
+    if (mDirty && mLodsQuery.empty() && !mLODJobs)
     {
         mDirty = false;
         updateDimentionsAndOffsets();
@@ -3906,11 +4166,14 @@ bool LLModelPreview::lodQueryCallback()
     if (fmp && fmp->mModelPreview)
     {
         LLModelPreview* preview = fmp->mModelPreview;
-        if (preview->mLodsQuery.size() > 0)
+        if (preview->mLODJobs)
         {
-            S32 lod = preview->mLodsQuery.back();
-            preview->mLodsQuery.pop_back();
-            preview->genMeshOptimizerLODs(lod, MESH_OPTIMIZER_AUTO);
+            // Generation runs on the thread pool, pick the lod up once it's done
+            S32 lod = preview->mLODJobs->getRequestedLOD();
+            if (!preview->finishMeshOptimizerLODs(false))
+            {
+                return false;
+            }
 
             if (preview->mLookUpLodFiles && (lod == LLModel::LOD_HIGH))
             {
@@ -3920,6 +4183,15 @@ bool LLModelPreview::lodQueryCallback()
             // return false to continue cycle
             return preview->mLodsQuery.empty();
         }
+        if (preview->mLodsQuery.size() > 0)
+        {
+            S32 lod = preview->mLodsQuery.back();
+            preview->mLodsQuery.pop_back();
+            preview->startMeshOptimizerLODs(lod, MESH_OPTIMIZER_AUTO);
+
+            // return false to continue cycle
+            return !preview->mLODJobs && preview->mLodsQuery.empty();
+        }
     }
     // nothing to process
     return true;
@@ -3935,3 +4207,135 @@ void LLModelPreview::onLODMeshOptimizerParamCommit(S32 requested_lod, bool enfor
     }
 }
 
+
+// State of a runLODBenchmark() load.  The loader keeps references to the
+// joint maps until it's deleted, after its callback returns.
+struct LLModelLODBenchmark
+{
+    std::string mFilename;
+    JointTransformMap mJointTransformMap;
+    JointNameSet mJointsFromNode;
+    std::map<std::string, std::string> mJointAliasMap;
+    LLTimer mLoadTimer;
+};
+
+static LLModelLODBenchmark* sLODBenchmark = NULL;
+
+// Generates every lod of base_models the way the uploader's automatic LODs
+// are, with threads threads of the general pool helping this one.  Returns
+// the time taken in milliseconds and the triangle count of each lod.
+static F64 run_lod_benchmark_pass(const LLModelLoader::model_list& base_models, size_t threads, S32 triangles[LLModel::NUM_LODS])
+{
+    const U32 decimation = 3;
+
+    LLTimer timer;
+    std::shared_ptr<LLModelLODJobs> jobs = std::make_shared<LLModelLODJobs>(-1, LLModelPreview::MESH_OPTIMIZER_AUTO, LLModelPreview::LIMIT_TRIANGLES, decimation);
+
+    F32 indices_decimator = 1.f;
+    for (S32 lod = LLModel::LOD_HIGH; lod >= 0; --lod)
+    {
+        jobs->addLOD(lod, base_models, indices_decimator, 1.f);
+        indices_decimator *= decimation;
+    }
+
+    if (threads > 0)
+    {
+        jobs->start(threads);
+    }
+    jobs->wait();
+    F64 elapsed_ms = timer.getElapsedTimeF64() * 1000.0;
+
+    for (S32 lod = 0; lod < LLModel::NUM_LODS; ++lod)
+    {
+        triangles[lod] = 0;
+        if (jobs->hasLOD(lod))
+        {
+            const LLModelLoader::model_list& targets = jobs->getTargets(lod);
+            for (U32 i = 0; i < targets.size(); ++i)
+            {
+                triangles[lod] += targets[i]->getNumTriangles();
+            }
+        }
+    }
+
+    jobs->release();
+    return elapsed_ms;
+}
+
+static void lod_benchmark_loaded(LLModelLoader::scene& scene, LLModelLoader::model_list& model_list, S32 lod, void* opaque)
+{
+    LLModelLODBenchmark* benchmark = static_cast<LLModelLODBenchmark*>(opaque);
+
+    S32 base_triangles = 0;
+    for (U32 i = 0; i < model_list.size(); ++i)
+    {
+        base_triangles += model_list[i]->getNumTriangles();
+    }
+
+    LL_INFOS("Benchmark") << "Mesh LOD benchmark loaded " << model_list.size() << " models, "
+        << base_triangles << " triangles from " << benchmark->mFilename
+        << " in " << benchmark->mLoadTimer.getElapsedTimeF64() * 1000.0 << " ms" << LL_ENDL;
+
+    if (!model_list.empty())
+    {
+        const LL::ThreadPool::ptr_t general_thread_pool = LL::ThreadPool::getInstance("General");
+        size_t threads = general_thread_pool ? general_thread_pool->getWidth() : 0;
+
+        S32 triangles[LLModel::NUM_LODS];
+        F64 serial_ms = run_lod_benchmark_pass(model_list, 0, triangles);
+        F64 parallel_ms = run_lod_benchmark_pass(model_list, threads, triangles);
+
+        LL_INFOS("Benchmark") << "Mesh LOD benchmark generated lods with " << triangles[LLModel::LOD_HIGH] << "/"
+            << triangles[LLModel::LOD_MEDIUM] << "/" << triangles[LLModel::LOD_LOW] << "/"
+            << triangles[LLModel::LOD_IMPOSTOR] << " triangles: "
+            << serial_ms << " ms on one thread, "
+            << parallel_ms << " ms with " << threads << " pool threads" << LL_ENDL;
+    }
+
+    // The loader still uses the joint maps until it deletes itself
+    doOnIdleOneTime([]()
+    {
+        delete sLODBenchmark;
+        sLODBenchmark = NULL;
+    });
+}
+
+// static
+void LLModelPreview::runLODBenchmark(const std::string& filename)
+{
+    assert_main_thread();
+
+    if (sLODBenchmark)
+    {
+        LL_WARNS("Benchmark") << "Mesh LOD benchmark already running" << LL_ENDL;
+        return;
+    }
+
+    if (filename.empty() || !gDirUtilp->fileExists(filename))
+    {
+        LL_WARNS("Benchmark") << "Mesh LOD benchmark needs a .dae file in MeshLODBenchmarkFile, got '"
+            << filename << "'" << LL_ENDL;
+        return;
+    }
+
+    sLODBenchmark = new LLModelLODBenchmark;
+    sLODBenchmark->mFilename = filename;
+
+    // No preview avatar or textures: only the geometry is wanted
+    LLModelLoader* loader = new LLDAELoader(
+        filename,
+        LLModel::LOD_HIGH,
+        &lod_benchmark_loaded,
+        [](const std::string&, void*) -> LLJoint* { return NULL; },
+        [](LLImportMaterial&, void*) -> U32 { return 0; },
+        [](U32, void*) {},
+        sLODBenchmark,
+        sLODBenchmark->mJointTransformMap,
+        sLODBenchmark->mJointsFromNode,
+        sLODBenchmark->mJointAliasMap,
+        LLSkinningUtil::getMaxJointCount(),
+        gSavedSettings.getU32("ImporterModelLimit"),
+        gSavedSettings.getBOOL("ImporterPreprocessDAE"));
+    loader->mTrySLM = false;
+    loader->start();
+}
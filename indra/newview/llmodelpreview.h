@@ -111,6 +111,8 @@ static const std::string lod_label_name[NUM_LOD + 1] =
     "I went off the end of the lod_label_name array.  Me so smart."
 };
 
+class LLModelLODJobs;
+
 class LLModelPreview : public LLViewerDynamicTexture, public LLMutex
 {
     LOG_CLASS(LLModelPreview);
@@ -161,9 +163,21 @@ public:
     void getJointAliases(JointMap& joint_map);
     void loadModel(std::string filename, S32 lod, bool force_disable_slm = false);
     void loadModelCallback(S32 lod);
-    bool lodsReady() { return !mGenLOD && mLodsQuery.empty(); }
+    bool lodsReady() { return !mGenLOD && mLodsQuery.empty() && !mLODJobs; }
     void queryLODs() { mGenLOD = true; };
+    // Generates the LODs and waits for them
     void genMeshOptimizerLODs(S32 which_lod, S32 meshopt_mode, U32 decimation = 3, bool enforce_tri_limit = false);
+    // Starts generating the LODs on the general thread pool.  Results are
+    // applied by finishMeshOptimizerLODs().  A generation already running
+    // is finished first.
+    void startMeshOptimizerLODs(S32 which_lod, S32 meshopt_mode, U32 decimation = 3, bool enforce_tri_limit = false);
+    // Applies the results of the running generation, if any.  Returns false
+    // if it is still running and wait is false.
+    bool finishMeshOptimizerLODs(bool wait);
+    // Stops the running generation and drops its results
+    void cancelMeshOptimizerLODs();
+    // Models simplified so far by the running generation, out of total
+    bool getMeshOptimizerProgress(U32& done, U32& total) const;
     void generateNormals();
     void restoreNormals();
     void updateDimentionsAndOffsets();
@@ -193,6 +207,10 @@ public:
     static void	textureLoadedCallback(BOOL success, LLViewerFetchedTexture *src_vi, LLImageRaw* src, LLImageRaw* src_aux, S32 discard_level, BOOL final, void* userdata);
     static bool lodQueryCallback();
 
+    // Loads filename with LLDAELoader and times generating all of its LODs,
+    // on one thread and on the general thread pool.  Results are logged.
+    static void runLODBenchmark(const std::string& filename);
+
     boost::signals2::connection setDetailsCallback(const details_signal_t::slot_type& cb){ return mDetailsSignal.connect(cb); }
     boost::signals2::connection setModelLoadedCallback(const model_loaded_signal_t::slot_type& cb){ return mModelLoadedSignal.connect(cb); }
     boost::signals2::connection setModelUpdatedCallback(const model_updated_signal_t::slot_type& cb){ return mModelUpdatedSignal.connect(cb); }
@@ -253,16 +271,20 @@ private:
     // Merges faces into single mesh, simplifies using mesh optimizer,
     // then splits back into faces.
     // Returns reached simplification ratio. -1 in case of a failure.
-    F32 genMeshOptimizerPerModel(LLModel *base_model, LLModel *target_model, F32 indices_ratio, F32 error_threshold, eSimplificationMode simplification_mode);
+    static F32 genMeshOptimizerPerModel(LLModel *base_model, LLModel *target_model, F32 indices_ratio, F32 error_threshold, eSimplificationMode simplification_mode);
     // Simplifies specified face using mesh optimizer.
     // Returns reached simplification ratio. -1 in case of a failure.
-    F32 genMeshOptimizerPerFace(LLModel *base_model, LLModel *target_model, U32 face_idx, F32 indices_ratio, F32 error_threshold, eSimplificationMode simplification_mode);
+    static F32 genMeshOptimizerPerFace(LLModel *base_model, LLModel *target_model, U32 face_idx, F32 indices_ratio, F32 error_threshold, eSimplificationMode simplification_mode);
+    // Simplifies base_model into target_model for one lod with the given
+    // method.  Touches nothing but the two models, so any thread can run it.
+    static void genMeshOptimizerModelLOD(LLModel *base_model, LLModel *target_model, S32 lod, S32 meshopt_mode, U32 lod_mode, U32 decimation, F32 indices_decimator, F32 error_threshold);
 
 protected:
     friend class LLModelLoader;
     friend class LLFloaterModelPreview;
     friend class LLFloaterModelPreview::DecompRequest;
     friend class LLPhysicsDecomp;
+    friend class LLModelLODJobs;
 
     LLFloater*  mFMP;
 
@@ -290,6 +312,8 @@ protected:
 
     // Model generation parameters (must rebuild object if these change)
     bool mLODFrozen;
+    // LOD generation running on the general thread pool, if any
+    std::shared_ptr<LLModelLODJobs> mLODJobs;
     U32 mRequestedLoDMode[LLModel::NUM_LODS];
     S32 mRequestedTriangleCount[LLModel::NUM_LODS];
     F32 mRequestedErrorThreshold[LLModel::NUM_LODS];
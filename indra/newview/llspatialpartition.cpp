@@ -4073,6 +4073,36 @@ U64 LLDrawInfo::getSkinHash()
     return mSkinInfo ? mSkinInfo->mHash : 0;
 }
 
+LLDrawInfo::StateKey LLDrawInfo::getStateKey()
+{
+	StateKey key;
+	key.mShaderMask = mShaderMask;
+	key.mTexture = mTexture.get();
+	key.mMaterial = mMaterial.get();
+	key.mModelMatrix = mModelMatrix;
+	key.mVertexBuffer = mVertexBuffer.get();
+	key.mOffset = mOffset;
+	key.mDrawInfo = this;
+	return key;
+}
+
+bool LLDrawInfo::canMultiDraw(const LLDrawInfo& other) const
+{
+	return mVertexBuffer == other.mVertexBuffer &&
+		mGroup == other.mGroup &&
+		mTexture == other.mTexture &&
+		mTextureList == other.mTextureList &&
+		mTextureMatrix == other.mTextureMatrix &&
+		mModelMatrix == other.mModelMatrix &&
+		mDrawMode == other.mDrawMode &&
+		mSelected == other.mSelected &&
+		mMaterial == other.mMaterial &&
+		mShaderMask == other.mShaderMask &&
+		mAlphaMaskCutoff == other.mAlphaMaskCutoff &&
+		mAvatar == other.mAvatar &&
+		mSkinInfo == other.mSkinInfo;
+}
+
 LLVertexBuffer* LLGeometryManager::createVertexBuffer(U32 type_mask, U32 usage)
 {
 	return new LLVertexBuffer(type_mask, usage);
@@ -4357,6 +4387,35 @@ void LLCullResult::pushDrawInfo(U32 type, LLDrawInfo* draw_info)
 }
 
 
+void LLCullResult::sortRenderMap(U32 type)
+{
+	U32 count = mRenderMapSize[type];
+	if (count < 2)
+	{
+		return;
+	}
+
+	// sort copies of the keys rather than chasing LLDrawInfo pointers on every compare
+	static std::vector<LLDrawInfo::StateKey> keys;
+	keys.clear();
+	for (U32 i = 0; i < count; ++i)
+	{
+		LLDrawInfo* info = mRenderMap[type][i];
+		if (!info)
+		{ //leave maps with holes in submission order
+			return;
+		}
+		keys.push_back(info->getStateKey());
+	}
+
+	std::sort(keys.begin(), keys.end());
+
+	for (U32 i = 0; i < count; ++i)
+	{
+		mRenderMap[type][i] = keys[i].mDrawInfo;
+	}
+}
+
 void LLCullResult::assertDrawMapsEmpty()
 {
 	for (U32 i = 0; i < LLRenderPass::NUM_RENDER_TYPES; i++)
@@ -43,6 +43,7 @@
 #include "llvoavatar.h"
 
 #include <queue>
+#include <tuple>
 #include <unordered_map>
 
 #define SG_STATE_INHERIT_MASK (OCCLUDED)
@@ -85,6 +86,32 @@ public:
     // return mSkinHash->mHash, or 0 if mSkinHash is null
     U64 getSkinHash();
 
+	// State that has to be set before this draws, most expensive to change
+	// first.  Render maps of opaque passes are sorted by it so draws sharing
+	// state end up next to each other (see LLCullResult::sortRenderMap).
+	struct StateKey
+	{
+		U32 mShaderMask;
+		const LLViewerTexture* mTexture;
+		const LLMaterial* mMaterial;
+		const LLMatrix4* mModelMatrix;
+		const LLVertexBuffer* mVertexBuffer;
+		U32 mOffset;
+		LLDrawInfo* mDrawInfo;
+
+		bool operator<(const StateKey& rhs) const
+		{
+			return std::tie(mShaderMask, mTexture, mMaterial, mModelMatrix, mVertexBuffer, mOffset) <
+				std::tie(rhs.mShaderMask, rhs.mTexture, rhs.mMaterial, rhs.mModelMatrix, rhs.mVertexBuffer, rhs.mOffset);
+		}
+	};
+
+	StateKey getStateKey();
+
+	// true if this and other only differ in their index range, so one
+	// glMultiDrawElements call can draw both
+	bool canMultiDraw(const LLDrawInfo& other) const;
+
 	LLVector4a mExtents[2];
 	
 	LLPointer<LLVertexBuffer> mVertexBuffer;
@@ -516,6 +543,8 @@ public:
 	void pushDrawable(LLDrawable* drawable);
 	void pushBridge(LLSpatialBridge* bridge);
 	void pushDrawInfo(U32 type, LLDrawInfo* draw_info);
+	// order the render map of type by LLDrawInfo::StateKey
+	void sortRenderMap(U32 type);
 	
 	U32 getVisibleGroupsSize()		{ return mVisibleGroupsSize; }
 	U32	getAlphaGroupsSize()		{ return mAlphaGroupsSize; }
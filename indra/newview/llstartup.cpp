@@ -676,6 +676,8 @@ bool idle_startup()
 
 				if (gAudiop)
 				{
+					gAudiop->getPCMCache().setMaxBytes((U64)gSavedSettings.getU32("AudioPCMCacheSizeMB") * 1024 * 1024);
+
 					// if the audio engine hasn't set up its own preferred handler for streaming audio then set up the generic streaming audio implementation which uses media plugins
 					if (NULL == gAudiop->getStreamingAudioImpl())
 					{
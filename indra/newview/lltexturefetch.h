@@ -33,6 +33,7 @@
 #include "lldir.h"
 #include "llimage.h"
 #include "lluuid.h"
+#include "lluuidhashmap.h"
 #include "llworkerthread.h"
 #include "lltextureinfo.h"
 #include "llimageworker.h"
@@ -325,7 +326,7 @@ private:
 	LLImageDecodeThread* mImageDecodeThread;
 	
 	// Map of all requests by UUID
-	typedef std::map<LLUUID,LLTextureFetchWorker*> map_t;
+	typedef LLUUIDHashMap<LLTextureFetchWorker*> map_t;
 	map_t mRequestMap;													// Mfq
 
 	// Set of requests that require network data
@@ -38,6 +38,7 @@
 #include "lltransfersourceasset.h"
 #include "lltransfertargetvfile.h"
 #include "llviewerassetstats.h"
+#include "llviewercontrol.h"
 #include "llcoros.h"
 #include "llcoproceduremanager.h"
 #include "lleventcoro.h"
@@ -51,6 +52,14 @@
  // There is also PoolSizeAssetStorage value in setting that should mirror this name
 static const std::string VIEWER_ASSET_STORAGE_CORO_POOL = "AssetStorage";
 
+// Fetches handed to the coroutine pool at once, enough to keep every
+// coroutine busy between calls to checkForTimeouts()
+static U32 get_max_queued_fetches()
+{
+    U32 pool_size = gSavedSettings.getU32("PoolSize" + VIEWER_ASSET_STORAGE_CORO_POOL);
+    return llclamp(pool_size * 2, (U32)1, LLCoprocedureManager::DEFAULT_QUEUE_SIZE - 1);
+}
+
 /**
  * @brief Local class to encapsulate asset fetch requests with a timestamp.
  *
@@ -114,6 +123,7 @@ LLViewerAssetStorage::LLViewerAssetStorage(LLMessageSystem *msg, LLXferManager *
       mTotalBytesFetched(0)
 {
     LLCoprocedureManager::instance().initializePool(VIEWER_ASSET_STORAGE_CORO_POOL);
+    mMaxQueuedFetches = get_max_queued_fetches();
 }
 
 LLViewerAssetStorage::LLViewerAssetStorage(LLMessageSystem *msg, LLXferManager *xfer)
@@ -125,6 +135,7 @@ LLViewerAssetStorage::LLViewerAssetStorage(LLMessageSystem *msg, LLXferManager *
       mTotalBytesFetched(0)
 {
     LLCoprocedureManager::instance().initializePool(VIEWER_ASSET_STORAGE_CORO_POOL);
+    mMaxQueuedFetches = get_max_queued_fetches();
 }
 
 LLViewerAssetStorage::~LLViewerAssetStorage()
@@ -135,12 +146,12 @@ LLViewerAssetStorage::~LLViewerAssetStorage()
         LLCoprocedureManager::instance().close(VIEWER_ASSET_STORAGE_CORO_POOL);
     }
 
-    while (mCoroWaitList.size() > 0)
+    LLUUID uuid;
+    LLAssetType::EType atype;
+    while (mWaitingFetches.pop(uuid, atype))
     {
-        CoroWaitList &request = mCoroWaitList.front();
         // Clean up pending downloads, delete request and trigger callbacks
-        removeAndCallbackPendingDownloads(request.mId, request.mType, request.mId, request.mType, LL_ERR_NOERR, LLExtStat::NONE);
-        mCoroWaitList.pop_front();
+        removeAndCallbackPendingDownloads(uuid, atype, uuid, atype, LL_ERR_NOERR, LLExtStat::NONE);
     }
 }
 
@@ -351,20 +362,30 @@ void LLViewerAssetStorage::checkForTimeouts()
     LLAssetStorage::checkForTimeouts();
 
     // Restore requests
+    startWaitingRequests();
+}
+
+void LLViewerAssetStorage::startWaitingRequests()
+{
     LLCoprocedureManager* manager = LLCoprocedureManager::getInstance();
-    while (mCoroWaitList.size() > 0
-           && manager->count(VIEWER_ASSET_STORAGE_CORO_POOL) < (LLCoprocedureManager::DEFAULT_QUEUE_SIZE - 1))
+    LLUUID uuid;
+    LLAssetType::EType atype;
+    while (manager->count(VIEWER_ASSET_STORAGE_CORO_POOL) < mMaxQueuedFetches
+           && mWaitingFetches.pop(uuid, atype))
     {
-        CoroWaitList &request = mCoroWaitList.front();
-        
+        // Requests that timed out while waiting are already gone
+        LLViewerAssetRequest* req = static_cast<LLViewerAssetRequest*>(findPendingDownload(uuid, atype));
+        if (!req)
+        {
+            continue;
+        }
+
         bool with_http = true;
         bool is_temp = false;
-        LLViewerAssetStatsFF::record_enqueue(request.mType, with_http, is_temp);
+        LLViewerAssetStatsFF::record_enqueue(atype, with_http, is_temp);
 
         manager->enqueueCoprocedure(VIEWER_ASSET_STORAGE_CORO_POOL, "LLViewerAssetStorage::assetRequestCoro",
-            boost::bind(&LLViewerAssetStorage::assetRequestCoro, this, request.mRequest, request.mId, request.mType, request.mCallback, request.mUserData));
-
-        mCoroWaitList.pop_front();
+            boost::bind(&LLViewerAssetStorage::assetRequestCoro, this, req, uuid, atype, req->mDownCallback, req->mUserData));
     }
 }
 
@@ -419,26 +440,19 @@ void LLViewerAssetStorage::queueRequestHttp(
         // are piggy-backing and will artificially lower averages.
         req->mMetricsStartTime = LLViewerAssetStatsFF::get_timestamp();
     }
-    mPendingDownloads.push_back(req);
+    addPendingDownload(req);
 
+    LLAssetFetchQueue::EPriority priority = is_priority ? LLAssetFetchQueue::PRIORITY_HIGH : LLAssetFetchQueue::PRIORITY_NORMAL;
     // This is the same as the current UDP logic - don't re-request a duplicate.
     if (!duplicate)
     {
-        // Coroutine buffer has fixed size (synchronization buffer, so we have no alternatives), so buffer any request above limit
-        LLCoprocedureManager* manager = LLCoprocedureManager::getInstance();
-        if (manager->count(VIEWER_ASSET_STORAGE_CORO_POOL) < (LLCoprocedureManager::DEFAULT_QUEUE_SIZE - 1))
-        {
-            bool with_http = true;
-            bool is_temp = false;
-            LLViewerAssetStatsFF::record_enqueue(atype, with_http, is_temp);
-
-            manager->enqueueCoprocedure(VIEWER_ASSET_STORAGE_CORO_POOL, "LLViewerAssetStorage::assetRequestCoro",
-                boost::bind(&LLViewerAssetStorage::assetRequestCoro, this, req, uuid, atype, callback, user_data));
-        }
-        else
-        {
-            mCoroWaitList.emplace_back(req, uuid, atype, callback, user_data);
-        }
+        mWaitingFetches.push(uuid, atype, priority);
+        startWaitingRequests();
+    }
+    else
+    {
+        // Someone waiting on the fetch now needs it sooner
+        mWaitingFetches.raisePriority(uuid, atype, priority);
     }
 }
 
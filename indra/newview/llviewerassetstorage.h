@@ -27,6 +27,7 @@
 #ifndef LLVIEWERASSETSTORAGE_H
 #define LLVIEWERASSETSTORAGE_H
 
+#include "llassetfetchqueue.h"
 #include "llassetstorage.h"
 #include "llcorehttputil.h"
 
@@ -94,32 +95,14 @@ protected:
 
     void logAssetStorageInfo() override;
 
-    // Asset storage works through coroutines and coroutines have limited queue capacity
-    // This class is meant to temporary store requests when fiber's queue is full
-    class CoroWaitList
-    {
-    public:
-        CoroWaitList(LLViewerAssetRequest *req,
-            const LLUUID& uuid,
-            LLAssetType::EType atype,
-            LLGetAssetCallback &callback,
-            void *user_data)
-          : mRequest(req),
-            mId(uuid),
-            mType(atype),
-            mCallback(callback),
-            mUserData(user_data)
-        {
-        }
-
-        LLViewerAssetRequest* mRequest;
-        LLUUID mId;
-        LLAssetType::EType mType;
-        LLGetAssetCallback mCallback;
-        void *mUserData;
-    };
-    typedef std::list<CoroWaitList> wait_list_t;
-    wait_list_t mCoroWaitList;
+    // Start waiting fetches, most urgent first, while the coroutine pool has room
+    void startWaitingRequests();
+
+    // Fetches not yet handed to the coroutine pool.  Only a couple of pools'
+    // worth of fetches are queued there at once (it serves them in order), so
+    // interactive requests can overtake background ones that are waiting here.
+    LLAssetFetchQueue mWaitingFetches;
+    U32 mMaxQueuedFetches;
 
     std::string mViewerAssetUrl;
     S32 mCountRequests;
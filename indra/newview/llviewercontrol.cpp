@@ -63,6 +63,7 @@
 #include "llkeyboard.h"
 #include "llerrorcontrol.h"
 #include "llappviewer.h"
+#include "lltracetimeline.h"
 #include "llvosurfacepatch.h"
 #include "llvowlsky.h"
 #include "llrender.h"
@@ -636,6 +637,12 @@ bool toggle_show_object_render_cost(const LLSD& newvalue)
 	return true;
 }
 
+static bool handleTimelineTraceChanged(const LLSD& newvalue)
+{
+	LLTrace::Timeline::setEnabled(newvalue.asBoolean());
+	return true;
+}
+
 void handleRenderAutoMuteByteLimitChanged(const LLSD& new_value);
 ////////////////////////////////////////////////////////////////////////////
 
@@ -744,6 +751,7 @@ void settings_setup_listeners()
 	setting_setup_signal_listener(gSavedSettings, "RenderVBOMappingDisable", handleResetVertexBuffersChanged);
 	setting_setup_signal_listener(gSavedSettings, "RenderUseStreamVBO", handleResetVertexBuffersChanged);
 	setting_setup_signal_listener(gSavedSettings, "RenderPreferStreamDraw", handleResetVertexBuffersChanged);
+	setting_setup_signal_listener(gSavedSettings, "RenderStreamRing", handleResetVertexBuffersChanged);
 	setting_setup_signal_listener(gSavedSettings, "WLSkyDetail", handleWLSkyDetailChanged);
 	setting_setup_signal_listener(gSavedSettings, "JoystickAxis0", handleJoystickChanged);
 	setting_setup_signal_listener(gSavedSettings, "JoystickAxis1", handleJoystickChanged);
@@ -817,6 +825,7 @@ void settings_setup_listeners()
 	setting_setup_signal_listener(gSavedSettings, "LoginLocation", handleLoginLocationChanged);
 	setting_setup_signal_listener(gSavedSettings, "DebugAvatarJoints", handleDebugAvatarJointsChanged);
 	setting_setup_signal_listener(gSavedSettings, "RenderAutoMuteByteLimit", handleRenderAutoMuteByteLimitChanged);
+	setting_setup_signal_listener(gSavedSettings, "TimelineTraceEnabled", handleTimelineTraceChanged);
 
     setting_setup_signal_listener(gSavedPerAccountSettings, "AvatarHoverOffsetZ", handleAvatarHoverOffsetChanged);
 }
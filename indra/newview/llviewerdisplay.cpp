@@ -76,6 +76,7 @@
 #include "lldrawpoolbump.h"
 #include "llpostprocess.h"
 #include "llscenemonitor.h"
+#include "lltracememaccount.h"
 
 #include "llenvironment.h"
 
@@ -225,6 +226,7 @@ void display_stats()
 		U32Megabytes memory = gMemoryAllocated;
 		LL_INFOS() << "MEMORY: " << memory << LL_ENDL;
 		LLMemory::logMemoryInfo(TRUE) ;
+		LLTrace::MemAccount::logSnapshot();
 		gRecentMemoryTime.reset();
 	}
     F32 asset_storage_log_freq = gSavedSettings.getF32("AssetStorageLogFrequency");
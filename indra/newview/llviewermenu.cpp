@@ -33,6 +33,7 @@
 #include "llviewermenu.h" 
 
 // linden library includes
+#include "llaudiodecodemgr.h"
 #include "llavatarnamecache.h"  // IDEVO (I Are Not Men!)
 #include "llcombobox.h"
 #include "llcoros.h"
@@ -55,8 +56,10 @@
 #include "llconsole.h"
 #include "lldebugview.h"
 #include "lldiskcache.h"
+#include "lldrawpoolbump.h"
 #include "llenvironment.h"
 #include "llfilepicker.h"
+#include "llfilesystem.h"
 #include "llfirstuse.h"
 #include "llfloaterabout.h"
 #include "llfloaterbuy.h"
@@ -79,6 +82,7 @@
 #include "llfloaterbuildoptions.h"
 #include "llavataractions.h"
 #include "lllandmarkactions.h"
+#include "lllfsthread.h"
 #include "llgroupmgr.h"
 #include "lltooltip.h"
 #include "lltoolface.h"
@@ -94,6 +98,7 @@
 #include "llpanelmaininventory.h"
 #include "llmarketplacefunctions.h"
 #include "llmenuoptionpathfindingrebakenavmesh.h"
+#include "llmodelpreview.h"
 #include "llmoveview.h"
 #include "llnavigationbar.h"
 #include "llparcel.h"
@@ -121,6 +126,7 @@
 #include "llviewerstats.h"
 #include "llvoavatarself.h"
 #include "llvoicevivox.h"
+#include "llvotree.h"
 #include "llworldmap.h"
 #include "pipeline.h"
 #include "llviewerjoystick.h"
@@ -2129,6 +2135,61 @@ class LLAdvancedPurgeDiskCache : public view_listener_t
 	}
 };
 
+class LLAdvancedDiskCacheBenchmark : public view_listener_t
+{
+	bool handleEvent(const LLSD& userdata)
+	{
+        LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
+        LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+        llassert_always(main_queue);
+        llassert_always(general_queue);
+        main_queue->postTo(
+            general_queue,
+            []() // Work done on general queue
+            {
+                LLFileSystem::runBenchmark(10000, 256);
+            },
+            [](){});
+
+		return true;
+	}
+};
+
+class LLAdvancedDiskIOBenchmark : public view_listener_t
+{
+	bool handleEvent(const LLSD& userdata)
+	{
+        LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
+        LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+        llassert_always(main_queue);
+        llassert_always(general_queue);
+        std::vector<std::string> dirs;
+        dirs.push_back(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "texturecache"));
+        dirs.push_back(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, gSavedSettings.getString("DiskCacheDirName")));
+        bool allow_io_uring = gSavedSettings.getBOOL("LFSUseIOUring");
+        main_queue->postTo(
+            general_queue,
+            [dirs, allow_io_uring]() // Work done on general queue
+            {
+                LLLFSThread::runBenchmark(dirs, 2000, allow_io_uring);
+            },
+            [](){});
+
+		return true;
+	}
+};
+
+class LLAdvancedAudioDecodeBenchmark : public view_listener_t
+{
+	bool handleEvent(const LLSD& userdata)
+	{
+		// Runs on the main thread: the decodes go through the normal queue
+		// and are timed as processQueue() finishes them
+		LLAudioDecodeMgr::getInstance()->startBenchmark(gSavedSettings.getString("AudioDecodeBenchmarkDir"));
+		return true;
+	}
+};
+
 
 ////////////////////
 // EVENT Recorder //
@@ -7836,6 +7897,33 @@ class LLAdvancedClickRenderBenchmark: public view_listener_t
 	}
 };
 
+class LLAdvancedClickTreeBenchmark: public view_listener_t
+{
+	bool handleEvent(const LLSD& userdata)
+	{
+		LLVOTree::runForestBenchmark(1000);
+		return true;
+	}
+};
+
+class LLAdvancedClickBumpBenchmark: public view_listener_t
+{
+	bool handleEvent(const LLSD& userdata)
+	{
+		LLBumpImageList::runBenchmark(16);
+		return true;
+	}
+};
+
+class LLAdvancedClickMeshLODBenchmark: public view_listener_t
+{
+	bool handleEvent(const LLSD& userdata)
+	{
+		LLModelPreview::runLODBenchmark(gSavedSettings.getString("MeshLODBenchmarkFile"));
+		return true;
+	}
+};
+
 // these are used in the gl menus to set control values that require shader recompilation
 class LLToggleShaderControl : public view_listener_t
 {
@@ -8197,6 +8285,11 @@ void handle_dump_timers()
 	LLTrace::BlockTimer::dumpCurTimes();
 }
 
+void handle_save_timeline_trace()
+{
+	LLAppViewer::instance()->saveTimelineTrace("timeline");
+}
+
 void handle_debug_avatar_textures(void*)
 {
 	LLViewerObject* objectp = LLSelectMgr::getInstance()->getSelection()->getPrimaryObject();
@@ -9434,6 +9527,9 @@ void initialize_menus()
 	view_listener_t::addMenu(new LLAdvancedClickRenderShadowOption(), "Advanced.ClickRenderShadowOption");
 	view_listener_t::addMenu(new LLAdvancedClickRenderProfile(), "Advanced.ClickRenderProfile");
 	view_listener_t::addMenu(new LLAdvancedClickRenderBenchmark(), "Advanced.ClickRenderBenchmark");
+	view_listener_t::addMenu(new LLAdvancedClickTreeBenchmark(), "Advanced.ClickTreeBenchmark");
+	view_listener_t::addMenu(new LLAdvancedClickBumpBenchmark(), "Advanced.ClickBumpBenchmark");
+	view_listener_t::addMenu(new LLAdvancedClickMeshLODBenchmark(), "Advanced.ClickMeshLODBenchmark");
 
 	#ifdef TOGGLE_HACKED_GODLIKE_VIEWER
 	view_listener_t::addMenu(new LLAdvancedHandleToggleHackedGodmode(), "Advanced.HandleToggleHackedGodmode");
@@ -9455,6 +9551,7 @@ void initialize_menus()
 	view_listener_t::addMenu(new LLAdvancedDumpSelectMgr(), "Advanced.DumpSelectMgr");
 	view_listener_t::addMenu(new LLAdvancedDumpInventory(), "Advanced.DumpInventory");
 	commit.add("Advanced.DumpTimers", boost::bind(&handle_dump_timers) );
+	commit.add("Advanced.SaveTimelineTrace", boost::bind(&handle_save_timeline_trace) );
 	commit.add("Advanced.DumpFocusHolder", boost::bind(&handle_dump_focus) );
 	view_listener_t::addMenu(new LLAdvancedPrintSelectedObjectInfo(), "Advanced.PrintSelectedObjectInfo");
 	view_listener_t::addMenu(new LLAdvancedPrintAgentInfo(), "Advanced.PrintAgentInfo");
@@ -9521,6 +9618,9 @@ void initialize_menus()
 
     // Advanced > Cache
     view_listener_t::addMenu(new LLAdvancedPurgeDiskCache(), "Advanced.PurgeDiskCache");
+    view_listener_t::addMenu(new LLAdvancedDiskCacheBenchmark(), "Advanced.DiskCacheBenchmark");
+    view_listener_t::addMenu(new LLAdvancedDiskIOBenchmark(), "Advanced.DiskIOBenchmark");
+    view_listener_t::addMenu(new LLAdvancedAudioDecodeBenchmark(), "Advanced.AudioDecodeBenchmark");
 
 	// Advanced > Recorder
 	view_listener_t::addMenu(new LLAdvancedAgentPilot(), "Advanced.AgentPilot");
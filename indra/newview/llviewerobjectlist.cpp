@@ -109,6 +109,7 @@ LLViewerObjectList::LLViewerObjectList()
 	mNumDeadObjects = 0;
 	mNumOrphans = 0;
 	mNumNewObjects = 0;
+	mNumIdleUpdates = 0;
 	mWasPaused = FALSE;
 	mNumDeadObjectUpdates = 0;
 	mNumUnknownUpdates = 0;
@@ -953,6 +954,7 @@ void LLViewerObjectList::update(LLAgent &agent)
 			llassert(objectp->isActive());
                 objectp->idleUpdate(agent, frame_time);
 		}
+		mNumIdleUpdates += idle_count;
 
 		//update flexible objects
 		LLVolumeImplFlexible::updateClass();
@@ -33,6 +33,7 @@
 // common includes
 #include "llstring.h"
 #include "lltrace.h"
+#include "lluuidhashmap.h"
 
 // project includes
 #include "llviewerobject.h"
@@ -172,6 +173,8 @@ public:
 
 	// Statistics data (see also LLViewerStats)
 	S32 mNumNewObjects;
+	// Running total of active object idleUpdate() calls
+	U32 mNumIdleUpdates;
 
 	// if we paused in the last frame
 	// used to discount stats from this frame
@@ -207,7 +210,8 @@ protected:
 
     uuid_set_t   mDeadObjects;
 
-	std::map<LLUUID, LLPointer<LLViewerObject> > mUUIDObjectMap;
+	typedef LLUUIDHashMap<LLPointer<LLViewerObject> > uuid_object_map_t;
+	uuid_object_map_t mUUIDObjectMap;
 
 	//set of objects that need to update their cost
     uuid_set_t   mStaleObjectCost;
@@ -265,7 +269,7 @@ extern LLViewerObjectList gObjectList;
  */
 inline LLViewerObject *LLViewerObjectList::findObject(const LLUUID &id)
 {
-	std::map<LLUUID, LLPointer<LLViewerObject> >::iterator iter = mUUIDObjectMap.find(id);
+	uuid_object_map_t::iterator iter = mUUIDObjectMap.find(id);
 	if(iter != mUUIDObjectMap.end())
 	{
 		return iter->second;
@@ -41,6 +41,7 @@ U32 LLViewerOctreeEntryData::sCurVisible = 10; //reserve the low numbers for spe
 BOOL LLViewerOctreeDebug::sInDebug = FALSE;
 
 static LLTrace::CountStatHandle<S32> sOcclusionQueries("occlusion_queries", "Number of occlusion queries executed"),
+									 sOcclusionResultsPending("occlusion_results_pending", "Occlusion query results checked before the GPU had them ready"),
 									 sNumObjectsOccluded("occluded_objects", "Count of objects being occluded by a query"),
 									 sNumObjectsUnoccluded("unoccluded_objects", "Count of objects being unoccluded by a query");
 
@@ -790,6 +791,24 @@ std::set<U32> LLOcclusionCullingGroup::sPendingQueries;
 
 static std::queue<GLuint> sFreeQueries;
 
+//occlusion queries queued between beginOcclusionBatch and endOcclusionBatch
+struct LLOcclusionBatchEntry
+{
+	GLuint mQuery;
+	U32 mMode;
+	bool mDepthClamp;
+	LLVector3 mCenter;
+	LLVector3 mSize;
+	U32 mFans[2];		//offsets of the box's triangle fans in ll_create_cube_vb's indices
+	U32 mFanCount;		//1, or 2 when the camera origin is unknown and the whole box is drawn
+	U32 mFirstVertex;	//first vertex of the box's fans in sOcclusionBatchVerts
+};
+
+static bool sOcclusionBatchOpen = false;
+static std::vector<LLOcclusionBatchEntry> sOcclusionBatch;
+static std::vector<LLVector3> sOcclusionBatchVerts;
+static LLPointer<LLVertexBuffer> sOcclusionBatchVB;
+
 #define QUERY_POOL_SIZE 1024
 
 U32 LLOcclusionCullingGroup::getNewOcclusionQueryObjectName()
@@ -822,6 +841,157 @@ void LLOcclusionCullingGroup::releaseOcclusionQueryObjectName(GLuint name)
     }
 }
 
+//static
+void LLOcclusionCullingGroup::beginOcclusionBatch()
+{
+	llassert(!sOcclusionBatchOpen);
+	sOcclusionBatchOpen = true;
+	sOcclusionBatch.clear();
+	sOcclusionBatchVerts.clear();
+}
+
+//static
+void LLOcclusionCullingGroup::queueOcclusionBox(LLCamera* camera, const LLVector4a& center, const LLVector4a& size, U32 query, U32 mode, bool depth_clamp)
+{
+	LLOcclusionBatchEntry entry;
+	entry.mQuery = query;
+	entry.mMode = mode;
+	entry.mDepthClamp = depth_clamp;
+	entry.mCenter.set(center.getF32ptr());
+	entry.mSize.set(size.getF32ptr());
+	entry.mFirstVertex = sOcclusionBatchVerts.size();
+
+	if (camera->getOrigin().isExactlyZero())
+	{ //origin is invalid, draw entire box
+		entry.mFans[0] = 0;
+		entry.mFans[1] = b111*8;
+		entry.mFanCount = 2;
+	}
+	else
+	{
+		entry.mFans[0] = get_box_fan_indices(camera, center);
+		entry.mFanCount = 1;
+	}
+
+	//the fans ll_create_cube_vb's indices describe, with the box transform
+	//the occlusion cube shader would apply done here instead
+	for (U32 f = 0; f < entry.mFanCount; ++f)
+	{
+		for (U32 i = 0; i < 8; ++i)
+		{
+			U16 corner = sOcclusionIndices[entry.mFans[f] + i];
+			sOcclusionBatchVerts.push_back(LLVector3(
+				center[0] + (corner & b100 ? size[0] : -size[0]),
+				center[1] + (corner & b010 ? size[1] : -size[1]),
+				center[2] + (corner & b001 ? size[2] : -size[2])));
+		}
+	}
+
+	sOcclusionBatch.push_back(entry);
+}
+
+//static
+//static
+void LLOcclusionCullingGroup::destroyGL()
+{
+	llassert(!sOcclusionBatchOpen);
+	sOcclusionBatchVB = NULL;
+}
+
+void LLOcclusionCullingGroup::endOcclusionBatch()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_OCTREE;
+	llassert(sOcclusionBatchOpen);
+	sOcclusionBatchOpen = false;
+
+	if (sOcclusionBatch.empty())
+	{
+		return;
+	}
+
+	LLGLSLShader* shader = LLGLSLShader::sCurBoundShaderPtr;
+	llassert(shader);
+
+	U32 vert_count = sOcclusionBatchVerts.size();
+	if (sOcclusionBatchVB.isNull() || sOcclusionBatchVB->getNumVerts() < (S32) vert_count)
+	{ //grow in steps of 1024 boxes so the buffer settles after a few frames
+		U32 alloc_count = (vert_count + 8191) & ~8191;
+		sOcclusionBatchVB = new LLVertexBuffer(LLVertexBuffer::MAP_VERTEX, GL_STREAM_DRAW_ARB);
+		if (!sOcclusionBatchVB->allocateBuffer(alloc_count, 0, true))
+		{
+			LL_WARNS() << "Failed to allocate occlusion batch buffer for " << alloc_count << " vertices" << LL_ENDL;
+			sOcclusionBatchVB = NULL;
+		}
+	}
+
+	if (sOcclusionBatchVB.isNull())
+	{ //draw the boxes one at a time from the cube buffer like doOcclusion would have
+		for (std::vector<LLOcclusionBatchEntry>::iterator iter = sOcclusionBatch.begin(); iter != sOcclusionBatch.end(); ++iter)
+		{
+			LLGLEnable clamp(iter->mDepthClamp ? GL_DEPTH_CLAMP : 0);
+			shader->uniform3fv(LLShaderMgr::BOX_CENTER, 1, iter->mCenter.mV);
+			shader->uniform3fv(LLShaderMgr::BOX_SIZE, 1, iter->mSize.mV);
+			glBeginQueryARB(iter->mMode, iter->mQuery);
+			for (U32 f = 0; f < iter->mFanCount; ++f)
+			{
+				gPipeline.mCubeVB->drawRange(LLRender::TRIANGLE_FAN, 0, 7, 8, iter->mFans[f]);
+			}
+			glEndQueryARB(iter->mMode);
+		}
+		sOcclusionBatch.clear();
+		sOcclusionBatchVerts.clear();
+		return;
+	}
+
+	{
+		LL_PROFILE_ZONE_NAMED_CATEGORY_OCTREE("occlusion batch - upload");
+		LLStrider<LLVector3> pos;
+		sOcclusionBatchVB->getVertexStrider(pos, 0, vert_count);
+		for (U32 i = 0; i < vert_count; ++i)
+		{
+			pos[i] = sOcclusionBatchVerts[i];
+		}
+		sOcclusionBatchVB->flush();
+	}
+
+	//vertices are already in agent space
+	shader->uniform3f(LLShaderMgr::BOX_CENTER, 0.f, 0.f, 0.f);
+	shader->uniform3f(LLShaderMgr::BOX_SIZE, 1.f, 1.f, 1.f);
+
+	sOcclusionBatchVB->setBuffer(LLVertexBuffer::MAP_VERTEX);
+
+	//water boxes are depth clamped, draw them after everything else so the clamp toggles once
+	for (U32 pass = 0; pass < 2; ++pass)
+	{
+		bool depth_clamp = pass == 1;
+		LLGLEnable clamp(depth_clamp && gGLManager.mHasDepthClamp ? GL_DEPTH_CLAMP : 0);
+
+		for (std::vector<LLOcclusionBatchEntry>::iterator iter = sOcclusionBatch.begin(); iter != sOcclusionBatch.end(); ++iter)
+		{
+			if (iter->mDepthClamp != depth_clamp)
+			{
+				continue;
+			}
+
+			glBeginQueryARB(iter->mMode, iter->mQuery);
+			for (U32 f = 0; f < iter->mFanCount; ++f)
+			{
+				sOcclusionBatchVB->drawArrays(LLRender::TRIANGLE_FAN, iter->mFirstVertex + f*8, 8);
+			}
+			glEndQueryARB(iter->mMode);
+		}
+	}
+
+	sOcclusionBatch.clear();
+	sOcclusionBatchVerts.clear();
+
+	//doOcclusion callers expect the cube buffer to stay bound
+	if (gPipeline.mCubeVB.notNull())
+	{
+		gPipeline.mCubeVB->setBuffer(LLVertexBuffer::MAP_VERTEX);
+	}
+}
+
 //=====================================
 //		Occlusion State Set/Clear
 //=====================================
@@ -1132,7 +1302,11 @@ void LLOcclusionCullingGroup::checkOcclusion()
                 glGetQueryObjectuivARB(mOcclusionQuery[LLViewerCamera::sCurCameraID], GL_QUERY_RESULT_AVAILABLE_ARB, &available);
             }
 
-            if (available)
+            if (!available)
+            {
+                add(sOcclusionResultsPending, 1);
+            }
+            else
             {   
                 GLuint query_result;    // Will be # samples drawn, or a boolean depending on mHasOcclusionQuery2 (both are type GLuint)
                 {
@@ -1244,55 +1418,65 @@ void LLOcclusionCullingGroup::doOcclusion(LLCamera* camera, const LLVector4a* sh
 						//store which frame this query was issued on
 						mOcclusionIssued[LLViewerCamera::sCurCameraID] = gFrameCount;
 
-                        {
-                            LL_PROFILE_ZONE_NAMED("glBeginQuery");
+                        //get an occlusion query that hasn't been used in awhile
+                        releaseOcclusionQueryObjectName(mOcclusionQuery[LLViewerCamera::sCurCameraID]);
+                        mOcclusionQuery[LLViewerCamera::sCurCameraID] = getNewOcclusionQueryObjectName();
 
-                            //get an occlusion query that hasn't been used in awhile
-                            releaseOcclusionQueryObjectName(mOcclusionQuery[LLViewerCamera::sCurCameraID]);
-                            mOcclusionQuery[LLViewerCamera::sCurCameraID] = getNewOcclusionQueryObjectName();
-                            glBeginQueryARB(mode, mOcclusionQuery[LLViewerCamera::sCurCameraID]);
+                        bool const squash = !use_depth_clamp && mSpatialPartition->mDrawableType == LLPipeline::RENDER_TYPE_VOIDWATER;
+                        if (sOcclusionBatchOpen && !squash)
+                        { //draw with the rest of the batch
+                            LLVector4a size;
+                            size.set(bounds[1][0] + SG_OCCLUSION_FUDGE, bounds[1][1] + SG_OCCLUSION_FUDGE, bounds[1][2] + OCCLUSION_FUDGE_Z);
+                            queueOcclusionBox(camera, bounds[0], size, mOcclusionQuery[LLViewerCamera::sCurCameraID], mode, use_depth_clamp);
                         }
+                        else
+                        {
+                            {
+                                LL_PROFILE_ZONE_NAMED("glBeginQuery");
+                                glBeginQueryARB(mode, mOcclusionQuery[LLViewerCamera::sCurCameraID]);
+                            }
 					
-						LLGLSLShader* shader = LLGLSLShader::sCurBoundShaderPtr;
-						llassert(shader);
-
-						shader->uniform3fv(LLShaderMgr::BOX_CENTER, 1, bounds[0].getF32ptr());
-						shader->uniform3f(LLShaderMgr::BOX_SIZE, bounds[1][0]+SG_OCCLUSION_FUDGE, 
-																 bounds[1][1]+SG_OCCLUSION_FUDGE, 
-																 bounds[1][2]+OCCLUSION_FUDGE_Z);
-
-						if (!use_depth_clamp && mSpatialPartition->mDrawableType == LLPipeline::RENDER_TYPE_VOIDWATER)
-						{
-                            LL_PROFILE_ZONE_NAMED_CATEGORY_OCTREE("doOcclusion - draw water");
-
-							LLGLSquashToFarClip squash;
-							if (camera->getOrigin().isExactlyZero())
-							{ //origin is invalid, draw entire box
-								gPipeline.mCubeVB->drawRange(LLRender::TRIANGLE_FAN, 0, 7, 8, 0);
-								gPipeline.mCubeVB->drawRange(LLRender::TRIANGLE_FAN, 0, 7, 8, b111*8);
-							}
-							else
+							LLGLSLShader* shader = LLGLSLShader::sCurBoundShaderPtr;
+							llassert(shader);
+
+							shader->uniform3fv(LLShaderMgr::BOX_CENTER, 1, bounds[0].getF32ptr());
+							shader->uniform3f(LLShaderMgr::BOX_SIZE, bounds[1][0]+SG_OCCLUSION_FUDGE, 
+																	 bounds[1][1]+SG_OCCLUSION_FUDGE, 
+																	 bounds[1][2]+OCCLUSION_FUDGE_Z);
+
+							if (!use_depth_clamp && mSpatialPartition->mDrawableType == LLPipeline::RENDER_TYPE_VOIDWATER)
 							{
-								gPipeline.mCubeVB->drawRange(LLRender::TRIANGLE_FAN, 0, 7, 8, get_box_fan_indices(camera, bounds[0]));
-							}
-						}
-						else
-						{
-                            LL_PROFILE_ZONE_NAMED_CATEGORY_OCTREE("doOcclusion - draw");
-							if (camera->getOrigin().isExactlyZero())
-							{ //origin is invalid, draw entire box
-								gPipeline.mCubeVB->drawRange(LLRender::TRIANGLE_FAN, 0, 7, 8, 0);
-								gPipeline.mCubeVB->drawRange(LLRender::TRIANGLE_FAN, 0, 7, 8, b111*8);
+                                LL_PROFILE_ZONE_NAMED_CATEGORY_OCTREE("doOcclusion - draw water");
+
+								LLGLSquashToFarClip squash;
+								if (camera->getOrigin().isExactlyZero())
+								{ //origin is invalid, draw entire box
+									gPipeline.mCubeVB->drawRange(LLRender::TRIANGLE_FAN, 0, 7, 8, 0);
+									gPipeline.mCubeVB->drawRange(LLRender::TRIANGLE_FAN, 0, 7, 8, b111*8);
+								}
+								else
+								{
+									gPipeline.mCubeVB->drawRange(LLRender::TRIANGLE_FAN, 0, 7, 8, get_box_fan_indices(camera, bounds[0]));
+								}
 							}
 							else
 							{
-								gPipeline.mCubeVB->drawRange(LLRender::TRIANGLE_FAN, 0, 7, 8, get_box_fan_indices(camera, bounds[0]));
+                                LL_PROFILE_ZONE_NAMED_CATEGORY_OCTREE("doOcclusion - draw");
+								if (camera->getOrigin().isExactlyZero())
+								{ //origin is invalid, draw entire box
+									gPipeline.mCubeVB->drawRange(LLRender::TRIANGLE_FAN, 0, 7, 8, 0);
+									gPipeline.mCubeVB->drawRange(LLRender::TRIANGLE_FAN, 0, 7, 8, b111*8);
+								}
+								else
+								{
+									gPipeline.mCubeVB->drawRange(LLRender::TRIANGLE_FAN, 0, 7, 8, get_box_fan_indices(camera, bounds[0]));
+								}
 							}
-						}
 	
-                        {
-                            LL_PROFILE_ZONE_NAMED("glEndQuery");
-                            glEndQueryARB(mode);
+                            {
+                                LL_PROFILE_ZONE_NAMED("glEndQuery");
+                                glEndQueryARB(mode);
+                            }
                         }
 					}
 				}
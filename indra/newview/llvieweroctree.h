@@ -322,11 +322,20 @@ public:
 	static U32 getNewOcclusionQueryObjectName();
 	static void releaseOcclusionQueryObjectName(U32 name);
 
+	//while a batch is open, doOcclusion queues its query instead of drawing it,
+	//and endOcclusionBatch draws every queued box from one vertex buffer
+	//expects the occlusion cube shader to be bound, like doOcclusion
+	static void beginOcclusionBatch();
+	static void endOcclusionBatch();
+	//release the batch vertex buffer, it's recreated on the next batch
+	static void destroyGL();
+
 protected:
 	void releaseOcclusionQueryObjectNames();
 
 private:	
 	BOOL earlyFail(LLCamera* camera, const LLVector4a* bounds);
+	static void queueOcclusionBox(LLCamera* camera, const LLVector4a& center, const LLVector4a& size, U32 query, U32 mode, bool depth_clamp);
 
 protected:
 	U32         mOcclusionState[LLViewerCamera::NUM_CAMERAS];
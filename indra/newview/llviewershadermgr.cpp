@@ -447,12 +447,19 @@ void LLViewerShaderMgr::setShaders()
 
     reentrance = true;
 
+    LLTimer load_timer;
+    static LLCachedControl<bool> use_shader_cache(gSavedSettings, "RenderShaderCache", true);
+    setProgramCacheDir(use_shader_cache ? gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "shader_cache") : std::string());
+    mProgramCacheHits = 0;
+    mProgramCacheMisses = 0;
+
     //setup preprocessor definitions
     LLShaderMgr::instance()->mDefinitions["NUM_TEX_UNITS"] = llformat("%d", gGLManager.mNumTextureImageUnits);
     
     // Make sure the compiled shader map is cleared before we recompile shaders.
     mVertexShaderObjects.clear();
     mFragmentShaderObjects.clear();
+    mShaderObjectHashes.clear();
     
     initAttribsAndUniforms();
     gPipeline.releaseGLBuffers();
@@ -730,6 +737,13 @@ void LLViewerShaderMgr::setShaders()
     }
     gPipeline.createGLBuffers();
 
+    LL_INFOS("ShaderLoading") << "Loaded shaders in " << load_timer.getElapsedTimeF32() << " seconds";
+    if (usingProgramCache())
+    {
+        LL_CONT << ", " << mProgramCacheHits << " programs from cache, " << mProgramCacheMisses << " compiled";
+    }
+    LL_CONT << LL_ENDL;
+
     reentrance = false;
 }
 
@@ -91,7 +91,11 @@ LLTrace::CountStatHandle<>	FPS("FPS", "Frames rendered"),
 							FRAMETIME_DOUBLED("frametimedoubled", "Ratio of frames 2x longer than previous"),
 							TEX_BAKES("texbakes", "Number of times avatar textures have been baked"),
 							TEX_REBAKES("texrebakes", "Number of times avatar textures have been forced to rebake"),
-							NUM_NEW_OBJECTS("numnewobjectsstat", "Number of objects in scene that were not previously in cache");
+							NUM_NEW_OBJECTS("numnewobjectsstat", "Number of objects in scene that were not previously in cache"),
+							DRAW_INFO_BATCHES("drawinfobatches", "Draw ranges submitted by render passes"),
+							DRAW_INFO_CALLS("drawinfocalls", "Draw calls issued for those ranges after merging"),
+							IMPOSTOR_UPDATES("impostorupdates", "Avatar impostors regenerated"),
+							IMPOSTOR_UPDATES_DEFERRED("impostorupdatesdeferred", "Avatar impostor updates pushed to a later frame by the per frame budget");
 
 LLTrace::CountStatHandle<LLUnit<F64, LLUnits::Kilotriangles> > 
 							TRIANGLES_DRAWN("trianglesdrawnstat");
@@ -105,13 +109,15 @@ LLTrace::CountStatHandle<F64Kilobytes >
 							OBJECT_NETWORK_DATA_RECEIVED("objectdatareceived", "Network data received for objects"),
 							ASSET_UDP_DATA_RECEIVED("assetudpdatareceived", "Network data received for assets (animations, sounds) over UDP message system"),
 							TEXTURE_NETWORK_DATA_RECEIVED("texturedatareceived", "Network data received for textures"),
+							TEXTURE_UPLOAD_DATA("textureuploaddata", "Texture data uploaded to GL"),
 							MESSAGE_SYSTEM_DATA_IN("messagedatain", "Incoming message system network data"),
 							MESSAGE_SYSTEM_DATA_OUT("messagedataout", "Outgoing message system network data");
 
 LLTrace::CountStatHandle<F64Seconds >	
 							SIM_20_FPS_TIME("sim20fpstime", "Seconds with sim FPS below 20"),
 							SIM_PHYSICS_20_FPS_TIME("simphysics20fpstime", "Seconds with physics FPS below 20"),
-							LOSS_5_PERCENT_TIME("loss5percenttime", "Seconds with packet loss > 5%");
+							LOSS_5_PERCENT_TIME("loss5percenttime", "Seconds with packet loss > 5%"),
+							TEXTURE_THREAD_CREATE_TIME("texturethreadcreatetime", "Seconds spent creating textures on the LLImageGL thread instead of the main thread");
 
 SimMeasurement<>			SIM_TIME_DILATION("simtimedilation", "Simulator time scale", LL_SIM_STAT_TIME_DILATION),
 							SIM_FPS("simfps", "Simulator framerate", LL_SIM_STAT_FPS),
@@ -150,7 +156,8 @@ LLTrace::SampleStatHandle<>	FPS_SAMPLE("fpssample"),
 							WINDOW_HEIGHT("windowheight", "Window height");
 
 LLTrace::SampleStatHandle<LLUnit<F32, LLUnits::Percent> > 
-							PACKETS_LOST_PERCENT("packetslostpercentstat");
+							PACKETS_LOST_PERCENT("packetslostpercentstat"),
+							IMPOSTOR_ATLAS_OCCUPANCY("impostoratlasoccupancy", "Share of the avatar impostor atlas in use");
 
 static LLTrace::SampleStatHandle<bool> 
 							CHAT_BUBBLES("chatbubbles", "Chat Bubbles Enabled");
@@ -391,6 +398,15 @@ void update_statistics()
 	add(LLStatViewer::ASSET_UDP_DATA_RECEIVED, F64Bits(gTransferManager.getTransferBitsIn(LLTCT_ASSET)));
 	gTransferManager.resetTransferBitsIn(LLTCT_ASSET);
 
+	static U64 last_upload_bytes = 0;
+	static U64 last_thread_create_time = 0;
+	U64 upload_bytes = LLImageGL::sUploadBytes.load(std::memory_order_relaxed);
+	U64 thread_create_time = LLImageGL::sThreadCreateTime.load(std::memory_order_relaxed);
+	add(LLStatViewer::TEXTURE_UPLOAD_DATA, F64Bytes((F64) (upload_bytes - last_upload_bytes)));
+	add(LLStatViewer::TEXTURE_THREAD_CREATE_TIME, F64Microseconds((F64) (thread_create_time - last_thread_create_time)));
+	last_upload_bytes = upload_bytes;
+	last_thread_create_time = thread_create_time;
+
 	sample(LLStatViewer::VISIBLE_AVATARS, LLVOAvatar::sNumVisibleAvatars);
     LLWorld *world = LLWorld::getInstance(); // not LLSingleton
     if (world)
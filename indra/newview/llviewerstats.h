@@ -138,7 +138,11 @@ extern LLTrace::CountStatHandle<>			FPS,
 											FRAMETIME_DOUBLED,
 											TEX_BAKES,
 											TEX_REBAKES,
-											NUM_NEW_OBJECTS;
+											NUM_NEW_OBJECTS,
+											DRAW_INFO_BATCHES,
+											DRAW_INFO_CALLS,
+											IMPOSTOR_UPDATES,
+											IMPOSTOR_UPDATES_DEFERRED;
 
 extern LLTrace::CountStatHandle<LLUnit<F64, LLUnits::Kilotriangles> > TRIANGLES_DRAWN;
 
@@ -147,12 +151,14 @@ extern LLTrace::CountStatHandle<F64Kilobytes >	ACTIVE_MESSAGE_DATA_RECEIVED,
 																	OBJECT_NETWORK_DATA_RECEIVED,
 																	ASSET_UDP_DATA_RECEIVED,
 																	TEXTURE_NETWORK_DATA_RECEIVED,
+																	TEXTURE_UPLOAD_DATA,
 																	MESSAGE_SYSTEM_DATA_IN,
 																	MESSAGE_SYSTEM_DATA_OUT;
 
 extern LLTrace::CountStatHandle<F64Seconds >		SIM_20_FPS_TIME,
 																	SIM_PHYSICS_20_FPS_TIME,
-																	LOSS_5_PERCENT_TIME;
+																	LOSS_5_PERCENT_TIME,
+																	TEXTURE_THREAD_CREATE_TIME;
 
 extern SimMeasurement<>						SIM_TIME_DILATION,
 											SIM_FPS,
@@ -189,7 +195,8 @@ extern LLTrace::SampleStatHandle<>		FPS_SAMPLE,
 										WINDOW_WIDTH,
 										WINDOW_HEIGHT;
 
-extern LLTrace::SampleStatHandle<LLUnit<F32, LLUnits::Percent> > PACKETS_LOST_PERCENT;
+extern LLTrace::SampleStatHandle<LLUnit<F32, LLUnits::Percent> > PACKETS_LOST_PERCENT,
+																IMPOSTOR_ATLAS_OCCUPANCY;
 
 extern LLTrace::SampleStatHandle<F64Megabytes >	GL_TEX_MEM,
 																	GL_BOUND_MEM,
@@ -1024,13 +1024,17 @@ F32 LLViewerTextureList::updateImagesCreateTextures(F32 max_time)
 	//
 		
 	LLTimer create_timer;
-	image_list_t::iterator enditer = mCreateTextureList.begin();
-	for (image_list_t::iterator iter = mCreateTextureList.begin();
-		 iter != mCreateTextureList.end();)
+
+	// create the most important textures first, whatever is left over waits
+	// for the next frame's budget
+	std::vector<LLPointer<LLViewerFetchedTexture> > create_list(mCreateTextureList.begin(), mCreateTextureList.end());
+	std::sort(create_list.begin(), create_list.end(), LLViewerFetchedTexture::Compare());
+
+	for (std::vector<LLPointer<LLViewerFetchedTexture> >::iterator iter = create_list.begin();
+		 iter != create_list.end(); ++iter)
 	{
-		image_list_t::iterator curiter = iter++;
-		enditer = iter;
-		LLViewerFetchedTexture *imagep = *curiter;
+		LLViewerFetchedTexture *imagep = *iter;
+		mCreateTextureList.erase(*iter);
 		imagep->createTexture();
         imagep->postCreateTexture();
 		if (create_timer.getElapsedTimeF32() > max_time)
@@ -1038,7 +1042,6 @@ F32 LLViewerTextureList::updateImagesCreateTextures(F32 max_time)
 			break;
 		}
 	}
-	mCreateTextureList.erase(mCreateTextureList.begin(), enditer);
 	return create_timer.getElapsedTimeF32();
 }
 
@@ -53,6 +53,7 @@
 #include "llxmltree.h"
 #include "llslurl.h"
 #include "llrender.h"
+#include "llglstatestats.h"
 
 #include "stringize.h"
 
@@ -124,6 +125,7 @@
 #include "llimage.h"
 #include "llimagej2c.h"
 #include "llimageworker.h"
+#include "llimpostoratlas.h"
 #include "llkeyboard.h"
 #include "lllineeditor.h"
 #include "llmenugl.h"
@@ -708,6 +710,22 @@ public:
 			addText(xpos, ypos, llformat("%d Vertex Buffer Sets", LLVertexBuffer::sSetCount));
 			ypos += y_inc;
 
+			if (LLVertexBuffer::sStreamRing.isValid())
+			{
+				addText(xpos, ypos, llformat("%d MB Streamed (%d Stalls)", (S32) (LLVertexBuffer::sStreamRing.mBytesStreamed/(1024*1024)), LLVertexBuffer::sStreamRing.mStalls));
+				ypos += y_inc;
+			}
+
+			LLPixelUnpackPool* unpack_pool = LLPixelUnpackPool::getCurrent();
+			if (unpack_pool)
+			{
+				addText(xpos, ypos, llformat("%d MB Textures Staged (%d Stalls)", (S32) (unpack_pool->mBytesStaged/(1024*1024)), unpack_pool->mStalls));
+				ypos += y_inc;
+			}
+
+			addText(xpos, ypos, llformat("%d Avatar Impostors (%d%% of Atlas)", gImpostorAtlas.getImpostorCount(), (S32) (gImpostorAtlas.getOccupancy()*100.f)));
+			ypos += y_inc;
+
 			addText(xpos, ypos, llformat("%d Texture Binds", LLImageGL::sBindCount));
 			ypos += y_inc;
 
@@ -729,14 +747,37 @@ public:
 			gPipeline.mTextureMatrixOps = 0;
 			gPipeline.mMatrixOpCount = 0;
 
+			{ //GL state changes sent to the driver vs skipped by the state caches
+				for (U32 pool = 0; pool < LLDrawPool::NUM_POOL_TYPES; ++pool)
+				{
+					const LLGLStateStats::Counts& counts = gGLStateStats.getCounts(pool);
+					if (counts.getIssued() || counts.getRedundant())
+					{
+						addText(xpos, ypos, llformat("    %s: %d/%d", LLDrawPool::getTypeName(pool), counts.getIssued(), counts.getRedundant()));
+						ypos += y_inc;
+					}
+				}
+
+				LLGLStateStats::Counts total = gGLStateStats.getTotal();
+				std::string types;
+				for (U32 i = 0; i < LLGLStateStats::NUM_STATE_TYPES; ++i)
+				{
+					types += llformat(" %s %d/%d", LLGLStateStats::getTypeName((LLGLStateStats::eStateType) i), total.mIssued[i], total.mRedundant[i]);
+				}
+				addText(xpos, ypos, "GL State Issued/Redundant:" + types);
+				ypos += y_inc;
+
+				gGLStateStats.reset();
+			}
+
  			if (last_frame_recording.getSampleCount(LLPipeline::sStatBatchSize) > 0)
 			{
                 addText(xpos, ypos, llformat("Batch min/max/mean: %d/%d/%d", (U32)last_frame_recording.getMin(LLPipeline::sStatBatchSize), (U32)last_frame_recording.getMax(LLPipeline::sStatBatchSize), (U32)last_frame_recording.getMean(LLPipeline::sStatBatchSize)));
 			}
             ypos += y_inc;
 
-			addText(xpos, ypos, llformat("UI Verts/Calls: %d/%d", LLRender::sUIVerts, LLRender::sUICalls));
-			LLRender::sUICalls = LLRender::sUIVerts = 0;
+			addText(xpos, ypos, llformat("UI Verts/Calls: %d/%d (%d merged)", LLRender::sUIVerts, LLRender::sUICalls, LLRender::sUIMergedCalls));
+			LLRender::sUICalls = LLRender::sUIVerts = LLRender::sUIMergedCalls = 0;
 			ypos += y_inc;
 
 			addText(xpos,ypos, llformat("%d/%d Nodes visible", gPipeline.mNumVisibleNodes, LLSpatialGroup::sNodeCount));
@@ -2003,7 +2044,7 @@ LLViewerWindow::LLViewerWindow(const Params& p)
 	{
 		gSavedSettings.setBOOL("RenderVBOEnable", FALSE);
 	}
-	LLVertexBuffer::initClass(gSavedSettings.getBOOL("RenderVBOEnable"), gSavedSettings.getBOOL("RenderVBOMappingDisable"));
+	LLVertexBuffer::initClass(gSavedSettings.getBOOL("RenderVBOEnable"), gSavedSettings.getBOOL("RenderVBOMappingDisable"), gSavedSettings.getBOOL("RenderStreamRing"));
 	LL_INFOS("RenderInit") << "LLVertexBuffer initialization done." << LL_ENDL ;
 	gGL.init(true);
 
@@ -2031,7 +2072,7 @@ LLViewerWindow::LLViewerWindow(const Params& p)
 		
 	// Init the image list.  Must happen after GL is initialized and before the images that
 	// LLViewerWindow needs are requested.
-    LLImageGL::initClass(mWindow, LLViewerTexture::MAX_GL_IMAGE_CATEGORY, false, gSavedSettings.getBOOL("RenderGLMultiThreaded"));
+    LLImageGL::initClass(mWindow, LLViewerTexture::MAX_GL_IMAGE_CATEGORY, false, gSavedSettings.getBOOL("RenderGLMultiThreaded"), gSavedSettings.getBOOL("RenderGLUnpackBuffers"));
 	gTextureList.init();
 	LLViewerTextureManager::init() ;
 	gBumpImageList.init();
@@ -2772,6 +2813,12 @@ void LLViewerWindow::draw()
 
 		// Draw all nested UI views.
 		// No translation needed, this view is glued to 0,0
+		static LLCachedControl<bool> ui_batching(gSavedSettings, "RenderUIBatching", true);
+		if (ui_batching)
+		{
+			gGL.beginUIBatch();
+		}
+
 		mRootView->draw();
 
 		if (LLView::sDebugRects)
@@ -2793,6 +2840,8 @@ void LLViewerWindow::draw()
 			LLUI::popMatrix();
 		}
 
+		gGL.endUIBatch();
+
 
 		if( gShowOverlayTitle && !mOverlayTitle.empty() )
 		{
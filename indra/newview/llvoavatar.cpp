@@ -61,6 +61,7 @@
 #include "llhudmanager.h"
 #include "llhudnametag.h"
 #include "llhudtext.h"				// for mText/mDebugText
+#include "llimpostoratlas.h"
 #include "llimview.h"
 #include "llinitparam.h"
 #include "llkeyframefallmotion.h"
@@ -713,6 +714,7 @@ LLVOAvatar::LLVOAvatar(const LLUUID& id,
 
 	mNeedsImpostorUpdate = TRUE;
 	mLastImpostorUpdateReason = 0;
+	mImpostorSlot = -1;
 	mNeedsAnimUpdate = TRUE;
 
 	mNeedsExtentUpdate = true;
@@ -821,6 +823,8 @@ LLVOAvatar::~LLVOAvatar()
 	std::for_each(mAttachmentPoints.begin(), mAttachmentPoints.end(), DeletePairedPointer());
 	mAttachmentPoints.clear();
 
+	gImpostorAtlas.release(this);
+
 	mDead = TRUE;
 	
 	mAnimationSources.clear();
@@ -1089,11 +1093,12 @@ void LLVOAvatar::destroyGL()
 //static
 void LLVOAvatar::resetImpostors()
 {
+	gImpostorAtlas.destroyGL();
+
 	for (std::vector<LLCharacter*>::iterator iter = LLCharacter::sInstances.begin();
 		 iter != LLCharacter::sInstances.end(); ++iter)
 	{
 		LLVOAvatar* avatar = (LLVOAvatar*) *iter;
-		avatar->mImpostor.release();
 		avatar->mNeedsImpostorUpdate = TRUE;
 		avatar->mLastImpostorUpdateReason = 1;
 	}
@@ -5238,11 +5243,14 @@ U32 LLVOAvatar::renderRigid()
 
 U32 LLVOAvatar::renderImpostor(LLColor4U color, S32 diffuse_channel)
 {
-	if (!mImpostor.isComplete())
+	if (mImpostorSlot < 0)
 	{
 		return 0;
 	}
 
+	gImpostorAtlas.touch(mImpostorSlot);
+	LLVector4 tc = gImpostorAtlas.getTexCoords(mImpostorSlot);
+
 	LLVector3 pos(getRenderPosition()+mImpostorOffset);
 	LLVector3 at = (pos - LLViewerCamera::getInstance()->getOrigin());
 	at.normalize();
@@ -5286,15 +5294,15 @@ U32 LLVOAvatar::renderImpostor(LLColor4U color, S32 diffuse_channel)
     gGL.flush();
 
 	gGL.color4ubv(color.mV);
-	gGL.getTexUnit(diffuse_channel)->bind(&mImpostor);
+	gGL.getTexUnit(diffuse_channel)->bind(&gImpostorAtlas.getTarget());
 	gGL.begin(LLRender::QUADS);
-	gGL.texCoord2f(0,0);
+	gGL.texCoord2f(tc.mV[VX], tc.mV[VY]);
 	gGL.vertex3fv((pos+left-up).mV);
-	gGL.texCoord2f(1,0);
+	gGL.texCoord2f(tc.mV[VZ], tc.mV[VY]);
 	gGL.vertex3fv((pos-left-up).mV);
-	gGL.texCoord2f(1,1);
+	gGL.texCoord2f(tc.mV[VZ], tc.mV[VW]);
 	gGL.vertex3fv((pos-left+up).mV);
-	gGL.texCoord2f(0,1);
+	gGL.texCoord2f(tc.mV[VX], tc.mV[VW]);
 	gGL.vertex3fv((pos+left+up).mV);
 	gGL.end();
 	gGL.flush();
@@ -10420,6 +10428,11 @@ void LLVOAvatar::updateImpostors()
 {
 	LLViewerCamera::sCurCameraID = LLViewerCamera::CAMERA_WORLD;
 
+	static LLCachedControl<U32> update_budget(gSavedSettings, "RenderAvatarImpostorUpdateBudget", 4);
+
+	typedef std::pair<F32, LLVOAvatar*> pending_impostor_t;
+	std::vector<pending_impostor_t> pending;
+
     std::vector<LLCharacter*> instances_copy = LLCharacter::sInstances;
 	for (std::vector<LLCharacter*>::iterator iter = instances_copy.begin();
 		iter != instances_copy.end(); ++iter)
@@ -10430,11 +10443,31 @@ void LLVOAvatar::updateImpostors()
 			&& avatar->isImpostor()
 			&& avatar->needsImpostorUpdate())
 		{
-            avatar->calcMutedAVColor();
-			gPipeline.generateImpostor(avatar);
+			pending.push_back(pending_impostor_t(avatar->getImpostorUpdatePriority(), avatar));
 		}
 	}
 
+	// regenerate the impostors that are most out of date on screen first,
+	// the rest keep their current image until a later frame
+	U32 update_count = pending.size();
+	if (update_budget > 0 && update_count > update_budget)
+	{
+		update_count = update_budget;
+		std::partial_sort(pending.begin(), pending.begin() + update_count, pending.end(),
+						  [](const pending_impostor_t& lhs, const pending_impostor_t& rhs) { return lhs.first > rhs.first; });
+	}
+
+	for (U32 i = 0; i < update_count; ++i)
+	{
+		LLVOAvatar* avatar = pending[i].second;
+		avatar->calcMutedAVColor();
+		gPipeline.generateImpostor(avatar);
+	}
+
+	add(LLStatViewer::IMPOSTOR_UPDATES, update_count);
+	add(LLStatViewer::IMPOSTOR_UPDATES_DEFERRED, pending.size() - update_count);
+	sample(LLStatViewer::IMPOSTOR_ATLAS_OCCUPANCY, gImpostorAtlas.getOccupancy() * 100.f);
+
 	LLCharacter::sAllowInstancesChange = TRUE;
 }
 
@@ -10477,6 +10510,29 @@ void LLVOAvatar::setImpostorDim(const LLVector2& dim)
 	mImpostorDim = dim;
 }
 
+F32 LLVOAvatar::getImpostorUpdatePriority() const
+{
+	if (mImpostorSlot < 0)
+	{ //nothing to draw until it's generated
+		return F32_MAX;
+	}
+
+	LL_ALIGN_16(LLVector4a ext[2]);
+	F32 distance;
+	LLVector3 angle;
+	getImpostorValues(ext, angle, distance);
+
+	//angle error relative to the threshold updateCharacter() flags an update at
+	F32 angle_error = 0.f;
+	F32 threshold = llmax(F_PI/512.f*distance, F_APPROXIMATELY_ZERO);
+	for (U32 i = 0; i < 3; i++)
+	{
+		angle_error = llmax(angle_error, fabsf(angle.mV[i]-mImpostorAngle.mV[i])/threshold);
+	}
+
+	return mImpostorPixelArea * (1.f + angle_error);
+}
+
 void LLVOAvatar::cacheImpostorValues()
 {
 	getImpostorValues(mImpostorExtents, mImpostorAngle, mImpostorDistance);
@@ -564,6 +564,8 @@ public:
 	virtual BOOL isImpostor();
 	BOOL 		shouldImpostor(const F32 rank_factor = 1.0);
 	BOOL 	    needsImpostorUpdate() const;
+	BOOL		hasImpostor() const { return mImpostorSlot >= 0; }
+	F32			getImpostorUpdatePriority() const;
 	const LLVector3& getImpostorOffset() const;
 	const LLVector2& getImpostorDim() const;
 	void 		getImpostorValues(LLVector4a* extents, LLVector3& angle, F32& distance) const;
@@ -571,7 +573,7 @@ public:
 	void 		setImpostorDim(const LLVector2& dim);
 	static void	resetImpostors();
 	static void updateImpostors();
-	LLRenderTarget mImpostor;
+	S32			mImpostorSlot; // cell in gImpostorAtlas, -1 if none
 	BOOL		mNeedsImpostorUpdate;
 	S32			mLastImpostorUpdateReason;
 	F32SecondsImplicit mLastImpostorUpdateFrameTime;
@@ -35,6 +35,7 @@
 #include "pipeline.h"
 #include "llagentcamera.h"
 #include "llmemory.h"
+#include "lltracememaccount.h"
 
 //static variables
 U32 LLVOCacheEntry::sMinFrameRange = 0;
@@ -44,6 +45,9 @@ F32 LLVOCacheEntry::sFrontPixelThreshold = 1.0f;
 F32 LLVOCacheEntry::sRearPixelThreshold = 1.0f;
 BOOL LLVOCachePartition::sNeedsOcclusionCheck = FALSE;
 
+// Entries and their packed object updates, across all regions
+static LLTrace::MemAccount sVOCacheEntryMemAccount("LLVOCacheEntry");
+
 const S32 ENTRY_HEADER_SIZE = 6 * sizeof(S32);
 const S32 MAX_ENTRY_BODY_SIZE = 10000;
 
@@ -79,6 +83,7 @@ LLVOCacheEntry::LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &
 	mBuffer = new U8[dp.getBufferSize()];
 	mDP.assignBuffer(mBuffer, dp.getBufferSize());
 	mDP = dp;
+	sVOCacheEntryMemAccount.claim(sizeof(LLVOCacheEntry) + mDP.getBufferSize());
 }
 
 LLVOCacheEntry::LLVOCacheEntry()
@@ -97,6 +102,7 @@ LLVOCacheEntry::LLVOCacheEntry()
 	mBSphereRadius(-1.0f)
 {
 	mDP.assignBuffer(mBuffer, 0);
+	sVOCacheEntryMemAccount.claim(sizeof(LLVOCacheEntry));
 }
 
 LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
@@ -162,10 +168,12 @@ LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
 		mEntry = NULL;
 		mState = INACTIVE;
 	}
+	sVOCacheEntryMemAccount.claim(sizeof(LLVOCacheEntry) + mDP.getBufferSize());
 }
 
 LLVOCacheEntry::~LLVOCacheEntry()
 {
+	sVOCacheEntryMemAccount.disclaim(sizeof(LLVOCacheEntry) + mDP.getBufferSize());
 	mDP.freeBuffer();
 }
 
@@ -177,12 +185,14 @@ void LLVOCacheEntry::updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp)
 		mCRCChangeCount++;
 	}
 
+	S32 old_size = mDP.getBufferSize();
 	mDP.freeBuffer();
 
 	llassert_always(dp.getBufferSize() > 0);
 	mBuffer = new U8[dp.getBufferSize()];
 	mDP.assignBuffer(mBuffer, dp.getBufferSize());
 	mDP = dp;
+	sVOCacheEntryMemAccount.adjust(S64(mDP.getBufferSize()) - old_size);
 }
 
 void LLVOCacheEntry::setParentID(U32 id) 
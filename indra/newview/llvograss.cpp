@@ -83,6 +83,10 @@ LLVOGrass::LLVOGrass(const LLUUID &id, const LLPCode pcode, LLViewerRegion *regi
 
 	setTEColor(0, LLColor4(1.0f, 1.0f, 1.0f, 1.f));
 	mNumBlades = GRASS_MAX_BLADES;
+
+	mBladePatch = NULL;
+	mBladePatchUpdateTime = 0;
+	mBladeSpecies = 0;
 }
 
 LLVOGrass::~LLVOGrass()
@@ -477,33 +481,36 @@ void LLVOGrass::getGeometry(S32 idx,
 	if (mPatch)
 		mLastPatchUpdateTime = mPatch->getLastUpdateTime();
 	
-	LLVector3 position;
-	// Create random blades of grass with gaussian distribution
-	F32 x,y,xf,yf,dzx,dzy;
-
 	LLColor4U color(255,255,255,255);
 
 	LLFace *face = mDrawable->getFace(idx);
 	if (!face)
 		return;
 
-	F32 width  = sSpeciesTable[mSpecies]->mBladeSizeX;
-	F32 height = sSpeciesTable[mSpecies]->mBladeSizeY;
-
 	U32 index_offset = face->getGeomIndex();
 
-	for (S32 i = 0;  i < mNumBlades; i++)
+	//blade placement only depends on the land under the grass and the
+	//grass itself, so keep it around for rebuilds that don't change either
+	U64 patch_time = mPatch ? mLastPatchUpdateTime : 0;
+	if (mBladePositions.size() != (size_t) mNumBlades * 4 ||
+		mBladePatch != mPatch ||
+		mBladePatchUpdateTime != patch_time ||
+		mBladeSpecies != mSpecies ||
+		mBladeOrigin != mPosition ||
+		mBladeScale != mScale)
 	{
-		x   = exp_x[i] * mScale.mV[VX];
-		y   = exp_y[i] * mScale.mV[VY];
-		xf  = rot_x[i] * GRASS_BLADE_BASE * width * w_mod[i];
-		yf  = rot_y[i] * GRASS_BLADE_BASE * width * w_mod[i];
-		dzx = dz_x [i];
-		dzy = dz_y [i];
+		generateBlades();
+		mBladePatch = mPatch;
+		mBladePatchUpdateTime = patch_time;
+		mBladeSpecies = mSpecies;
+		mBladeOrigin = mPosition;
+		mBladeScale = mScale;
+	}
 
-		LLVector3 v1,v2,v3;
-		F32 blade_height= GRASS_BLADE_HEIGHT * height * w_mod[i];
+	const LLVector3& origin_agent = mRegionp->getOriginAgent();
 
+	for (S32 i = 0;  i < mNumBlades; i++)
+	{
 		*texcoordsp++   = LLVector2(0, 0);
 		*texcoordsp++   = LLVector2(0, 0);
 		*texcoordsp++   = LLVector2(0, 0.98f);
@@ -513,41 +520,17 @@ void LLVOGrass::getGeometry(S32 idx,
 		*texcoordsp++   = LLVector2(1, 0.98f);
 		*texcoordsp++   = LLVector2(1, 0.98f);
 
-		position.mV[0]  = mPosition.mV[VX] + x + xf;
-		position.mV[1]  = mPosition.mV[VY] + y + yf;
-		position.mV[2]  = mRegionp->getLand().resolveHeightRegion(position);
-		v1 = position + mRegionp->getOriginAgent();
-		(*verticesp++).load3(v1.mV);
-		(*verticesp++).load3(v1.mV);
-
-
-		position.mV[0] += dzx;
-		position.mV[1] += dzy;
-		position.mV[2] += blade_height;
-		v2 = position + mRegionp->getOriginAgent();
-		(*verticesp++).load3(v2.mV);
-		(*verticesp++).load3(v2.mV);
-
-		position.mV[0]  = mPosition.mV[VX] + x - xf;
-		position.mV[1]  = mPosition.mV[VY] + y - xf;
-		position.mV[2]  = mRegionp->getLand().resolveHeightRegion(position);
-		v3 = position + mRegionp->getOriginAgent();
-		(*verticesp++).load3(v3.mV);
-		(*verticesp++).load3(v3.mV);
+		for (S32 j = 0; j < 4; j++)
+		{
+			LLVector3 v = mBladePositions[i*4 + j] + origin_agent;
+			(*verticesp++).load3(v.mV);
+			(*verticesp++).load3(v.mV);
+		}
 
-		LLVector3 normal1 = (v1-v2) % (v2-v3);
-		normal1.mV[VZ] = 0.75f;
-		normal1.normalize();
+		const LLVector3& normal1 = mBladeNormals[i];
 		LLVector3 normal2 = -normal1;
 		normal2.mV[VZ] = -normal2.mV[VZ];
 
-		position.mV[0] += dzx;
-		position.mV[1] += dzy;
-		position.mV[2] += blade_height;
-		v1 = position + mRegionp->getOriginAgent();
-		(*verticesp++).load3(v1.mV);
-		(*verticesp++).load3(v1.mV);
-
 		*(normalsp++)   = normal1;
 		*(normalsp++)   = normal2;
 		*(normalsp++)   = normal1;
@@ -588,6 +571,60 @@ void LLVOGrass::getGeometry(S32 idx,
 	LLPipeline::sCompiles++;
 }
 
+void LLVOGrass::generateBlades()
+{
+	LLVector3 position;
+	// Create random blades of grass with gaussian distribution
+	F32 x,y,xf,yf,dzx,dzy;
+
+	F32 width  = sSpeciesTable[mSpecies]->mBladeSizeX;
+	F32 height = sSpeciesTable[mSpecies]->mBladeSizeY;
+
+	mBladePositions.resize(mNumBlades * 4);
+	mBladeNormals.resize(mNumBlades);
+
+	for (S32 i = 0;  i < mNumBlades; i++)
+	{
+		x   = exp_x[i] * mScale.mV[VX];
+		y   = exp_y[i] * mScale.mV[VY];
+		xf  = rot_x[i] * GRASS_BLADE_BASE * width * w_mod[i];
+		yf  = rot_y[i] * GRASS_BLADE_BASE * width * w_mod[i];
+		dzx = dz_x [i];
+		dzy = dz_y [i];
+
+		LLVector3 v1,v2,v3;
+		F32 blade_height= GRASS_BLADE_HEIGHT * height * w_mod[i];
+
+		position.mV[0]  = mPosition.mV[VX] + x + xf;
+		position.mV[1]  = mPosition.mV[VY] + y + yf;
+		position.mV[2]  = mRegionp->getLand().resolveHeightRegion(position);
+		v1 = position;
+		mBladePositions[i*4] = v1;
+
+		position.mV[0] += dzx;
+		position.mV[1] += dzy;
+		position.mV[2] += blade_height;
+		v2 = position;
+		mBladePositions[i*4 + 1] = v2;
+
+		position.mV[0]  = mPosition.mV[VX] + x - xf;
+		position.mV[1]  = mPosition.mV[VY] + y - xf;
+		position.mV[2]  = mRegionp->getLand().resolveHeightRegion(position);
+		v3 = position;
+		mBladePositions[i*4 + 2] = v3;
+
+		LLVector3 normal1 = (v1-v2) % (v2-v3);
+		normal1.mV[VZ] = 0.75f;
+		normal1.normalize();
+		mBladeNormals[i] = normal1;
+
+		position.mV[0] += dzx;
+		position.mV[1] += dzy;
+		position.mV[2] += blade_height;
+		mBladePositions[i*4 + 3] = position;
+	}
+}
+
 U32 LLVOGrass::getPartitionType() const
 {
 	return LLViewerRegion::PARTITION_GRASS;
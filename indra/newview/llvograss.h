@@ -120,6 +120,19 @@ private:
 	F32 mLastHeight;		// For cheap update hack
 	S32 mNumBlades;
 
+	// Place mNumBlades blades on the land, filling mBladePositions and mBladeNormals
+	void generateBlades();
+
+	// Region space corners (4 per blade) and front face normals (1 per blade)
+	// of the last blades placed, and what they were placed for
+	std::vector<LLVector3> mBladePositions;
+	std::vector<LLVector3> mBladeNormals;
+	LLSurfacePatch* mBladePatch;
+	U64 mBladePatchUpdateTime;
+	U8 mBladeSpecies;
+	LLVector3 mBladeOrigin;
+	LLVector3 mBladeScale;
+
 	static SpeciesMap sSpeciesTable;
 };
 #endif // LL_VO_GRASS_
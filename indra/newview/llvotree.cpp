@@ -54,6 +54,7 @@
 #include "llnotificationsutil.h"
 #include "raytrace.h"
 #include "llglslshader.h"
+#include "llrand.h"
 
 extern LLPipeline gPipeline;
 
@@ -78,6 +79,11 @@ F32 LLVOTree::sTreeFactor = 1.f;
 LLVOTree::SpeciesMap LLVOTree::sSpeciesTable;
 S32 LLVOTree::sMaxTreeSpecies = 0;
 
+LLVOTree::mesh_map_t LLVOTree::sReferenceBuffers;
+LLVOTree::mesh_map_t LLVOTree::sSpeciesMeshes;
+
+static LLTrace::CountStatHandle<> sTreeMeshBuilds("tree_mesh_builds", "Number of tree species meshes generated");
+
 // Tree variables and functions
 
 LLVOTree::LLVOTree(const LLUUID &id, const LLPCode pcode, LLViewerRegion *regionp):
@@ -273,10 +279,18 @@ void LLVOTree::initClass()
 //static
 void LLVOTree::cleanupClass()
 {
+	destroyGL();
 	std::for_each(sSpeciesTable.begin(), sSpeciesTable.end(), DeletePairedPointer());
 	sSpeciesTable.clear();
 }
 
+//static
+void LLVOTree::destroyGL()
+{
+	sSpeciesMeshes.clear();
+	sReferenceBuffers.clear();
+}
+
 U32 LLVOTree::processUpdateMessage(LLMessageSystem *mesgsys,
 										  void **user_data,
 										  U32 block_num, EObjectUpdateType update_type,
@@ -374,7 +388,7 @@ void LLVOTree::idleUpdate(LLAgent &agent, const F64 &time)
     trunk_LOD = llmax(trunk_LOD, LLVolumeLODGroup::NUM_LODS - cur_detail - 1);
     trunk_LOD = llmin(trunk_LOD, sMAX_NUM_TREE_LOD_LEVELS);
 
-	if (mReferenceBuffer.isNull())
+	if (!mDrawable->getFace(0) || !mDrawable->getFace(0)->getVertexBuffer())
 	{
 		gPipeline.markRebuild(mDrawable, LLDrawable::REBUILD_ALL, TRUE);
 	}
@@ -385,8 +399,8 @@ void LLVOTree::idleUpdate(LLAgent &agent, const F64 &time)
 	else
 	{
 		// we're not animating but we may *still* need to
-		// regenerate the mesh if we moved, since position
-		// and rotation are baked into the mesh.
+		// update the instance matrix if we moved, since position
+		// and rotation are baked into it.
 		// *TODO: I don't know what's so special about trees
 		// that they don't get REBUILD_POSITION automatically
 		// at a higher level.
@@ -497,419 +511,430 @@ BOOL LLVOTree::updateGeometry(LLDrawable *drawable)
 {
     LL_PROFILE_ZONE_SCOPED;
 
+	LLFace* face = drawable->getFace(0);
+	if (!face)
+	{
+		return TRUE;
+	}
+
 	if(mTrunkLOD >= sMAX_NUM_TREE_LOD_LEVELS) //do not display the tree.
 	{
-		mReferenceBuffer = NULL ;
-		LLFace * facep = drawable->getFace(0);
-		if (facep)
-		{
-			facep->setVertexBuffer(NULL);
-		}
+		face->setVertexBuffer(NULL);
 		return TRUE ;
 	}
 
-	if (mDrawable->getFace(0) &&
-		(mReferenceBuffer.isNull() || !mDrawable->getFace(0)->getVertexBuffer()))
-	{
-		const F32 SRR3 = 0.577350269f; // sqrt(1/3)
-		const F32 SRR2 = 0.707106781f; // sqrt(1/2)
-		U32 i, j;
+	face->mCenterAgent = getPositionAgent();
+	face->mCenterLocal = face->mCenterAgent;
 
-		U32 slices = MAX_SLICES;
+	//every tree of the same species and LOD draws the same mesh with its own transform
+	face->setVertexBuffer(getSpeciesMesh(mSpecies, mTrunkLOD));
 
-		S32 max_indices = LEAF_INDICES;
-		S32 max_vertices = LEAF_VERTICES;
-		S32 lod;
+	updateMesh();
+	
+	return TRUE;
+}
 
-		LLFace *face = drawable->getFace(0);
-		if (!face) return TRUE;
+//static
+LLPointer<LLVertexBuffer> LLVOTree::createReferenceBuffer(const TreeSpeciesData* species)
+{
+    LL_PROFILE_ZONE_SCOPED;
 
-		face->mCenterAgent = getPositionAgent();
-		face->mCenterLocal = face->mCenterAgent;
+	const F32 SRR3 = 0.577350269f; // sqrt(1/3)
+	const F32 SRR2 = 0.707106781f; // sqrt(1/2)
+	U32 i, j;
 
-		for (lod = 0; lod < sMAX_NUM_TREE_LOD_LEVELS; lod++)
-		{
-			slices = sLODSlices[lod];
-			sLODVertexOffset[lod] = max_vertices;
-			sLODVertexCount[lod] = slices*slices;
-			sLODIndexOffset[lod] = max_indices;
-			sLODIndexCount[lod] = (slices-1)*(slices-1)*6;
-			max_indices += sLODIndexCount[lod];
-			max_vertices += sLODVertexCount[lod];
-		}
+	U32 slices = MAX_SLICES;
 
-		mReferenceBuffer = new LLVertexBuffer(LLDrawPoolTree::VERTEX_DATA_MASK, 0);
-		if (!mReferenceBuffer->allocateBuffer(max_vertices, max_indices, TRUE))
-		{
-			LL_WARNS() << "Failed to allocate Vertex Buffer on update to "
-				<< max_vertices << " vertices and "
-				<< max_indices << " indices" << LL_ENDL;
-			mReferenceBuffer = NULL; //unref
-			return TRUE;
-		}
+	S32 max_indices = LEAF_INDICES;
+	S32 max_vertices = LEAF_VERTICES;
+	S32 lod;
 
-		LLStrider<LLVector3> vertices;
-		LLStrider<LLVector3> normals;
-        LLStrider<LLColor4U> colors;
-		LLStrider<LLVector2> tex_coords;
-		LLStrider<U16> indicesp;
-
-		mReferenceBuffer->getVertexStrider(vertices);
-		mReferenceBuffer->getNormalStrider(normals);
-		mReferenceBuffer->getTexCoord0Strider(tex_coords);
-        mReferenceBuffer->getColorStrider(colors);
-		mReferenceBuffer->getIndexStrider(indicesp);
-				
-		S32 vertex_count = 0;
-		S32 index_count = 0;
-		
-		// First leaf
-		*(normals++) =		LLVector3(-SRR2, -SRR2, 0.f);
-		*(tex_coords++) =	LLVector2(LEAF_LEFT, LEAF_BOTTOM);
-		*(vertices++) =		LLVector3(-0.5f*LEAF_WIDTH, 0.f, 0.f);
+	for (lod = 0; lod < sMAX_NUM_TREE_LOD_LEVELS; lod++)
+	{
+		slices = sLODSlices[lod];
+		sLODVertexOffset[lod] = max_vertices;
+		sLODVertexCount[lod] = slices*slices;
+		sLODIndexOffset[lod] = max_indices;
+		sLODIndexCount[lod] = (slices-1)*(slices-1)*6;
+		max_indices += sLODIndexCount[lod];
+		max_vertices += sLODVertexCount[lod];
+	}
+
+	LLPointer<LLVertexBuffer> buff = new LLVertexBuffer(LLDrawPoolTree::VERTEX_DATA_MASK, 0);
+	if (!buff->allocateBuffer(max_vertices, max_indices, TRUE))
+	{
+		LL_WARNS() << "Failed to allocate Vertex Buffer on update to "
+			<< max_vertices << " vertices and "
+			<< max_indices << " indices" << LL_ENDL;
+		return NULL;
+	}
+
+	LLStrider<LLVector3> vertices;
+	LLStrider<LLVector3> normals;
+    LLStrider<LLColor4U> colors;
+	LLStrider<LLVector2> tex_coords;
+	LLStrider<U16> indicesp;
+
+	buff->getVertexStrider(vertices);
+	buff->getNormalStrider(normals);
+	buff->getTexCoord0Strider(tex_coords);
+    buff->getColorStrider(colors);
+	buff->getIndexStrider(indicesp);
+			
+	S32 vertex_count = 0;
+	S32 index_count = 0;
+	
+	// First leaf
+	*(normals++) =		LLVector3(-SRR2, -SRR2, 0.f);
+	*(tex_coords++) =	LLVector2(LEAF_LEFT, LEAF_BOTTOM);
+	*(vertices++) =		LLVector3(-0.5f*LEAF_WIDTH, 0.f, 0.f);
         *(colors++) =       LLColor4U::white;
-		vertex_count++;
+	vertex_count++;
 
-		*(normals++) =		LLVector3(SRR3, -SRR3, SRR3);
-		*(tex_coords++) =	LLVector2(LEAF_RIGHT, LEAF_TOP);
-		*(vertices++) =		LLVector3(0.5f*LEAF_WIDTH, 0.f, 1.f);
+	*(normals++) =		LLVector3(SRR3, -SRR3, SRR3);
+	*(tex_coords++) =	LLVector2(LEAF_RIGHT, LEAF_TOP);
+	*(vertices++) =		LLVector3(0.5f*LEAF_WIDTH, 0.f, 1.f);
         *(colors++) =       LLColor4U::white;
-		vertex_count++;
+	vertex_count++;
 
-		*(normals++) =		LLVector3(-SRR3, -SRR3, SRR3);
-		*(tex_coords++) =	LLVector2(LEAF_LEFT, LEAF_TOP);
-		*(vertices++) =		LLVector3(-0.5f*LEAF_WIDTH, 0.f, 1.f);
+	*(normals++) =		LLVector3(-SRR3, -SRR3, SRR3);
+	*(tex_coords++) =	LLVector2(LEAF_LEFT, LEAF_TOP);
+	*(vertices++) =		LLVector3(-0.5f*LEAF_WIDTH, 0.f, 1.f);
         *(colors++) =       LLColor4U::white;
-		vertex_count++;
+	vertex_count++;
 
-		*(normals++) =		LLVector3(SRR2, -SRR2, 0.f);
-		*(tex_coords++) =	LLVector2(LEAF_RIGHT, LEAF_BOTTOM);
-		*(vertices++) =		LLVector3(0.5f*LEAF_WIDTH, 0.f, 0.f);
+	*(normals++) =		LLVector3(SRR2, -SRR2, 0.f);
+	*(tex_coords++) =	LLVector2(LEAF_RIGHT, LEAF_BOTTOM);
+	*(vertices++) =		LLVector3(0.5f*LEAF_WIDTH, 0.f, 0.f);
         *(colors++) =       LLColor4U::white;
-		vertex_count++;
+	vertex_count++;
         
-		*(indicesp++) = 0;
-		index_count++;
-		*(indicesp++) = 1;
-		index_count++;
-		*(indicesp++) = 2;
-		index_count++;
-
-		*(indicesp++) = 0;
-		index_count++;
-		*(indicesp++) = 3;
-		index_count++;
-		*(indicesp++) = 1;
-		index_count++;
-
-		// Same leaf, inverse winding/normals
-		*(normals++) =		LLVector3(-SRR2, SRR2, 0.f);
-		*(tex_coords++) =	LLVector2(LEAF_LEFT, LEAF_BOTTOM);
-		*(vertices++) =		LLVector3(-0.5f*LEAF_WIDTH, 0.f, 0.f);
+	*(indicesp++) = 0;
+	index_count++;
+	*(indicesp++) = 1;
+	index_count++;
+	*(indicesp++) = 2;
+	index_count++;
+
+	*(indicesp++) = 0;
+	index_count++;
+	*(indicesp++) = 3;
+	index_count++;
+	*(indicesp++) = 1;
+	index_count++;
+
+	// Same leaf, inverse winding/normals
+	*(normals++) =		LLVector3(-SRR2, SRR2, 0.f);
+	*(tex_coords++) =	LLVector2(LEAF_LEFT, LEAF_BOTTOM);
+	*(vertices++) =		LLVector3(-0.5f*LEAF_WIDTH, 0.f, 0.f);
         *(colors++) =       LLColor4U::white;
-		vertex_count++;
+	vertex_count++;
 
-		*(normals++) =		LLVector3(SRR3, SRR3, SRR3);
-		*(tex_coords++) =	LLVector2(LEAF_RIGHT, LEAF_TOP);
-		*(vertices++) =		LLVector3(0.5f*LEAF_WIDTH, 0.f, 1.f);
+	*(normals++) =		LLVector3(SRR3, SRR3, SRR3);
+	*(tex_coords++) =	LLVector2(LEAF_RIGHT, LEAF_TOP);
+	*(vertices++) =		LLVector3(0.5f*LEAF_WIDTH, 0.f, 1.f);
         *(colors++) =       LLColor4U::white;
-		vertex_count++;
+	vertex_count++;
 
-		*(normals++) =		LLVector3(-SRR3, SRR3, SRR3);
-		*(tex_coords++) =	LLVector2(LEAF_LEFT, LEAF_TOP);
-		*(vertices++) =		LLVector3(-0.5f*LEAF_WIDTH, 0.f, 1.f);
+	*(normals++) =		LLVector3(-SRR3, SRR3, SRR3);
+	*(tex_coords++) =	LLVector2(LEAF_LEFT, LEAF_TOP);
+	*(vertices++) =		LLVector3(-0.5f*LEAF_WIDTH, 0.f, 1.f);
         *(colors++) =       LLColor4U::white;
-		vertex_count++;
+	vertex_count++;
 
-		*(normals++) =		LLVector3(SRR2, SRR2, 0.f);
-		*(tex_coords++) =	LLVector2(LEAF_RIGHT, LEAF_BOTTOM);
-		*(vertices++) =		LLVector3(0.5f*LEAF_WIDTH, 0.f, 0.f);
+	*(normals++) =		LLVector3(SRR2, SRR2, 0.f);
+	*(tex_coords++) =	LLVector2(LEAF_RIGHT, LEAF_BOTTOM);
+	*(vertices++) =		LLVector3(0.5f*LEAF_WIDTH, 0.f, 0.f);
         *(colors++) =       LLColor4U::white;
-		vertex_count++;
-
-		*(indicesp++) = 4;
-		index_count++;
-		*(indicesp++) = 6;
-		index_count++;
-		*(indicesp++) = 5;
-		index_count++;
-
-		*(indicesp++) = 4;
-		index_count++;
-		*(indicesp++) = 5;
-		index_count++;
-		*(indicesp++) = 7;
-		index_count++;
-
-
-		// next leaf
-		*(normals++) =		LLVector3(SRR2, -SRR2, 0.f);
-		*(tex_coords++) =	LLVector2(LEAF_LEFT, LEAF_BOTTOM);
-		*(vertices++) =		LLVector3(0.f, -0.5f*LEAF_WIDTH, 0.f);
+	vertex_count++;
+
+	*(indicesp++) = 4;
+	index_count++;
+	*(indicesp++) = 6;
+	index_count++;
+	*(indicesp++) = 5;
+	index_count++;
+
+	*(indicesp++) = 4;
+	index_count++;
+	*(indicesp++) = 5;
+	index_count++;
+	*(indicesp++) = 7;
+	index_count++;
+
+
+	// next leaf
+	*(normals++) =		LLVector3(SRR2, -SRR2, 0.f);
+	*(tex_coords++) =	LLVector2(LEAF_LEFT, LEAF_BOTTOM);
+	*(vertices++) =		LLVector3(0.f, -0.5f*LEAF_WIDTH, 0.f);
         *(colors++) =       LLColor4U::white;
-		vertex_count++;
+	vertex_count++;
 
-		*(normals++) =		LLVector3(SRR3, SRR3, SRR3);
-		*(tex_coords++) =	LLVector2(LEAF_RIGHT, LEAF_TOP);
-		*(vertices++) =		LLVector3(0.f, 0.5f*LEAF_WIDTH, 1.f);
+	*(normals++) =		LLVector3(SRR3, SRR3, SRR3);
+	*(tex_coords++) =	LLVector2(LEAF_RIGHT, LEAF_TOP);
+	*(vertices++) =		LLVector3(0.f, 0.5f*LEAF_WIDTH, 1.f);
         *(colors++) =       LLColor4U::white;
-		vertex_count++;
+	vertex_count++;
 
-		*(normals++) =		LLVector3(SRR3, -SRR3, SRR3);
-		*(tex_coords++) =	LLVector2(LEAF_LEFT, LEAF_TOP);
-		*(vertices++) =		LLVector3(0.f, -0.5f*LEAF_WIDTH, 1.f);
+	*(normals++) =		LLVector3(SRR3, -SRR3, SRR3);
+	*(tex_coords++) =	LLVector2(LEAF_LEFT, LEAF_TOP);
+	*(vertices++) =		LLVector3(0.f, -0.5f*LEAF_WIDTH, 1.f);
         *(colors++) =       LLColor4U::white;
-		vertex_count++;
+	vertex_count++;
 
-		*(normals++) =		LLVector3(SRR2, SRR2, 0.f);
-		*(tex_coords++) =	LLVector2(LEAF_RIGHT, LEAF_BOTTOM);
-		*(vertices++) =		LLVector3(0.f, 0.5f*LEAF_WIDTH, 0.f);
+	*(normals++) =		LLVector3(SRR2, SRR2, 0.f);
+	*(tex_coords++) =	LLVector2(LEAF_RIGHT, LEAF_BOTTOM);
+	*(vertices++) =		LLVector3(0.f, 0.5f*LEAF_WIDTH, 0.f);
         *(colors++) =       LLColor4U::white;
-		vertex_count++;
-
-		*(indicesp++) = 8;
-		index_count++;
-		*(indicesp++) = 9;
-		index_count++;
-		*(indicesp++) = 10;
-		index_count++;
-
-		*(indicesp++) = 8;
-		index_count++;
-		*(indicesp++) = 11;
-		index_count++;
-		*(indicesp++) = 9;
-		index_count++;
-
-
-		// other side of same leaf
-		*(normals++) =		LLVector3(-SRR2, -SRR2, 0.f);
-		*(tex_coords++) =	LLVector2(LEAF_LEFT, LEAF_BOTTOM);
-		*(vertices++) =		LLVector3(0.f, -0.5f*LEAF_WIDTH, 0.f);
+	vertex_count++;
+
+	*(indicesp++) = 8;
+	index_count++;
+	*(indicesp++) = 9;
+	index_count++;
+	*(indicesp++) = 10;
+	index_count++;
+
+	*(indicesp++) = 8;
+	index_count++;
+	*(indicesp++) = 11;
+	index_count++;
+	*(indicesp++) = 9;
+	index_count++;
+
+
+	// other side of same leaf
+	*(normals++) =		LLVector3(-SRR2, -SRR2, 0.f);
+	*(tex_coords++) =	LLVector2(LEAF_LEFT, LEAF_BOTTOM);
+	*(vertices++) =		LLVector3(0.f, -0.5f*LEAF_WIDTH, 0.f);
         *(colors++) =       LLColor4U::white;
-		vertex_count++;
+	vertex_count++;
 
-		*(normals++) =		LLVector3(-SRR3, SRR3, SRR3);
-		*(tex_coords++) =	LLVector2(LEAF_RIGHT, LEAF_TOP);
-		*(vertices++) =		LLVector3(0.f, 0.5f*LEAF_WIDTH, 1.f);
+	*(normals++) =		LLVector3(-SRR3, SRR3, SRR3);
+	*(tex_coords++) =	LLVector2(LEAF_RIGHT, LEAF_TOP);
+	*(vertices++) =		LLVector3(0.f, 0.5f*LEAF_WIDTH, 1.f);
         *(colors++) =       LLColor4U::white;
-		vertex_count++;
+	vertex_count++;
 
-		*(normals++) =		LLVector3(-SRR3, -SRR3, SRR3);
-		*(tex_coords++) =	LLVector2(LEAF_LEFT, LEAF_TOP);
-		*(vertices++) =		LLVector3(0.f, -0.5f*LEAF_WIDTH, 1.f);
+	*(normals++) =		LLVector3(-SRR3, -SRR3, SRR3);
+	*(tex_coords++) =	LLVector2(LEAF_LEFT, LEAF_TOP);
+	*(vertices++) =		LLVector3(0.f, -0.5f*LEAF_WIDTH, 1.f);
         *(colors++) =       LLColor4U::white;
-		vertex_count++;
+	vertex_count++;
 
-		*(normals++) =		LLVector3(-SRR2, SRR2, 0.f);
-		*(tex_coords++) =	LLVector2(LEAF_RIGHT, LEAF_BOTTOM);
-		*(vertices++) =		LLVector3(0.f, 0.5f*LEAF_WIDTH, 0.f);
+	*(normals++) =		LLVector3(-SRR2, SRR2, 0.f);
+	*(tex_coords++) =	LLVector2(LEAF_RIGHT, LEAF_BOTTOM);
+	*(vertices++) =		LLVector3(0.f, 0.5f*LEAF_WIDTH, 0.f);
         *(colors++) =       LLColor4U::white;
-		vertex_count++;
+	vertex_count++;
 
-		*(indicesp++) = 12;
-		index_count++;
-		*(indicesp++) = 14;
-		index_count++;
-		*(indicesp++) = 13;
-		index_count++;
+	*(indicesp++) = 12;
+	index_count++;
+	*(indicesp++) = 14;
+	index_count++;
+	*(indicesp++) = 13;
+	index_count++;
 
-		*(indicesp++) = 12;
-		index_count++;
-		*(indicesp++) = 13;
-		index_count++;
-		*(indicesp++) = 15;
-		index_count++;
+	*(indicesp++) = 12;
+	index_count++;
+	*(indicesp++) = 13;
+	index_count++;
+	*(indicesp++) = 15;
+	index_count++;
 
-		// Generate geometry for the cylinders
+	// Generate geometry for the cylinders
 
-		// Different LOD's
+	// Different LOD's
 
-		// Generate the vertices
-		// Generate the indices
+	// Generate the vertices
+	// Generate the indices
 
-		for (lod = 0; lod < sMAX_NUM_TREE_LOD_LEVELS; lod++)
+	for (lod = 0; lod < sMAX_NUM_TREE_LOD_LEVELS; lod++)
+	{
+		slices = sLODSlices[lod];
+		F32 base_radius = 0.65f;
+		F32 top_radius = base_radius * species->mTaper;
+		//LL_INFOS() << "Species " << ((U32) mSpecies) << ", taper = " << sSpeciesTable[mSpecies].mTaper << LL_ENDL;
+		//LL_INFOS() << "Droop " << mDroop << ", branchlength: " << mBranchLength << LL_ENDL;
+		F32 angle = 0;
+		F32 angle_inc = 360.f/(slices-1);
+		F32 z = 0.f;
+		F32 z_inc = 1.f;
+		if (slices > 3)
 		{
-			slices = sLODSlices[lod];
-			F32 base_radius = 0.65f;
-			F32 top_radius = base_radius * sSpeciesTable[mSpecies]->mTaper;
-			//LL_INFOS() << "Species " << ((U32) mSpecies) << ", taper = " << sSpeciesTable[mSpecies].mTaper << LL_ENDL;
-			//LL_INFOS() << "Droop " << mDroop << ", branchlength: " << mBranchLength << LL_ENDL;
-			F32 angle = 0;
-			F32 angle_inc = 360.f/(slices-1);
-			F32 z = 0.f;
-			F32 z_inc = 1.f;
-			if (slices > 3)
-			{
-				z_inc = 1.f/(slices - 3);
-			}
-			F32 radius = base_radius;
+			z_inc = 1.f/(slices - 3);
+		}
+		F32 radius = base_radius;
+
+		F32 x1,y1;
+		F32 noise_scale = species->mNoiseMag;
+		LLVector3 nvec;
 
-			F32 x1,y1;
-			F32 noise_scale = sSpeciesTable[mSpecies]->mNoiseMag;
-			LLVector3 nvec;
+		const F32 cap_nudge = 0.1f;			// Height to 'peak' the caps on top/bottom of branch
 
-			const F32 cap_nudge = 0.1f;			// Height to 'peak' the caps on top/bottom of branch
+		const S32 fractal_depth = 5;
+		F32 nvec_scale = 1.f * species->mNoiseScale;
+		F32 nvec_scalez = 4.f * species->mNoiseScale;
 
-			const S32 fractal_depth = 5;
-			F32 nvec_scale = 1.f * sSpeciesTable[mSpecies]->mNoiseScale;
-			F32 nvec_scalez = 4.f * sSpeciesTable[mSpecies]->mNoiseScale;
+		F32 tex_z_repeat = species->mRepeatTrunkZ;
 
-			F32 tex_z_repeat = sSpeciesTable[mSpecies]->mRepeatTrunkZ;
+		F32 start_radius;
+		F32 nangle = 0;
+		F32 height = 1.f;
+		F32 r0;
 
-			F32 start_radius;
-			F32 nangle = 0;
-			F32 height = 1.f;
-			F32 r0;
+		for (i = 0; i < slices; i++)
+		{
+			if (i == 0) 
+			{
+				z = - cap_nudge;
+				r0 = 0.0;
+			}
+			else if (i == (slices - 1))
+			{
+				z = 1.f + cap_nudge;//((i - 2) * z_inc) + cap_nudge;
+				r0 = 0.0;
+			}
+			else  
+			{
+				z = (i - 1) * z_inc;
+				r0 = base_radius + (top_radius - base_radius)*z;
+			}
 
-			for (i = 0; i < slices; i++)
+			for (j = 0; j < slices; j++)
 			{
-				if (i == 0) 
+				if (slices - 1 == j)
 				{
-					z = - cap_nudge;
-					r0 = 0.0;
+					angle = 0.f;
 				}
-				else if (i == (slices - 1))
+				else
 				{
-					z = 1.f + cap_nudge;//((i - 2) * z_inc) + cap_nudge;
-					r0 = 0.0;
+					angle =  j*angle_inc;
 				}
-				else  
+			
+				nangle = angle;
+				
+				x1 = cos(angle * DEG_TO_RAD);
+				y1 = sin(angle * DEG_TO_RAD);
+				LLVector2 tc;
+				// This isn't totally accurate.  Should compute based on slope as well.
+				start_radius = r0 * (1.f + 1.2f*fabs(z - 0.66f*height)/height);
+				nvec.set(	cos(nangle * DEG_TO_RAD)*start_radius*nvec_scale, 
+							sin(nangle * DEG_TO_RAD)*start_radius*nvec_scale, 
+							z*nvec_scalez); 
+				// First and last slice at 0 radius (to bring in top/bottom of structure)
+				radius = start_radius + turbulence3((F32*)&nvec.mV, (F32)fractal_depth)*noise_scale;
+
+				if (slices - 1 == j)
 				{
-					z = (i - 1) * z_inc;
-					r0 = base_radius + (top_radius - base_radius)*z;
+					// Not 0.5 for slight slop factor to avoid edges on leaves
+					tc = LLVector2(0.490f, (1.f - z/2.f)*tex_z_repeat);
 				}
-
-				for (j = 0; j < slices; j++)
+				else
 				{
-					if (slices - 1 == j)
-					{
-						angle = 0.f;
-					}
-					else
-					{
-						angle =  j*angle_inc;
-					}
-				
-					nangle = angle;
-					
-					x1 = cos(angle * DEG_TO_RAD);
-					y1 = sin(angle * DEG_TO_RAD);
-					LLVector2 tc;
-					// This isn't totally accurate.  Should compute based on slope as well.
-					start_radius = r0 * (1.f + 1.2f*fabs(z - 0.66f*height)/height);
-					nvec.set(	cos(nangle * DEG_TO_RAD)*start_radius*nvec_scale, 
-								sin(nangle * DEG_TO_RAD)*start_radius*nvec_scale, 
-								z*nvec_scalez); 
-					// First and last slice at 0 radius (to bring in top/bottom of structure)
-					radius = start_radius + turbulence3((F32*)&nvec.mV, (F32)fractal_depth)*noise_scale;
-
-					if (slices - 1 == j)
-					{
-						// Not 0.5 for slight slop factor to avoid edges on leaves
-						tc = LLVector2(0.490f, (1.f - z/2.f)*tex_z_repeat);
-					}
-					else
-					{
-						tc = LLVector2((angle/360.f)*0.5f, (1.f - z/2.f)*tex_z_repeat);
-					}
-
-					*(vertices++) =		LLVector3(x1*radius, y1*radius, z);
-					*(normals++) =		LLVector3(x1, y1, 0.f);
-					*(tex_coords++) = tc;
-                    *(colors++) =       LLColor4U::white;
-					vertex_count++;
+					tc = LLVector2((angle/360.f)*0.5f, (1.f - z/2.f)*tex_z_repeat);
 				}
+
+				*(vertices++) =		LLVector3(x1*radius, y1*radius, z);
+				*(normals++) =		LLVector3(x1, y1, 0.f);
+				*(tex_coords++) = tc;
+                    *(colors++) =       LLColor4U::white;
+				vertex_count++;
 			}
+		}
 
-			for (i = 0; i < (slices - 1); i++)
+		for (i = 0; i < (slices - 1); i++)
+		{
+			for (j = 0; j < (slices - 1); j++)
 			{
-				for (j = 0; j < (slices - 1); j++)
+				S32 x1_offset = j+1;
+				if ((j+1) == slices)
 				{
-					S32 x1_offset = j+1;
-					if ((j+1) == slices)
-					{
-						x1_offset = 0;
-					}
-					// Generate the matching quads
-					*(indicesp) = j + (i*slices) + sLODVertexOffset[lod];
-					llassert(*(indicesp) < (U32)max_vertices);
-					indicesp++;
-					index_count++;
-					*(indicesp) = x1_offset + ((i+1)*slices) + sLODVertexOffset[lod];
-					llassert(*(indicesp) < (U32)max_vertices);
-					indicesp++;
-					index_count++;
-					*(indicesp) = j + ((i+1)*slices) + sLODVertexOffset[lod];
-					llassert(*(indicesp) < (U32)max_vertices);
-					indicesp++;
-					index_count++;
-
-					*(indicesp) = j + (i*slices) + sLODVertexOffset[lod];
-					llassert(*(indicesp) < (U32)max_vertices);
-					indicesp++;
-					index_count++;
-					*(indicesp) = x1_offset + (i*slices) + sLODVertexOffset[lod];
-					llassert(*(indicesp) < (U32)max_vertices);
-					indicesp++;
-					index_count++;
-					*(indicesp) = x1_offset + ((i+1)*slices) + sLODVertexOffset[lod];
-					llassert(*(indicesp) < (U32)max_vertices);
-					indicesp++;
-					index_count++;
+					x1_offset = 0;
 				}
+				// Generate the matching quads
+				*(indicesp) = j + (i*slices) + sLODVertexOffset[lod];
+				llassert(*(indicesp) < (U32)max_vertices);
+				indicesp++;
+				index_count++;
+				*(indicesp) = x1_offset + ((i+1)*slices) + sLODVertexOffset[lod];
+				llassert(*(indicesp) < (U32)max_vertices);
+				indicesp++;
+				index_count++;
+				*(indicesp) = j + ((i+1)*slices) + sLODVertexOffset[lod];
+				llassert(*(indicesp) < (U32)max_vertices);
+				indicesp++;
+				index_count++;
+
+				*(indicesp) = j + (i*slices) + sLODVertexOffset[lod];
+				llassert(*(indicesp) < (U32)max_vertices);
+				indicesp++;
+				index_count++;
+				*(indicesp) = x1_offset + (i*slices) + sLODVertexOffset[lod];
+				llassert(*(indicesp) < (U32)max_vertices);
+				indicesp++;
+				index_count++;
+				*(indicesp) = x1_offset + ((i+1)*slices) + sLODVertexOffset[lod];
+				llassert(*(indicesp) < (U32)max_vertices);
+				indicesp++;
+				index_count++;
 			}
-			slices /= 2; 
 		}
-
-		mReferenceBuffer->flush();
-		llassert(vertex_count == max_vertices);
-		llassert(index_count == max_indices);
+		slices /= 2; 
 	}
 
-	//generate tree mesh
-	updateMesh();
-	
-	return TRUE;
+	buff->flush();
+	llassert(vertex_count == max_vertices);
+	llassert(index_count == max_indices);
+
+	return buff;
 }
 
-void LLVOTree::updateMesh()
+//static
+LLVertexBuffer* LLVOTree::getSpeciesMesh(U8 species, S32 trunk_LOD)
 {
-	LLMatrix4 matrix;
-	
-	// Translate to tree base  HACK - adjustment in Z plants tree underground
-	const LLVector3 &pos_region = getPositionRegion();
-	//gGL.translatef(pos_agent.mV[VX], pos_agent.mV[VY], pos_agent.mV[VZ] - 0.1f);
-	LLMatrix4 trans_mat;
-	trans_mat.setTranslation(pos_region.mV[VX], pos_region.mV[VY], pos_region.mV[VZ] - 0.1f);
-	trans_mat *= matrix;
-	
-	// Rotate to tree position and bend for current trunk/wind
-	// Note that trunk stiffness controls the amount of bend at the trunk as 
-	// opposed to the crown of the tree
-	// 
-	const F32 TRUNK_STIFF = 22.f;
-	
-	LLQuaternion rot = 
-		LLQuaternion(mTrunkBend.magVec()*TRUNK_STIFF*DEG_TO_RAD, LLVector4(mTrunkBend.mV[VX], mTrunkBend.mV[VY], 0)) *
-		LLQuaternion(90.f*DEG_TO_RAD, LLVector4(0,0,1)) *
-		getRotation();
+	U32 key = species * sMAX_NUM_TREE_LOD_LEVELS + trunk_LOD;
+	mesh_map_t::iterator iter = sSpeciesMeshes.find(key);
+	if (iter != sSpeciesMeshes.end())
+	{
+		return iter->second;
+	}
 
-	LLMatrix4 rot_mat(rot);
-	rot_mat *= trans_mat;
+	SpeciesMap::const_iterator species_iter = sSpeciesTable.find(species);
+	if (species_iter == sSpeciesTable.end())
+	{
+		return NULL;
+	}
 
-	F32 radius = getScale().magVec()*0.05f;
-	LLMatrix4 scale_mat;
-	scale_mat.mMatrix[0][0] = 
-		scale_mat.mMatrix[1][1] =
-		scale_mat.mMatrix[2][2] = radius;
+	LLPointer<LLVertexBuffer>& reference = sReferenceBuffers[species];
+	if (reference.isNull())
+	{
+		reference = createReferenceBuffer(species_iter->second);
+		if (reference.isNull())
+		{
+			sReferenceBuffers.erase(species);
+			return NULL;
+		}
+	}
 
-	scale_mat *= rot_mat;
+	LLPointer<LLVertexBuffer> mesh = createSpeciesMesh(species_iter->second, reference, trunk_LOD);
+	if (mesh.isNull())
+	{
+		return NULL;
+	}
+
+	sSpeciesMeshes[key] = mesh;
+	return mesh;
+}
 
-//	const F32 THRESH_ANGLE_FOR_BILLBOARD = 15.f;
-//	const F32 BLEND_RANGE_FOR_BILLBOARD = 3.f;
+//static
+LLPointer<LLVertexBuffer> LLVOTree::createSpeciesMesh(const TreeSpeciesData* species, LLVertexBuffer* reference, S32 trunk_LOD)
+{
+    LL_PROFILE_ZONE_SCOPED;
 
-	F32 droop = mDroop + 25.f*(1.f - mTrunkBend.magVec());
+	//the mesh can't depend on anything about a single tree, so it's built unbent;
+	//mTrunkBend is never set anyway and only bends the trunk through mInstanceMatrix
+	F32 droop = species->mDroop + 25.f;
 	
 	S32 stop_depth = 0;
 	F32 alpha = 1.0;
@@ -917,28 +942,17 @@ void LLVOTree::updateMesh()
 	U32 vert_count = 0;
 	U32 index_count = 0;
 	
-	calcNumVerts(vert_count, index_count, mTrunkLOD, stop_depth, mDepth, mTrunkDepth, mBranches);
+	calcNumVerts(vert_count, index_count, trunk_LOD, stop_depth, species->mDepth, species->mTrunkDepth, species->mBranches);
 
-	LLFace* facep = mDrawable->getFace(0);
-	if (!facep) return;
-	LLVertexBuffer* buff = new LLVertexBuffer(LLDrawPoolTree::VERTEX_DATA_MASK, GL_STATIC_DRAW_ARB);
+	LLPointer<LLVertexBuffer> buff = new LLVertexBuffer(LLDrawPoolTree::VERTEX_DATA_MASK, GL_STATIC_DRAW_ARB);
 	if (!buff->allocateBuffer(vert_count, index_count, TRUE))
 	{
 		LL_WARNS() << "Failed to allocate Vertex Buffer on mesh update to "
 			<< vert_count << " vertices and "
 			<< index_count << " indices" << LL_ENDL;
-		buff->allocateBuffer(1, 3, true);
-		memset((U8*)buff->getMappedData(), 0, buff->getSize());
-		memset((U8*)buff->getMappedIndices(), 0, buff->getIndicesSize());
-		facep->setSize(1, 3);
-		facep->setVertexBuffer(buff);
-		mReferenceBuffer->flush();
-		buff->flush();
-		return;
+		return NULL;
 	}
 
-	facep->setVertexBuffer(buff);
-	
 	LLStrider<LLVector3> vertices;
 	LLStrider<LLVector3> normals;
 	LLStrider<LLVector2> tex_coords;
@@ -952,13 +966,54 @@ void LLVOTree::updateMesh()
     buff->getColorStrider(colors);
 	buff->getIndexStrider(indices);
 
-	genBranchPipeline(vertices, normals, tex_coords, colors, indices, idx_offset, scale_mat, mTrunkLOD, stop_depth, mDepth, mTrunkDepth, 1.0, mTwist, droop, mBranches, alpha);
+	LLMatrix4 matrix;
+	genBranchPipeline(species, reference, vertices, normals, tex_coords, colors, indices, idx_offset, matrix, trunk_LOD, stop_depth, species->mDepth, species->mTrunkDepth, 1.0, species->mTwist, droop, species->mBranches, alpha);
 	
-	mReferenceBuffer->flush();
 	buff->flush();
+
+	add(sTreeMeshBuilds, 1);
+	return buff;
+}
+
+void LLVOTree::updateMesh()
+{
+	LLMatrix4 matrix;
+	
+	// Translate to tree base  HACK - adjustment in Z plants tree underground
+	const LLVector3 &pos_region = getPositionRegion();
+	//gGL.translatef(pos_agent.mV[VX], pos_agent.mV[VY], pos_agent.mV[VZ] - 0.1f);
+	LLMatrix4 trans_mat;
+	trans_mat.setTranslation(pos_region.mV[VX], pos_region.mV[VY], pos_region.mV[VZ] - 0.1f);
+	trans_mat *= matrix;
+	
+	// Rotate to tree position and bend for current trunk/wind
+	// Note that trunk stiffness controls the amount of bend at the trunk as 
+	// opposed to the crown of the tree
+	// 
+	const F32 TRUNK_STIFF = 22.f;
+	
+	LLQuaternion rot = 
+		LLQuaternion(mTrunkBend.magVec()*TRUNK_STIFF*DEG_TO_RAD, LLVector4(mTrunkBend.mV[VX], mTrunkBend.mV[VY], 0)) *
+		LLQuaternion(90.f*DEG_TO_RAD, LLVector4(0,0,1)) *
+		getRotation();
+
+	LLMatrix4 rot_mat(rot);
+	rot_mat *= trans_mat;
+
+	F32 radius = getScale().magVec()*0.05f;
+	LLMatrix4 scale_mat;
+	scale_mat.mMatrix[0][0] = 
+		scale_mat.mMatrix[1][1] =
+		scale_mat.mMatrix[2][2] = radius;
+
+	scale_mat *= rot_mat;
+
+	//the species mesh is drawn with this in place of the per tree mesh it used to be baked into
+	mInstanceMatrix = scale_mat;
 }
 
-void LLVOTree::appendMesh(LLStrider<LLVector3>& vertices, 
+void LLVOTree::appendMesh(LLVertexBuffer* reference,
+						 LLStrider<LLVector3>& vertices, 
 						 LLStrider<LLVector3>& normals, 
 						 LLStrider<LLVector2>& tex_coords, 
                          LLStrider<LLColor4U>& colors, 
@@ -977,11 +1032,11 @@ void LLVOTree::appendMesh(LLStrider<LLVector3>& vertices,
     LLStrider<LLColor4U> c;
 	LLStrider<U16> idx;
 
-	mReferenceBuffer->getVertexStrider(v);
-	mReferenceBuffer->getNormalStrider(n);
-	mReferenceBuffer->getTexCoord0Strider(t);
-    mReferenceBuffer->getColorStrider(c);
-	mReferenceBuffer->getIndexStrider(idx);
+	reference->getVertexStrider(v);
+	reference->getNormalStrider(n);
+	reference->getTexCoord0Strider(t);
+    reference->getColorStrider(c);
+	reference->getIndexStrider(idx);
 	
 	//copy/transform vertices into mesh - check
 	for (S32 i = 0; i < vert_count; i++)
@@ -1007,7 +1062,9 @@ void LLVOTree::appendMesh(LLStrider<LLVector3>& vertices,
 }
 								 
 
-void LLVOTree::genBranchPipeline(LLStrider<LLVector3>& vertices, 
+void LLVOTree::genBranchPipeline(const TreeSpeciesData* species,
+								 LLVertexBuffer* reference,
+								 LLStrider<LLVector3>& vertices, 
 								 LLStrider<LLVector3>& normals, 
 								 LLStrider<LLVector2>& tex_coords, 
                                  LLStrider<LLColor4U>& colors,
@@ -1030,8 +1087,8 @@ void LLVOTree::genBranchPipeline(LLStrider<LLVector3>& vertices,
 	static F32 constant_twist;
 	static F32 width = 0;
 
-	F32 length = ((trunk_depth || (scale == 1.f))? mTrunkLength:mBranchLength);
-	F32 aspect = ((trunk_depth || (scale == 1.f))? mTrunkAspect:mBranchAspect);
+	F32 length = ((trunk_depth || (scale == 1.f))? species->mTrunkLength:species->mBranchLength);
+	F32 aspect = ((trunk_depth || (scale == 1.f))? species->mTrunkAspect:species->mBranchAspect);
 	
 	constant_twist = 360.f/branches;
 
@@ -1052,7 +1109,7 @@ void LLVOTree::genBranchPipeline(LLStrider<LLVector3>& vertices,
 				LLMatrix4 norm_mat = LLMatrix4(norm.inverse().transpose().m);
 
 				norm_mat.invert();
-				appendMesh(vertices, normals, tex_coords, colors, indices, index_offset, scale_mat, norm_mat, 
+				appendMesh(reference, vertices, normals, tex_coords, colors, indices, index_offset, scale_mat, norm_mat, 
 							sLODVertexOffset[trunk_LOD], sLODVertexCount[trunk_LOD], sLODIndexCount[trunk_LOD], sLODIndexOffset[trunk_LOD]);
 			}
 			
@@ -1071,7 +1128,7 @@ void LLVOTree::genBranchPipeline(LLStrider<LLVector3>& vertices,
 				LLMatrix4 rot_mat(rot);
 				rot_mat *= trans_mat;
 
-				genBranchPipeline(vertices, normals, tex_coords, colors, indices, index_offset, rot_mat, trunk_LOD, stop_level, depth - 1, 0, scale*mScaleStep, twist, droop, branches, alpha);
+				genBranchPipeline(species, reference, vertices, normals, tex_coords, colors, indices, index_offset, rot_mat, trunk_LOD, stop_level, depth - 1, 0, scale*species->mScaleStep, twist, droop, branches, alpha);
 			}
 			//  Recurse to continue trunk
 			if (trunk_depth)
@@ -1082,7 +1139,7 @@ void LLVOTree::genBranchPipeline(LLStrider<LLVector3>& vertices,
 
 				LLMatrix4 rot_mat(70.5f*DEG_TO_RAD, LLVector4(0,0,1));
 				rot_mat *= trans_mat; // rotate a bit around Z when ascending 
-				genBranchPipeline(vertices, normals, tex_coords, colors, indices, index_offset, rot_mat, trunk_LOD, stop_level, depth, trunk_depth-1, scale*mScaleStep, twist, droop, branches, alpha);
+				genBranchPipeline(species, reference, vertices, normals, tex_coords, colors, indices, index_offset, rot_mat, trunk_LOD, stop_level, depth, trunk_depth-1, scale*species->mScaleStep, twist, droop, branches, alpha);
 			}
 		}
 		else
@@ -1094,14 +1151,14 @@ void LLVOTree::genBranchPipeline(LLStrider<LLVector3>& vertices,
 				LLMatrix4 scale_mat;
 				scale_mat.mMatrix[0][0] = 
 					scale_mat.mMatrix[1][1] =
-					scale_mat.mMatrix[2][2] = scale*mLeafScale;
+					scale_mat.mMatrix[2][2] = scale*species->mLeafScale;
 
 				scale_mat *= matrix;
 
 				glh::matrix4f norm((F32*) scale_mat.mMatrix);
 				LLMatrix4 norm_mat = LLMatrix4(norm.inverse().transpose().m);
 
-				appendMesh(vertices, normals, tex_coords, colors, indices, index_offset, scale_mat, norm_mat, 0, LEAF_VERTICES, LEAF_INDICES, 0);	
+				appendMesh(reference, vertices, normals, tex_coords, colors, indices, index_offset, scale_mat, norm_mat, 0, LEAF_VERTICES, LEAF_INDICES, 0);	
 			}
 		}
 	}
@@ -1220,6 +1277,65 @@ BOOL LLVOTree::lineSegmentIntersect(const LLVector4a& start, const LLVector4a& e
 	return FALSE;
 }
 
+//static
+void LLVOTree::runForestBenchmark(U32 tree_count)
+{
+	if (sSpeciesTable.empty() || tree_count == 0)
+	{
+		return;
+	}
+
+	// synthetic forest of random species at random trunk LODs
+	std::vector<std::pair<U8, S32> > forest;
+	forest.reserve(tree_count);
+	for (U32 i = 0; i < tree_count; ++i)
+	{
+		SpeciesMap::const_iterator iter = sSpeciesTable.begin();
+		std::advance(iter, ll_rand((S32) sSpeciesTable.size()));
+		forest.push_back(std::make_pair((U8) iter->first, (S32) ll_rand(sMAX_NUM_TREE_LOD_LEVELS)));
+	}
+
+	// every tree builds its own reference geometry and mesh, as trees used to
+	LLTimer timer;
+	for (U32 i = 0; i < tree_count; ++i)
+	{
+		const TreeSpeciesData* species = sSpeciesTable[forest[i].first];
+		LLPointer<LLVertexBuffer> reference = createReferenceBuffer(species);
+		if (reference.notNull())
+		{
+			createSpeciesMesh(species, reference, forest[i].second);
+		}
+	}
+	F32 uncached_time = timer.getElapsedTimeF32();
+
+	// start from an empty cache so the first tree of each kind pays for its mesh
+	mesh_map_t reference_buffers;
+	mesh_map_t species_meshes;
+	reference_buffers.swap(sReferenceBuffers);
+	species_meshes.swap(sSpeciesMeshes);
+
+	std::set<LLVertexBuffer*> meshes;
+	timer.reset();
+	for (U32 i = 0; i < tree_count; ++i)
+	{
+		meshes.insert(getSpeciesMesh(forest[i].first, forest[i].second));
+	}
+	F32 cached_time = timer.getElapsedTimeF32();
+	meshes.erase(NULL);
+
+	reference_buffers.swap(sReferenceBuffers);
+	species_meshes.swap(sSpeciesMeshes);
+
+	// the draw pool sorts trees by mesh, so a buffer is bound once per distinct mesh
+	LL_INFOS("Benchmark") << "Tree benchmark, " << tree_count << " trees of "
+		<< sSpeciesTable.size() << " species" << LL_ENDL;
+	LL_INFOS("Benchmark") << "Per tree meshes: " << uncached_time * 1000.f << " ms, "
+		<< tree_count << " draw calls, " << tree_count << " buffer binds" << LL_ENDL;
+	LL_INFOS("Benchmark") << "Species meshes: " << cached_time * 1000.f << " ms, "
+		<< meshes.size() << " meshes, " << tree_count << " draw calls, "
+		<< meshes.size() << " buffer binds" << LL_ENDL;
+}
+
 U32 LLVOTree::getPartitionType() const
 { 
 	return LLViewerRegion::PARTITION_TREE; 
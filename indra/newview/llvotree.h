@@ -54,6 +54,13 @@ public:
 	static void cleanupClass();
 	static bool isTreeRenderingStopped();
 
+	// Release the meshes shared between trees
+	static void destroyGL();
+
+	// Time generating meshes for tree_count trees of random species and LOD with
+	// and without the species mesh cache, and log the results
+	static void runForestBenchmark(U32 tree_count);
+
 	/*virtual*/ U32 processUpdateMessage(LLMessageSystem *mesgsys,
 											void **user_data,
 											U32 block_num, const EObjectUpdateType update_type,
@@ -73,11 +80,12 @@ public:
 
 	void updateRadius();
 
-	void calcNumVerts(U32& vert_count, U32& index_count, S32 trunk_LOD, S32 stop_level, U16 depth, U16 trunk_depth, F32 branches);
+	static void calcNumVerts(U32& vert_count, U32& index_count, S32 trunk_LOD, S32 stop_level, U16 depth, U16 trunk_depth, F32 branches);
 
 	void updateMesh();
 
-	void appendMesh(LLStrider<LLVector3>& vertices, 
+	static void appendMesh(LLVertexBuffer* reference,
+						 LLStrider<LLVector3>& vertices, 
 						 LLStrider<LLVector3>& normals, 
 						 LLStrider<LLVector2>& tex_coords,
                          LLStrider<LLColor4U>& colors,
@@ -90,7 +98,11 @@ public:
 						 S32 index_count,
 						 S32 index_offset);
 
-	void genBranchPipeline(LLStrider<LLVector3>& vertices, 
+	struct TreeSpeciesData;
+
+	static void genBranchPipeline(const TreeSpeciesData* species,
+								 LLVertexBuffer* reference,
+								 LLStrider<LLVector3>& vertices, 
 								 LLStrider<LLVector3>& normals, 
 								 LLStrider<LLVector2>& tex_coords, 
                                  LLStrider<LLColor4U>& colors,
@@ -153,7 +165,6 @@ protected:
 	LLVector3		mTrunkBend;		// Accumulated wind (used for blowing trees)
 	LLVector3		mWind;
 
-	LLPointer<LLVertexBuffer> mReferenceBuffer; //reference geometry for generating tree mesh
 	LLPointer<LLViewerFetchedTexture> mTreeImagep;	// Pointer to proper tree image
 
 	U8				mSpecies;		// Species of tree
@@ -179,11 +190,26 @@ protected:
 	LLVector3 mLastPosition;
 	LLQuaternion mLastRotation;
 
+	// tree space to region space, applied when drawing the shared species mesh
+	LLMatrix4 mInstanceMatrix;
+	// mInstanceMatrix with the region's render matrix applied, set by LLDrawPoolTree
+	LLMatrix4 mDrawMatrix;
+
 	U32 mFrameCount;
 
 	typedef std::map<U32, TreeSpeciesData*> SpeciesMap;
 	static SpeciesMap sSpeciesTable;
 
+	// reference geometry (leaves and a branch cylinder per LOD) for each species
+	static LLPointer<LLVertexBuffer> createReferenceBuffer(const TreeSpeciesData* species);
+	// mesh shared by every tree of a species at a trunk LOD, in tree space
+	static LLVertexBuffer* getSpeciesMesh(U8 species, S32 trunk_LOD);
+	static LLPointer<LLVertexBuffer> createSpeciesMesh(const TreeSpeciesData* species, LLVertexBuffer* reference, S32 trunk_LOD);
+
+	typedef std::map<U32, LLPointer<LLVertexBuffer> > mesh_map_t;
+	static mesh_map_t sReferenceBuffers;	// by species
+	static mesh_map_t sSpeciesMeshes;		// by species * sMAX_NUM_TREE_LOD_LEVELS + trunk LOD
+
 	static S32 sLODIndexOffset[4];
 	static S32 sLODIndexCount[4];
 	static S32 sLODVertexOffset[4];
@@ -64,9 +64,11 @@
 #include "llfloatertelehub.h"
 #include "llfloaterreg.h"
 #include "llgldbg.h"
+#include "llglstatestats.h"
 #include "llhudmanager.h"
 #include "llhudnametag.h"
 #include "llhudtext.h"
+#include "llimpostoratlas.h"
 #include "lllightconstants.h"
 #include "llmeshrepository.h"
 #include "llpipelinelistener.h"
@@ -150,6 +152,8 @@ U32 LLPipeline::RenderResolutionDivisor;
 bool LLPipeline::RenderUIBuffer;
 S32 LLPipeline::RenderShadowDetail;
 bool LLPipeline::RenderDeferredSSAO;
+bool LLPipeline::RenderMultiDrawBatches;
+bool LLPipeline::RenderOcclusionBatching;
 F32 LLPipeline::RenderShadowResolutionScale;
 bool LLPipeline::RenderLocalLights;
 bool LLPipeline::RenderDelayCreation;
@@ -545,6 +549,8 @@ void LLPipeline::init()
 	connectRefreshCachedSettingsSafe("RenderUIBuffer");
 	connectRefreshCachedSettingsSafe("RenderShadowDetail");
 	connectRefreshCachedSettingsSafe("RenderDeferredSSAO");
+	connectRefreshCachedSettingsSafe("RenderMultiDrawBatches");
+	connectRefreshCachedSettingsSafe("RenderOcclusionBatching");
 	connectRefreshCachedSettingsSafe("RenderShadowResolutionScale");
 	connectRefreshCachedSettingsSafe("RenderLocalLights");
 	connectRefreshCachedSettingsSafe("RenderDelayCreation");
@@ -692,6 +698,8 @@ void LLPipeline::cleanup()
 	mDeferredVB = NULL;
 
 	mCubeVB = NULL;
+
+	LLOcclusionCullingGroup::destroyGL();
 }
 
 //============================================================================
@@ -1074,6 +1082,8 @@ void LLPipeline::refreshCachedSettings()
 	RenderUIBuffer = gSavedSettings.getBOOL("RenderUIBuffer");
 	RenderShadowDetail = gSavedSettings.getS32("RenderShadowDetail");
 	RenderDeferredSSAO = gSavedSettings.getBOOL("RenderDeferredSSAO");
+	RenderMultiDrawBatches = gSavedSettings.getBOOL("RenderMultiDrawBatches");
+	RenderOcclusionBatching = gSavedSettings.getBOOL("RenderOcclusionBatching");
 	RenderShadowResolutionScale = gSavedSettings.getF32("RenderShadowResolutionScale");
 	RenderLocalLights = gSavedSettings.getBOOL("RenderLocalLights");
 	RenderDelayCreation = gSavedSettings.getBOOL("RenderDelayCreation");
@@ -1868,6 +1878,11 @@ void LLPipeline::resetFrameStats()
 	sCompiles        = 0;
 	mNumVisibleFaces = 0;
 
+	add(LLStatViewer::DRAW_INFO_BATCHES, LLRenderPass::sDrawInfoCount);
+	add(LLStatViewer::DRAW_INFO_CALLS, LLRenderPass::sDrawInfoCalls);
+	LLRenderPass::sDrawInfoCount = 0;
+	LLRenderPass::sDrawInfoCalls = 0;
+
 	if (mOldRenderDebugMask != mRenderDebugMask)
 	{
 		gObjectList.clearDebugText();
@@ -2652,6 +2667,11 @@ void LLPipeline::doOcclusion(LLCamera& camera)
 		}
 		mCubeVB->setBuffer(LLVertexBuffer::MAP_VERTEX);
 
+		if (RenderOcclusionBatching)
+		{ //queue the query boxes and draw them from one buffer below
+			LLOcclusionCullingGroup::beginOcclusionBatch();
+		}
+
 		for (LLCullResult::sg_iterator iter = sCull->beginOcclusionGroups(); iter != sCull->endOcclusionGroups(); ++iter)
 		{
 			LLSpatialGroup* group = *iter;
@@ -2670,6 +2690,11 @@ void LLPipeline::doOcclusion(LLCamera& camera)
 			}
 		}
 
+		if (RenderOcclusionBatching)
+		{
+			LLOcclusionCullingGroup::endOcclusionBatch();
+		}
+
 		if (bind_shader)
 		{
 			if (LLPipeline::sShadowRender)
@@ -3837,6 +3862,43 @@ void LLPipeline::postSort(LLCamera& camera)
 		}
 	}
 	
+	if (RenderMultiDrawBatches)
+	{ //put LLDrawInfos that can share a draw call next to each other
+		// alpha blended passes are drawn in depth order and rigged passes
+		// by avatar, so only the opaque static passes are sorted
+		static const U32 sorted_types[] =
+		{
+			LLRenderPass::PASS_SIMPLE,
+			LLRenderPass::PASS_GRASS,
+			LLRenderPass::PASS_FULLBRIGHT,
+			LLRenderPass::PASS_INVISIBLE,
+			LLRenderPass::PASS_INVISI_SHINY,
+			LLRenderPass::PASS_FULLBRIGHT_SHINY,
+			LLRenderPass::PASS_SHINY,
+			LLRenderPass::PASS_BUMP,
+			LLRenderPass::PASS_POST_BUMP,
+			LLRenderPass::PASS_MATERIAL,
+			LLRenderPass::PASS_MATERIAL_ALPHA_MASK,
+			LLRenderPass::PASS_SPECMAP,
+			LLRenderPass::PASS_SPECMAP_MASK,
+			LLRenderPass::PASS_SPECMAP_EMISSIVE,
+			LLRenderPass::PASS_NORMMAP,
+			LLRenderPass::PASS_NORMMAP_MASK,
+			LLRenderPass::PASS_NORMMAP_EMISSIVE,
+			LLRenderPass::PASS_NORMSPEC,
+			LLRenderPass::PASS_NORMSPEC_MASK,
+			LLRenderPass::PASS_NORMSPEC_EMISSIVE,
+			LLRenderPass::PASS_GLOW,
+			LLRenderPass::PASS_ALPHA_MASK,
+			LLRenderPass::PASS_FULLBRIGHT_ALPHA_MASK,
+		};
+
+		for (U32 type : sorted_types)
+		{
+			sCull->sortRenderMap(type);
+		}
+	}
+
 	//flush particle VB
 	if (LLVOPartGroup::sVB)
 	{
@@ -4384,6 +4446,7 @@ void LLPipeline::renderGeom(LLCamera& camera, bool forceVBOUpdate)
 			if (hasRenderType(poolp->getType()) && poolp->getNumPasses() > 0)
 			{
 				LL_PROFILE_ZONE_NAMED_CATEGORY_DRAWPOOL("pool render"); //LL_RECORD_BLOCK_TIME(FTM_POOLRENDER);
+				LLGLStateStats::Scope state_stats(cur_type);
 
 				gGLLastMatrix = NULL;
 				gGL.loadMatrix(gGLModelView);
@@ -4556,6 +4619,7 @@ void LLPipeline::renderGeomDeferred(LLCamera& camera)
 			if (hasRenderType(poolp->getType()) && poolp->getNumDeferredPasses() > 0)
 			{
 				LL_PROFILE_ZONE_NAMED_CATEGORY_DRAWPOOL("deferred pool render"); //LL_RECORD_BLOCK_TIME(FTM_DEFERRED_POOLRENDER);
+				LLGLStateStats::Scope state_stats(cur_type);
 
 				gGLLastMatrix = NULL;
 				gGL.loadMatrix(gGLModelView);
@@ -4645,6 +4709,7 @@ void LLPipeline::renderGeomPostDeferred(LLCamera& camera, bool do_occlusion)
 		if (hasRenderType(poolp->getType()) && poolp->getNumPostDeferredPasses() > 0)
 		{
 			LL_PROFILE_ZONE_NAMED_CATEGORY_DRAWPOOL("deferred poolrender"); //LL_RECORD_BLOCK_TIME(FTM_POST_DEFERRED_POOLRENDER);
+			LLGLStateStats::Scope state_stats(cur_type);
 
 			gGLLastMatrix = NULL;
 			gGL.loadMatrix(gGLModelView);
@@ -4723,6 +4788,7 @@ void LLPipeline::renderGeomShadow(LLCamera& camera)
 		pool_set_t::iterator iter2 = iter1;
 		if (hasRenderType(poolp->getType()) && poolp->getNumShadowPasses() > 0)
 		{
+			LLGLStateStats::Scope state_stats(cur_type);
 			poolp->prerender() ;
 
 			gGLLastMatrix = NULL;
@@ -7266,6 +7332,8 @@ void LLPipeline::doResetVertexBuffers(bool forced)
 	gSky.resetVertexBuffers();
 
 	LLVOPartGroup::destroyGL();
+	LLVOTree::destroyGL();
+	LLOcclusionCullingGroup::destroyGL();
 
 	if ( LLPathingLib::getInstance() )
 	{
@@ -7296,7 +7364,7 @@ void LLPipeline::doResetVertexBuffers(bool forced)
 	sNoAlpha = gSavedSettings.getBOOL("RenderNoAlpha");
 	LLPipeline::sTextureBindTest = gSavedSettings.getBOOL("RenderDebugTextureBind");
 
-	LLVertexBuffer::initClass(LLVertexBuffer::sEnableVBOs, LLVertexBuffer::sDisableVBOMapping);
+	LLVertexBuffer::initClass(LLVertexBuffer::sEnableVBOs, LLVertexBuffer::sDisableVBOMapping, gSavedSettings.getBOOL("RenderStreamRing"));
     gGL.initVertexBuffer();
 
     mDeferredVB = new LLVertexBuffer(DEFERRED_VB_MASK, 0);
@@ -10953,6 +11021,9 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
 	U32 resY = 0;
 	U32 resX = 0;
 
+	//keep clears and draws inside the avatar's atlas cell
+	LLGLEnable scissor(preview_avatar ? 0 : GL_SCISSOR_TEST);
+
     if (!preview_avatar)
 	{
 		const LLVector4a* ext = avatar->mDrawable->getSpatialExtents();
@@ -11009,25 +11080,23 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
 		resY = llmin(nhpo2((U32) (fov*pa)), (U32) 512);
 		resX = llmin(nhpo2((U32) (atanf(tdim.mV[0]/distance)*2.f*RAD_TO_DEG*pa)), (U32) 512);
 
-		if (!avatar->mImpostor.isComplete())
+		LLRenderTarget& atlas = gImpostorAtlas.getTarget();
+		if (!atlas.isComplete())
 		{
-            avatar->mImpostor.allocate(resX, resY, GL_RGBA, TRUE, FALSE);
+            atlas.allocate(LLImpostorAtlas::ATLAS_SIZE, LLImpostorAtlas::ATLAS_SIZE, GL_RGBA, TRUE, FALSE);
 
 			if (LLPipeline::sRenderDeferred)
 			{
-				addDeferredAttachments(avatar->mImpostor, true);
+				addDeferredAttachments(atlas, true);
 			}
 		
-			gGL.getTexUnit(0)->bind(&avatar->mImpostor);
+			gGL.getTexUnit(0)->bind(&atlas);
 			gGL.getTexUnit(0)->setTextureFilteringOption(LLTexUnit::TFO_POINT);
 			gGL.getTexUnit(0)->unbind(LLTexUnit::TT_TEXTURE);
 		}
-		else if(resX != avatar->mImpostor.getWidth() || resY != avatar->mImpostor.getHeight())
-		{
-			avatar->mImpostor.resize(resX,resY);
-		}
 
-		avatar->mImpostor.bindTarget();
+		//the atlas may hand back a smaller cell than asked for when it's full
+		gImpostorAtlas.bindCell(gImpostorAtlas.allocate(avatar, resX, resY));
 	}
 
 	F32 old_alpha = LLDrawPoolAvatar::sMinimumAlpha;
@@ -11052,7 +11121,7 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
     }
     else if (LLPipeline::sRenderDeferred)
 	{
-		avatar->mImpostor.clear();
+		gImpostorAtlas.clearCell();
 		renderGeomDeferred(camera);
 
 		renderGeomPostDeferred(camera);		
@@ -11074,9 +11143,7 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
 	}
 	else
 	{
-		LLGLEnable scissor(GL_SCISSOR_TEST);
-		glScissor(0, 0, resX, resY);
-		avatar->mImpostor.clear();
+		gImpostorAtlas.clearCell();
 		renderGeom(camera);
 
 		// Shameless hack time: render it all again,
@@ -11161,7 +11228,7 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar, bool preview_avatar)
 
     if (!preview_avatar)
     {
-        avatar->mImpostor.flush();
+        gImpostorAtlas.flushCell(avatar->mImpostorSlot);
         avatar->setImpostorDim(tdim);
     }
 
@@ -913,6 +913,8 @@ public:
 	static bool RenderUIBuffer;
 	static S32 RenderShadowDetail;
 	static bool RenderDeferredSSAO;
+	static bool RenderMultiDrawBatches;
+	static bool RenderOcclusionBatching;
 	static F32 RenderShadowResolutionScale;
 	static bool RenderLocalLights;
 	static bool RenderDelayCreation;
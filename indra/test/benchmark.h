@@ -0,0 +1,66 @@
+/**
+ * @file   benchmark.h
+ * @brief  Helpers for timing tests that are skipped during ordinary builds.
+ *
+ *         Microbenchmarks live next to the regression tests for the code they
+ *         measure, but they take too long (and are too noisy) to run as part
+ *         of every build. Start each benchmark test with
+ *         skip_unless_benchmarking(), then set LL_BENCHMARK=1 in the
+ *         environment when running the test executable to get the numbers.
+ *
+ * $LicenseInfo:firstyear=2023&license=viewerlgpl$
+ * Copyright (c) 2023, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+#if ! defined(LL_BENCHMARK_H)
+#define LL_BENCHMARK_H
+
+#include "lltut.h"
+#include "llstring.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+/// true if the LL_BENCHMARK environment variable is set to a non-empty value
+inline bool benchmarking()
+{
+    return ! LLStringUtil::getenv("LL_BENCHMARK").empty();
+}
+
+/// call at the top of a benchmark test
+inline void skip_unless_benchmarking()
+{
+    if (! benchmarking())
+    {
+        tut::skip("set LL_BENCHMARK=1 to run benchmarks");
+    }
+}
+
+/// Run func once, return elapsed wall-clock time in seconds.
+template <typename FUNC>
+double time_seconds(FUNC&& func)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::forward<FUNC>(func)();
+    std::chrono::duration<double> elapsed(std::chrono::steady_clock::now() - start);
+    return elapsed.count();
+}
+
+/// Print one line of benchmark output in a consistent, greppable format:
+/// "BENCH <label>: <ops> ops in <ms> ms, <ns>/op"
+inline void report_benchmark(const std::string& label, size_t ops, double seconds,
+                             const std::string& extra=std::string())
+{
+    std::cout << "BENCH " << label << ": " << ops << " ops in "
+              << std::fixed << std::setprecision(2) << (seconds * 1000.0) << " ms, "
+              << std::setprecision(1) << (ops ? seconds * 1e9 / ops : 0.0) << " ns/op";
+    if (! extra.empty())
+    {
+        std::cout << ", " << extra;
+    }
+    std::cout << std::endl;
+}
+
+#endif /* ! defined(LL_BENCHMARK_H) */
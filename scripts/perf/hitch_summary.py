@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""\
+@file hitch_summary.py
+@brief Summarize hitch capture (.llhc) files saved by the viewer when
+       HitchCaptureEnabled is set. Pass --help for details.
+
+$LicenseInfo:firstyear=2023&license=viewerlgpl$
+Second Life Viewer Source Code
+Copyright (C) 2023, Linden Research, Inc.
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation;
+version 2.1 of the License only.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+$/LicenseInfo$
+"""
+
+import argparse
+import statistics
+import struct
+import sys
+
+# See LLTrace::HitchCapture in indra/llcommon/lltracehitchcapture.h for the
+# file format.
+MAGIC = b"LLHC"
+VERSION = 1
+ENTRY = struct.Struct("<HHIII")
+
+
+class Frame:
+    def __init__(self, number, ms, counters, entries):
+        self.number = number
+        self.ms = ms
+        self.counters = counters
+        # list of (timer, parent, calls, total usec, self usec)
+        self.entries = entries
+
+    def self_ms(self):
+        result = {}
+        for timer, _, _, _, self_usec in self.entries:
+            result[timer] = result.get(timer, 0.0) + self_usec / 1000.0
+        return result
+
+
+class Capture:
+    def __init__(self, filename):
+        with open(filename, "rb") as f:
+            self.data = f.read()
+        self.pos = 0
+        if self.read(4) != MAGIC:
+            raise ValueError(f"{filename} is not a hitch capture file")
+        version = self.u32()
+        if version != VERSION:
+            raise ValueError(f"{filename} has unsupported version {version}")
+        self.timers = [self.name() for _ in range(self.u32())]
+        self.counters = [self.name() for _ in range(self.u32())]
+        self.frames = []
+        for _ in range(self.u32()):
+            number = self.u32()
+            ms = struct.unpack("<f", self.read(4))[0]
+            counters = [self.u32() for _ in self.counters]
+            count = self.u32()
+            entries = [ENTRY.unpack_from(self.read(ENTRY.size)) for _ in range(count)]
+            self.frames.append(Frame(number, ms, counters, entries))
+
+    def read(self, size):
+        if self.pos + size > len(self.data):
+            raise ValueError("truncated hitch capture file")
+        result = self.data[self.pos:self.pos + size]
+        self.pos += size
+        return result
+
+    def u32(self):
+        return struct.unpack("<I", self.read(4))[0]
+
+    def name(self):
+        length = struct.unpack("<H", self.read(2))[0]
+        return self.read(length).decode("utf-8", "replace")
+
+
+def print_tree(capture, frame, min_ms):
+    depth = {}
+    for timer, parent, calls, total_usec, self_usec in frame.entries:
+        depth[timer] = 0 if parent == timer else depth.get(parent, -1) + 1
+        if total_usec / 1000.0 < min_ms:
+            continue
+        indent = "  " * depth[timer]
+        print(f"  {indent}{capture.timers[timer]}: {total_usec / 1000.0:.2f} ms total, "
+              f"{self_usec / 1000.0:.2f} ms self, {calls} calls")
+
+
+def summarize(filename, args):
+    capture = Capture(filename)
+    frames = capture.frames
+    print(f"{filename}: {len(frames)} frames")
+    if not frames:
+        return
+
+    times = [frame.ms for frame in frames]
+    print(f"  frame ms: min {min(times):.1f}, median {statistics.median(times):.1f}, "
+          f"max {max(times):.1f}")
+
+    if args.frame is not None:
+        matches = [frame for frame in frames if frame.number == args.frame]
+        if not matches:
+            print(f"  frame {args.frame} not in capture")
+            return
+        target = matches[0]
+    else:
+        target = max(frames, key=lambda frame: frame.ms)
+    others = [frame for frame in frames if frame is not target]
+    print(f"  frame {target.number}: {target.ms:.1f} ms")
+
+    # Counters: what happened in this frame, against a typical frame.
+    for i, name in enumerate(capture.counters):
+        typical = statistics.median([frame.counters[i] for frame in others]) if others else 0
+        print(f"    {name}: {target.counters[i]} (median {typical:g})")
+
+    # Timers whose self time grew the most compared with a typical frame.
+    baseline = {}
+    for frame in others:
+        for timer, ms in frame.self_ms().items():
+            baseline.setdefault(timer, []).append(ms)
+    excess = []
+    for timer, ms in target.self_ms().items():
+        samples = baseline.get(timer, [])
+        # a timer absent from a frame spent no time in it
+        samples = samples + [0.0] * (len(others) - len(samples))
+        typical = statistics.median(samples) if samples else 0.0
+        excess.append((ms - typical, ms, typical, timer))
+    excess.sort(reverse=True)
+    print(f"  top {args.top} timers by self time over median:")
+    for over, ms, typical, timer in excess[:args.top]:
+        print(f"    {over:8.2f} ms  {capture.timers[timer]} ({ms:.2f} ms, median {typical:.2f} ms)")
+
+    if args.tree:
+        print("  timer tree:")
+        print_tree(capture, target, args.min_ms)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Summarize viewer hitch capture (.llhc) files. "
+                                     "For each file, compare the slowest frame (or --frame) "
+                                     "against the median of the other captured frames.")
+    parser.add_argument("files", nargs="+", help="hitch capture files from the viewer logs directory")
+    parser.add_argument("--frame", type=int, help="examine this frame number instead of the slowest")
+    parser.add_argument("--top", type=int, default=15, help="number of timers to list (default 15)")
+    parser.add_argument("--tree", action="store_true", help="also print the frame's full timer tree")
+    parser.add_argument("--min-ms", type=float, default=0.1,
+                        help="omit timers below this many ms from --tree (default 0.1)")
+    args = parser.parse_args()
+
+    status = 0
+    for filename in args.files:
+        try:
+            summarize(filename, args)
+        except (OSError, ValueError) as e:
+            print(f"{filename}: {e}", file=sys.stderr)
+            status = 1
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())